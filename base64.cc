@@ -5,18 +5,218 @@
 #include "base/base64.h"
 
 #include <stddef.h>
+#include <string.h>
 
+#include <algorithm>
+
+#include "base/check_op.h"
+#include "base/cpu.h"
+#include "build/build_config.h"
 #include "third_party/modp_b64/modp_b64.h"
 
+#if defined(ARCH_CPU_X86_64)
+#include <tmmintrin.h>
+#endif
+
 namespace base {
+namespace {
+
+constexpr char kAlphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Maps each character to its 6-bit value, or to -1 if it is not in the
+// alphabet.
+struct DecodeTable {
+  int8_t values[256];
+};
+
+constexpr DecodeTable MakeDecodeTable() {
+  DecodeTable table = {};
+  for (int i = 0; i < 256; ++i)
+    table.values[i] = -1;
+  for (int i = 0; i < 64; ++i)
+    table.values[static_cast<uint8_t>(kAlphabet[i])] = static_cast<int8_t>(i);
+  return table;
+}
+
+constexpr DecodeTable kDecodeTable = MakeDecodeTable();
+
+#if defined(ARCH_CPU_X86_64)
+
+bool HasSSSE3() {
+  static const bool has_ssse3 = CPU().has_ssse3();
+  return has_ssse3;
+}
+
+// Encodes blocks of 12 bytes of |input| into 16 characters each, and returns
+// the number of bytes encoded. Each block loads 16 bytes, so the last 4 bytes
+// are never encoded here.
+__attribute__((target("ssse3"))) size_t EncodeBlocks(const uint8_t* input,
+                                                     size_t size,
+                                                     char* output) {
+  size_t i = 0;
+  for (; i + 16 <= size; i += 12, output += 16) {
+    // Gathers the bytes of each group of 3 into a 32-bit lane, in the order
+    // (1, 0, 2, 1), so that each 6-bit index sits within a 16-bit half.
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+    v = _mm_shuffle_epi8(
+        v, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+
+    // Shifts the indices in place with multiplies: the first and third down
+    // into the low bits of their halves, the second and fourth up into the
+    // high byte, so that the first index ends up in the lowest byte.
+    const __m128i first_third = _mm_mulhi_epu16(
+        _mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00)),
+        _mm_set1_epi32(0x04000040));
+    const __m128i second_fourth = _mm_mullo_epi16(
+        _mm_and_si128(v, _mm_set1_epi32(0x003f03f0)),
+        _mm_set1_epi32(0x01000010));
+    const __m128i indices = _mm_or_si128(first_third, second_fourth);
+
+    // Adds the offset from each index to its character: 'A' for 0 to 25, then
+    // 'a' - 26 up to 51, '0' - 52 up to 61, and '+' - 62 and '/' - 63.
+    __m128i offsets = _mm_set1_epi8('A');
+    offsets = _mm_add_epi8(
+        offsets, _mm_and_si128(_mm_cmpgt_epi8(indices, _mm_set1_epi8(25)),
+                               _mm_set1_epi8('a' - 26 - 'A')));
+    offsets = _mm_add_epi8(
+        offsets, _mm_and_si128(_mm_cmpgt_epi8(indices, _mm_set1_epi8(51)),
+                               _mm_set1_epi8('0' - 52 - ('a' - 26))));
+    offsets = _mm_add_epi8(
+        offsets, _mm_and_si128(_mm_cmpgt_epi8(indices, _mm_set1_epi8(61)),
+                               _mm_set1_epi8('+' - 62 - ('0' - 52))));
+    offsets = _mm_add_epi8(
+        offsets, _mm_and_si128(_mm_cmpgt_epi8(indices, _mm_set1_epi8(62)),
+                               _mm_set1_epi8('/' - 63 - ('+' - 62))));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output),
+                     _mm_add_epi8(indices, offsets));
+  }
+  return i;
+}
+
+// Decodes blocks of 16 characters of |input| into 12 bytes each, and returns
+// the number of characters decoded. Stops at the first block with a character
+// that is not in the alphabet, padding included.
+__attribute__((target("ssse3"))) size_t DecodeBlocks(const char* input,
+                                                     size_t size,
+                                                     uint8_t* output) {
+  // The alphabet is checked one nibble at a time: each high nibble that
+  // starts a range of the alphabet has a bit, and the table for low nibbles
+  // has the bits of the high nibbles it makes a character of the alphabet
+  // with. High nibbles 4 and 6 ('A' to 'O' and 'a' to 'o') share a bit, and
+  // so do 5 and 7 ('P' to 'Z' and 'p' to 'z').
+  const __m128i high_nibble_bits =
+      _mm_setr_epi8(0, 0, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0, 0, 0, 0, 0,
+                    0, 0, 0);
+  const __m128i low_nibble_bits =
+      _mm_setr_epi8(0x0a, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e,
+                    0x0e, 0x0c, 0x05, 0x04, 0x04, 0x04, 0x05);
+  // The offset from each character to its value, by high nibble, which is
+  // right for all of the alphabet but '/'.
+  const __m128i offsets_by_high_nibble =
+      _mm_setr_epi8(0, 0, 62 - '+', 52 - '0', 0 - 'A', 15 - 'P', 26 - 'a',
+                    41 - 'p', 0, 0, 0, 0, 0, 0, 0, 0);
+
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16, output += 12) {
+    const __m128i chars =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+    const __m128i high_nibbles =
+        _mm_and_si128(_mm_srli_epi32(chars, 4), _mm_set1_epi8(0x0f));
+    const __m128i low_nibbles = _mm_and_si128(chars, _mm_set1_epi8(0x0f));
+    const __m128i matches =
+        _mm_and_si128(_mm_shuffle_epi8(high_nibble_bits, high_nibbles),
+                      _mm_shuffle_epi8(low_nibble_bits, low_nibbles));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(matches, _mm_setzero_si128())))
+      break;
+
+    const __m128i slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+    const __m128i offsets = _mm_add_epi8(
+        _mm_shuffle_epi8(offsets_by_high_nibble, high_nibbles),
+        _mm_and_si128(slash, _mm_set1_epi8((63 - '/') - (62 - '+'))));
+    const __m128i values = _mm_add_epi8(chars, offsets);
+
+    // Merges pairs of values into 12 bits in each 16-bit lane, then pairs of
+    // those into the 24 bits of each group, and packs the bytes of the groups
+    // in order.
+    const __m128i pairs =
+        _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    const __m128i groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    const __m128i bytes = _mm_shuffle_epi8(
+        groups,
+        _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(output), bytes);
+    const uint32_t last_bytes =
+        static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(bytes, 8)));
+    memcpy(output + 8, &last_bytes, sizeof(last_bytes));
+  }
+  return i;
+}
+
+#endif  // defined(ARCH_CPU_X86_64)
+
+// Encodes |size| bytes of |input|, a multiple of 3, which needs no padding.
+void EncodeGroups(const uint8_t* input, size_t size, char* output) {
+  DCHECK_EQ(size % 3, 0u);
+  size_t i = 0;
+#if defined(ARCH_CPU_X86_64)
+  if (HasSSSE3()) {
+    i = EncodeBlocks(input, size, output);
+    output += i / 3 * 4;
+  }
+#endif
+  for (; i < size; i += 3, output += 4) {
+    const uint32_t group = input[i] << 16 | input[i + 1] << 8 | input[i + 2];
+    output[0] = kAlphabet[group >> 18];
+    output[1] = kAlphabet[(group >> 12) & 0x3f];
+    output[2] = kAlphabet[(group >> 6) & 0x3f];
+    output[3] = kAlphabet[group & 0x3f];
+  }
+}
+
+// Decodes |size| characters of |input|, a multiple of 4, which may not be
+// padded. Returns false if any of them is not in the alphabet.
+bool DecodeGroups(const char* input, size_t size, uint8_t* output) {
+  DCHECK_EQ(size % 4, 0u);
+  size_t i = 0;
+#if defined(ARCH_CPU_X86_64)
+  if (HasSSSE3()) {
+    i = DecodeBlocks(input, size, output);
+    output += i / 4 * 3;
+  }
+#endif
+  for (; i < size; i += 4, output += 3) {
+    const int a = kDecodeTable.values[static_cast<uint8_t>(input[i])];
+    const int b = kDecodeTable.values[static_cast<uint8_t>(input[i + 1])];
+    const int c = kDecodeTable.values[static_cast<uint8_t>(input[i + 2])];
+    const int d = kDecodeTable.values[static_cast<uint8_t>(input[i + 3])];
+    if ((a | b | c | d) < 0)
+      return false;
+    const uint32_t group = a << 18 | b << 12 | c << 6 | d;
+    output[0] = static_cast<uint8_t>(group >> 16);
+    output[1] = static_cast<uint8_t>(group >> 8);
+    output[2] = static_cast<uint8_t>(group);
+  }
+  return true;
+}
+
+}  // namespace
 
 std::string Base64Encode(span<const uint8_t> input) {
   std::string output;
   output.resize(modp_b64_encode_len(input.size()));  // makes room for null byte
 
-  // modp_b64_encode_len() returns at least 1, so output[0] is safe to use.
-  const size_t output_size = modp_b64_encode(
-      &(output[0]), reinterpret_cast<const char*>(input.data()), input.size());
+  // Encodes the whole groups of 3 bytes, and leaves the padded end to
+  // modp_b64. modp_b64_encode_len() returns at least 1, so output[0] is safe
+  // to use.
+  const size_t groups_size = input.size() - input.size() % 3;
+  EncodeGroups(input.data(), groups_size, &output[0]);
+  const size_t encoded_size = groups_size / 3 * 4;
+  const size_t output_size =
+      encoded_size +
+      modp_b64_encode(&output[encoded_size],
+                      reinterpret_cast<const char*>(input.data()) + groups_size,
+                      input.size() - groups_size);
 
   output.resize(output_size);
   return output;
@@ -30,15 +230,142 @@ bool Base64Decode(const StringPiece& input, std::string* output) {
   std::string temp;
   temp.resize(modp_b64_decode_len(input.size()));
 
+  // Only the last group of 4 characters may be padded. Decodes the groups
+  // before it, and leaves the last one to modp_b64, which also rejects inputs
+  // of other sizes, so that exactly the same inputs are accepted.
+  size_t groups_size = 0;
+  if (input.size() > 4 && input.size() % 4 == 0) {
+    groups_size = input.size() - 4;
+    if (!DecodeGroups(input.data(), groups_size,
+                      reinterpret_cast<uint8_t*>(&temp[0]))) {
+      return false;
+    }
+  }
+
   // does not null terminate result since result is binary data!
-  size_t input_size = input.size();
-  size_t output_size = modp_b64_decode(&(temp[0]), input.data(), input_size);
+  const size_t decoded_size = groups_size / 4 * 3;
+  size_t output_size =
+      modp_b64_decode(&temp[decoded_size], input.data() + groups_size,
+                      input.size() - groups_size);
   if (output_size == MODP_B64_ERROR)
     return false;
 
-  temp.resize(output_size);
+  temp.resize(decoded_size + output_size);
   output->swap(temp);
   return true;
 }
 
+// static
+constexpr size_t Base64Encoder::kMaxFinishSize;
+
+Base64Encoder::Base64Encoder() = default;
+
+Base64Encoder::~Base64Encoder() = default;
+
+size_t Base64Encoder::Update(span<const uint8_t> input, span<char> output) {
+  DCHECK_GE(output.size(), MaxUpdateSize(input.size()));
+  if (pending_size_ + input.size() < 3) {
+    std::copy(input.begin(), input.end(), pending_ + pending_size_);
+    pending_size_ += input.size();
+    return 0;
+  }
+
+  size_t output_size = 0;
+  if (pending_size_ > 0) {
+    uint8_t group[3];
+    const size_t taken = 3 - pending_size_;
+    std::copy_n(pending_, pending_size_, group);
+    std::copy_n(input.data(), taken, group + pending_size_);
+    EncodeGroups(group, 3, output.data());
+    output_size = 4;
+    input = input.subspan(taken);
+  }
+
+  const size_t groups_size = input.size() - input.size() % 3;
+  EncodeGroups(input.data(), groups_size, output.data() + output_size);
+  output_size += groups_size / 3 * 4;
+
+  pending_size_ = input.size() - groups_size;
+  std::copy(input.begin() + groups_size, input.end(), pending_);
+  return output_size;
+}
+
+size_t Base64Encoder::Finish(span<char> output) {
+  DCHECK_GE(output.size(), kMaxFinishSize);
+  // Leaves the padding to modp_b64, which also writes a null byte.
+  char encoded[kMaxFinishSize + 1];
+  const size_t output_size = modp_b64_encode(
+      encoded, reinterpret_cast<const char*>(pending_), pending_size_);
+  std::copy_n(encoded, output_size, output.data());
+  pending_size_ = 0;
+  return output_size;
+}
+
+// static
+constexpr size_t Base64Decoder::kMaxFinishSize;
+
+Base64Decoder::Base64Decoder() = default;
+
+Base64Decoder::~Base64Decoder() = default;
+
+bool Base64Decoder::Update(StringPiece input,
+                           span<uint8_t> output,
+                           size_t* output_size) {
+  DCHECK_GE(output.size(), MaxUpdateSize(input.size()));
+  *output_size = 0;
+  if (failed_)
+    return false;
+
+  // Fills the group held back, and decodes it if more input follows it.
+  const size_t taken = std::min(4 - pending_size_, input.size());
+  std::copy_n(input.data(), taken, pending_ + pending_size_);
+  pending_size_ += taken;
+  input.remove_prefix(taken);
+  if (input.empty())
+    return true;
+
+  uint8_t* out = output.data();
+  if (!DecodeGroups(pending_, 4, out)) {
+    failed_ = true;
+    return false;
+  }
+  out += 3;
+
+  // Decodes all the other groups but the last one, which may be padded, and
+  // holds back its 1 to 4 characters.
+  const size_t groups_size = (input.size() - 1) / 4 * 4;
+  if (!DecodeGroups(input.data(), groups_size, out)) {
+    failed_ = true;
+    return false;
+  }
+  out += groups_size / 4 * 3;
+  input.remove_prefix(groups_size);
+
+  pending_size_ = input.size();
+  std::copy(input.begin(), input.end(), pending_);
+  *output_size = out - output.data();
+  return true;
+}
+
+bool Base64Decoder::Finish(span<uint8_t> output, size_t* output_size) {
+  DCHECK_GE(output.size(), kMaxFinishSize);
+  *output_size = 0;
+  const bool failed = failed_;
+  const size_t pending_size = pending_size_;
+  failed_ = false;
+  pending_size_ = 0;
+  if (failed)
+    return false;
+  if (pending_size == 0)
+    return true;
+
+  // Leaves the padding and the size check to modp_b64, as Base64Decode() does.
+  const size_t decoded_size = modp_b64_decode(
+      reinterpret_cast<char*>(output.data()), pending_, pending_size);
+  if (decoded_size == MODP_B64_ERROR)
+    return false;
+  *output_size = decoded_size;
+  return true;
+}
+
 }  // namespace base
@@ -5,6 +5,9 @@
 #ifndef BASE_BASE64_H_
 #define BASE_BASE64_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <string>
 
 #include "base/base_export.h"
@@ -24,6 +27,79 @@ BASE_EXPORT void Base64Encode(const StringPiece& input, std::string* output);
 // be done in-place.
 BASE_EXPORT bool Base64Decode(const StringPiece& input, std::string* output);
 
+// Encodes a stream of binary data in base64, one chunk at a time, into
+// caller-provided buffers. The concatenated output is the same as what
+// Base64Encode() gives for the concatenated input.
+class BASE_EXPORT Base64Encoder {
+ public:
+  // The most characters Finish() writes.
+  static constexpr size_t kMaxFinishSize = 4;
+
+  // The most characters Update() writes for |input_size| bytes of input.
+  static constexpr size_t MaxUpdateSize(size_t input_size) {
+    return (input_size + 2) / 3 * 4;
+  }
+
+  Base64Encoder();
+  Base64Encoder(const Base64Encoder&) = delete;
+  Base64Encoder& operator=(const Base64Encoder&) = delete;
+  ~Base64Encoder();
+
+  // Encodes |input| into |output|, which must have room for at least
+  // MaxUpdateSize(input.size()) characters, and returns the number of
+  // characters written. Up to two trailing bytes are held back until more
+  // input comes in or Finish() is called.
+  size_t Update(span<const uint8_t> input, span<char> output);
+
+  // Encodes the bytes held back, with padding, into |output|, which must have
+  // room for at least kMaxFinishSize characters, and returns the number of
+  // characters written. The encoder can be reused afterwards.
+  size_t Finish(span<char> output);
+
+ private:
+  uint8_t pending_[2];
+  size_t pending_size_ = 0;
+};
+
+// Decodes a stream of base64 text, one chunk at a time, into caller-provided
+// buffers. The input is accepted or rejected exactly as Base64Decode() would
+// accept or reject the concatenated input, and the concatenated output of a
+// successful decoding is the same.
+class BASE_EXPORT Base64Decoder {
+ public:
+  // The most bytes Finish() writes.
+  static constexpr size_t kMaxFinishSize = 3;
+
+  // The most bytes Update() writes for |input_size| characters of input.
+  static constexpr size_t MaxUpdateSize(size_t input_size) {
+    return (input_size / 4 + 1) * 3;
+  }
+
+  Base64Decoder();
+  Base64Decoder(const Base64Decoder&) = delete;
+  Base64Decoder& operator=(const Base64Decoder&) = delete;
+  ~Base64Decoder();
+
+  // Decodes |input| into |output|, which must have room for at least
+  // MaxUpdateSize(input.size()) bytes, and sets |*output_size| to the number
+  // of bytes written. The last group of four characters is held back until
+  // more input comes in or Finish() is called, since only the end of the input
+  // may be padded. Returns false if the input is already known to be invalid,
+  // in which case every later call fails too.
+  bool Update(StringPiece input, span<uint8_t> output, size_t* output_size);
+
+  // Decodes the characters held back into |output|, which must have room for
+  // at least kMaxFinishSize bytes, and sets |*output_size| to the number of
+  // bytes written. Returns false if the input as a whole is invalid. The
+  // decoder can be reused afterwards.
+  bool Finish(span<uint8_t> output, size_t* output_size);
+
+ private:
+  char pending_[4];
+  size_t pending_size_ = 0;
+  bool failed_ = false;
+};
+
 }  // namespace base
 
 #endif  // BASE_BASE64_H_
@@ -4,10 +4,57 @@
 
 #include "base/base64.h"
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/strings/string_util.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace base {
 
+namespace {
+
+constexpr size_t kChunkSizes[] = {1, 2, 3, 5, 16, 17, 64};
+
+// Encodes |input| with a Base64Encoder, |chunk_size| bytes at a time.
+std::string StreamEncode(span<const uint8_t> input, size_t chunk_size) {
+  Base64Encoder encoder;
+  std::string output;
+  std::vector<char> buffer(
+      Base64Encoder::MaxUpdateSize(chunk_size) + Base64Encoder::kMaxFinishSize);
+  for (size_t i = 0; i < input.size(); i += chunk_size) {
+    const size_t size = encoder.Update(
+        input.subspan(i, std::min(chunk_size, input.size() - i)), buffer);
+    output.append(buffer.data(), size);
+  }
+  const size_t size = encoder.Finish(buffer);
+  output.append(buffer.data(), size);
+  return output;
+}
+
+// Decodes |input| with a Base64Decoder, |chunk_size| characters at a time.
+// Returns false if the decoder rejects the input.
+bool StreamDecode(StringPiece input, size_t chunk_size, std::string* output) {
+  Base64Decoder decoder;
+  output->clear();
+  std::vector<uint8_t> buffer(
+      Base64Decoder::MaxUpdateSize(chunk_size) + Base64Decoder::kMaxFinishSize);
+  size_t size;
+  for (size_t i = 0; i < input.size(); i += chunk_size) {
+    if (!decoder.Update(input.substr(i, chunk_size), buffer, &size))
+      return false;
+    output->append(buffer.begin(), buffer.begin() + size);
+  }
+  if (!decoder.Finish(buffer, &size))
+    return false;
+  output->append(buffer.begin(), buffer.begin() + size);
+  return true;
+}
+
+}  // namespace
+
 TEST(Base64Test, Basic) {
   const std::string kText = "hello world";
   const std::string kBase64Text = "aGVsbG8gd29ybGQ=";
@@ -51,4 +98,137 @@ TEST(Base64Test, InPlace) {
   EXPECT_EQ(text, kText);
 }
 
+TEST(Base64Test, LongText) {
+  const std::string kText = "The quick brown fox jumps over the lazy dog";
+  const std::string kBase64Text =
+      "VGhlIHF1aWNrIGJyb3duIGZveCBqdW1wcyBvdmVyIHRoZSBsYXp5IGRvZw==";
+
+  std::string encoded;
+  Base64Encode(kText, &encoded);
+  EXPECT_EQ(kBase64Text, encoded);
+
+  std::string decoded;
+  EXPECT_TRUE(Base64Decode(kBase64Text, &decoded));
+  EXPECT_EQ(kText, decoded);
+}
+
+TEST(Base64Test, AllSizes) {
+  std::vector<uint8_t> data(200);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<uint8_t>(i * 149 + 7);
+
+  for (size_t size = 0; size <= data.size(); ++size) {
+    SCOPED_TRACE(size);
+    const auto input = make_span(data).first(size);
+    const std::string encoded = Base64Encode(input);
+    EXPECT_EQ((size + 2) / 3 * 4, encoded.size());
+
+    std::string decoded;
+    ASSERT_TRUE(Base64Decode(encoded, &decoded));
+    EXPECT_EQ(std::string(input.begin(), input.end()), decoded);
+
+    for (size_t chunk_size : kChunkSizes) {
+      SCOPED_TRACE(chunk_size);
+      EXPECT_EQ(encoded, StreamEncode(input, chunk_size));
+      std::string stream_decoded;
+      EXPECT_TRUE(StreamDecode(encoded, chunk_size, &stream_decoded));
+      EXPECT_EQ(decoded, stream_decoded);
+    }
+  }
+}
+
+TEST(Base64Test, InvalidCharacters) {
+  const std::string kValid = "AbCdEfGhIjKlMnOpQrStUvWxYz0123456789+/Aa";
+  std::string decoded;
+  ASSERT_TRUE(Base64Decode(kValid, &decoded));
+
+  // Replaces each character with every other one, and checks that the input is
+  // accepted if and only if the replacement is in the alphabet, or is padding
+  // at the very end.
+  for (size_t pos = 0; pos < kValid.size(); ++pos) {
+    for (int c = 0; c < 256; ++c) {
+      std::string input = kValid;
+      input[pos] = static_cast<char>(c);
+      const bool expected =
+          IsAsciiAlpha(c) || IsAsciiDigit(c) || c == '+' || c == '/' ||
+          (c == '=' && pos == kValid.size() - 1);
+      SCOPED_TRACE(input);
+
+      std::string output = "untouched";
+      EXPECT_EQ(expected, Base64Decode(input, &output));
+      if (!expected)
+        EXPECT_EQ("untouched", output);
+      for (size_t chunk_size : kChunkSizes) {
+        std::string stream_output;
+        EXPECT_EQ(expected, StreamDecode(input, chunk_size, &stream_output));
+        if (expected)
+          EXPECT_EQ(output, stream_output);
+      }
+    }
+  }
+}
+
+TEST(Base64Test, Padding) {
+  const struct {
+    const char* input;
+    bool valid;
+    const char* output;
+  } kCases[] = {
+      {"", true, ""},
+      {"QQ==", true, "A"},
+      {"QUI=", true, "AB"},
+      {"QUJD", true, "ABC"},
+      {"QUJDRA==", true, "ABCD"},
+      {"QUJDREVGR0hJSktMTU5PUFFSU1Q=", true, "ABCDEFGHIJKLMNOPQRST"},
+      {"QQ", false, nullptr},
+      {"QUI", false, nullptr},
+      {"QUJDRA", false, nullptr},
+      {"Q===", false, nullptr},
+      {"====", false, nullptr},
+      {"QQ=A", false, nullptr},
+      {"QQ==QUJD", false, nullptr},
+      {"QUJDRA===", false, nullptr},
+      {"QUJDREVG====", false, nullptr},
+      {"QUJDREVGR0hJSktMTU5P==FSU1Q=", false, nullptr},
+      {" QUJD", false, nullptr},
+      {"QUJD\n", false, nullptr},
+  };
+
+  for (const auto& test_case : kCases) {
+    SCOPED_TRACE(test_case.input);
+    std::string output;
+    EXPECT_EQ(test_case.valid, Base64Decode(test_case.input, &output));
+    if (test_case.valid)
+      EXPECT_EQ(test_case.output, output);
+    for (size_t chunk_size : kChunkSizes) {
+      std::string stream_output;
+      EXPECT_EQ(test_case.valid,
+                StreamDecode(test_case.input, chunk_size, &stream_output));
+      if (test_case.valid)
+        EXPECT_EQ(test_case.output, stream_output);
+    }
+  }
+}
+
+TEST(Base64Test, StreamingReuse) {
+  Base64Decoder decoder;
+  uint8_t buffer[Base64Decoder::MaxUpdateSize(4)];
+  size_t size;
+
+  // Padding is only found to be misplaced once more input follows it, and the
+  // decoder then keeps failing until Finish().
+  EXPECT_TRUE(decoder.Update("QQ==", buffer, &size));
+  EXPECT_EQ(0u, size);
+  EXPECT_FALSE(decoder.Update("QUJD", buffer, &size));
+  EXPECT_FALSE(decoder.Update("QUJD", buffer, &size));
+  EXPECT_FALSE(decoder.Finish(buffer, &size));
+
+  // Finish() resets the decoder.
+  EXPECT_TRUE(decoder.Update("QUJD", buffer, &size));
+  EXPECT_EQ(0u, size);
+  EXPECT_TRUE(decoder.Finish(buffer, &size));
+  EXPECT_EQ(3u, size);
+  EXPECT_EQ("ABC", std::string(buffer, buffer + size));
+}
+
 }  // namespace base
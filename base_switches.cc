@@ -168,6 +168,13 @@ const char kForceFieldTrialParams[] = "force-fieldtrial-params";
 // This flag requires the BPF sandbox to be disabled.
 const char kEnableThreadInstructionCount[] = "enable-thread-instruction-count";
 
+// Enables reporting of per-task hardware performance counters (cycles,
+// instructions, cache and branch misses, context switches) in trace events on
+// Linux.
+//
+// This flag requires the BPF sandbox to be disabled.
+const char kEnableThreadPerfCounters[] = "enable-thread-perf-counters";
+
 // TODO(crbug.com/1176772): Remove kEnableCrashpad and IsCrashpadEnabled() when
 // Crashpad is fully enabled on Linux. Indicates that Crashpad should be
 // enabled.
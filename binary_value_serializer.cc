@@ -0,0 +1,441 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/binary_value_serializer.h"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "base/bits.h"
+#include "base/check_op.h"
+#include "base/notreached.h"
+#include "base/pickle.h"
+#include "base/strings/string_util.h"
+
+namespace base {
+
+namespace {
+
+// Identifies an encoding, and its version, which must change whenever the
+// encoding does.
+constexpr uint32_t kMagic = 0x4C415642;  // "BVAL" in little-endian.
+constexpr uint32_t kVersion = 1;
+
+// The type tags of encoded values. These are persisted, so existing values
+// must not change.
+enum class Tag : uint32_t {
+  kNone = 0,
+  kBool = 1,
+  kInt = 2,
+  kDouble = 3,
+  kString = 4,
+  kBlob = 5,
+  kDictionary = 6,
+  kList = 7,
+};
+
+// The contents of a list or dictionary are written like a Pickle::WriteData()
+// payload, and their length doubles as the header of a nested Pickle holding
+// them, which lets them be iterated in place.
+static_assert(sizeof(Pickle::Header) == sizeof(int),
+              "The length of contents must be a Pickle header");
+
+// The largest size of the contents of a list or dictionary, whose length is
+// an int.
+constexpr size_t kMaxContentsSize = std::numeric_limits<int>::max();
+
+size_t AlignedSize(size_t size) {
+  return bits::AlignUp(size, sizeof(uint32_t));
+}
+
+// Encodes a Value in two passes: the first computes the size of the contents
+// of each list and dictionary, which precede them, and of the whole encoding,
+// so that the second can write it with a single allocation.
+class Encoder {
+ public:
+  // Computes the sizes for |value| at nesting level |depth| and sets |size| to
+  // the size of its encoding. Returns false if |value| can't be encoded.
+  bool Measure(const Value& value, size_t depth, size_t* size) {
+    *size = sizeof(Tag);
+    switch (value.type()) {
+      case Value::Type::NONE:
+        return true;
+      case Value::Type::BOOLEAN:
+      case Value::Type::INTEGER:
+        *size += sizeof(int);
+        return true;
+      case Value::Type::DOUBLE:
+        *size += sizeof(double);
+        return true;
+      case Value::Type::STRING:
+        *size += sizeof(int) + AlignedSize(value.GetString().size());
+        return true;
+      case Value::Type::BINARY:
+        *size += sizeof(int) + AlignedSize(value.GetBlob().size());
+        return true;
+      case Value::Type::LIST:
+      case Value::Type::DICTIONARY: {
+        if (depth >= kMaxBinaryValueDepth)
+          return false;
+        const size_t index = contents_sizes_.size();
+        contents_sizes_.push_back(0);
+
+        // The number of entries, then the entries.
+        size_t contents_size = sizeof(uint32_t);
+        size_t entry_size;
+        if (value.is_list()) {
+          for (const Value& element : value.GetList()) {
+            if (!Measure(element, depth + 1, &entry_size))
+              return false;
+            contents_size += entry_size;
+          }
+        } else {
+          for (const auto item : value.DictItems()) {
+            if (!Measure(item.second, depth + 1, &entry_size))
+              return false;
+            contents_size +=
+                sizeof(int) + AlignedSize(item.first.size()) + entry_size;
+          }
+        }
+        if (contents_size > kMaxContentsSize)
+          return false;
+
+        contents_sizes_[index] = static_cast<int>(contents_size);
+        *size += sizeof(int) + contents_size;
+        return true;
+      }
+    }
+    NOTREACHED();
+    return false;
+  }
+
+  // Writes |value|, which must have been measured.
+  void Write(const Value& value, Pickle* pickle) {
+    switch (value.type()) {
+      case Value::Type::NONE:
+        WriteTag(Tag::kNone, pickle);
+        return;
+      case Value::Type::BOOLEAN:
+        WriteTag(Tag::kBool, pickle);
+        pickle->WriteBool(value.GetBool());
+        return;
+      case Value::Type::INTEGER:
+        WriteTag(Tag::kInt, pickle);
+        pickle->WriteInt(value.GetInt());
+        return;
+      case Value::Type::DOUBLE:
+        WriteTag(Tag::kDouble, pickle);
+        pickle->WriteDouble(value.GetDouble());
+        return;
+      case Value::Type::STRING:
+        WriteTag(Tag::kString, pickle);
+        pickle->WriteString(value.GetString());
+        return;
+      case Value::Type::BINARY:
+        WriteTag(Tag::kBlob, pickle);
+        pickle->WriteData(reinterpret_cast<const char*>(value.GetBlob().data()),
+                          static_cast<int>(value.GetBlob().size()));
+        return;
+      case Value::Type::LIST:
+        WriteTag(Tag::kList, pickle);
+        pickle->WriteInt(contents_sizes_[next_contents_++]);
+        pickle->WriteUInt32(static_cast<uint32_t>(value.GetList().size()));
+        for (const Value& element : value.GetList())
+          Write(element, pickle);
+        return;
+      case Value::Type::DICTIONARY:
+        WriteTag(Tag::kDictionary, pickle);
+        pickle->WriteInt(contents_sizes_[next_contents_++]);
+        pickle->WriteUInt32(static_cast<uint32_t>(value.DictSize()));
+        // Keys are written in sorted order, which lets readers stop looking
+        // for a key early.
+        for (const auto item : value.DictItems()) {
+          pickle->WriteString(item.first);
+          Write(item.second, pickle);
+        }
+        return;
+    }
+    NOTREACHED();
+  }
+
+ private:
+  static void WriteTag(Tag tag, Pickle* pickle) {
+    pickle->WriteUInt32(static_cast<uint32_t>(tag));
+  }
+
+  // The sizes of the contents of the lists and dictionaries, in the order
+  // they are written.
+  std::vector<int> contents_sizes_;
+  size_t next_contents_ = 0;
+};
+
+}  // namespace
+
+bool WriteValueToPickle(const Value& value, Pickle* pickle) {
+  Encoder encoder;
+  size_t size;
+  if (!encoder.Measure(value, 0, &size) || size > kMaxContentsSize)
+    return false;
+  size += 2 * sizeof(uint32_t);
+
+  const size_t start_size = pickle->payload_size();
+  pickle->Reserve(size);
+  pickle->WriteUInt32(kMagic);
+  pickle->WriteUInt32(kVersion);
+  encoder.Write(value, pickle);
+  DCHECK_EQ(size, pickle->payload_size() - start_size);
+  return true;
+}
+
+absl::optional<std::vector<uint8_t>> ValueToBinary(const Value& value) {
+  Pickle pickle;
+  if (!WriteValueToPickle(value, &pickle))
+    return absl::nullopt;
+  const uint8_t* data = static_cast<const uint8_t*>(pickle.data());
+  return std::vector<uint8_t>(data, data + pickle.size());
+}
+
+absl::optional<Value> BinaryToValue(span<const uint8_t> data) {
+  absl::optional<BinaryValueView> view = BinaryValueView::Create(data);
+  if (!view)
+    return absl::nullopt;
+  return view->ToValue();
+}
+
+BinaryValueView::BinaryValueView() : type_(Value::Type::NONE), int_value_(0) {}
+
+// static
+absl::optional<BinaryValueView> BinaryValueView::Create(
+    span<const uint8_t> data) {
+  // This Pickle refers to |data| without copying it.
+  DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(data.data()) % sizeof(uint32_t));
+  Pickle pickle(reinterpret_cast<const char*>(data.data()), data.size());
+  if (pickle.size() != data.size())
+    return absl::nullopt;
+
+  PickleIterator iter(pickle);
+  absl::optional<BinaryValueView> view = Create(&iter);
+  if (!view || !iter.ReachedEnd())
+    return absl::nullopt;
+  return view;
+}
+
+// static
+absl::optional<BinaryValueView> BinaryValueView::Create(PickleIterator* iter) {
+  uint32_t magic;
+  uint32_t version;
+  BinaryValueView view;
+  if (!iter->ReadUInt32(&magic) || magic != kMagic ||
+      !iter->ReadUInt32(&version) || version != kVersion ||
+      !ReadValue(iter, &view)) {
+    return absl::nullopt;
+  }
+  return view;
+}
+
+absl::optional<bool> BinaryValueView::GetIfBool() const {
+  if (type_ != Value::Type::BOOLEAN)
+    return absl::nullopt;
+  return bool_value_;
+}
+
+absl::optional<int> BinaryValueView::GetIfInt() const {
+  if (type_ != Value::Type::INTEGER)
+    return absl::nullopt;
+  return int_value_;
+}
+
+absl::optional<double> BinaryValueView::GetIfDouble() const {
+  if (type_ == Value::Type::INTEGER)
+    return int_value_;
+  if (type_ != Value::Type::DOUBLE)
+    return absl::nullopt;
+  return double_value_;
+}
+
+absl::optional<StringPiece> BinaryValueView::GetIfString() const {
+  if (type_ != Value::Type::STRING ||
+      !IsStringUTF8AllowingNoncharacters(data_)) {
+    return absl::nullopt;
+  }
+  return data_;
+}
+
+absl::optional<span<const uint8_t>> BinaryValueView::GetIfBlob() const {
+  if (type_ != Value::Type::BINARY)
+    return absl::nullopt;
+  return as_bytes(make_span(data_.data(), data_.size()));
+}
+
+absl::optional<BinaryValueView> BinaryValueView::FindKey(
+    StringPiece key) const {
+  PickleIterator iter;
+  uint32_t count;
+  if (type_ != Value::Type::DICTIONARY || !IterateContents(&iter, &count))
+    return absl::nullopt;
+
+  for (uint32_t i = 0; i < count; ++i) {
+    StringPiece entry_key;
+    BinaryValueView entry_value;
+    if (!iter.ReadStringPiece(&entry_key) ||
+        !ReadValue(&iter, &entry_value)) {
+      return absl::nullopt;
+    }
+    if (entry_key == key)
+      return entry_value;
+    // Keys are sorted.
+    if (entry_key > key)
+      break;
+  }
+  return absl::nullopt;
+}
+
+absl::optional<BinaryValueView> BinaryValueView::FindPath(
+    StringPiece path) const {
+  absl::optional<BinaryValueView> cur = *this;
+  while (cur && !path.empty()) {
+    const size_t dot = path.find('.');
+    cur = cur->FindKey(path.substr(0, dot));
+    path = dot == StringPiece::npos ? StringPiece() : path.substr(dot + 1);
+  }
+  return cur;
+}
+
+absl::optional<Value> BinaryValueView::ToValue() const {
+  return ToValueAtDepth(0);
+}
+
+// static
+bool BinaryValueView::ReadValue(PickleIterator* iter, BinaryValueView* view) {
+  uint32_t tag;
+  if (!iter->ReadUInt32(&tag))
+    return false;
+
+  switch (static_cast<Tag>(tag)) {
+    case Tag::kNone:
+      view->type_ = Value::Type::NONE;
+      return true;
+    case Tag::kBool: {
+      // Pickle::ReadBool() would load the untrusted byte as a bool, which is
+      // undefined unless it is 0 or 1.
+      int value;
+      if (!iter->ReadInt(&value) || (value != 0 && value != 1))
+        return false;
+      view->type_ = Value::Type::BOOLEAN;
+      view->bool_value_ = value;
+      return true;
+    }
+    case Tag::kInt:
+      view->type_ = Value::Type::INTEGER;
+      return iter->ReadInt(&view->int_value_);
+    case Tag::kDouble:
+      view->type_ = Value::Type::DOUBLE;
+      return iter->ReadDouble(&view->double_value_);
+    case Tag::kString:
+      view->type_ = Value::Type::STRING;
+      return iter->ReadStringPiece(&view->data_);
+    case Tag::kBlob:
+    case Tag::kList:
+    case Tag::kDictionary: {
+      const char* data;
+      int length;
+      if (!iter->ReadData(&data, &length))
+        return false;
+      if (static_cast<Tag>(tag) == Tag::kBlob) {
+        view->type_ = Value::Type::BINARY;
+        view->data_ = StringPiece(data, length);
+      } else {
+        view->type_ = static_cast<Tag>(tag) == Tag::kList
+                          ? Value::Type::LIST
+                          : Value::Type::DICTIONARY;
+        // Include the length, which is the header of the nested pickle.
+        view->data_ = StringPiece(data - sizeof(Pickle::Header),
+                                  length + sizeof(Pickle::Header));
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+bool BinaryValueView::IterateContents(PickleIterator* iter,
+                                      uint32_t* count) const {
+  DCHECK(type_ == Value::Type::LIST || type_ == Value::Type::DICTIONARY);
+  // This Pickle refers to the contents without copying them.
+  Pickle contents(data_.data(), data_.size());
+  *iter = PickleIterator(contents);
+  return iter->ReadUInt32(count);
+}
+
+absl::optional<Value> BinaryValueView::ToValueAtDepth(size_t depth) const {
+  switch (type_) {
+    case Value::Type::NONE:
+      return Value();
+    case Value::Type::BOOLEAN:
+      return Value(bool_value_);
+    case Value::Type::INTEGER:
+      return Value(int_value_);
+    case Value::Type::DOUBLE:
+      return Value(double_value_);
+    case Value::Type::STRING:
+      if (!IsStringUTF8AllowingNoncharacters(data_))
+        return absl::nullopt;
+      return Value(data_);
+    case Value::Type::BINARY:
+      return Value(*GetIfBlob());
+    case Value::Type::LIST:
+    case Value::Type::DICTIONARY:
+      break;
+  }
+
+  PickleIterator iter;
+  uint32_t count;
+  if (depth >= kMaxBinaryValueDepth || !IterateContents(&iter, &count))
+    return absl::nullopt;
+  // Every entry takes at least four bytes, so this never reserves much more
+  // than the size of the encoding, even if |count| is bogus.
+  const size_t capacity = std::min<size_t>(count, data_.size() / 4);
+
+  if (type_ == Value::Type::LIST) {
+    Value::ListStorage list;
+    list.reserve(capacity);
+    for (uint32_t i = 0; i < count; ++i) {
+      BinaryValueView element;
+      if (!ReadValue(&iter, &element))
+        return absl::nullopt;
+      absl::optional<Value> value = element.ToValueAtDepth(depth + 1);
+      if (!value)
+        return absl::nullopt;
+      list.push_back(std::move(*value));
+    }
+    if (!iter.ReachedEnd())
+      return absl::nullopt;
+    return Value(std::move(list));
+  }
+
+  std::vector<Value::DictStorage::value_type> dict;
+  dict.reserve(capacity);
+  for (uint32_t i = 0; i < count; ++i) {
+    StringPiece key;
+    BinaryValueView entry_value;
+    // Keys must be sorted and unique, as they are written.
+    if (!iter.ReadStringPiece(&key) ||
+        (!dict.empty() && dict.back().first >= key) ||
+        !IsStringUTF8AllowingNoncharacters(key) ||
+        !ReadValue(&iter, &entry_value)) {
+      return absl::nullopt;
+    }
+    absl::optional<Value> value = entry_value.ToValueAtDepth(depth + 1);
+    if (!value)
+      return absl::nullopt;
+    dict.emplace_back(std::string(key), std::move(*value));
+  }
+  if (!iter.ReachedEnd())
+    return absl::nullopt;
+  return Value(Value::DictStorage(sorted_unique, std::move(dict)));
+}
+
+}  // namespace base
@@ -0,0 +1,134 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// A binary encoding of base::Value that is fast to decode, for persisting and
+// shipping large values that would otherwise be written as JSON and parsed back
+// at startup. It is not compact: padding every field to 4 bytes makes it about
+// 1.6 times as large as JSON.
+//
+// The encoding is a Pickle: every value is a type tag followed by its data,
+// and lists and dictionaries are prefixed with their size in bytes, so they
+// can be skipped without being decoded. Nothing in it depends on where it is
+// located, so an encoding written to a file can be memory-mapped and read in
+// place with BinaryValueView, as long as it starts at a 4-byte aligned address,
+// since it is read with aligned loads:
+//
+//   base::MemoryMappedFile file;
+//   if (file.Initialize(path)) {
+//     absl::optional<base::BinaryValueView> root =
+//         base::BinaryValueView::Create(
+//             base::make_span(file.data(), file.length()));
+//     if (root) {
+//       absl::optional<base::BinaryValueView> value =
+//           root->FindPath("some.setting");
+//       ...
+//     }
+//   }
+//
+// Encodings are not meant to be portable across architectures of different
+// endianness. Decoding validates its input and fails on malformed data.
+
+#ifndef BASE_BINARY_VALUE_SERIALIZER_H_
+#define BASE_BINARY_VALUE_SERIALIZER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/containers/span.h"
+#include "base/strings/string_piece.h"
+#include "base/values.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+
+class Pickle;
+class PickleIterator;
+
+// Values nested deeper than this can neither be encoded nor decoded, which
+// bounds the recursion on untrusted input.
+constexpr size_t kMaxBinaryValueDepth = 200;
+
+// Appends the encoding of |value| to |pickle|. Returns false, without
+// modifying |pickle|, if |value| is nested too deeply or too large to encode.
+BASE_EXPORT bool WriteValueToPickle(const Value& value, Pickle* pickle);
+
+// Returns the encoding of |value|, or nullopt if it can't be encoded. The
+// result is a serialized Pickle, as from Pickle::data().
+BASE_EXPORT absl::optional<std::vector<uint8_t>> ValueToBinary(
+    const Value& value);
+
+// Decodes the Value encoded in |data|, which must be 4-byte aligned, or
+// returns nullopt if |data| is not a valid encoding.
+BASE_EXPORT absl::optional<Value> BinaryToValue(span<const uint8_t> data);
+
+// A lazily decoded view of an encoded Value, pointing into the encoding, which
+// must outlive it. Looking up a key only reads the keys before it in its
+// dictionary; the values of other keys are skipped without being decoded.
+class BASE_EXPORT BinaryValueView {
+ public:
+  // Returns a view of the Value encoded in |data|, or nullopt if |data| is not
+  // an encoding. |data| must be 4-byte aligned. The contents of lists and
+  // dictionaries are only validated as they are read.
+  static absl::optional<BinaryValueView> Create(span<const uint8_t> data);
+
+  // Like above, for a value written by WriteValueToPickle() at the position of
+  // |iter|, which is advanced past it. The view points into the pickle.
+  static absl::optional<BinaryValueView> Create(PickleIterator* iter);
+
+  BinaryValueView(const BinaryValueView&) = default;
+  BinaryValueView& operator=(const BinaryValueView&) = default;
+
+  Value::Type type() const { return type_; }
+
+  // These return nullopt if the type does not match, or for a string that is
+  // not valid UTF-8. The returned string or blob points into the encoding.
+  absl::optional<bool> GetIfBool() const;
+  absl::optional<int> GetIfInt() const;
+  // Implicitly converts from int if necessary.
+  absl::optional<double> GetIfDouble() const;
+  absl::optional<StringPiece> GetIfString() const;
+  absl::optional<span<const uint8_t>> GetIfBlob() const;
+
+  // Returns the value of |key| in a dictionary, or nullopt if it is missing,
+  // this is not a dictionary, or the dictionary is malformed.
+  absl::optional<BinaryValueView> FindKey(StringPiece key) const;
+
+  // Like Value::FindPath(), returns the value at a '.'-separated |path| of
+  // keys in nested dictionaries.
+  absl::optional<BinaryValueView> FindPath(StringPiece path) const;
+
+  // Decodes the whole value, or returns nullopt if it is malformed.
+  absl::optional<Value> ToValue() const;
+
+ private:
+  BinaryValueView();
+
+  // Reads the value at the position of |iter| into |view|.
+  static bool ReadValue(PickleIterator* iter, BinaryValueView* view);
+
+  // Sets |iter| to the entries of a list or dictionary and reads their number
+  // into |count|. Returns false if this is not a valid list or dictionary.
+  bool IterateContents(PickleIterator* iter, uint32_t* count) const;
+
+  absl::optional<Value> ToValueAtDepth(size_t depth) const;
+
+  Value::Type type_;
+
+  union {
+    bool bool_value_;
+    int int_value_;
+    double double_value_;
+  };
+
+  // The bytes of a string or blob, or, for a list or dictionary, the nested
+  // pickle holding its entries.
+  StringPiece data_;
+};
+
+}  // namespace base
+
+#endif  // BASE_BINARY_VALUE_SERIALIZER_H_
@@ -0,0 +1,121 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/binary_value_serializer.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+
+namespace {
+
+constexpr char kMetricPrefix[] = "BinaryValueSerializer.";
+constexpr char kMetricJSONWriteTime[] = "json_write_time";
+constexpr char kMetricJSONReadTime[] = "json_read_time";
+constexpr char kMetricJSONSize[] = "json_size";
+constexpr char kMetricBinaryWriteTime[] = "binary_write_time";
+constexpr char kMetricBinaryReadTime[] = "binary_read_time";
+constexpr char kMetricBinaryFindPathTime[] = "binary_find_path_time";
+constexpr char kMetricBinarySize[] = "binary_size";
+
+perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
+  perf_test::PerfResultReporter reporter(kMetricPrefix, story_name);
+  reporter.RegisterImportantMetric(kMetricJSONWriteTime, "ms");
+  reporter.RegisterImportantMetric(kMetricJSONReadTime, "ms");
+  reporter.RegisterImportantMetric(kMetricJSONSize, "bytes");
+  reporter.RegisterImportantMetric(kMetricBinaryWriteTime, "ms");
+  reporter.RegisterImportantMetric(kMetricBinaryReadTime, "ms");
+  reporter.RegisterImportantMetric(kMetricBinaryFindPathTime, "ms");
+  reporter.RegisterImportantMetric(kMetricBinarySize, "bytes");
+  return reporter;
+}
+
+// Generates a tree of dictionaries with |breadth| children per level, each
+// holding a few scalars, a string and a list.
+Value GenerateLayeredDict(int breadth, int depth) {
+  Value root(Value::Type::DICTIONARY);
+  root.SetDoubleKey("Double", 3.141);
+  root.SetBoolKey("Bool", true);
+  root.SetIntKey("Int", 42);
+  root.SetStringKey("String", "A string of moderate length");
+  Value list(Value::Type::LIST);
+  list.Append(2.718);
+  list.Append(false);
+  list.Append(123);
+  list.Append("Bar");
+  root.SetKey("List", std::move(list));
+
+  if (depth > 1) {
+    Value child = GenerateLayeredDict(breadth, depth - 1);
+    for (int i = 0; i < breadth; ++i)
+      root.SetKey("Dict" + NumberToString(i), child.Clone());
+  }
+  return root;
+}
+
+void TestEncodings(int breadth, int depth) {
+  auto reporter = SetUpReporter("breadth_" + NumberToString(breadth) +
+                                "_depth_" + NumberToString(depth));
+  const Value value = GenerateLayeredDict(breadth, depth);
+
+  std::string json;
+  TimeTicks start = TimeTicks::Now();
+  ASSERT_TRUE(JSONWriter::Write(value, &json));
+  reporter.AddResult(kMetricJSONWriteTime, TimeTicks::Now() - start);
+  reporter.AddResult(kMetricJSONSize, json.size());
+
+  start = TimeTicks::Now();
+  absl::optional<Value> from_json = JSONReader::Read(json);
+  reporter.AddResult(kMetricJSONReadTime, TimeTicks::Now() - start);
+  ASSERT_TRUE(from_json);
+
+  start = TimeTicks::Now();
+  absl::optional<std::vector<uint8_t>> binary = ValueToBinary(value);
+  reporter.AddResult(kMetricBinaryWriteTime, TimeTicks::Now() - start);
+  ASSERT_TRUE(binary);
+  reporter.AddResult(kMetricBinarySize, binary->size());
+
+  start = TimeTicks::Now();
+  absl::optional<Value> from_binary = BinaryToValue(*binary);
+  reporter.AddResult(kMetricBinaryReadTime, TimeTicks::Now() - start);
+  ASSERT_TRUE(from_binary);
+  EXPECT_EQ(*from_json, *from_binary);
+
+  // Look up the last leaf, which skips all its siblings at every level.
+  std::string path;
+  for (int i = 1; i < depth; ++i)
+    path += "Dict" + NumberToString(breadth - 1) + ".";
+  path += "Int";
+  start = TimeTicks::Now();
+  absl::optional<BinaryValueView> root = BinaryValueView::Create(*binary);
+  absl::optional<BinaryValueView> leaf;
+  if (root)
+    leaf = root->FindPath(path);
+  reporter.AddResult(kMetricBinaryFindPathTime, TimeTicks::Now() - start);
+  ASSERT_TRUE(leaf);
+  EXPECT_EQ(42, leaf->GetIfInt());
+}
+
+}  // namespace
+
+TEST(BinaryValueSerializerPerfTest, LayeredDict) {
+  for (int breadth = 2; breadth <= 4; ++breadth) {
+    for (int depth = 1; depth <= 8; ++depth)
+      TestEncodings(breadth, depth);
+  }
+}
+
+}  // namespace base
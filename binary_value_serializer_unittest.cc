@@ -0,0 +1,207 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/binary_value_serializer.h"
+
+#include <string.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/json/json_reader.h"
+#include "base/pickle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+Value CreateTestValue() {
+  absl::optional<Value> value = JSONReader::Read(R"({
+    "null": null,
+    "bool": true,
+    "int": -42,
+    "double": 3.25,
+    "string": "héllo",
+    "empty": "",
+    "list": [1, "two", [3.5, false], {}],
+    "dict": {"a": {"b": {"c": 7}}, "z": []}
+  })");
+  CHECK(value);
+  const uint8_t kBlob[] = {0, 1, 2, 3, 4};
+  value->SetKey("blob", Value(make_span(kBlob)));
+  return std::move(*value);
+}
+
+}  // namespace
+
+TEST(BinaryValueSerializerTest, RoundTrip) {
+  const Value value = CreateTestValue();
+  absl::optional<std::vector<uint8_t>> binary = ValueToBinary(value);
+  ASSERT_TRUE(binary);
+  EXPECT_EQ(value, BinaryToValue(*binary));
+
+  // Scalars and empty containers at the root.
+  for (const Value& root :
+       {Value(), Value(false), Value(1), Value(-0.5), Value("root"),
+        Value(Value::Type::LIST), Value(Value::Type::DICTIONARY)}) {
+    binary = ValueToBinary(root);
+    ASSERT_TRUE(binary);
+    EXPECT_EQ(root, BinaryToValue(*binary));
+  }
+}
+
+TEST(BinaryValueSerializerTest, View) {
+  absl::optional<std::vector<uint8_t>> binary =
+      ValueToBinary(CreateTestValue());
+  ASSERT_TRUE(binary);
+  absl::optional<BinaryValueView> root = BinaryValueView::Create(*binary);
+  ASSERT_TRUE(root);
+  EXPECT_EQ(Value::Type::DICTIONARY, root->type());
+
+  EXPECT_EQ(Value::Type::NONE, root->FindKey("null")->type());
+  EXPECT_EQ(true, root->FindKey("bool")->GetIfBool());
+  EXPECT_EQ(-42, root->FindKey("int")->GetIfInt());
+  EXPECT_EQ(-42.0, root->FindKey("int")->GetIfDouble());
+  EXPECT_EQ(3.25, root->FindKey("double")->GetIfDouble());
+  EXPECT_FALSE(root->FindKey("double")->GetIfInt());
+  EXPECT_EQ("h\xc3\xa9llo", root->FindKey("string")->GetIfString());
+  EXPECT_EQ("", root->FindKey("empty")->GetIfString());
+  absl::optional<span<const uint8_t>> blob = root->FindKey("blob")->GetIfBlob();
+  ASSERT_TRUE(blob);
+  EXPECT_EQ(std::vector<uint8_t>({0, 1, 2, 3, 4}),
+            std::vector<uint8_t>(blob->begin(), blob->end()));
+
+  EXPECT_EQ(7, root->FindPath("dict.a.b.c")->GetIfInt());
+  EXPECT_EQ(Value::Type::LIST, root->FindPath("dict.z")->type());
+  EXPECT_FALSE(root->FindPath("dict.a.x"));
+  EXPECT_FALSE(root->FindPath("dict.a.b.c.d"));
+  EXPECT_FALSE(root->FindKey("missing"));
+  EXPECT_FALSE(root->FindKey("list")->FindKey("0"));
+  EXPECT_EQ(Value::Type::DICTIONARY, root->FindPath("")->type());
+
+  absl::optional<Value> list = root->FindKey("list")->ToValue();
+  ASSERT_TRUE(list);
+  EXPECT_EQ(*CreateTestValue().FindKey("list"), *list);
+}
+
+TEST(BinaryValueSerializerTest, ViewOfCopy) {
+  absl::optional<std::vector<uint8_t>> binary =
+      ValueToBinary(CreateTestValue());
+  ASSERT_TRUE(binary);
+  // The encoding can be read from anywhere, e.g. a memory-mapped file.
+  std::vector<uint8_t> copy(binary->size() + 4);
+  std::copy(binary->begin(), binary->end(), copy.begin() + 4);
+  absl::optional<BinaryValueView> root =
+      BinaryValueView::Create(make_span(copy).subspan(4));
+  ASSERT_TRUE(root);
+  EXPECT_EQ(CreateTestValue(), root->ToValue());
+}
+
+TEST(BinaryValueSerializerTest, WithinPickle) {
+  Pickle pickle;
+  pickle.WriteInt(1);
+  ASSERT_TRUE(WriteValueToPickle(CreateTestValue(), &pickle));
+  pickle.WriteInt(2);
+
+  PickleIterator iter(pickle);
+  int before;
+  ASSERT_TRUE(iter.ReadInt(&before));
+  absl::optional<BinaryValueView> view = BinaryValueView::Create(&iter);
+  ASSERT_TRUE(view);
+  int after;
+  ASSERT_TRUE(iter.ReadInt(&after));
+  EXPECT_EQ(2, after);
+  EXPECT_EQ(CreateTestValue(), view->ToValue());
+}
+
+TEST(BinaryValueSerializerTest, Malformed) {
+  absl::optional<std::vector<uint8_t>> binary =
+      ValueToBinary(CreateTestValue());
+  ASSERT_TRUE(binary);
+
+  EXPECT_FALSE(BinaryToValue({}));
+  // Every truncation is rejected.
+  for (size_t size = 0; size < binary->size(); ++size)
+    EXPECT_FALSE(BinaryToValue(make_span(binary->data(), size))) << size;
+  // So is trailing data.
+  std::vector<uint8_t> longer = *binary;
+  longer.resize(longer.size() + 4);
+  EXPECT_FALSE(BinaryToValue(longer));
+
+  // Corrupting any byte must not crash; it may or may not be detected.
+  for (size_t i = 0; i < binary->size(); ++i) {
+    std::vector<uint8_t> corrupt = *binary;
+    corrupt[i] ^= 0x5a;
+    absl::optional<BinaryValueView> view = BinaryValueView::Create(corrupt);
+    if (view) {
+      view->ToValue();
+      view->FindPath("dict.a.b.c");
+    }
+  }
+}
+
+// A boolean is encoded as an int, which must be 0 or 1.
+TEST(BinaryValueSerializerTest, MalformedBool) {
+  absl::optional<std::vector<uint8_t>> binary = ValueToBinary(Value(true));
+  ASSERT_TRUE(binary);
+  EXPECT_EQ(Value(true), BinaryToValue(*binary));
+
+  // The int is at the end of the encoding.
+  const size_t int_offset = binary->size() - sizeof(int);
+  for (int value : {2, -1, 0x100}) {
+    std::vector<uint8_t> corrupt = *binary;
+    memcpy(corrupt.data() + int_offset, &value, sizeof(int));
+    EXPECT_FALSE(BinaryToValue(corrupt)) << value;
+    EXPECT_FALSE(BinaryValueView::Create(corrupt)) << value;
+  }
+
+  const int kFalse = 0;
+  memcpy(binary->data() + int_offset, &kFalse, sizeof(int));
+  EXPECT_EQ(Value(false), BinaryToValue(*binary));
+}
+
+TEST(BinaryValueSerializerTest, UnsortedKeys) {
+  Value dict(Value::Type::DICTIONARY);
+  dict.SetIntKey("a", 1);
+  dict.SetIntKey("b", 2);
+  absl::optional<std::vector<uint8_t>> binary = ValueToBinary(dict);
+  ASSERT_TRUE(binary);
+
+  // Swap the keys, which are the same size and are each followed by the same
+  // number of bytes.
+  const std::string encoding(binary->begin(), binary->end());
+  const size_t a = encoding.find('a');
+  const size_t b = encoding.find('b');
+  ASSERT_NE(std::string::npos, a);
+  ASSERT_NE(std::string::npos, b);
+  std::swap((*binary)[a], (*binary)[b]);
+  EXPECT_FALSE(BinaryToValue(*binary));
+
+  // Duplicate keys.
+  (*binary)[b] = 'b';
+  EXPECT_FALSE(BinaryToValue(*binary));
+}
+
+TEST(BinaryValueSerializerTest, MaxDepth) {
+  Value value(Value::Type::LIST);
+  for (size_t i = 1; i < kMaxBinaryValueDepth; ++i) {
+    Value list(Value::Type::LIST);
+    list.Append(std::move(value));
+    value = std::move(list);
+  }
+  absl::optional<std::vector<uint8_t>> binary = ValueToBinary(value);
+  ASSERT_TRUE(binary);
+  EXPECT_EQ(value, BinaryToValue(*binary));
+
+  Value deeper(Value::Type::LIST);
+  deeper.Append(std::move(value));
+  Pickle pickle;
+  EXPECT_FALSE(WriteValueToPickle(deeper, &pickle));
+  EXPECT_EQ(0u, pickle.payload_size());
+  EXPECT_FALSE(ValueToBinary(deeper));
+}
+
+}  // namespace base
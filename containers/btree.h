@@ -0,0 +1,1108 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_CONTAINERS_BTREE_H_
+#define BASE_CONTAINERS_BTREE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "base/check.h"
+#include "base/check_op.h"
+#include "base/compiler_specific.h"
+#include "base/containers/flat_tree.h"
+#include "build/build_config.h"
+
+namespace base {
+namespace internal {
+
+// btree is the B-tree behind btree_map and btree_set. Unlike a binary tree,
+// each node holds many values in a sorted array, so that a lookup touches a
+// few nodes that are each a few cache lines long, and the tree makes one
+// allocation per node rather than one per value.
+//
+// Values are in all the nodes. An internal node with N values has N + 1
+// children, the values of child i being between values i - 1 and i of the
+// node. All the leaves are at the same depth. A full node splits in two when a
+// value is inserted into it, and a node that falls under half full after an
+// erase is merged with a sibling, or takes values from it, so that nodes are
+// at least half full but for the root and those at the ends of the tree.
+
+// Nodes are about eight cache lines long: large enough that a lookup visits few
+// nodes, and small enough that inserting into a node, which shifts the values
+// after the new one, stays cheap. Lookups prefetch each node as a whole, so
+// that its cache lines are fetched together rather than one per comparison
+// (see btree_map_perftest.cc).
+constexpr size_t kBTreeTargetNodeSize = 512;
+
+template <class Value>
+class BTreeInternalNode;
+
+template <class Value>
+class BTreeNode {
+ public:
+  using InternalNode = BTreeInternalNode<Value>;
+
+  // The number of values that a node holds, at least 3 so that a node can be
+  // split into two nodes and a value for their parent, and at most 255 so
+  // that counts fit in a byte.
+  static constexpr size_t kNodeSlots = std::min<size_t>(
+      255,
+      std::max<size_t>(3,
+                       (kBTreeTargetNodeSize - sizeof(void*) - 4) /
+                           sizeof(Value)));
+
+  explicit BTreeNode(bool is_leaf) : is_leaf_(is_leaf) {}
+  BTreeNode(const BTreeNode&) = delete;
+  BTreeNode& operator=(const BTreeNode&) = delete;
+
+  bool is_leaf() const { return is_leaf_; }
+
+  // The parent of the root is null.
+  InternalNode* parent() const { return parent_; }
+  // The index of this node among the children of its parent.
+  size_t position() const { return position_; }
+  // Makes this node the root.
+  void clear_parent() {
+    parent_ = nullptr;
+    position_ = 0;
+  }
+
+  size_t count() const { return count_; }
+  void set_count(size_t count) {
+    DCHECK_LE(count, kNodeSlots);
+    count_ = static_cast<uint8_t>(count);
+  }
+
+  Value* value(size_t i) { return reinterpret_cast<Value*>(&values_[i]); }
+  const Value* value(size_t i) const {
+    return reinterpret_cast<const Value*>(&values_[i]);
+  }
+
+  // Brings the values of this node into the cache.
+  void Prefetch() const {
+#if defined(__clang__) || defined(COMPILER_GCC)
+    for (size_t offset = 0; offset < sizeof(BTreeNode); offset += 64)
+      __builtin_prefetch(reinterpret_cast<const char*>(this) + offset);
+#endif
+  }
+
+  // Only for internal nodes.
+  BTreeNode* child(size_t i) const;
+  InternalNode* AsInternal();
+
+  // Moves value |i| of |src| to the uninitialized slot |j| of |dest|.
+  static void TransferValue(BTreeNode* dest,
+                            size_t j,
+                            BTreeNode* src,
+                            size_t i) {
+    new (dest->value(j)) Value(std::move(*src->value(i)));
+    src->value(i)->~Value();
+  }
+
+ private:
+  friend class BTreeInternalNode<Value>;
+
+  InternalNode* parent_ = nullptr;
+  uint8_t position_ = 0;
+  uint8_t count_ = 0;
+  const bool is_leaf_;
+  std::aligned_storage_t<sizeof(Value), alignof(Value)> values_[kNodeSlots];
+};
+
+template <class Value>
+constexpr size_t BTreeNode<Value>::kNodeSlots;
+
+template <class Value>
+class BTreeInternalNode : public BTreeNode<Value> {
+ public:
+  using Node = BTreeNode<Value>;
+
+  BTreeInternalNode() : Node(/*is_leaf=*/false) {}
+
+  Node* child(size_t i) const { return children_[i]; }
+
+  // Makes |child| the child |i| of this node.
+  void set_child(size_t i, Node* child) {
+    children_[i] = child;
+    child->parent_ = this;
+    child->position_ = static_cast<uint8_t>(i);
+  }
+
+ private:
+  Node* children_[Node::kNodeSlots + 1];
+};
+
+template <class Value>
+BTreeNode<Value>* BTreeNode<Value>::child(size_t i) const {
+  DCHECK(!is_leaf_);
+  return static_cast<const InternalNode*>(this)->child(i);
+}
+
+template <class Value>
+BTreeInternalNode<Value>* BTreeNode<Value>::AsInternal() {
+  DCHECK(!is_leaf_);
+  return static_cast<InternalNode*>(this);
+}
+
+// Points at value |position| of |node|. The end iterator points past the last
+// value of the last leaf.
+template <class Value, class T>
+class BTreeIterator {
+ public:
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = std::remove_const_t<T>;
+  using difference_type = ptrdiff_t;
+  using pointer = T*;
+  using reference = T&;
+
+  BTreeIterator() = default;
+
+  // Converts iterators to const_iterators.
+  template <class U,
+            class = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+  BTreeIterator(const BTreeIterator<Value, U>& other)  // NOLINT
+      : node_(other.node_), position_(other.position_) {}
+
+  reference operator*() const { return *node_->value(position_); }
+  pointer operator->() const { return node_->value(position_); }
+
+  BTreeIterator& operator++() {
+    if (node_->is_leaf() && ++position_ < node_->count())
+      return *this;
+    IncrementSlow();
+    return *this;
+  }
+  BTreeIterator operator++(int) {
+    BTreeIterator old = *this;
+    ++*this;
+    return old;
+  }
+
+  BTreeIterator& operator--() {
+    if (node_->is_leaf() && position_ > 0) {
+      --position_;
+      return *this;
+    }
+    DecrementSlow();
+    return *this;
+  }
+  BTreeIterator operator--(int) {
+    BTreeIterator old = *this;
+    --*this;
+    return old;
+  }
+
+  friend bool operator==(const BTreeIterator& a, const BTreeIterator& b) {
+    return a.node_ == b.node_ && a.position_ == b.position_;
+  }
+  friend bool operator!=(const BTreeIterator& a, const BTreeIterator& b) {
+    return !(a == b);
+  }
+
+ private:
+  using Node = BTreeNode<Value>;
+
+  template <class V, class U>
+  friend class BTreeIterator;
+  template <class Key, class V, class GetKeyFromValue, class KeyCompare>
+  friend class btree;
+
+  BTreeIterator(Node* node, size_t position)
+      : node_(node), position_(position) {}
+
+  void IncrementSlow() {
+    if (node_->is_leaf()) {
+      // Past the last value of a leaf, the next one is in the first ancestor
+      // that the leaf is not at the end of. The last leaf has none, and stays
+      // where it is, at end().
+      Node* node = node_;
+      size_t position = position_;
+      while (position == node->count() && node->parent()) {
+        position = node->position();
+        node = node->parent();
+      }
+      if (position < node->count()) {
+        node_ = node;
+        position_ = position;
+      }
+      return;
+    }
+    // The next value of an internal node is the first of its next subtree.
+    node_ = node_->child(position_ + 1);
+    while (!node_->is_leaf())
+      node_ = node_->child(0);
+    position_ = 0;
+  }
+
+  void DecrementSlow() {
+    if (node_->is_leaf()) {
+      while (position_ == 0) {
+        DCHECK(node_->parent());
+        position_ = node_->position();
+        node_ = node_->parent();
+      }
+      --position_;
+      return;
+    }
+    node_ = node_->child(position_);
+    while (!node_->is_leaf())
+      node_ = node_->child(node_->count());
+    position_ = node_->count() - 1;
+  }
+
+  Node* node_ = nullptr;
+  size_t position_ = 0;
+};
+
+// Keys are ordered with KeyCompare, which can be transparent to allow lookups
+// with other types than |Key|. GetKeyFromValue extracts the key of a value.
+//
+// A set is a tree whose Value is its Key, and only has const iterators.
+template <class Key, class Value, class GetKeyFromValue, class KeyCompare>
+class btree {
+ private:
+  using Node = BTreeNode<Value>;
+  using InternalNode = BTreeInternalNode<Value>;
+
+ public:
+  // --------------------------------------------------------------------------
+  // Types.
+
+  using key_type = Key;
+  using key_compare = KeyCompare;
+  using value_type = Value;
+
+  // Wraps the templated key comparison to compare values.
+  struct value_compare {
+    bool operator()(const value_type& left, const value_type& right) const {
+      GetKeyFromValue extractor;
+      return comp(extractor(left), extractor(right));
+    }
+
+    NO_UNIQUE_ADDRESS key_compare comp;
+  };
+
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using iterator = BTreeIterator<
+      Value,
+      std::conditional_t<std::is_same<Key, Value>::value, const Value, Value>>;
+  using const_iterator = BTreeIterator<Value, const Value>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  // --------------------------------------------------------------------------
+  // Lifetime.
+  //
+  // Constructors that take ranges take O(N) for sorted ranges, and
+  // O(N * log(N)) otherwise. They keep the first of values with equal keys.
+  //
+  // When passing the base::sorted_unique tag as the first argument, the range
+  // must be sorted and have no duplicates, and the tree is built from it
+  // without comparing the keys.
+
+  btree() = default;
+
+  explicit btree(const key_compare& comp) : comp_(comp) {}
+
+  template <class InputIterator>
+  btree(InputIterator first,
+        InputIterator last,
+        const key_compare& comp = key_compare())
+      : comp_(comp) {
+    insert(first, last);
+  }
+
+  btree(std::initializer_list<value_type> ilist,
+        const key_compare& comp = key_compare())
+      : btree(ilist.begin(), ilist.end(), comp) {}
+
+  template <class InputIterator>
+  btree(sorted_unique_t,
+        InputIterator first,
+        InputIterator last,
+        const key_compare& comp = key_compare())
+      : comp_(comp) {
+    for (; first != last; ++first) {
+      DCHECK(empty() || comp_(GetKeyFromValue()(*rbegin()),
+                              GetKeyFromValue()(*first)));
+      InsertBefore(end(), *first);
+    }
+  }
+
+  btree(sorted_unique_t,
+        std::initializer_list<value_type> ilist,
+        const key_compare& comp = key_compare())
+      : btree(sorted_unique, ilist.begin(), ilist.end(), comp) {}
+
+  btree(const btree& other) : comp_(other.comp_) {
+    for (const value_type& value : other)
+      InsertBefore(end(), value);
+  }
+
+  btree(btree&& other) noexcept
+      : root_(std::exchange(other.root_, nullptr)),
+        leftmost_(std::exchange(other.leftmost_, nullptr)),
+        rightmost_(std::exchange(other.rightmost_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        num_leaf_nodes_(std::exchange(other.num_leaf_nodes_, 0)),
+        num_internal_nodes_(std::exchange(other.num_internal_nodes_, 0)),
+        comp_(other.comp_) {}
+
+  ~btree() { clear(); }
+
+  // --------------------------------------------------------------------------
+  // Assignments.
+
+  btree& operator=(const btree& other) {
+    if (this != &other) {
+      btree copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  btree& operator=(btree&& other) noexcept {
+    btree moved(std::move(other));
+    swap(moved);
+    return *this;
+  }
+
+  // Takes the first if there are duplicates in the initializer list.
+  btree& operator=(std::initializer_list<value_type> ilist) {
+    clear();
+    insert(ilist.begin(), ilist.end());
+    return *this;
+  }
+
+  // --------------------------------------------------------------------------
+  // Size management.
+
+  void clear() {
+    if (root_)
+      DeleteSubtree(root_);
+    root_ = leftmost_ = rightmost_ = nullptr;
+    size_ = 0;
+  }
+
+  size_t size() const { return size_; }
+  size_t max_size() const { return std::numeric_limits<ptrdiff_t>::max(); }
+  bool empty() const { return !size_; }
+
+  // The number of bytes allocated for the nodes.
+  size_t bytes_used() const {
+    return num_leaf_nodes_ * sizeof(Node) +
+           num_internal_nodes_ * sizeof(InternalNode);
+  }
+
+  // --------------------------------------------------------------------------
+  // Iterators.
+  //
+  // Iterators follow the ordering defined by the key comparator used in
+  // construction of the btree.
+
+  iterator begin() { return iterator(leftmost_, 0); }
+  const_iterator begin() const { return const_cast<btree*>(this)->begin(); }
+  const_iterator cbegin() const { return begin(); }
+
+  iterator end() {
+    return iterator(rightmost_, rightmost_ ? rightmost_->count() : 0);
+  }
+  const_iterator end() const { return const_cast<btree*>(this)->end(); }
+  const_iterator cend() const { return end(); }
+
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
+  const_reverse_iterator crbegin() const { return rbegin(); }
+
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
+  const_reverse_iterator crend() const { return rend(); }
+
+  // --------------------------------------------------------------------------
+  // Insert operations.
+  //
+  // Assume that every operation invalidates iterators and references, as
+  // values move between nodes when they split. Insertion of one element takes
+  // O(log(size)), or O(1) amortized with a hint that is right.
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return emplace_key_args(GetKeyFromValue()(value), value);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return emplace_key_args(GetKeyFromValue()(value), std::move(value));
+  }
+
+  iterator insert(const_iterator position_hint, const value_type& value) {
+    return emplace_hint_key_args(position_hint, GetKeyFromValue()(value),
+                                 value)
+        .first;
+  }
+
+  iterator insert(const_iterator position_hint, value_type&& value) {
+    return emplace_hint_key_args(position_hint, GetKeyFromValue()(value),
+                                 std::move(value))
+        .first;
+  }
+
+  // Values that go after all the others are appended without a search, so
+  // that sorted ranges take O(N).
+  template <class InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    for (; first != last; ++first)
+      insert(cend(), *first);
+  }
+
+  // Constructs the value first, to know its key.
+  template <class... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    return insert(value_type(std::forward<Args>(args)...));
+  }
+
+  template <class... Args>
+  iterator emplace_hint(const_iterator position_hint, Args&&... args) {
+    return insert(position_hint, value_type(std::forward<Args>(args)...));
+  }
+
+  // --------------------------------------------------------------------------
+  // Erase operations.
+  //
+  // Assume that every operation invalidates iterators and references, as
+  // values move between nodes when they merge. Erasing one element takes
+  // O(log(size)).
+
+  iterator erase(const_iterator position) {
+    DCHECK(position != end());
+    iterator it(position.node_, position.position_);
+    const bool internal_erase = !it.node_->is_leaf();
+    if (internal_erase) {
+      // Takes the place of the value, which goes before it, out of its leaf.
+      iterator previous = it;
+      --previous;
+      *it.node_->value(it.position_) =
+          std::move(*previous.node_->value(previous.position_));
+      it = previous;
+    }
+    Node* const leaf = it.node_;
+    leaf->value(it.position_)->~value_type();
+    CloseSlot(leaf, it.position_);
+    --size_;
+    RebalanceAfterErase(leaf, &it);
+    it = NextIfPastEndOfNode(it);
+    // |it| is at the value that took the place of the erased one.
+    if (internal_erase)
+      ++it;
+    return it;
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    size_t count = std::distance(first, last);
+    iterator it(first.node_, first.position_);
+    for (; count; --count)
+      it = erase(it);
+    return it;
+  }
+
+  template <class K,
+            class = std::enable_if_t<
+                !std::is_convertible<const K&, const_iterator>::value>>
+  size_t erase(const K& key) {
+    const_iterator it = find(key);
+    if (it == end())
+      return 0;
+    erase(it);
+    return 1;
+  }
+
+  // --------------------------------------------------------------------------
+  // Comparators.
+
+  key_compare key_comp() const { return comp_; }
+  value_compare value_comp() const { return value_compare{comp_}; }
+
+  // --------------------------------------------------------------------------
+  // Search operations.
+  //
+  // Search operations have O(log(size)) complexity. With a transparent
+  // KeyCompare, they accept any type that it does.
+
+  template <class K>
+  size_t count(const K& key) const {
+    return contains(key) ? 1 : 0;
+  }
+
+  template <class K>
+  iterator find(const K& key) {
+    const KeyTypeOrK<K>& key_ref = key;
+    for (Node* node = root_; node;) {
+      const size_t position = LowerBoundInNode(node, key_ref);
+      if (position < node->count() &&
+          !comp_(key_ref, GetKeyFromValue()(*node->value(position)))) {
+        return iterator(node, position);
+      }
+      if (node->is_leaf())
+        break;
+      node = node->child(position);
+      node->Prefetch();
+    }
+    return end();
+  }
+
+  template <class K>
+  const_iterator find(const K& key) const {
+    return const_cast<btree*>(this)->find(key);
+  }
+
+  template <class K>
+  bool contains(const K& key) const {
+    return find(key) != end();
+  }
+
+  template <class K>
+  std::pair<iterator, iterator> equal_range(const K& key) {
+    iterator it = lower_bound(key);
+    const KeyTypeOrK<K>& key_ref = key;
+    if (it == end() || comp_(key_ref, GetKeyFromValue()(*it)))
+      return {it, it};
+    return {it, std::next(it)};
+  }
+
+  template <class K>
+  std::pair<const_iterator, const_iterator> equal_range(const K& key) const {
+    return const_cast<btree*>(this)->equal_range(key);
+  }
+
+  template <class K>
+  iterator lower_bound(const K& key) {
+    const KeyTypeOrK<K>& key_ref = key;
+    // The bound in a node is before the bounds found in its ancestors.
+    iterator result = end();
+    for (Node* node = root_; node;) {
+      const size_t position = LowerBoundInNode(node, key_ref);
+      if (position < node->count())
+        result = iterator(node, position);
+      if (node->is_leaf())
+        break;
+      node = node->child(position);
+      node->Prefetch();
+    }
+    return result;
+  }
+
+  template <class K>
+  const_iterator lower_bound(const K& key) const {
+    return const_cast<btree*>(this)->lower_bound(key);
+  }
+
+  template <class K>
+  iterator upper_bound(const K& key) {
+    const KeyTypeOrK<K>& key_ref = key;
+    iterator result = end();
+    for (Node* node = root_; node;) {
+      const size_t position = UpperBoundInNode(node, key_ref);
+      if (position < node->count())
+        result = iterator(node, position);
+      if (node->is_leaf())
+        break;
+      node = node->child(position);
+      node->Prefetch();
+    }
+    return result;
+  }
+
+  template <class K>
+  const_iterator upper_bound(const K& key) const {
+    return const_cast<btree*>(this)->upper_bound(key);
+  }
+
+  // --------------------------------------------------------------------------
+  // General operations.
+
+  void swap(btree& other) noexcept {
+    std::swap(root_, other.root_);
+    std::swap(leftmost_, other.leftmost_);
+    std::swap(rightmost_, other.rightmost_);
+    std::swap(size_, other.size_);
+    std::swap(num_leaf_nodes_, other.num_leaf_nodes_);
+    std::swap(num_internal_nodes_, other.num_internal_nodes_);
+    std::swap(comp_, other.comp_);
+  }
+
+  friend bool operator==(const btree& lhs, const btree& rhs) {
+    return lhs.size() == rhs.size() &&
+           std::equal(lhs.begin(), lhs.end(), rhs.begin());
+  }
+
+  friend bool operator!=(const btree& lhs, const btree& rhs) {
+    return !(lhs == rhs);
+  }
+
+  friend bool operator<(const btree& lhs, const btree& rhs) {
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(),
+                                        rhs.end());
+  }
+
+  friend bool operator>(const btree& lhs, const btree& rhs) {
+    return rhs < lhs;
+  }
+
+  friend bool operator>=(const btree& lhs, const btree& rhs) {
+    return !(lhs < rhs);
+  }
+
+  friend bool operator<=(const btree& lhs, const btree& rhs) {
+    return !(lhs > rhs);
+  }
+
+  friend void swap(btree& lhs, btree& rhs) noexcept { lhs.swap(rhs); }
+
+ protected:
+  // If the compare is not transparent we want to construct key_type once.
+  template <class K>
+  using KeyTypeOrK = std::
+      conditional_t<IsTransparentCompare<key_compare>::value, K, key_type>;
+
+  // Inserts a value constructed from |args| if there is no value with |key|,
+  // and returns where the value with |key| is.
+  template <class K, class... Args>
+  std::pair<iterator, bool> emplace_key_args(const K& key, Args&&... args) {
+    const KeyTypeOrK<K>& key_ref = key;
+    if (!root_)
+      return {InsertBefore(end(), std::forward<Args>(args)...), true};
+    Node* node = root_;
+    while (true) {
+      const size_t position = LowerBoundInNode(node, key_ref);
+      if (position < node->count() &&
+          !comp_(key_ref, GetKeyFromValue()(*node->value(position)))) {
+        return {iterator(node, position), false};
+      }
+      if (node->is_leaf()) {
+        return {InsertAt(node, position, std::forward<Args>(args)...), true};
+      }
+      node = node->child(position);
+      node->Prefetch();
+    }
+  }
+
+  // Same, but starts by checking if the value goes right before |hint|.
+  template <class K, class... Args>
+  std::pair<iterator, bool> emplace_hint_key_args(const_iterator hint,
+                                                  const K& key,
+                                                  Args&&... args) {
+    const KeyTypeOrK<K>& key_ref = key;
+    iterator position(hint.node_, hint.position_);
+    if (position == end() ||
+        comp_(key_ref, GetKeyFromValue()(*position))) {
+      if (position == begin() ||
+          comp_(GetKeyFromValue()(*std::prev(position)), key_ref)) {
+        return {InsertBefore(position, std::forward<Args>(args)...), true};
+      }
+    } else if (!comp_(GetKeyFromValue()(*position), key_ref)) {
+      return {position, false};
+    }
+    // The hint was not helpful, dispatch to the hintless version.
+    return emplace_key_args(key_ref, std::forward<Args>(args)...);
+  }
+
+ private:
+  static constexpr size_t kNodeSlots = Node::kNodeSlots;
+  // Erases keep nodes other than the root at least this full.
+  static constexpr size_t kMinNodeValues = kNodeSlots / 2;
+
+  template <class K>
+  size_t LowerBoundInNode(const Node* node, const K& key) const {
+    size_t low = 0;
+    size_t high = node->count();
+    while (low < high) {
+      const size_t middle = (low + high) / 2;
+      if (comp_(GetKeyFromValue()(*node->value(middle)), key))
+        low = middle + 1;
+      else
+        high = middle;
+    }
+    return low;
+  }
+
+  template <class K>
+  size_t UpperBoundInNode(const Node* node, const K& key) const {
+    size_t low = 0;
+    size_t high = node->count();
+    while (low < high) {
+      const size_t middle = (low + high) / 2;
+      if (comp_(key, GetKeyFromValue()(*node->value(middle))))
+        high = middle;
+      else
+        low = middle + 1;
+    }
+    return low;
+  }
+
+  Node* NewLeafNode() {
+    ++num_leaf_nodes_;
+    return new Node(/*is_leaf=*/true);
+  }
+
+  InternalNode* NewInternalNode() {
+    ++num_internal_nodes_;
+    return new InternalNode();
+  }
+
+  // Only deletes the node, not its values or its children.
+  void DeleteNode(Node* node) {
+    if (node->is_leaf()) {
+      --num_leaf_nodes_;
+      delete node;
+    } else {
+      --num_internal_nodes_;
+      delete node->AsInternal();
+    }
+  }
+
+  void DeleteSubtree(Node* node) {
+    for (size_t i = 0; i < node->count(); ++i)
+      node->value(i)->~value_type();
+    if (!node->is_leaf()) {
+      for (size_t i = 0; i <= node->count(); ++i)
+        DeleteSubtree(node->child(i));
+    }
+    DeleteNode(node);
+  }
+
+  // Makes room for a value at |i| by moving the next values, and the
+  // children after them, one slot to the right.
+  static void OpenSlot(Node* node, size_t i) {
+    const size_t count = node->count();
+    for (size_t j = count; j > i; --j)
+      Node::TransferValue(node, j, node, j - 1);
+    if (!node->is_leaf()) {
+      InternalNode* internal = node->AsInternal();
+      for (size_t j = count + 1; j > i + 1; --j)
+        internal->set_child(j, internal->child(j - 1));
+    }
+    node->set_count(count + 1);
+  }
+
+  // Removes the slot |i|, whose value was moved or destroyed, and the child
+  // after it, by moving the next values and children one slot to the left.
+  static void CloseSlot(Node* node, size_t i) {
+    const size_t count = node->count();
+    for (size_t j = i; j + 1 < count; ++j)
+      Node::TransferValue(node, j, node, j + 1);
+    if (!node->is_leaf()) {
+      InternalNode* internal = node->AsInternal();
+      for (size_t j = i + 1; j < count; ++j)
+        internal->set_child(j, internal->child(j + 1));
+    }
+    node->set_count(count - 1);
+  }
+
+  // Inserts a value before |position|, where the caller knows it belongs.
+  template <class... Args>
+  iterator InsertBefore(iterator position, Args&&... args) {
+    if (!root_) {
+      root_ = leftmost_ = rightmost_ = NewLeafNode();
+      return InsertAt(root_, 0, std::forward<Args>(args)...);
+    }
+    // Values are inserted in leaves, right after the previous value.
+    if (!position.node_->is_leaf()) {
+      --position;
+      ++position.position_;
+    }
+    return InsertAt(position.node_, position.position_,
+                    std::forward<Args>(args)...);
+  }
+
+  template <class... Args>
+  iterator InsertAt(Node* leaf, size_t position, Args&&... args) {
+    DCHECK(leaf->is_leaf());
+    if (leaf->count() == kNodeSlots)
+      Split(&leaf, &position);
+    OpenSlot(leaf, position);
+    new (leaf->value(position)) value_type(std::forward<Args>(args)...);
+    ++size_;
+    return iterator(leaf, position);
+  }
+
+  // Whether |node| is on the path from the root to the first leaf.
+  static bool IsOnLeftEdge(const Node* node) {
+    for (; node->parent(); node = node->parent()) {
+      if (node->position() != 0)
+        return false;
+    }
+    return true;
+  }
+
+  // Whether |node| is on the path from the root to the last leaf.
+  static bool IsOnRightEdge(const Node* node) {
+    for (; node->parent(); node = node->parent()) {
+      if (node->position() != node->parent()->count())
+        return false;
+    }
+    return true;
+  }
+
+  // Splits the full |*node| in two, and the value at the middle goes to their
+  // parent, which is split first if it is full too. |*node| and |*position|
+  // are updated to where a value that was to go at |*position| goes.
+  void Split(Node** node_ptr, size_t* position_ptr) {
+    Node* const node = *node_ptr;
+    const size_t position = *position_ptr;
+    DCHECK_EQ(node->count(), kNodeSlots);
+    if (node == root_) {
+      InternalNode* new_root = NewInternalNode();
+      new_root->set_child(0, node);
+      root_ = new_root;
+    } else if (node->parent()->count() == kNodeSlots) {
+      Node* parent = node->parent();
+      size_t parent_position = node->position();
+      Split(&parent, &parent_position);
+    }
+    InternalNode* const parent = node->parent();
+
+    // Insertions at either end of the tree are usually sorted ones, which
+    // leave the nodes full when all the values but one stay on the other side.
+    size_t num_to_move = kNodeSlots / 2;
+    if (position == 0 && IsOnLeftEdge(node))
+      num_to_move = kNodeSlots - 1;
+    else if (position == kNodeSlots && IsOnRightEdge(node))
+      num_to_move = 0;
+
+    Node* sibling;
+    const size_t num_left = kNodeSlots - num_to_move;
+    if (node->is_leaf()) {
+      sibling = NewLeafNode();
+      if (node == rightmost_)
+        rightmost_ = sibling;
+    } else {
+      InternalNode* internal_sibling = NewInternalNode();
+      for (size_t i = 0; i <= num_to_move; ++i) {
+        internal_sibling->set_child(i, node->child(num_left + i));
+      }
+      sibling = internal_sibling;
+    }
+    for (size_t i = 0; i < num_to_move; ++i)
+      Node::TransferValue(sibling, i, node, num_left + i);
+    sibling->set_count(num_to_move);
+
+    // The last value that stays separates the two nodes in the parent.
+    const size_t separator = num_left - 1;
+    OpenSlot(parent, node->position());
+    Node::TransferValue(parent, node->position(), node, separator);
+    parent->set_child(node->position() + 1, sibling);
+    node->set_count(separator);
+
+    if (position > separator) {
+      *node_ptr = sibling;
+      *position_ptr = position - separator - 1;
+    }
+  }
+
+  // Merges |right|, and the value that separates it from |left| in their
+  // parent, into |left|, and deletes |right|.
+  void Merge(Node* left, Node* right) {
+    InternalNode* const parent = left->parent();
+    const size_t separator = left->position();
+    const size_t left_count = left->count();
+    const size_t right_count = right->count();
+    DCHECK_LE(left_count + 1 + right_count, kNodeSlots);
+
+    Node::TransferValue(left, left_count, parent, separator);
+    for (size_t i = 0; i < right_count; ++i)
+      Node::TransferValue(left, left_count + 1 + i, right, i);
+    if (!left->is_leaf()) {
+      for (size_t i = 0; i <= right_count; ++i)
+        left->AsInternal()->set_child(left_count + 1 + i, right->child(i));
+    }
+    left->set_count(left_count + 1 + right_count);
+    right->set_count(0);
+    CloseSlot(parent, separator);
+
+    if (right == rightmost_)
+      rightmost_ = left;
+    DeleteNode(right);
+  }
+
+  // Moves |n| values from |right| to |left| through their parent.
+  void RebalanceRightToLeft(Node* left, Node* right, size_t n) {
+    InternalNode* const parent = left->parent();
+    const size_t separator = left->position();
+    const size_t left_count = left->count();
+    const size_t right_count = right->count();
+    DCHECK_GE(n, 1u);
+    DCHECK_LT(n, right_count);
+
+    Node::TransferValue(left, left_count, parent, separator);
+    for (size_t i = 0; i + 1 < n; ++i)
+      Node::TransferValue(left, left_count + 1 + i, right, i);
+    Node::TransferValue(parent, separator, right, n - 1);
+    for (size_t i = 0; i + n < right_count; ++i)
+      Node::TransferValue(right, i, right, i + n);
+    if (!left->is_leaf()) {
+      InternalNode* internal_left = left->AsInternal();
+      InternalNode* internal_right = right->AsInternal();
+      for (size_t i = 0; i < n; ++i)
+        internal_left->set_child(left_count + 1 + i, right->child(i));
+      for (size_t i = 0; i + n <= right_count; ++i)
+        internal_right->set_child(i, right->child(i + n));
+    }
+    left->set_count(left_count + n);
+    right->set_count(right_count - n);
+  }
+
+  // Moves |n| values from |left| to |right| through their parent.
+  void RebalanceLeftToRight(Node* left, Node* right, size_t n) {
+    InternalNode* const parent = left->parent();
+    const size_t separator = left->position();
+    const size_t left_count = left->count();
+    const size_t right_count = right->count();
+    DCHECK_GE(n, 1u);
+    DCHECK_LT(n, left_count);
+
+    for (size_t i = right_count; i > 0; --i)
+      Node::TransferValue(right, i - 1 + n, right, i - 1);
+    Node::TransferValue(right, n - 1, parent, separator);
+    for (size_t i = 0; i + 1 < n; ++i)
+      Node::TransferValue(right, i, left, left_count - n + 1 + i);
+    Node::TransferValue(parent, separator, left, left_count - n);
+    if (!left->is_leaf()) {
+      InternalNode* internal_right = right->AsInternal();
+      for (size_t i = right_count + 1; i > 0; --i)
+        internal_right->set_child(i - 1 + n, right->child(i - 1));
+      for (size_t i = 0; i < n; ++i)
+        internal_right->set_child(i, left->child(left_count - n + 1 + i));
+    }
+    left->set_count(left_count - n);
+    right->set_count(right_count + n);
+  }
+
+  // Brings |node|, from which a value was erased, and then its ancestors back
+  // to at least kMinNodeValues values, by merging them with a sibling or
+  // taking values from one. |*it| points into |node|, and keeps pointing at
+  // the same position among the values.
+  void RebalanceAfterErase(Node* node, iterator* it) {
+    while (node != root_ && node->count() < kMinNodeValues) {
+      InternalNode* const parent = node->parent();
+      const size_t position = node->position();
+      if (position > 0) {
+        Node* left = parent->child(position - 1);
+        if (left->count() + 1 + node->count() <= kNodeSlots) {
+          if (it->node_ == node) {
+            it->node_ = left;
+            it->position_ += left->count() + 1;
+          }
+          Merge(left, node);
+          node = parent;
+          continue;
+        }
+      }
+      if (position < parent->count()) {
+        Node* right = parent->child(position + 1);
+        if (node->count() + 1 + right->count() <= kNodeSlots) {
+          Merge(node, right);
+          node = parent;
+          continue;
+        }
+        RebalanceRightToLeft(node, right,
+                             (right->count() - node->count()) / 2);
+        return;
+      }
+      // Only the left sibling remains, and it is too full to merge with.
+      Node* left = parent->child(position - 1);
+      const size_t n = (left->count() - node->count()) / 2;
+      if (it->node_ == node)
+        it->position_ += n;
+      RebalanceLeftToRight(left, node, n);
+      return;
+    }
+
+    if (node != root_ || node->count())
+      return;
+    if (node->is_leaf()) {
+      DeleteNode(node);
+      root_ = leftmost_ = rightmost_ = nullptr;
+      *it = end();
+      return;
+    }
+    // A root without values has one child, which becomes the root.
+    root_ = node->child(0);
+    root_->clear_parent();
+    DeleteNode(node);
+  }
+
+  // Moves an iterator that points past the values of a leaf to the next
+  // value, which is in an ancestor, or to end().
+  iterator NextIfPastEndOfNode(iterator it) {
+    if (!it.node_)
+      return it;
+    while (it.position_ == it.node_->count()) {
+      if (!it.node_->parent())
+        return end();
+      it.position_ = it.node_->position();
+      it.node_ = it.node_->parent();
+    }
+    return it;
+  }
+
+  Node* root_ = nullptr;
+  // The first and last leaves, for begin() and end().
+  Node* leftmost_ = nullptr;
+  Node* rightmost_ = nullptr;
+  size_t size_ = 0;
+  size_t num_leaf_nodes_ = 0;
+  size_t num_internal_nodes_ = 0;
+
+  NO_UNIQUE_ADDRESS key_compare comp_;
+};
+
+template <class Key, class Value, class GetKeyFromValue, class KeyCompare>
+constexpr size_t btree<Key, Value, GetKeyFromValue, KeyCompare>::kNodeSlots;
+template <class Key, class Value, class GetKeyFromValue, class KeyCompare>
+constexpr size_t btree<Key, Value, GetKeyFromValue, KeyCompare>::kMinNodeValues;
+
+}  // namespace internal
+
+// ----------------------------------------------------------------------------
+// Free functions.
+
+// Erases all elements that match predicate. It has O(size * log(size))
+// complexity.
+template <class Key,
+          class Value,
+          class GetKeyFromValue,
+          class KeyCompare,
+          typename Predicate>
+size_t EraseIf(
+    base::internal::btree<Key, Value, GetKeyFromValue, KeyCompare>& container,
+    Predicate pred) {
+  const size_t old_size = container.size();
+  for (auto it = container.begin(); it != container.end();) {
+    if (pred(*it))
+      it = container.erase(it);
+    else
+      ++it;
+  }
+  return old_size - container.size();
+}
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_BTREE_H_
@@ -0,0 +1,236 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_CONTAINERS_BTREE_MAP_H_
+#define BASE_CONTAINERS_BTREE_MAP_H_
+
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "base/check.h"
+#include "base/containers/btree.h"
+
+namespace base {
+
+namespace internal {
+
+// Extracts the key of btree_map values.
+struct BTreeGetFirst {
+  template <class Key, class Mapped>
+  constexpr const Key& operator()(const std::pair<Key, Mapped>& p) const {
+    return p.first;
+  }
+};
+
+}  // namespace internal
+
+// btree_map is a container with a std::map-like interface that stores its
+// contents in a B-tree, whose nodes hold sorted arrays of a few cache lines
+// (see btree.h).
+//
+// Please see //base/containers/README.md for an overview of which container
+// to select.
+//
+// PROS
+//
+//  - O(log(n)) inserts and removals, where flat_map takes O(n), with lookups
+//    about as fast as flat_map's for large maps: a lookup touches a few nodes
+//    rather than a cache line per comparison.
+//  - One allocation per node rather than one per element, and less overhead
+//    per element than std::map.
+//
+// CONS
+//
+//  - Iterators and references are invalidated across mutations, unlike with
+//    std::map.
+//  - Iterators are bidirectional rather than random access.
+//  - Small maps take a whole node, so flat_map remains better for those.
+//
+// IMPORTANT NOTES
+//
+//  - As with flat_map, value_type is std::pair<Key, Mapped> rather than
+//    std::pair<const Key, Mapped>, so that elements can be moved between
+//    nodes. Keys must not be modified through iterators.
+//  - Iterators are invalidated across mutations. This means that the following
+//    line of code has undefined behavior since adding a new element could
+//    split the node that |it| points into:
+//      container["new element"] = it->second;
+//  - Sorted ranges, and elements inserted with the end() hint in increasing
+//    order, are appended in O(1) amortized time, into nodes that are left
+//    full.
+//
+// QUICK REFERENCE
+//
+// Most of the core functionality is inherited from internal::btree, see
+// btree_set.h for those functions. The map adds:
+//
+//   mapped_type&         operator[](const key_type&);
+//   mapped_type&         operator[](key_type&&);
+//   mapped_type&         at(const K&);
+//   const mapped_type&   at(const K&) const;
+//   pair<iterator, bool> insert_or_assign(K&&, M&&);
+//   iterator             insert_or_assign(const_iterator hint, K&&, M&&);
+//   pair<iterator, bool> try_emplace(K&&, Args&&...);
+//   iterator             try_emplace(const_iterator hint, K&&, Args&&...);
+//
+template <class Key, class Mapped, class Compare = std::less<>>
+class btree_map : public ::base::internal::btree<Key,
+                                                 std::pair<Key, Mapped>,
+                                                 internal::BTreeGetFirst,
+                                                 Compare> {
+ private:
+  using tree = typename ::base::internal::
+      btree<Key, std::pair<Key, Mapped>, internal::BTreeGetFirst, Compare>;
+
+ public:
+  using key_type = typename tree::key_type;
+  using mapped_type = Mapped;
+  using value_type = typename tree::value_type;
+  using iterator = typename tree::iterator;
+  using const_iterator = typename tree::const_iterator;
+  using reverse_iterator = typename tree::reverse_iterator;
+  using const_reverse_iterator = typename tree::const_reverse_iterator;
+
+  // --------------------------------------------------------------------------
+  // Lifetime and assignments.
+
+  using tree::tree;
+  using tree::operator=;
+
+  // Out-of-bound calls to at() will CHECK.
+  template <class K>
+  mapped_type& at(const K& key);
+  template <class K>
+  const mapped_type& at(const K& key) const;
+
+  // --------------------------------------------------------------------------
+  // Map-specific insert operations.
+  //
+  // Normal insert() functions are inherited from btree.
+  //
+  // Assume that every operation invalidates iterators and references.
+  // Insertion of one element takes O(log(size)).
+
+  mapped_type& operator[](const key_type& key);
+  mapped_type& operator[](key_type&& key);
+
+  template <class K, class M>
+  std::pair<iterator, bool> insert_or_assign(K&& key, M&& obj);
+  template <class K, class M>
+  iterator insert_or_assign(const_iterator hint, K&& key, M&& obj);
+
+  template <class K, class... Args>
+  std::enable_if_t<std::is_constructible<key_type, K&&>::value,
+                   std::pair<iterator, bool>>
+  try_emplace(K&& key, Args&&... args);
+
+  template <class K, class... Args>
+  std::enable_if_t<std::is_constructible<key_type, K&&>::value, iterator>
+  try_emplace(const_iterator hint, K&& key, Args&&... args);
+
+  // --------------------------------------------------------------------------
+  // General operations.
+  //
+  // Assume that swap invalidates iterators and references.
+
+  void swap(btree_map& other) noexcept;
+
+  friend void swap(btree_map& lhs, btree_map& rhs) noexcept { lhs.swap(rhs); }
+};
+
+// ----------------------------------------------------------------------------
+// Lookups.
+
+template <class Key, class Mapped, class Compare>
+template <class K>
+auto btree_map<Key, Mapped, Compare>::at(const K& key) -> mapped_type& {
+  iterator found = tree::find(key);
+  CHECK(found != tree::end());
+  return found->second;
+}
+
+template <class Key, class Mapped, class Compare>
+template <class K>
+auto btree_map<Key, Mapped, Compare>::at(const K& key) const
+    -> const mapped_type& {
+  const_iterator found = tree::find(key);
+  CHECK(found != tree::cend());
+  return found->second;
+}
+
+// ----------------------------------------------------------------------------
+// Insert operations.
+
+template <class Key, class Mapped, class Compare>
+auto btree_map<Key, Mapped, Compare>::operator[](const key_type& key)
+    -> mapped_type& {
+  return try_emplace(key).first->second;
+}
+
+template <class Key, class Mapped, class Compare>
+auto btree_map<Key, Mapped, Compare>::operator[](key_type&& key)
+    -> mapped_type& {
+  return try_emplace(std::move(key)).first->second;
+}
+
+template <class Key, class Mapped, class Compare>
+template <class K, class M>
+auto btree_map<Key, Mapped, Compare>::insert_or_assign(K&& key, M&& obj)
+    -> std::pair<iterator, bool> {
+  auto result =
+      tree::emplace_key_args(key, std::forward<K>(key), std::forward<M>(obj));
+  if (!result.second)
+    result.first->second = std::forward<M>(obj);
+  return result;
+}
+
+template <class Key, class Mapped, class Compare>
+template <class K, class M>
+auto btree_map<Key, Mapped, Compare>::insert_or_assign(const_iterator hint,
+                                                       K&& key,
+                                                       M&& obj) -> iterator {
+  auto result = tree::emplace_hint_key_args(hint, key, std::forward<K>(key),
+                                            std::forward<M>(obj));
+  if (!result.second)
+    result.first->second = std::forward<M>(obj);
+  return result.first;
+}
+
+template <class Key, class Mapped, class Compare>
+template <class K, class... Args>
+auto btree_map<Key, Mapped, Compare>::try_emplace(K&& key, Args&&... args)
+    -> std::enable_if_t<std::is_constructible<key_type, K&&>::value,
+                        std::pair<iterator, bool>> {
+  return tree::emplace_key_args(
+      key, std::piecewise_construct,
+      std::forward_as_tuple(std::forward<K>(key)),
+      std::forward_as_tuple(std::forward<Args>(args)...));
+}
+
+template <class Key, class Mapped, class Compare>
+template <class K, class... Args>
+auto btree_map<Key, Mapped, Compare>::try_emplace(const_iterator hint,
+                                                  K&& key,
+                                                  Args&&... args)
+    -> std::enable_if_t<std::is_constructible<key_type, K&&>::value, iterator> {
+  return tree::emplace_hint_key_args(
+             hint, key, std::piecewise_construct,
+             std::forward_as_tuple(std::forward<K>(key)),
+             std::forward_as_tuple(std::forward<Args>(args)...))
+      .first;
+}
+
+// ----------------------------------------------------------------------------
+// General operations.
+
+template <class Key, class Mapped, class Compare>
+void btree_map<Key, Mapped, Compare>::swap(btree_map& other) noexcept {
+  tree::swap(other);
+}
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_BTREE_MAP_H_
@@ -0,0 +1,192 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/btree_map.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/containers/flat_map.h"
+#include "base/rand_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
+#include "base/trace_event/memory_usage_estimator.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace base {
+
+namespace {
+
+constexpr char kMetricPrefix[] = "OrderedMap.";
+constexpr char kMetricInsertTime[] = "insert_time_per_key";
+constexpr char kMetricSortedInsertTime[] = "sorted_insert_time_per_key";
+constexpr char kMetricFindTime[] = "find_time_per_key";
+constexpr char kMetricIterateTime[] = "iterate_time_per_key";
+constexpr char kMetricEraseTime[] = "erase_time_per_key";
+constexpr char kMetricMemoryUsage[] = "memory_usage_per_key";
+
+constexpr size_t kSizes[] = {10, 1000, 100000, 10000000};
+constexpr size_t kNumLookups = 1000000;
+
+// Inserting into and erasing from flat_map take O(size), so maps larger than
+// this are built in one go, and not erased from.
+constexpr size_t kMaxFlatMapUpdateSize = 100000;
+
+// Returns |n| distinct keys, in an order that looks random.
+std::vector<uint64_t> MakeKeys(size_t n) {
+  std::vector<uint64_t> keys(n);
+  for (size_t i = 0; i < n; ++i)
+    keys[i] = (i + 1) * 0x9e3779b97f4a7c15;
+  return keys;
+}
+
+double NanosecondsPer(TimeDelta elapsed, size_t count) {
+  return static_cast<double>(elapsed.InNanoseconds()) / count;
+}
+
+template <class Map>
+void InsertAll(const std::vector<uint64_t>& keys, Map* map) {
+  for (uint64_t key : keys)
+    map->emplace(key, 0);
+}
+
+template <>
+void InsertAll(const std::vector<uint64_t>& keys,
+               flat_map<uint64_t, int>* map) {
+  if (keys.size() <= kMaxFlatMapUpdateSize) {
+    for (uint64_t key : keys)
+      map->emplace(key, 0);
+    return;
+  }
+  std::vector<std::pair<uint64_t, int>> items;
+  items.reserve(keys.size());
+  for (uint64_t key : keys)
+    items.emplace_back(key, 0);
+  *map = flat_map<uint64_t, int>(std::move(items));
+}
+
+// Returns false if the map is too large to erase from.
+template <class Map>
+bool EraseAll(const std::vector<uint64_t>& keys, Map* map) {
+  for (uint64_t key : keys)
+    map->erase(key);
+  return true;
+}
+
+template <>
+bool EraseAll(const std::vector<uint64_t>& keys,
+              flat_map<uint64_t, int>* map) {
+  if (keys.size() > kMaxFlatMapUpdateSize)
+    return false;
+  for (uint64_t key : keys)
+    map->erase(key);
+  return true;
+}
+
+template <class Map>
+void RunMapTest(const std::string& story_name,
+                const std::vector<uint64_t>& keys,
+                const std::vector<uint64_t>& sorted_keys,
+                const std::vector<uint64_t>& lookups) {
+  perf_test::PerfResultReporter reporter(kMetricPrefix, story_name);
+  reporter.RegisterImportantMetric(kMetricInsertTime, "ns");
+  reporter.RegisterImportantMetric(kMetricSortedInsertTime, "ns");
+  reporter.RegisterImportantMetric(kMetricFindTime, "ns");
+  reporter.RegisterImportantMetric(kMetricIterateTime, "ns");
+  reporter.RegisterImportantMetric(kMetricEraseTime, "ns");
+  reporter.RegisterImportantMetric(kMetricMemoryUsage, "bytes");
+
+  // Builds small maps repeatedly, so that it takes long enough to be timed.
+  const size_t repeats = std::max<size_t>(1, kNumLookups / keys.size());
+  std::vector<Map> maps(repeats);
+  TimeTicks start = TimeTicks::Now();
+  for (Map& map : maps)
+    InsertAll(keys, &map);
+  reporter.AddResult(kMetricInsertTime,
+                     NanosecondsPer(TimeTicks::Now() - start,
+                                    repeats * keys.size()));
+  maps.clear();
+
+  // Maps are built from sorted keys in one go.
+  std::vector<std::pair<uint64_t, int>> sorted_items;
+  sorted_items.reserve(sorted_keys.size());
+  for (uint64_t key : sorted_keys)
+    sorted_items.emplace_back(key, 0);
+  maps.resize(repeats);
+  start = TimeTicks::Now();
+  for (Map& map : maps)
+    map = Map(sorted_items.begin(), sorted_items.end());
+  reporter.AddResult(kMetricSortedInsertTime,
+                     NanosecondsPer(TimeTicks::Now() - start,
+                                    repeats * keys.size()));
+  sorted_items.clear();
+  sorted_items.shrink_to_fit();
+  const Map& map = maps.front();
+  reporter.AddResult(
+      kMetricMemoryUsage,
+      static_cast<double>(trace_event::EstimateMemoryUsage(map)) / keys.size());
+
+  size_t found = 0;
+  start = TimeTicks::Now();
+  for (uint64_t key : lookups)
+    found += map.count(key);
+  reporter.AddResult(kMetricFindTime,
+                     NanosecondsPer(TimeTicks::Now() - start, lookups.size()));
+  EXPECT_EQ(lookups.size(), found);
+
+  uint64_t sum = 0;
+  size_t visited = 0;
+  start = TimeTicks::Now();
+  while (visited < kNumLookups) {
+    for (const auto& entry : map)
+      sum += entry.first;
+    visited += map.size();
+  }
+  reporter.AddResult(kMetricIterateTime,
+                     NanosecondsPer(TimeTicks::Now() - start, visited));
+  EXPECT_NE(0u, sum);
+
+  start = TimeTicks::Now();
+  for (Map& erased_map : maps) {
+    if (!EraseAll(keys, &erased_map))
+      return;
+  }
+  reporter.AddResult(kMetricEraseTime,
+                     NanosecondsPer(TimeTicks::Now() - start,
+                                    repeats * keys.size()));
+  EXPECT_TRUE(maps.front().empty());
+}
+
+}  // namespace
+
+TEST(BTreeMapPerfTest, IntKeys) {
+  for (size_t size : kSizes) {
+    const std::vector<uint64_t> keys = MakeKeys(size);
+    std::vector<uint64_t> sorted_keys = keys;
+    std::sort(sorted_keys.begin(), sorted_keys.end());
+    // Looks the keys up in random order, so that the lookups of large maps
+    // miss the cache as they would in practice.
+    std::vector<uint64_t> lookups;
+    lookups.reserve(kNumLookups);
+    for (size_t i = 0; i < kNumLookups; ++i)
+      lookups.push_back(keys[RandGenerator(size)]);
+
+    const std::string suffix = "_" + NumberToString(size);
+    RunMapTest<btree_map<uint64_t, int>>("btree_map" + suffix, keys,
+                                         sorted_keys, lookups);
+    RunMapTest<std::map<uint64_t, int>>("std_map" + suffix, keys, sorted_keys,
+                                        lookups);
+    RunMapTest<flat_map<uint64_t, int>>("flat_map" + suffix, keys,
+                                        sorted_keys, lookups);
+  }
+}
+
+}  // namespace base
@@ -0,0 +1,359 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/btree_map.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/rand_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_piece.h"
+#include "base/test/move_only_int.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+// The tree itself is mostly tested through btree_set, in
+// btree_set_unittest.cc.
+
+using ::testing::ElementsAre;
+using ::testing::Pair;
+
+namespace base {
+
+namespace {
+
+// Large enough that nodes hold the minimum of 3 values, so that trees of a few
+// values are already several levels deep.
+struct Padded {
+  Padded() = default;
+  explicit Padded(int value) : value(value) {}
+
+  int value = 0;
+  char padding[200] = {};
+};
+
+// Runs random operations on |map| and on a std::map, and checks that they
+// agree.
+template <class Mapped>
+void RunRandomOperations(btree_map<int, Mapped>& map) {
+  std::map<int, int> expected;
+  for (int i = 0; i < 50000; ++i) {
+    // Few enough keys for some of the operations to find them.
+    const int key = static_cast<int>(RandGenerator(1000));
+    switch (RandGenerator(6)) {
+      case 0:
+      case 1:
+        map[key] = Mapped(i);
+        expected[key] = i;
+        break;
+      case 2:
+        ASSERT_EQ(expected.erase(key), map.erase(key));
+        break;
+      case 3: {
+        // Erases the next element, through an iterator.
+        auto it = map.lower_bound(key);
+        auto expected_it = expected.lower_bound(key);
+        ASSERT_EQ(expected_it == expected.end(), it == map.end());
+        if (it == map.end())
+          break;
+        ASSERT_EQ(expected_it->first, it->first);
+        it = map.erase(it);
+        expected_it = expected.erase(expected_it);
+        ASSERT_EQ(expected_it == expected.end(), it == map.end());
+        if (it != map.end()) {
+          ASSERT_EQ(expected_it->first, it->first);
+        }
+        break;
+      }
+      case 4: {
+        auto it = map.upper_bound(key);
+        auto expected_it = expected.upper_bound(key);
+        ASSERT_EQ(expected_it == expected.end(), it == map.end());
+        if (it != map.end()) {
+          EXPECT_EQ(expected_it->first, it->first);
+          EXPECT_EQ(expected_it->second, it->second.value);
+        }
+        break;
+      }
+      case 5: {
+        auto it = map.insert(map.find(key + 1), {key, Mapped(i)});
+        expected.insert({key, i});
+        EXPECT_EQ(key, it->first);
+        EXPECT_EQ(expected[key], it->second.value);
+        break;
+      }
+    }
+    ASSERT_EQ(expected.size(), map.size());
+    if (i % 1000)
+      continue;
+    // Walks the whole map both ways.
+    ASSERT_TRUE(std::equal(expected.begin(), expected.end(), map.begin(),
+                           map.end(),
+                           [](const std::pair<const int, int>& expected_entry,
+                              const std::pair<int, Mapped>& entry) {
+                             return expected_entry.first == entry.first &&
+                                    expected_entry.second == entry.second.value;
+                           }));
+    ASSERT_TRUE(std::equal(expected.rbegin(), expected.rend(), map.rbegin(),
+                           map.rend(),
+                           [](const std::pair<const int, int>& expected_entry,
+                              const std::pair<int, Mapped>& entry) {
+                             return expected_entry.first == entry.first;
+                           }));
+  }
+}
+
+struct IntValue {
+  IntValue() = default;
+  explicit IntValue(int value) : value(value) {}
+
+  int value = 0;
+};
+
+}  // namespace
+
+TEST(BTreeMap, InitializerListConstructor) {
+  btree_map<int, int> map = {{2, 2}, {1, 1}, {2, 3}};
+  EXPECT_THAT(map, ElementsAre(Pair(1, 1), Pair(2, 2)));
+}
+
+TEST(BTreeMap, SortedRangeConstructor) {
+  std::vector<std::pair<int, int>> values;
+  for (int i = 0; i < 10000; ++i)
+    values.emplace_back(i, -i);
+  btree_map<int, int> map(sorted_unique, values.begin(), values.end());
+  ASSERT_EQ(values.size(), map.size());
+  EXPECT_TRUE(std::equal(values.begin(), values.end(), map.begin()));
+  EXPECT_EQ(-5000, map.at(5000));
+
+  // Appending leaves the nodes full, so that they take little more than the
+  // values themselves.
+  EXPECT_LT(map.bytes_used(), values.size() * sizeof(values[0]) * 5 / 4);
+}
+
+TEST(BTreeMap, InsertFindSize) {
+  btree_map<int, int> map;
+  EXPECT_TRUE(map.insert({1, 1}).second);
+  EXPECT_FALSE(map.insert({1, 2}).second);
+  EXPECT_TRUE(map.emplace(2, 2).second);
+  EXPECT_EQ(2u, map.size());
+  EXPECT_EQ(1, map.find(1)->second);
+  EXPECT_EQ(map.end(), map.find(3));
+  EXPECT_EQ(1u, map.count(2));
+  EXPECT_EQ(0u, map.count(3));
+}
+
+TEST(BTreeMap, Subscript) {
+  btree_map<MoveOnlyInt, int> map;
+  map[MoveOnlyInt(1)] = 10;
+  map[MoveOnlyInt(2)] = 20;
+  map[MoveOnlyInt(1)] += 1;
+  EXPECT_EQ(2u, map.size());
+  EXPECT_EQ(11, map[MoveOnlyInt(1)]);
+  EXPECT_EQ(20, map.at(MoveOnlyInt(2)));
+}
+
+TEST(BTreeMap, SubscriptConstKey) {
+  btree_map<std::string, int> map;
+  const std::string key("key");
+  EXPECT_EQ(0, map[key]);
+  map[key] = 1;
+  EXPECT_EQ(1, map[key]);
+  EXPECT_EQ(1u, map.size());
+}
+
+TEST(BTreeMap, AtFunction) {
+  btree_map<int, std::string> map = {{1, "a"}, {2, "b"}};
+  map.at(1) = "c";
+  const btree_map<int, std::string>& const_map = map;
+  EXPECT_EQ("c", const_map.at(1));
+  EXPECT_EQ("b", const_map.at(2));
+  EXPECT_DEATH_IF_SUPPORTED(map.at(3), "");
+}
+
+TEST(BTreeMap, InsertOrAssign) {
+  btree_map<MoveOnlyInt, MoveOnlyInt> map;
+  auto result = map.insert_or_assign(MoveOnlyInt(1), MoveOnlyInt(10));
+  EXPECT_TRUE(result.second);
+  EXPECT_EQ(10, result.first->second.data());
+
+  result = map.insert_or_assign(MoveOnlyInt(1), MoveOnlyInt(11));
+  EXPECT_FALSE(result.second);
+  EXPECT_EQ(11, result.first->second.data());
+  EXPECT_EQ(1u, map.size());
+
+  auto it = map.insert_or_assign(map.end(), MoveOnlyInt(2), MoveOnlyInt(20));
+  EXPECT_EQ(2, it->first.data());
+  it = map.insert_or_assign(map.begin(), MoveOnlyInt(2), MoveOnlyInt(21));
+  EXPECT_EQ(21, it->second.data());
+  EXPECT_EQ(2u, map.size());
+}
+
+TEST(BTreeMap, TryEmplace) {
+  btree_map<int, std::pair<MoveOnlyInt, MoveOnlyInt>> map;
+  auto result = map.try_emplace(1, MoveOnlyInt(10), MoveOnlyInt(20));
+  EXPECT_TRUE(result.second);
+  EXPECT_EQ(10, result.first->second.first.data());
+
+  // The arguments are not used when the key is there.
+  MoveOnlyInt value(30);
+  result = map.try_emplace(1, std::move(value), MoveOnlyInt(40));
+  EXPECT_FALSE(result.second);
+  EXPECT_EQ(20, result.first->second.second.data());
+  EXPECT_EQ(30, value.data());
+
+  auto it = map.try_emplace(map.end(), 0, MoveOnlyInt(50), MoveOnlyInt(60));
+  EXPECT_EQ(0, it->first);
+  EXPECT_EQ(map.begin(), it);
+  it = map.try_emplace(map.end(), 0, std::move(value), MoveOnlyInt(70));
+  EXPECT_EQ(50, it->second.first.data());
+  EXPECT_EQ(30, value.data());
+}
+
+TEST(BTreeMap, StringPieceLookups) {
+  btree_map<std::string, int> map = {{"one", 1}, {"two", 2}};
+  const StringPiece two("two and more", 3);
+  EXPECT_EQ(2, map.find(two)->second);
+  EXPECT_EQ(1, map.at(StringPiece("one")));
+  EXPECT_TRUE(map.contains("one"));
+  EXPECT_FALSE(map.contains(StringPiece("three")));
+  EXPECT_EQ("two", map.lower_bound(StringPiece("p"))->first);
+
+  EXPECT_TRUE(map.try_emplace(StringPiece("three"), 3).second);
+  EXPECT_EQ(3, map["three"]);
+  EXPECT_EQ(1u, map.erase(StringPiece("one")));
+  EXPECT_EQ(2u, map.size());
+}
+
+TEST(BTreeMap, IterateAndErase) {
+  btree_map<int, int> map;
+  for (int i = 0; i < 1000; ++i)
+    map[i] = i;
+  for (auto it = map.begin(); it != map.end();) {
+    if (it->first % 2)
+      it = map.erase(it);
+    else
+      ++it;
+  }
+  EXPECT_EQ(500u, map.size());
+  int expected_key = 0;
+  for (const auto& entry : map) {
+    EXPECT_EQ(expected_key, entry.first);
+    expected_key += 2;
+  }
+}
+
+TEST(BTreeMap, EraseRange) {
+  btree_map<int, int> map;
+  for (int i = 0; i < 1000; ++i)
+    map[i] = i;
+  auto it = map.erase(map.find(100), map.find(900));
+  EXPECT_EQ(900, it->first);
+  EXPECT_EQ(200u, map.size());
+  EXPECT_EQ(99, std::prev(it)->first);
+  EXPECT_EQ(map.end(), map.erase(map.begin(), map.end()));
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(0u, map.bytes_used());
+}
+
+TEST(BTreeMap, MovesValuesBetweenNodes) {
+  btree_map<int, std::unique_ptr<int>> map;
+  for (int i = 0; i < 1000; ++i)
+    map[(i * 7) % 1000] = std::make_unique<int>((i * 7) % 1000);
+  for (int i = 0; i < 1000; i += 3)
+    map.erase(i);
+  for (const auto& entry : map)
+    EXPECT_EQ(entry.first, *entry.second);
+}
+
+TEST(BTreeMap, CopyAndEquality) {
+  btree_map<std::string, int> map;
+  for (int i = 0; i < 1000; ++i)
+    map[NumberToString(i)] = i;
+
+  btree_map<std::string, int> copy = map;
+  EXPECT_EQ(map, copy);
+  copy["0"] = -1;
+  EXPECT_NE(map, copy);
+  EXPECT_LT(copy, map);
+  copy["0"] = 0;
+  copy.erase("1");
+  EXPECT_NE(map, copy);
+
+  btree_map<std::string, int> moved = std::move(copy);
+  EXPECT_EQ(999u, moved.size());
+  copy = moved;
+  EXPECT_EQ(moved, copy);
+}
+
+TEST(BTreeMap, Swap) {
+  btree_map<int, int> map1 = {{1, 1}, {2, 2}};
+  btree_map<int, int> map2 = {{3, 3}};
+  swap(map1, map2);
+  EXPECT_THAT(map1, ElementsAre(Pair(3, 3)));
+  EXPECT_THAT(map2, ElementsAre(Pair(1, 1), Pair(2, 2)));
+}
+
+TEST(BTreeMap, EraseIf) {
+  btree_map<int, int> map;
+  for (int i = 0; i < 1000; ++i)
+    map[i] = i;
+  EXPECT_EQ(666u, EraseIf(map, [](const std::pair<int, int>& entry) {
+              return entry.first % 3;
+            }));
+  EXPECT_EQ(334u, map.size());
+  EXPECT_EQ(3, std::next(map.begin())->first);
+}
+
+// Sorted inserts with a hint at the end or the beginning of the map, which
+// only split nodes at their ends.
+TEST(BTreeMap, SortedInsertsWithHint) {
+  btree_map<int, Padded> increasing;
+  btree_map<int, Padded> decreasing;
+  for (int i = 0; i < 1000; ++i) {
+    increasing.emplace_hint(increasing.end(), i, Padded(i));
+    decreasing.emplace_hint(decreasing.begin(), -i, Padded(-i));
+  }
+  EXPECT_EQ(1000u, increasing.size());
+  EXPECT_EQ(1000u, decreasing.size());
+  int key = 0;
+  for (const auto& entry : increasing)
+    EXPECT_EQ(key++, entry.second.value);
+  key = -999;
+  for (const auto& entry : decreasing)
+    EXPECT_EQ(key++, entry.second.value);
+}
+
+TEST(BTreeMap, EqualRange) {
+  btree_map<int, int> map;
+  for (int i = 0; i < 1000; i += 2)
+    map[i] = i;
+  auto range = map.equal_range(500);
+  EXPECT_EQ(500, range.first->first);
+  EXPECT_EQ(502, range.second->first);
+  range = map.equal_range(501);
+  EXPECT_EQ(range.first, range.second);
+  EXPECT_EQ(502, range.first->first);
+  range = map.equal_range(1000);
+  EXPECT_EQ(map.end(), range.first);
+  EXPECT_EQ(map.end(), range.second);
+}
+
+TEST(BTreeMap, MatchesStdMap) {
+  btree_map<int, IntValue> map;
+  RunRandomOperations(map);
+}
+
+TEST(BTreeMap, MatchesStdMapWithSmallNodes) {
+  btree_map<int, Padded> map;
+  RunRandomOperations(map);
+}
+
+}  // namespace base
@@ -0,0 +1,112 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_CONTAINERS_BTREE_SET_H_
+#define BASE_CONTAINERS_BTREE_SET_H_
+
+#include <functional>
+
+#include "base/containers/btree.h"
+#include "base/functional/identity.h"
+
+namespace base {
+
+// btree_set is a container with a std::set-like interface that stores its
+// elements in a B-tree. See btree_map.h for when to use it, and btree.h for
+// how it works.
+//
+// Unlike flat_set, it has no reserve(), capacity(), shrink_to_fit(),
+// extract() or replace(), and its iterators are bidirectional.
+//
+// QUICK REFERENCE
+//
+// Constructors (inputs need not be sorted):
+//   btree_set(const btree_set&);
+//   btree_set(btree_set&&);
+//   btree_set(InputIterator first, InputIterator last,
+//             const Compare& compare = Compare());
+//   btree_set(std::initializer_list<value_type> ilist,
+//             const Compare& comp = Compare());
+//
+// Constructors (inputs need to be sorted):
+//   btree_set(sorted_unique_t,
+//             InputIterator first, InputIterator last,
+//             const Compare& compare = Compare());
+//   btree_set(sorted_unique_t,
+//             std::initializer_list<value_type> ilist,
+//             const Compare& comp = Compare());
+//
+// Assignment functions:
+//   btree_set& operator=(const btree_set&);
+//   btree_set& operator=(btree_set&&);
+//   btree_set& operator=(initializer_list<value_type>);
+//
+// Size management functions:
+//   void   clear();
+//   size_t size() const;
+//   size_t max_size() const;
+//   bool   empty() const;
+//   size_t bytes_used() const;
+//
+// Iterator functions (all iterators are const_iterators):
+//   iterator               begin();
+//   const_iterator         begin() const;
+//   const_iterator         cbegin() const;
+//   iterator               end();
+//   const_iterator         end() const;
+//   const_iterator         cend() const;
+//   reverse_iterator       rbegin();
+//   const reverse_iterator rbegin() const;
+//   const_reverse_iterator crbegin() const;
+//   reverse_iterator       rend();
+//   const_reverse_iterator rend() const;
+//   const_reverse_iterator crend() const;
+//
+// Insert and accessor functions:
+//   pair<iterator, bool> insert(const key_type&);
+//   pair<iterator, bool> insert(key_type&&);
+//   iterator             insert(const_iterator hint, const key_type&);
+//   iterator             insert(const_iterator hint, key_type&&);
+//   void                 insert(InputIterator first, InputIterator last);
+//   pair<iterator, bool> emplace(Args&&...);
+//   iterator             emplace_hint(const_iterator, Args&&...);
+//
+// Erase functions:
+//   iterator erase(const_iterator);
+//   iterator erase(const_iterator first, const_iterator last);
+//   template <class K> size_t erase(const K& key);
+//
+// Comparators (see std::set documentation).
+//   key_compare   key_comp() const;
+//   value_compare value_comp() const;
+//
+// Search functions:
+//   template <typename K> size_t                   count(const K&) const;
+//   template <typename K> iterator                 find(const K&);
+//   template <typename K> const_iterator           find(const K&) const;
+//   template <typename K> bool                     contains(const K&) const;
+//   template <typename K> pair<iterator, iterator> equal_range(K&);
+//   template <typename K> iterator                 lower_bound(const K&);
+//   template <typename K> const_iterator           lower_bound(const K&) const;
+//   template <typename K> iterator                 upper_bound(const K&);
+//   template <typename K> const_iterator           upper_bound(const K&) const;
+//
+// General functions:
+//   void swap(btree_set&);
+//
+// Non-member operators:
+//   bool operator==(const btree_set&, const btree_set);
+//   bool operator!=(const btree_set&, const btree_set);
+//   bool operator<(const btree_set&, const btree_set);
+//   bool operator>(const btree_set&, const btree_set);
+//   bool operator>=(const btree_set&, const btree_set);
+//   bool operator<=(const btree_set&, const btree_set);
+//
+template <class Key, class Compare = std::less<>>
+using btree_set =
+    typename ::base::internal::btree<Key, Key, base::identity, Compare>;
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_BTREE_SET_H_
@@ -0,0 +1,251 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/btree_set.h"
+
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/rand_util.h"
+#include "base/strings/string_piece.h"
+#include "base/test/move_only_int.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using ::testing::ElementsAre;
+
+namespace base {
+
+namespace {
+
+// Counts its live instances.
+class Counted {
+ public:
+  explicit Counted(int value) : value_(value) { ++num_instances_; }
+  Counted(const Counted& other) : value_(other.value_) { ++num_instances_; }
+  Counted& operator=(const Counted& other) = default;
+  ~Counted() { --num_instances_; }
+
+  int value() const { return value_; }
+  static int num_instances() { return num_instances_; }
+
+  friend bool operator<(const Counted& lhs, const Counted& rhs) {
+    return lhs.value_ < rhs.value_;
+  }
+
+ private:
+  int value_;
+  static int num_instances_;
+};
+
+int Counted::num_instances_ = 0;
+
+// Orders keys from the largest.
+struct Greater {
+  bool operator()(int lhs, int rhs) const { return lhs > rhs; }
+};
+
+}  // namespace
+
+TEST(BTreeSet, Empty) {
+  btree_set<int> set;
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(0u, set.size());
+  EXPECT_EQ(0u, set.bytes_used());
+  EXPECT_EQ(set.begin(), set.end());
+  EXPECT_EQ(set.rbegin(), set.rend());
+  EXPECT_EQ(set.end(), set.find(1));
+  EXPECT_EQ(set.end(), set.lower_bound(1));
+  EXPECT_EQ(set.end(), set.upper_bound(1));
+  EXPECT_FALSE(set.contains(1));
+  EXPECT_EQ(0u, set.erase(1));
+  set.clear();
+  EXPECT_TRUE(set.empty());
+}
+
+TEST(BTreeSet, Constructors) {
+  std::vector<int> values = {3, 1, 2, 3};
+  btree_set<int> set(values.begin(), values.end());
+  EXPECT_THAT(set, ElementsAre(1, 2, 3));
+
+  btree_set<int> copy(set);
+  EXPECT_THAT(copy, ElementsAre(1, 2, 3));
+
+  btree_set<int> moved(std::move(copy));
+  EXPECT_THAT(moved, ElementsAre(1, 2, 3));
+  EXPECT_TRUE(copy.empty());  // NOLINT(bugprone-use-after-move)
+
+  moved = {5, 4};
+  EXPECT_THAT(moved, ElementsAre(4, 5));
+  moved = set;
+  EXPECT_EQ(set, moved);
+
+  btree_set<int> sorted(sorted_unique, {1, 2, 3});
+  EXPECT_EQ(set, sorted);
+
+  btree_set<int, Greater> greater(values.begin(), values.end());
+  EXPECT_THAT(greater, ElementsAre(3, 2, 1));
+}
+
+TEST(BTreeSet, InsertErase) {
+  btree_set<int> set;
+  for (int i = 0; i < 1000; ++i) {
+    const int value = (i * 337) % 1000;
+    auto result = set.insert(value);
+    EXPECT_TRUE(result.second);
+    EXPECT_EQ(value, *result.first);
+  }
+  EXPECT_FALSE(set.insert(10).second);
+  EXPECT_EQ(1000u, set.size());
+  EXPECT_EQ(1000, std::distance(set.begin(), set.end()));
+  EXPECT_TRUE(std::is_sorted(set.begin(), set.end()));
+
+  for (int i = 0; i < 1000; i += 2)
+    EXPECT_EQ(1u, set.erase(i));
+  EXPECT_EQ(500u, set.size());
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_EQ(i % 2 == 1, set.contains(i));
+
+  for (int i = 1; i < 1000; i += 2)
+    EXPECT_EQ(1u, set.erase(i));
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(0u, set.bytes_used());
+}
+
+TEST(BTreeSet, Bounds) {
+  btree_set<int> set;
+  for (int i = 0; i < 1000; i += 10)
+    set.insert(i);
+  for (int i = -5; i < 1005; ++i) {
+    auto lower = set.lower_bound(i);
+    auto upper = set.upper_bound(i);
+    const int expected_lower = (i + 9) / 10 * 10;
+    const int expected_upper = i < 0 ? 0 : (i + 10) / 10 * 10;
+    if (expected_lower >= 1000)
+      EXPECT_EQ(set.end(), lower);
+    else
+      EXPECT_EQ(std::max(0, expected_lower), *lower);
+    if (expected_upper >= 1000)
+      EXPECT_EQ(set.end(), upper);
+    else
+      EXPECT_EQ(expected_upper, *upper);
+  }
+}
+
+TEST(BTreeSet, ReverseIteration) {
+  btree_set<int> set;
+  for (int i = 0; i < 1000; ++i)
+    set.insert(i);
+  int expected = 999;
+  for (auto it = set.rbegin(); it != set.rend(); ++it)
+    EXPECT_EQ(expected--, *it);
+  EXPECT_EQ(-1, expected);
+  EXPECT_EQ(999, *std::prev(set.end()));
+}
+
+// Erasing and inserting as many elements keeps the nodes at least half full.
+TEST(BTreeSet, Churn) {
+  btree_set<int> set;
+  for (int i = 0; i < 100000; ++i) {
+    set.insert(static_cast<int>(RandGenerator(1000000)));
+    if (set.size() <= 1000)
+      continue;
+    auto it = set.lower_bound(static_cast<int>(RandGenerator(1000000)));
+    set.erase(it == set.end() ? set.begin() : it);
+  }
+  EXPECT_TRUE(std::is_sorted(set.begin(), set.end()));
+  EXPECT_EQ(set.size(),
+            static_cast<size_t>(std::distance(set.begin(), set.end())));
+  EXPECT_LE(set.bytes_used(), 3 * set.size() * sizeof(int) + 1024);
+}
+
+TEST(BTreeSet, MoveOnly) {
+  btree_set<MoveOnlyInt> set;
+  for (int i = 0; i < 1000; ++i)
+    set.insert(MoveOnlyInt(i));
+  set.emplace(1);
+  EXPECT_EQ(1000u, set.size());
+  EXPECT_TRUE(set.contains(MoveOnlyInt(999)));
+  for (int i = 0; i < 1000; i += 2)
+    set.erase(set.find(i));
+  EXPECT_EQ(500u, set.size());
+  EXPECT_EQ(1, set.begin()->data());
+}
+
+TEST(BTreeSet, DestroysElements) {
+  {
+    btree_set<Counted> set;
+    for (int i = 0; i < 1000; ++i)
+      set.emplace(i);
+    EXPECT_EQ(1000, Counted::num_instances());
+    set.erase(Counted(0));
+    EXPECT_EQ(999, Counted::num_instances());
+    set.erase(set.find(Counted(500)));
+    EXPECT_EQ(998, Counted::num_instances());
+    set.clear();
+    EXPECT_EQ(0, Counted::num_instances());
+    for (int i = 0; i < 10; ++i)
+      set.emplace(i);
+  }
+  EXPECT_EQ(0, Counted::num_instances());
+}
+
+TEST(BTreeSet, EraseRange) {
+  btree_set<int> set = {1, 2, 3, 4};
+  EXPECT_EQ(4, *set.erase(set.find(2), set.find(4)));
+  EXPECT_THAT(set, ElementsAre(1, 4));
+  EXPECT_EQ(set.end(), set.erase(set.begin(), set.end()));
+  EXPECT_TRUE(set.empty());
+}
+
+TEST(BTreeSet, StringPieceLookups) {
+  btree_set<std::string> set = {"a", "b"};
+  EXPECT_TRUE(set.contains(StringPiece("a")));
+  EXPECT_EQ("b", *set.find(StringPiece("bc", 1)));
+  EXPECT_EQ(1u, set.count("a"));
+  EXPECT_EQ(1u, set.erase(StringPiece("a")));
+  EXPECT_FALSE(set.contains("a"));
+}
+
+TEST(BTreeSet, Comparisons) {
+  btree_set<int> a = {1, 2};
+  btree_set<int> b = {1, 3};
+  EXPECT_LT(a, b);
+  EXPECT_LE(a, b);
+  EXPECT_GT(b, a);
+  EXPECT_GE(b, a);
+  EXPECT_NE(a, b);
+  b = {1, 2};
+  EXPECT_EQ(a, b);
+}
+
+TEST(BTreeSet, Swap) {
+  btree_set<int> a = {1, 2};
+  btree_set<int> b = {3};
+  swap(a, b);
+  EXPECT_THAT(a, ElementsAre(3));
+  EXPECT_THAT(b, ElementsAre(1, 2));
+}
+
+TEST(BTreeSet, MatchesStdSet) {
+  btree_set<int> set;
+  std::set<int> expected;
+  for (int i = 0; i < 100000; ++i) {
+    const int value = static_cast<int>(RandGenerator(5000));
+    if (RandGenerator(2)) {
+      EXPECT_EQ(expected.insert(value).second, set.insert(value).second);
+    } else {
+      EXPECT_EQ(expected.erase(value), set.erase(value));
+    }
+    ASSERT_EQ(expected.size(), set.size());
+  }
+  EXPECT_TRUE(std::equal(expected.begin(), expected.end(), set.begin(),
+                         set.end()));
+}
+
+}  // namespace base
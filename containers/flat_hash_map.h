@@ -0,0 +1,159 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_CONTAINERS_FLAT_HASH_MAP_H_
+#define BASE_CONTAINERS_FLAT_HASH_MAP_H_
+
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "base/check.h"
+#include "base/containers/flat_hash_table.h"
+
+namespace base {
+
+namespace internal {
+
+// Extracts the key of FlatHashMap values.
+struct FlatHashGetFirst {
+  template <class Key, class Mapped>
+  constexpr const Key& operator()(const std::pair<Key, Mapped>& p) const {
+    return p.first;
+  }
+};
+
+}  // namespace internal
+
+// FlatHashMap is a container with a std::unordered_map-like interface that
+// stores its contents in place, in an open-addressing hash table with SIMD
+// lookups (see flat_hash_table.h).
+//
+// Please see //base/containers/README.md for an overview of which container
+// to select.
+//
+// PROS
+//
+//  - O(1) inserts, lookups and removals, with good memory locality: a lookup
+//    usually touches one group of control bytes and one slot, where
+//    std::unordered_map follows a pointer to a node per element.
+//  - One allocation for the whole table instead of one per element.
+//  - Lookups with StringPiece in maps with std::string keys, which are hashed
+//    with FastHash() by default.
+//
+// CONS
+//
+//  - Iterators and references are invalidated when the map grows.
+//  - Empty slots cost sizeof(value_type) each, and the map is between 7/16
+//    and 7/8 full, so large values are better kept behind a pointer.
+//  - The order of iteration is unspecified, and changes as the map grows.
+//
+// IMPORTANT NOTES
+//
+//  - As with flat_map, value_type is std::pair<Key, Mapped> rather than
+//    std::pair<const Key, Mapped>, so that elements can be moved when the map
+//    grows. Keys must not be modified through iterators.
+//  - Custom Hash and KeyEqual types that are both transparent (declare
+//    is_transparent) allow lookups with other types than Key. They must agree
+//    on them: keys that compare equal must have equal hashes.
+//
+// QUICK REFERENCE
+//
+// Most of the core functionality is inherited from internal::FlatHashTable,
+// see flat_hash_set.h for those functions. The map adds:
+//
+//   mapped_type&         operator[](const key_type&);
+//   mapped_type&         operator[](key_type&&);
+//   mapped_type&         at(const K&);
+//   const mapped_type&   at(const K&) const;
+//   pair<iterator, bool> insert_or_assign(K&&, M&&);
+//   pair<iterator, bool> try_emplace(K&&, Args&&...);
+//
+template <class Key,
+          class Mapped,
+          class Hash = internal::FlatHashDefaultHash<Key>,
+          class KeyEqual = std::equal_to<>>
+class FlatHashMap
+    : public ::base::internal::FlatHashTable<Key,
+                                             std::pair<Key, Mapped>,
+                                             internal::FlatHashGetFirst,
+                                             Hash,
+                                             KeyEqual> {
+ private:
+  using table = typename ::base::internal::FlatHashTable<
+      Key,
+      std::pair<Key, Mapped>,
+      internal::FlatHashGetFirst,
+      Hash,
+      KeyEqual>;
+
+ public:
+  using key_type = typename table::key_type;
+  using mapped_type = Mapped;
+  using value_type = typename table::value_type;
+  using iterator = typename table::iterator;
+  using const_iterator = typename table::const_iterator;
+
+  // --------------------------------------------------------------------------
+  // Lifetime and assignments.
+
+  using table::table;
+  using table::operator=;
+
+  // Lookups of missing keys with at() will CHECK.
+  template <class K>
+  mapped_type& at(const K& key) {
+    iterator it = this->find(key);
+    CHECK(it != this->end());
+    return it->second;
+  }
+
+  template <class K>
+  const mapped_type& at(const K& key) const {
+    const_iterator it = this->find(key);
+    CHECK(it != this->end());
+    return it->second;
+  }
+
+  // --------------------------------------------------------------------------
+  // Map-specific insert operations.
+
+  mapped_type& operator[](const key_type& key) {
+    return try_emplace(key).first->second;
+  }
+
+  mapped_type& operator[](key_type&& key) {
+    return try_emplace(std::move(key)).first->second;
+  }
+
+  template <class K, class M>
+  std::pair<iterator, bool> insert_or_assign(K&& key, M&& obj) {
+    std::pair<iterator, bool> result =
+        try_emplace(std::forward<K>(key), std::forward<M>(obj));
+    if (!result.second)
+      result.first->second = std::forward<M>(obj);
+    return result;
+  }
+
+  // Constructs the mapped value from |args| only if |key| is not in the map.
+  template <class K, class... Args>
+  std::enable_if_t<std::is_constructible<key_type, K&&>::value,
+                   std::pair<iterator, bool>>
+  try_emplace(K&& key, Args&&... args) {
+    const typename table::template KeyTypeOrK<std::decay_t<K>>& key_ref = key;
+    const std::pair<size_t, bool> pos = this->FindOrPrepareInsert(key_ref);
+    if (pos.second) {
+      new (this->slot(pos.first))
+          value_type(std::piecewise_construct,
+                     std::forward_as_tuple(std::forward<K>(key)),
+                     std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+    return {this->IteratorAt(pos.first), pos.second};
+  }
+};
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_FLAT_HASH_MAP_H_
@@ -0,0 +1,150 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/flat_hash_map.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "base/containers/flat_map.h"
+#include "base/rand_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace base {
+
+namespace {
+
+constexpr char kMetricPrefix[] = "HashMap.";
+constexpr char kMetricInsertTime[] = "insert_time_per_key";
+constexpr char kMetricFindTime[] = "find_time_per_key";
+constexpr char kMetricFindMissingTime[] = "find_missing_time_per_key";
+
+constexpr size_t kSizes[] = {16, 1000, 100000, 1000000};
+constexpr size_t kNumLookups = 1000000;
+
+// Returns |n| distinct keys, which the |offset| of another call keeps apart.
+template <class Key>
+std::vector<Key> MakeKeys(size_t n, size_t offset);
+
+template <>
+std::vector<uint64_t> MakeKeys(size_t n, size_t offset) {
+  std::vector<uint64_t> keys(n);
+  for (size_t i = 0; i < n; ++i)
+    keys[i] = (offset + i + 1) * 0x9e3779b97f4a7c15;
+  return keys;
+}
+
+template <>
+std::vector<std::string> MakeKeys(size_t n, size_t offset) {
+  std::vector<std::string> keys(n);
+  for (size_t i = 0; i < n; ++i)
+    keys[i] = "key:" + NumberToString((offset + i + 1) * 0x9e3779b97f4a7c15);
+  return keys;
+}
+
+double NanosecondsPer(TimeDelta elapsed, size_t count) {
+  return static_cast<double>(elapsed.InNanoseconds()) / count;
+}
+
+template <class Map, class Key>
+void InsertAll(const std::vector<Key>& keys, Map* map) {
+  for (const Key& key : keys)
+    map->emplace(key, 0);
+}
+
+// flat_map is built in one go, as inserting keys one at a time is quadratic.
+template <class Key>
+void InsertAll(const std::vector<Key>& keys, flat_map<Key, int>* map) {
+  std::vector<std::pair<Key, int>> items;
+  items.reserve(keys.size());
+  for (const Key& key : keys)
+    items.emplace_back(key, 0);
+  *map = flat_map<Key, int>(std::move(items));
+}
+
+template <class Map, class Key>
+void RunMapTest(const std::string& story_name,
+                const std::vector<Key>& keys,
+                const std::vector<Key>& lookups,
+                const std::vector<Key>& missing_lookups) {
+  perf_test::PerfResultReporter reporter(kMetricPrefix, story_name);
+  reporter.RegisterImportantMetric(kMetricInsertTime, "ns");
+  reporter.RegisterImportantMetric(kMetricFindTime, "ns");
+  reporter.RegisterImportantMetric(kMetricFindMissingTime, "ns");
+
+  // Builds small maps repeatedly, so that it takes long enough to be timed.
+  const size_t repeats = std::max<size_t>(1, kNumLookups / keys.size());
+  std::vector<Map> maps(repeats);
+  TimeTicks start = TimeTicks::Now();
+  for (Map& map : maps)
+    InsertAll(keys, &map);
+  reporter.AddResult(kMetricInsertTime,
+                     NanosecondsPer(TimeTicks::Now() - start,
+                                    repeats * keys.size()));
+  const Map& map = maps.front();
+
+  size_t found = 0;
+  start = TimeTicks::Now();
+  for (const Key& key : lookups)
+    found += map.count(key);
+  reporter.AddResult(kMetricFindTime,
+                     NanosecondsPer(TimeTicks::Now() - start, lookups.size()));
+  EXPECT_EQ(lookups.size(), found);
+
+  found = 0;
+  start = TimeTicks::Now();
+  for (const Key& key : missing_lookups)
+    found += map.count(key);
+  reporter.AddResult(
+      kMetricFindMissingTime,
+      NanosecondsPer(TimeTicks::Now() - start, missing_lookups.size()));
+  EXPECT_EQ(0u, found);
+}
+
+template <class Key>
+void RunTests(const std::string& key_name) {
+  for (size_t size : kSizes) {
+    const std::vector<Key> keys = MakeKeys<Key>(size, 0);
+    // Looks the keys up in random order, so that the lookups of large maps
+    // miss the cache as they would in practice.
+    std::vector<Key> lookups;
+    lookups.reserve(kNumLookups);
+    for (size_t i = 0; i < kNumLookups; ++i)
+      lookups.push_back(keys[RandGenerator(size)]);
+    const std::vector<Key> missing_keys = MakeKeys<Key>(size, size);
+    std::vector<Key> missing_lookups;
+    missing_lookups.reserve(kNumLookups);
+    for (size_t i = 0; i < kNumLookups; ++i)
+      missing_lookups.push_back(missing_keys[RandGenerator(size)]);
+
+    const std::string suffix = "_" + key_name + "_" + NumberToString(size);
+    RunMapTest<FlatHashMap<Key, int>>("FlatHashMap" + suffix, keys, lookups,
+                                      missing_lookups);
+    RunMapTest<std::unordered_map<Key, int>>("unordered_map" + suffix, keys,
+                                             lookups, missing_lookups);
+    RunMapTest<flat_map<Key, int>>("flat_map" + suffix, keys, lookups,
+                                   missing_lookups);
+  }
+}
+
+}  // namespace
+
+TEST(FlatHashMapPerfTest, IntKeys) {
+  RunTests<uint64_t>("int");
+}
+
+TEST(FlatHashMapPerfTest, StringKeys) {
+  RunTests<std::string>("string");
+}
+
+}  // namespace base
@@ -0,0 +1,195 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/flat_hash_map.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/rand_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_piece.h"
+#include "base/test/move_only_int.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+// The table itself is mostly tested through FlatHashSet, in
+// flat_hash_set_unittest.cc.
+
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
+
+namespace base {
+
+namespace {
+
+struct MoveOnlyIntHash {
+  size_t operator()(const MoveOnlyInt& value) const {
+    return std::hash<int>()(value.data());
+  }
+};
+
+}  // namespace
+
+TEST(FlatHashMap, InitializerListConstructor) {
+  FlatHashMap<int, int> map = {{1, 1}, {2, 2}, {1, 3}};
+  EXPECT_THAT(map, UnorderedElementsAre(Pair(1, 1), Pair(2, 2)));
+}
+
+TEST(FlatHashMap, InsertFindSize) {
+  FlatHashMap<int, int> map;
+  EXPECT_TRUE(map.insert({1, 1}).second);
+  EXPECT_FALSE(map.insert({1, 2}).second);
+  EXPECT_TRUE(map.emplace(2, 2).second);
+  EXPECT_EQ(2u, map.size());
+  EXPECT_EQ(1, map.find(1)->second);
+  EXPECT_EQ(map.end(), map.find(3));
+}
+
+TEST(FlatHashMap, Subscript) {
+  FlatHashMap<MoveOnlyInt, int, MoveOnlyIntHash> map;
+  map[MoveOnlyInt(1)] = 10;
+  map[MoveOnlyInt(2)] = 20;
+  map[MoveOnlyInt(1)] += 1;
+  EXPECT_EQ(2u, map.size());
+  EXPECT_EQ(11, map[MoveOnlyInt(1)]);
+  EXPECT_EQ(20, map.at(MoveOnlyInt(2)));
+}
+
+TEST(FlatHashMap, SubscriptConstKey) {
+  FlatHashMap<std::string, int> map;
+  const std::string key("key");
+  EXPECT_EQ(0, map[key]);
+  map[key] = 1;
+  EXPECT_EQ(1, map[key]);
+  EXPECT_EQ(1u, map.size());
+}
+
+TEST(FlatHashMap, AtFunction) {
+  FlatHashMap<int, std::string> map = {{1, "a"}, {2, "b"}};
+  map.at(1) = "c";
+  const FlatHashMap<int, std::string>& const_map = map;
+  EXPECT_EQ("c", const_map.at(1));
+  EXPECT_EQ("b", const_map.at(2));
+  EXPECT_DEATH_IF_SUPPORTED(map.at(3), "");
+}
+
+TEST(FlatHashMap, InsertOrAssign) {
+  FlatHashMap<MoveOnlyInt, MoveOnlyInt, MoveOnlyIntHash> map;
+  auto result = map.insert_or_assign(MoveOnlyInt(1), MoveOnlyInt(10));
+  EXPECT_TRUE(result.second);
+  EXPECT_EQ(10, result.first->second.data());
+
+  result = map.insert_or_assign(MoveOnlyInt(1), MoveOnlyInt(11));
+  EXPECT_FALSE(result.second);
+  EXPECT_EQ(11, result.first->second.data());
+  EXPECT_EQ(1u, map.size());
+}
+
+TEST(FlatHashMap, TryEmplace) {
+  FlatHashMap<int, std::pair<MoveOnlyInt, MoveOnlyInt>> map;
+  auto result = map.try_emplace(1, MoveOnlyInt(10), MoveOnlyInt(20));
+  EXPECT_TRUE(result.second);
+  EXPECT_EQ(10, result.first->second.first.data());
+
+  // The arguments are not used when the key is there.
+  MoveOnlyInt value(30);
+  result = map.try_emplace(1, std::move(value), MoveOnlyInt(40));
+  EXPECT_FALSE(result.second);
+  EXPECT_EQ(20, result.first->second.second.data());
+  EXPECT_EQ(30, value.data());
+}
+
+TEST(FlatHashMap, StringPieceLookups) {
+  FlatHashMap<std::string, int> map = {{"one", 1}, {"two", 2}};
+  const StringPiece two("two and more", 3);
+  EXPECT_EQ(2, map.find(two)->second);
+  EXPECT_EQ(1, map.at(StringPiece("one")));
+  EXPECT_TRUE(map.contains("one"));
+  EXPECT_FALSE(map.contains(StringPiece("three")));
+
+  EXPECT_TRUE(map.try_emplace(StringPiece("three"), 3).second);
+  EXPECT_EQ(3, map["three"]);
+  EXPECT_EQ(1u, map.erase(StringPiece("one")));
+  EXPECT_EQ(2u, map.size());
+}
+
+TEST(FlatHashMap, String16Keys) {
+  FlatHashMap<std::u16string, int> map = {{u"one", 1}};
+  EXPECT_EQ(1, map.find(StringPiece16(u"one"))->second);
+}
+
+TEST(FlatHashMap, IterateAndErase) {
+  FlatHashMap<int, int> map;
+  for (int i = 0; i < 100; ++i)
+    map[i] = i;
+  for (auto it = map.begin(); it != map.end();) {
+    if (it->first % 2)
+      it = map.erase(it);
+    else
+      ++it;
+  }
+  EXPECT_EQ(50u, map.size());
+  for (const auto& entry : map)
+    EXPECT_EQ(0, entry.first % 2);
+}
+
+TEST(FlatHashMap, MovesValuesOnGrowth) {
+  FlatHashMap<int, std::unique_ptr<int>> map;
+  for (int i = 0; i < 1000; ++i)
+    map[i] = std::make_unique<int>(i);
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_EQ(i, *map[i]);
+}
+
+TEST(FlatHashMap, CopyAndEquality) {
+  FlatHashMap<std::string, int> map;
+  for (int i = 0; i < 100; ++i)
+    map[NumberToString(i)] = i;
+
+  FlatHashMap<std::string, int> copy = map;
+  EXPECT_EQ(map, copy);
+  copy["0"] = -1;
+  EXPECT_NE(map, copy);
+  copy["0"] = 0;
+  copy.erase("1");
+  EXPECT_NE(map, copy);
+}
+
+// Runs random operations on the map and on a std::map, and checks that they
+// agree.
+TEST(FlatHashMap, MatchesStdMap) {
+  FlatHashMap<uint64_t, uint64_t> map;
+  std::map<uint64_t, uint64_t> expected;
+  for (int i = 0; i < 100000; ++i) {
+    // Few enough keys for some of the operations to find them.
+    const uint64_t key = RandGenerator(2000);
+    switch (RandGenerator(4)) {
+      case 0:
+      case 1:
+        map[key] = i;
+        expected[key] = i;
+        break;
+      case 2:
+        EXPECT_EQ(expected.erase(key), map.erase(key));
+        break;
+      case 3: {
+        auto it = map.find(key);
+        auto expected_it = expected.find(key);
+        ASSERT_EQ(expected_it == expected.end(), it == map.end());
+        if (it != map.end())
+          EXPECT_EQ(expected_it->second, it->second);
+        break;
+      }
+    }
+    ASSERT_EQ(expected.size(), map.size());
+  }
+  const std::map<uint64_t, uint64_t> contents(map.begin(), map.end());
+  EXPECT_EQ(expected, contents);
+}
+
+}  // namespace base
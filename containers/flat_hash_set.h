@@ -0,0 +1,82 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_CONTAINERS_FLAT_HASH_SET_H_
+#define BASE_CONTAINERS_FLAT_HASH_SET_H_
+
+#include <functional>
+
+#include "base/containers/flat_hash_table.h"
+#include "base/functional/identity.h"
+
+namespace base {
+
+// FlatHashSet is a container with a std::unordered_set-like interface that
+// stores its elements in place, in an open-addressing hash table. See
+// flat_hash_map.h for when to use it, and flat_hash_table.h for how it works.
+//
+// QUICK REFERENCE
+//
+// Constructors:
+//   FlatHashSet(const FlatHashSet&);
+//   FlatHashSet(FlatHashSet&&);
+//   FlatHashSet(InputIterator first, InputIterator last);
+//   FlatHashSet(std::initializer_list<value_type> ilist);
+//
+// Assignment functions:
+//   FlatHashSet& operator=(const FlatHashSet&);
+//   FlatHashSet& operator=(FlatHashSet&&);
+//   FlatHashSet& operator=(initializer_list<value_type>);
+//
+// Memory management functions:
+//   void   reserve(size_t);
+//   size_t capacity() const;
+//
+// Size management functions:
+//   void   clear();
+//   size_t size() const;
+//   size_t max_size() const;
+//   bool   empty() const;
+//
+// Iterator functions (all iterators are const_iterators):
+//   iterator       begin();
+//   const_iterator begin() const;
+//   const_iterator cbegin() const;
+//   iterator       end();
+//   const_iterator end() const;
+//   const_iterator cend() const;
+//
+// Insert functions:
+//   pair<iterator, bool> insert(const key_type&);
+//   pair<iterator, bool> insert(key_type&&);
+//   void                 insert(InputIterator first, InputIterator last);
+//   pair<iterator, bool> emplace(Args&&...);
+//
+// Erase functions:
+//   iterator erase(const_iterator);
+//   iterator erase(const_iterator first, const_iterator last);
+//   template <class K> size_t erase(const K& key);
+//
+// Search functions:
+//   template <typename K> size_t         count(const K&) const;
+//   template <typename K> iterator       find(const K&);
+//   template <typename K> const_iterator find(const K&) const;
+//   template <typename K> bool           contains(const K&) const;
+//
+// General functions:
+//   void swap(FlatHashSet&);
+//
+// Non-member operators:
+//   bool operator==(const FlatHashSet&, const FlatHashSet);
+//   bool operator!=(const FlatHashSet&, const FlatHashSet);
+//
+template <class Key,
+          class Hash = internal::FlatHashDefaultHash<Key>,
+          class KeyEqual = std::equal_to<>>
+using FlatHashSet =
+    internal::FlatHashTable<Key, Key, base::identity, Hash, KeyEqual>;
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_FLAT_HASH_SET_H_
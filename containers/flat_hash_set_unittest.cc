@@ -0,0 +1,213 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/flat_hash_set.h"
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/strings/string_piece.h"
+#include "base/test/move_only_int.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using ::testing::UnorderedElementsAre;
+
+namespace base {
+
+namespace {
+
+// Gives all the values the same hash, so that they all collide.
+struct ConstantHash {
+  size_t operator()(int value) const { return 42; }
+};
+
+struct MoveOnlyIntHash {
+  size_t operator()(const MoveOnlyInt& value) const {
+    return std::hash<int>()(value.data());
+  }
+};
+
+// Counts its live instances.
+class Counted {
+ public:
+  explicit Counted(int value) : value_(value) { ++num_instances_; }
+  Counted(const Counted& other) : value_(other.value_) { ++num_instances_; }
+  ~Counted() { --num_instances_; }
+
+  int value() const { return value_; }
+  static int num_instances() { return num_instances_; }
+
+  friend bool operator==(const Counted& lhs, const Counted& rhs) {
+    return lhs.value_ == rhs.value_;
+  }
+
+  struct Hash {
+    size_t operator()(const Counted& counted) const { return counted.value(); }
+  };
+
+ private:
+  int value_;
+  static int num_instances_;
+};
+
+int Counted::num_instances_ = 0;
+
+}  // namespace
+
+TEST(FlatHashSet, Empty) {
+  FlatHashSet<int> set;
+  EXPECT_TRUE(set.empty());
+  EXPECT_EQ(0u, set.size());
+  EXPECT_EQ(0u, set.capacity());
+  EXPECT_EQ(set.begin(), set.end());
+  EXPECT_EQ(set.end(), set.find(1));
+  EXPECT_FALSE(set.contains(1));
+  EXPECT_EQ(0u, set.erase(1));
+  set.clear();
+  EXPECT_TRUE(set.empty());
+}
+
+TEST(FlatHashSet, Constructors) {
+  std::vector<int> values = {3, 1, 2, 3};
+  FlatHashSet<int> set(values.begin(), values.end());
+  EXPECT_THAT(set, UnorderedElementsAre(1, 2, 3));
+
+  FlatHashSet<int> copy(set);
+  EXPECT_THAT(copy, UnorderedElementsAre(1, 2, 3));
+
+  FlatHashSet<int> moved(std::move(copy));
+  EXPECT_THAT(moved, UnorderedElementsAre(1, 2, 3));
+  EXPECT_TRUE(copy.empty());  // NOLINT(bugprone-use-after-move)
+
+  moved = {4, 5};
+  EXPECT_THAT(moved, UnorderedElementsAre(4, 5));
+  moved = set;
+  EXPECT_EQ(set, moved);
+}
+
+TEST(FlatHashSet, InsertErase) {
+  FlatHashSet<int> set;
+  for (int i = 0; i < 1000; ++i) {
+    auto result = set.insert(i);
+    EXPECT_TRUE(result.second);
+    EXPECT_EQ(i, *result.first);
+  }
+  EXPECT_FALSE(set.insert(10).second);
+  EXPECT_EQ(1000u, set.size());
+  // The table is at most 7/8 full.
+  EXPECT_LE(set.size() * 8, set.capacity() * 7);
+
+  for (int i = 0; i < 1000; i += 2)
+    EXPECT_EQ(1u, set.erase(i));
+  EXPECT_EQ(500u, set.size());
+  for (int i = 0; i < 1000; ++i)
+    EXPECT_EQ(i % 2 == 1, set.contains(i));
+}
+
+TEST(FlatHashSet, Collisions) {
+  FlatHashSet<int, ConstantHash> set;
+  for (int i = 0; i < 100; ++i)
+    EXPECT_TRUE(set.insert(i).second);
+  for (int i = 0; i < 100; ++i)
+    EXPECT_TRUE(set.contains(i));
+  EXPECT_FALSE(set.contains(100));
+
+  for (int i = 0; i < 100; i += 3)
+    set.erase(i);
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(i % 3 != 0, set.contains(i));
+}
+
+// Erasing and inserting as many elements does not make the table grow without
+// bound, as it rehashes at the same capacity to drop the deleted slots.
+TEST(FlatHashSet, Churn) {
+  FlatHashSet<int> set;
+  for (int i = 0; i < 100000; ++i) {
+    set.insert(i);
+    if (i >= 100)
+      set.erase(i - 100);
+  }
+  EXPECT_EQ(100u, set.size());
+  EXPECT_LT(set.capacity(), 4 * 100u);
+  for (int i = 100000 - 100; i < 100000; ++i)
+    EXPECT_TRUE(set.contains(i));
+}
+
+TEST(FlatHashSet, Reserve) {
+  FlatHashSet<int> set;
+  set.reserve(1000);
+  const size_t capacity = set.capacity();
+  EXPECT_LE(1000u * 8, capacity * 7);
+  for (int i = 0; i < 1000; ++i)
+    set.insert(i);
+  EXPECT_EQ(capacity, set.capacity());
+}
+
+TEST(FlatHashSet, SmallTables) {
+  // Tables smaller than a group of control bytes fill up completely.
+  for (int size = 1; size < 40; ++size) {
+    FlatHashSet<int> set;
+    for (int i = 0; i < size; ++i)
+      set.insert(i * 1000);
+    EXPECT_EQ(static_cast<size_t>(size), set.size());
+    for (int i = 0; i < size; ++i)
+      EXPECT_TRUE(set.contains(i * 1000));
+    EXPECT_FALSE(set.contains(1));
+    EXPECT_EQ(static_cast<size_t>(size),
+              static_cast<size_t>(std::distance(set.begin(), set.end())));
+  }
+}
+
+TEST(FlatHashSet, MoveOnly) {
+  FlatHashSet<MoveOnlyInt, MoveOnlyIntHash> set;
+  for (int i = 0; i < 100; ++i)
+    set.insert(MoveOnlyInt(i));
+  set.emplace(1);
+  EXPECT_EQ(100u, set.size());
+  EXPECT_TRUE(set.contains(MoveOnlyInt(99)));
+}
+
+TEST(FlatHashSet, DestroysElements) {
+  {
+    FlatHashSet<Counted, Counted::Hash> set;
+    for (int i = 0; i < 100; ++i)
+      set.emplace(i);
+    EXPECT_EQ(100, Counted::num_instances());
+    set.erase(Counted(0));
+    EXPECT_EQ(99, Counted::num_instances());
+    set.clear();
+    EXPECT_EQ(0, Counted::num_instances());
+    for (int i = 0; i < 10; ++i)
+      set.emplace(i);
+  }
+  EXPECT_EQ(0, Counted::num_instances());
+}
+
+TEST(FlatHashSet, EraseRange) {
+  FlatHashSet<int> set = {1, 2, 3, 4};
+  EXPECT_EQ(set.end(), set.erase(set.begin(), set.end()));
+  EXPECT_TRUE(set.empty());
+}
+
+TEST(FlatHashSet, StringPieceLookups) {
+  FlatHashSet<std::string> set = {"a", "b"};
+  EXPECT_TRUE(set.contains(StringPiece("a")));
+  EXPECT_EQ("b", *set.find(StringPiece("bc", 1)));
+  EXPECT_EQ(1u, set.count("a"));
+  EXPECT_EQ(1u, set.erase(StringPiece("a")));
+  EXPECT_FALSE(set.contains("a"));
+}
+
+TEST(FlatHashSet, Swap) {
+  FlatHashSet<int> a = {1, 2};
+  FlatHashSet<int> b = {3};
+  swap(a, b);
+  EXPECT_THAT(a, UnorderedElementsAre(3));
+  EXPECT_THAT(b, UnorderedElementsAre(1, 2));
+}
+
+}  // namespace base
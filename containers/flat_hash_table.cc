@@ -0,0 +1,17 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/flat_hash_table.h"
+
+namespace base {
+namespace internal {
+
+alignas(16) const ctrl_t kFlatHashEmptyGroup[16] = {
+    kFlatHashSentinel, kFlatHashEmpty, kFlatHashEmpty, kFlatHashEmpty,
+    kFlatHashEmpty,    kFlatHashEmpty, kFlatHashEmpty, kFlatHashEmpty,
+    kFlatHashEmpty,    kFlatHashEmpty, kFlatHashEmpty, kFlatHashEmpty,
+    kFlatHashEmpty,    kFlatHashEmpty, kFlatHashEmpty, kFlatHashEmpty};
+
+}  // namespace internal
+}  // namespace base
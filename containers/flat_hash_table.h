@@ -0,0 +1,778 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_CONTAINERS_FLAT_HASH_TABLE_H_
+#define BASE_CONTAINERS_FLAT_HASH_TABLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "base/base_export.h"
+#include "base/bits.h"
+#include "base/check.h"
+#include "base/compiler_specific.h"
+#include "base/containers/flat_tree.h"
+#include "base/containers/span.h"
+#include "base/hash/hash.h"
+#include "base/strings/string_piece.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_64)
+#include <emmintrin.h>
+#endif
+
+namespace base {
+namespace internal {
+
+// FlatHashTable is the open-addressing hash table behind FlatHashMap and
+// FlatHashSet, in the style of Abseil's SwissTable
+// (https://abseil.io/about/design/swisstables).
+//
+// Next to the array of slots, the table keeps one control byte per slot: its
+// 7 low bits of hash when it holds an element, or whether it is empty or
+// deleted. Lookups load a whole group of control bytes at once, compare them
+// all with the 7 bits of the key they look for, and only compare the keys of
+// the slots that match. A group with an empty slot ends the probe sequence.
+
+// A control byte. Full slots have their 7 bits of hash, which are positive.
+using ctrl_t = int8_t;
+
+enum : ctrl_t {
+  kFlatHashEmpty = -128,  // 0b10000000
+  kFlatHashDeleted = -2,  // 0b11111110
+  // Follows the last slot, to stop iterations.
+  kFlatHashSentinel = -1,  // 0b11111111
+};
+
+inline bool IsFlatHashFull(ctrl_t ctrl) {
+  return ctrl >= 0;
+}
+
+inline bool IsFlatHashEmptyOrDeleted(ctrl_t ctrl) {
+  return ctrl < kFlatHashSentinel;
+}
+
+// The bits of a group that match some condition, |Shift| being the log2 of
+// the number of bits per control byte. Iterating yields the positions of the
+// matching control bytes within the group.
+template <class T, int Shift>
+class FlatHashBitMask {
+ public:
+  explicit FlatHashBitMask(T mask) : mask_(mask) {}
+
+  explicit operator bool() const { return mask_ != 0; }
+
+  // The position of the first matching control byte, which is also the
+  // number of non-matching control bytes at the start of the group.
+  uint32_t LowestBitSet() const {
+    return bits::CountTrailingZeroBits(mask_) >> Shift;
+  }
+
+  // The number of non-matching control bytes at the end of the group.
+  uint32_t LeadingZeros() const {
+    constexpr int kTotalBits = sizeof(T) * 8;
+    constexpr int kExtraBits = kTotalBits - (kGroupBits << Shift);
+    return (bits::CountLeadingZeroBits(mask_) - kExtraBits) >> Shift;
+  }
+
+  FlatHashBitMask begin() const { return *this; }
+  FlatHashBitMask end() const { return FlatHashBitMask(0); }
+
+  uint32_t operator*() const { return LowestBitSet(); }
+  FlatHashBitMask& operator++() {
+    mask_ &= mask_ - 1;
+    return *this;
+  }
+
+  friend bool operator!=(const FlatHashBitMask& a, const FlatHashBitMask& b) {
+    return a.mask_ != b.mask_;
+  }
+
+ private:
+  static constexpr int kGroupBits = Shift == 0 ? 16 : 8;
+
+  T mask_;
+};
+
+#if defined(ARCH_CPU_X86_64)
+
+// Matches 16 control bytes at a time with SSE2.
+class FlatHashGroup {
+ public:
+  static constexpr size_t kWidth = 16;
+
+  explicit FlatHashGroup(const ctrl_t* pos)
+      : ctrl_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {}
+
+  // The slots that may hold an element with these 7 bits of hash.
+  FlatHashBitMask<uint32_t, 0> Match(ctrl_t h2) const {
+    return FlatHashBitMask<uint32_t, 0>(static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_))));
+  }
+
+  FlatHashBitMask<uint32_t, 0> MatchEmpty() const {
+    return Match(kFlatHashEmpty);
+  }
+
+  FlatHashBitMask<uint32_t, 0> MatchEmptyOrDeleted() const {
+    return FlatHashBitMask<uint32_t, 0>(
+        static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_cmpgt_epi8(_mm_set1_epi8(kFlatHashSentinel), ctrl_))));
+  }
+
+  uint32_t CountLeadingEmptyOrDeleted() const {
+    const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+        _mm_cmpgt_epi8(_mm_set1_epi8(kFlatHashSentinel), ctrl_)));
+    return bits::CountTrailingZeroBits(mask + 1);
+  }
+
+ private:
+  __m128i ctrl_;
+};
+
+#else  // defined(ARCH_CPU_X86_64)
+
+// Matches 8 control bytes at a time in a 64-bit word. Match() can report false
+// positives, which only cost a key comparison.
+class FlatHashGroup {
+ public:
+  static constexpr size_t kWidth = 8;
+
+  explicit FlatHashGroup(const ctrl_t* pos) { memcpy(&ctrl_, pos, kWidth); }
+
+  FlatHashBitMask<uint64_t, 3> Match(ctrl_t h2) const {
+    const uint64_t x = ctrl_ ^ (kLsbs * static_cast<uint8_t>(h2));
+    return FlatHashBitMask<uint64_t, 3>((x - kLsbs) & ~x & kMsbs);
+  }
+
+  FlatHashBitMask<uint64_t, 3> MatchEmpty() const {
+    return FlatHashBitMask<uint64_t, 3>((ctrl_ & (~ctrl_ << 6)) & kMsbs);
+  }
+
+  FlatHashBitMask<uint64_t, 3> MatchEmptyOrDeleted() const {
+    return FlatHashBitMask<uint64_t, 3>((ctrl_ & (~ctrl_ << 7)) & kMsbs);
+  }
+
+  uint32_t CountLeadingEmptyOrDeleted() const {
+    const uint64_t not_empty_or_deleted = ~(ctrl_ & (~ctrl_ << 7)) & kMsbs;
+    return bits::CountTrailingZeroBits(not_empty_or_deleted) >> 3;
+  }
+
+ private:
+  static constexpr uint64_t kLsbs = 0x0101010101010101;
+  static constexpr uint64_t kMsbs = 0x8080808080808080;
+
+  uint64_t ctrl_;
+};
+
+#endif  // defined(ARCH_CPU_X86_64)
+
+// The control bytes of tables that have no slots: a sentinel, then empty
+// slots so that lookups end at once.
+BASE_EXPORT extern const ctrl_t kFlatHashEmptyGroup[16];
+static_assert(FlatHashGroup::kWidth <= 16, "kFlatHashEmptyGroup is too small");
+
+// Hashes strings and string pieces alike with FastHash(), so that maps with
+// string keys can be searched with StringPiece without a copy.
+template <class CharT>
+struct FlatHashStringHash {
+  using is_transparent = void;
+
+  size_t operator()(BasicStringPiece<CharT> str) const {
+    return FastHash(as_bytes(make_span(str)));
+  }
+};
+
+template <class Key>
+struct FlatHashDefaultHash : std::hash<Key> {};
+
+template <>
+struct FlatHashDefaultHash<std::string> : FlatHashStringHash<char> {};
+template <>
+struct FlatHashDefaultHash<StringPiece> : FlatHashStringHash<char> {};
+template <>
+struct FlatHashDefaultHash<std::u16string> : FlatHashStringHash<char16_t> {};
+template <>
+struct FlatHashDefaultHash<StringPiece16> : FlatHashStringHash<char16_t> {};
+
+// The positions of the groups that a lookup of |hash| loads, in order. Each
+// group starts |kWidth| slots further than the previous one did, so that all
+// the groups are visited when there are a power of two of them.
+class FlatHashProbeSeq {
+ public:
+  FlatHashProbeSeq(size_t hash, size_t mask)
+      : mask_(mask), offset_(hash & mask) {}
+
+  size_t offset() const { return offset_; }
+  size_t offset(size_t i) const { return (offset_ + i) & mask_; }
+
+  void next() {
+    index_ += FlatHashGroup::kWidth;
+    offset_ = (offset_ + index_) & mask_;
+  }
+
+ private:
+  const size_t mask_;
+  size_t offset_;
+  size_t index_ = 0;
+};
+
+template <class T>
+class FlatHashIterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = std::remove_const_t<T>;
+  using difference_type = ptrdiff_t;
+  using pointer = T*;
+  using reference = T&;
+
+  FlatHashIterator() = default;
+
+  // Converts iterators to const_iterators.
+  template <class U,
+            class = std::enable_if_t<std::is_convertible<U*, T*>::value>>
+  FlatHashIterator(const FlatHashIterator<U>& other)  // NOLINT
+      : ctrl_(other.ctrl_), slot_(other.slot_) {}
+
+  reference operator*() const { return *slot_; }
+  pointer operator->() const { return slot_; }
+
+  FlatHashIterator& operator++() {
+    ++ctrl_;
+    ++slot_;
+    SkipEmptyOrDeleted();
+    return *this;
+  }
+  FlatHashIterator operator++(int) {
+    FlatHashIterator old = *this;
+    ++*this;
+    return old;
+  }
+
+  friend bool operator==(const FlatHashIterator& a, const FlatHashIterator& b) {
+    return a.ctrl_ == b.ctrl_;
+  }
+  friend bool operator!=(const FlatHashIterator& a, const FlatHashIterator& b) {
+    return a.ctrl_ != b.ctrl_;
+  }
+
+ private:
+  template <class U>
+  friend class FlatHashIterator;
+  template <class Key,
+            class Value,
+            class GetKeyFromValue,
+            class KeyHash,
+            class KeyEqual>
+  friend class FlatHashTable;
+
+  FlatHashIterator(const ctrl_t* ctrl, T* slot) : ctrl_(ctrl), slot_(slot) {}
+
+  // Moves to the next full slot, or to the sentinel.
+  void SkipEmptyOrDeleted() {
+    while (IsFlatHashEmptyOrDeleted(*ctrl_)) {
+      const uint32_t shift = FlatHashGroup(ctrl_).CountLeadingEmptyOrDeleted();
+      ctrl_ += shift;
+      slot_ += shift;
+    }
+  }
+
+  const ctrl_t* ctrl_ = nullptr;
+  T* slot_ = nullptr;
+};
+
+// Keys are compared with KeyEqual, and hashed with KeyHash before the table
+// mixes the hash with a multiplication. The probe sequence starts from
+// hash >> 7 and the control bytes hold the low 7 bits, so unmixed hashes like
+// std::hash of integers, which is the identity, or of aligned pointers, whose
+// low bits are zero, would cluster in a few groups and share control bytes.
+// KeyHash and KeyEqual can be transparent to allow lookups with other types
+// than |Key|, in which case they must agree: equal keys must have equal hashes.
+//
+// A set is a table whose Value is its Key, and only has const iterators.
+template <class Key,
+          class Value,
+          class GetKeyFromValue,
+          class KeyHash,
+          class KeyEqual>
+class FlatHashTable {
+ public:
+  using key_type = Key;
+  using value_type = Value;
+  using hasher = KeyHash;
+  using key_equal = KeyEqual;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using iterator = FlatHashIterator<
+      std::conditional_t<std::is_same<Key, Value>::value, const Value, Value>>;
+  using const_iterator = FlatHashIterator<const Value>;
+
+  // --------------------------------------------------------------------------
+  // Lifetime.
+
+  FlatHashTable() = default;
+
+  template <class InputIterator>
+  FlatHashTable(InputIterator first, InputIterator last) {
+    insert(first, last);
+  }
+
+  FlatHashTable(std::initializer_list<value_type> ilist)
+      : FlatHashTable(ilist.begin(), ilist.end()) {}
+
+  FlatHashTable(const FlatHashTable& other)
+      : hash_(other.hash_), eq_(other.eq_) {
+    reserve(other.size());
+    // The keys are known to be unique, so they are not compared.
+    for (const value_type& value : other) {
+      const size_t hash = HashOf(GetKeyFromValue()(value));
+      const size_t pos = FindFirstNonFull(hash);
+      SetCtrl(pos, H2(hash));
+      new (slots_ + pos) value_type(value);
+    }
+    size_ = other.size_;
+    growth_left_ -= other.size_;
+  }
+
+  FlatHashTable(FlatHashTable&& other) noexcept
+      : ctrl_(std::exchange(other.ctrl_, EmptyGroup())),
+        slots_(std::exchange(other.slots_, nullptr)),
+        size_(std::exchange(other.size_, 0)),
+        capacity_(std::exchange(other.capacity_, 0)),
+        growth_left_(std::exchange(other.growth_left_, 0)),
+        hash_(other.hash_),
+        eq_(other.eq_) {}
+
+  FlatHashTable& operator=(const FlatHashTable& other) {
+    if (this != &other) {
+      FlatHashTable copy(other);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  FlatHashTable& operator=(FlatHashTable&& other) noexcept {
+    FlatHashTable moved(std::move(other));
+    swap(moved);
+    return *this;
+  }
+
+  FlatHashTable& operator=(std::initializer_list<value_type> ilist) {
+    clear();
+    insert(ilist.begin(), ilist.end());
+    return *this;
+  }
+
+  ~FlatHashTable() {
+    if (!capacity_)
+      return;
+    DestroySlots();
+    ::operator delete(ctrl_);
+  }
+
+  // --------------------------------------------------------------------------
+  // Memory management.
+  //
+  // The table grows before it is 7/8 full, to twice its capacity plus one.
+
+  // Makes room for |new_size| elements without rehashing.
+  void reserve(size_t new_size) {
+    if (new_size > size_ + growth_left_)
+      Resize(NormalizeCapacity(GrowthToLowerboundCapacity(new_size)));
+  }
+
+  // The number of slots, full or not.
+  size_t capacity() const { return capacity_; }
+
+  // --------------------------------------------------------------------------
+  // Size management.
+
+  // Destroys the elements, and keeps the slots for new ones.
+  void clear() {
+    if (!capacity_)
+      return;
+    DestroySlots();
+    ResetCtrl();
+    size_ = 0;
+    growth_left_ = CapacityToGrowth(capacity_);
+  }
+
+  size_t size() const { return size_; }
+  size_t max_size() const { return std::numeric_limits<ptrdiff_t>::max(); }
+  bool empty() const { return !size_; }
+
+  // --------------------------------------------------------------------------
+  // Iterators.
+  //
+  // The order of iteration is unspecified. All iterators are invalidated when
+  // an insertion makes the table grow.
+
+  iterator begin() {
+    iterator it(ctrl_, slots_);
+    it.SkipEmptyOrDeleted();
+    return it;
+  }
+  const_iterator begin() const {
+    return const_cast<FlatHashTable*>(this)->begin();
+  }
+  const_iterator cbegin() const { return begin(); }
+
+  iterator end() { return iterator(ctrl_ + capacity_, slots_ + capacity_); }
+  const_iterator end() const { return const_cast<FlatHashTable*>(this)->end(); }
+  const_iterator cend() const { return end(); }
+
+  // --------------------------------------------------------------------------
+  // Insert operations.
+  //
+  // Inserts nothing when there already is an element with the same key, and
+  // returns it instead.
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    const std::pair<size_t, bool> pos =
+        FindOrPrepareInsert(GetKeyFromValue()(value));
+    if (pos.second)
+      new (slots_ + pos.first) value_type(value);
+    return {IteratorAt(pos.first), pos.second};
+  }
+
+  std::pair<iterator, bool> insert(value_type&& value) {
+    const std::pair<size_t, bool> pos =
+        FindOrPrepareInsert(GetKeyFromValue()(value));
+    if (pos.second)
+      new (slots_ + pos.first) value_type(std::move(value));
+    return {IteratorAt(pos.first), pos.second};
+  }
+
+  template <class InputIterator>
+  void insert(InputIterator first, InputIterator last) {
+    if (is_multipass<InputIterator>())
+      reserve(size_ + std::distance(first, last));
+    for (; first != last; ++first)
+      emplace(*first);
+  }
+
+  // Constructs the value first, to know its key.
+  template <class... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    return insert(value_type(std::forward<Args>(args)...));
+  }
+
+  // --------------------------------------------------------------------------
+  // Erase operations.
+  //
+  // Erasing does not invalidate iterators to other elements.
+
+  iterator erase(const_iterator pos) {
+    DCHECK(pos != end());
+    EraseAt(static_cast<size_t>(pos.ctrl_ - ctrl_));
+    iterator next(pos.ctrl_, const_cast<value_type*>(pos.slot_));
+    next.SkipEmptyOrDeleted();
+    return next;
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    while (first != last)
+      first = erase(first);
+    return iterator(last.ctrl_, const_cast<value_type*>(last.slot_));
+  }
+
+  template <class K,
+            class = std::enable_if_t<
+                !std::is_convertible<const K&, const_iterator>::value>>
+  size_t erase(const K& key) {
+    const KeyTypeOrK<K>& key_ref = key;
+    const size_t pos = FindIndex(key_ref);
+    if (pos == capacity_)
+      return 0;
+    EraseAt(pos);
+    return 1;
+  }
+
+  // --------------------------------------------------------------------------
+  // Search operations.
+  //
+  // With a transparent KeyHash and KeyEqual, these accept any type that they
+  // do, e.g. StringPiece for std::string keys.
+
+  template <class K>
+  iterator find(const K& key) {
+    const KeyTypeOrK<K>& key_ref = key;
+    return IteratorAt(FindIndex(key_ref));
+  }
+
+  template <class K>
+  const_iterator find(const K& key) const {
+    return const_cast<FlatHashTable*>(this)->find(key);
+  }
+
+  template <class K>
+  bool contains(const K& key) const {
+    const KeyTypeOrK<K>& key_ref = key;
+    return FindIndex(key_ref) != capacity_;
+  }
+
+  template <class K>
+  size_t count(const K& key) const {
+    return contains(key) ? 1 : 0;
+  }
+
+  // --------------------------------------------------------------------------
+  // General operations.
+
+  hasher hash_function() const { return hash_; }
+  key_equal key_eq() const { return eq_; }
+
+  void swap(FlatHashTable& other) noexcept {
+    std::swap(ctrl_, other.ctrl_);
+    std::swap(slots_, other.slots_);
+    std::swap(size_, other.size_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(growth_left_, other.growth_left_);
+    std::swap(hash_, other.hash_);
+    std::swap(eq_, other.eq_);
+  }
+
+  friend void swap(FlatHashTable& lhs, FlatHashTable& rhs) noexcept {
+    lhs.swap(rhs);
+  }
+
+  // Tables are equal when they have equal elements, in whatever order.
+  friend bool operator==(const FlatHashTable& lhs, const FlatHashTable& rhs) {
+    if (lhs.size() != rhs.size())
+      return false;
+    for (const value_type& value : lhs) {
+      const size_t pos = rhs.FindIndex(GetKeyFromValue()(value));
+      if (pos == rhs.capacity_ || !(rhs.slots_[pos] == value))
+        return false;
+    }
+    return true;
+  }
+
+  friend bool operator!=(const FlatHashTable& lhs, const FlatHashTable& rhs) {
+    return !(lhs == rhs);
+  }
+
+ protected:
+  // If the hash and equality are not transparent we want to construct
+  // key_type once.
+  template <class K>
+  using KeyTypeOrK = std::conditional_t<
+      IsTransparentCompare<hasher>::value &&
+          IsTransparentCompare<key_equal>::value,
+      K,
+      key_type>;
+
+  // Returns the position of the element with |key|, or of a new slot for it
+  // which the caller must construct an element in. The second member tells
+  // which one.
+  template <class K>
+  std::pair<size_t, bool> FindOrPrepareInsert(const K& key) {
+    const size_t hash = HashOf(key);
+    FlatHashProbeSeq seq(H1(hash), capacity_);
+    while (true) {
+      const FlatHashGroup group(ctrl_ + seq.offset());
+      for (uint32_t i : group.Match(H2(hash))) {
+        const size_t pos = seq.offset(i);
+        if (eq_(key, GetKeyFromValue()(slots_[pos])))
+          return {pos, false};
+      }
+      if (group.MatchEmpty())
+        break;
+      seq.next();
+    }
+    return {PrepareInsert(hash), true};
+  }
+
+  template <class K>
+  size_t FindIndex(const K& key) const {
+    const size_t hash = HashOf(key);
+    FlatHashProbeSeq seq(H1(hash), capacity_);
+    while (true) {
+      const FlatHashGroup group(ctrl_ + seq.offset());
+      for (uint32_t i : group.Match(H2(hash))) {
+        const size_t pos = seq.offset(i);
+        if (LIKELY(eq_(key, GetKeyFromValue()(slots_[pos]))))
+          return pos;
+      }
+      if (LIKELY(group.MatchEmpty()))
+        return capacity_;
+      seq.next();
+    }
+  }
+
+  iterator IteratorAt(size_t pos) {
+    return iterator(ctrl_ + pos, slots_ + pos);
+  }
+
+  value_type* slot(size_t pos) { return slots_ + pos; }
+
+ private:
+  static ctrl_t* EmptyGroup() {
+    return const_cast<ctrl_t*>(kFlatHashEmptyGroup);
+  }
+
+  // The position of the first group to probe, and the bits of hash that the
+  // control byte keeps.
+  static size_t H1(size_t hash) { return hash >> 7; }
+  static ctrl_t H2(size_t hash) { return static_cast<ctrl_t>(hash & 0x7f); }
+
+  template <class K>
+  size_t HashOf(const K& key) const {
+    const uint64_t product =
+        static_cast<uint64_t>(hash_(key)) * 0x9e3779b97f4a7c15;
+    return static_cast<size_t>(product ^ (product >> 32));
+  }
+
+  // The capacity is always a power of two minus one, so that it is also the
+  // mask of slot positions.
+  static size_t NormalizeCapacity(size_t n) {
+    return n ? std::numeric_limits<size_t>::max() >>
+                   bits::CountLeadingZeroBits(n)
+             : 1;
+  }
+
+  // The number of elements that a table of |capacity| slots holds before it
+  // grows, i.e. 7/8 of its capacity. A table smaller than a group can be full,
+  // as lookups see the empty bytes past its end.
+  static size_t CapacityToGrowth(size_t capacity) {
+    if (FlatHashGroup::kWidth == 8 && capacity == 7)
+      return 6;
+    return capacity - capacity / 8;
+  }
+
+  static size_t GrowthToLowerboundCapacity(size_t growth) {
+    if (FlatHashGroup::kWidth == 8 && growth == 7)
+      return 8;
+    return growth + (growth - 1) / 7;
+  }
+
+  // The slots are in the same allocation as the control bytes, after them.
+  static size_t SlotOffset(size_t capacity) {
+    return bits::AlignUp(capacity + FlatHashGroup::kWidth, alignof(value_type));
+  }
+
+  // Sets the control byte of |pos|, and of its clone past the sentinel. Groups
+  // that start near the end of the table load the clones of the first control
+  // bytes, so that they never need to wrap around.
+  void SetCtrl(size_t pos, ctrl_t h) {
+    constexpr size_t kNumClonedBytes = FlatHashGroup::kWidth - 1;
+    ctrl_[pos] = h;
+    ctrl_[((pos - kNumClonedBytes) & capacity_) +
+          (kNumClonedBytes & capacity_)] = h;
+  }
+
+  void ResetCtrl() {
+    memset(ctrl_, kFlatHashEmpty, capacity_ + FlatHashGroup::kWidth);
+    ctrl_[capacity_] = kFlatHashSentinel;
+  }
+
+  void DestroySlots() {
+    for (size_t i = 0; i < capacity_; ++i) {
+      if (IsFlatHashFull(ctrl_[i]))
+        slots_[i].~value_type();
+    }
+  }
+
+  // Returns the first slot where an element with |hash| can go.
+  size_t FindFirstNonFull(size_t hash) const {
+    FlatHashProbeSeq seq(H1(hash), capacity_);
+    while (true) {
+      const auto mask = FlatHashGroup(ctrl_ + seq.offset()).MatchEmptyOrDeleted();
+      if (mask)
+        return seq.offset(mask.LowestBitSet());
+      seq.next();
+    }
+  }
+
+  size_t PrepareInsert(size_t hash) {
+    size_t pos = FindFirstNonFull(hash);
+    if (UNLIKELY(!growth_left_ && ctrl_[pos] != kFlatHashDeleted)) {
+      // Rehashing at the same capacity is enough when many of the slots are
+      // deleted ones, i.e. when at most 25/32 of them are full.
+      if (capacity_ > FlatHashGroup::kWidth && size_ * 32 <= capacity_ * 25)
+        Resize(capacity_);
+      else
+        Resize(capacity_ * 2 + 1);
+      pos = FindFirstNonFull(hash);
+    }
+    ++size_;
+    growth_left_ -= ctrl_[pos] == kFlatHashEmpty;
+    SetCtrl(pos, H2(hash));
+    return pos;
+  }
+
+  void EraseAt(size_t pos) {
+    DCHECK(IsFlatHashFull(ctrl_[pos]));
+    slots_[pos].~value_type();
+    --size_;
+    // The slot can become empty again if no lookup ever went past it, which is
+    // when the groups around it were never full.
+    const size_t pos_before = (pos - FlatHashGroup::kWidth) & capacity_;
+    const auto empty_after = FlatHashGroup(ctrl_ + pos).MatchEmpty();
+    const auto empty_before = FlatHashGroup(ctrl_ + pos_before).MatchEmpty();
+    const bool was_never_full =
+        empty_before && empty_after &&
+        empty_after.LowestBitSet() + empty_before.LeadingZeros() <
+            FlatHashGroup::kWidth;
+    SetCtrl(pos, was_never_full ? kFlatHashEmpty : kFlatHashDeleted);
+    growth_left_ += was_never_full;
+  }
+
+  void Resize(size_t new_capacity) {
+    DCHECK(bits::IsPowerOfTwo(new_capacity + 1));
+    ctrl_t* const old_ctrl = ctrl_;
+    value_type* const old_slots = slots_;
+    const size_t old_capacity = capacity_;
+
+    capacity_ = new_capacity;
+    ctrl_ = static_cast<ctrl_t*>(::operator new(
+        SlotOffset(capacity_) + capacity_ * sizeof(value_type)));
+    slots_ = reinterpret_cast<value_type*>(
+        reinterpret_cast<char*>(ctrl_) + SlotOffset(capacity_));
+    ResetCtrl();
+    growth_left_ = CapacityToGrowth(capacity_) - size_;
+
+    for (size_t i = 0; i < old_capacity; ++i) {
+      if (!IsFlatHashFull(old_ctrl[i]))
+        continue;
+      const size_t hash = HashOf(GetKeyFromValue()(old_slots[i]));
+      const size_t pos = FindFirstNonFull(hash);
+      SetCtrl(pos, H2(hash));
+      new (slots_ + pos) value_type(std::move(old_slots[i]));
+      old_slots[i].~value_type();
+    }
+    if (old_capacity)
+      ::operator delete(old_ctrl);
+  }
+
+  static_assert(alignof(value_type) <= alignof(std::max_align_t),
+                "over-aligned types are not supported");
+
+  ctrl_t* ctrl_ = EmptyGroup();
+  value_type* slots_ = nullptr;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+  size_t growth_left_ = 0;
+
+  NO_UNIQUE_ADDRESS hasher hash_;
+  NO_UNIQUE_ADDRESS key_equal eq_;
+};
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_FLAT_HASH_TABLE_H_
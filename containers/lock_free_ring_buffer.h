@@ -0,0 +1,378 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Bounded lock-free queues, to hand elements from thread to thread without a
+// Lock or a PostTask() per element:
+//
+//  - SpscRingBuffer, for a single producer thread and a single consumer thread
+//    at a time.
+//  - MpmcRingBuffer, for any number of producer and consumer threads.
+//
+// Pushing and popping never block: they fail when the queue is full or empty.
+// WaitableRingBuffer (waitable_ring_buffer.h) adds blocking Push() and Pop(),
+// and SequenceDrainedRingBuffer (sequence_drained_ring_buffer.h) hands the
+// elements to a sequence as they arrive.
+//
+// The batch versions of pushing and popping update the shared indices once per
+// batch rather than once per element, which matters when elements are small.
+//
+// Example:
+//
+//   SpscRingBuffer<std::unique_ptr<Frame>> frames(/*capacity=*/64);
+//
+//   // Producer thread.
+//   if (!frames.TryPush(std::move(frame)))
+//     ++dropped_frames;
+//
+//   // Consumer thread.
+//   while (absl::optional<std::unique_ptr<Frame>> frame = frames.TryPop())
+//     Render(std::move(*frame));
+
+#ifndef BASE_CONTAINERS_LOCK_FREE_RING_BUFFER_H_
+#define BASE_CONTAINERS_LOCK_FREE_RING_BUFFER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "base/bits.h"
+#include "base/check_op.h"
+#include "base/containers/span.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+
+namespace internal {
+
+// The indices that producers and consumers write are kept this many bytes
+// apart, so that they do not share a cache line.
+constexpr size_t kRingBufferCacheLineSize = 64;
+
+// Rounds |capacity| up to a power of two, so that indices wrap around with a
+// mask.
+inline size_t RoundUpRingBufferCapacity(size_t capacity) {
+  DCHECK_GT(capacity, 0u);
+  DCHECK_LE(capacity, size_t{1} << 31);
+  return size_t{1} << bits::Log2Ceiling(static_cast<uint32_t>(capacity));
+}
+
+// Uninitialized storage for an element.
+template <class T>
+using RingBufferStorage =
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+}  // namespace internal
+
+// A queue for one producer thread and one consumer thread. Threads may take
+// over either role, provided that the handover is synchronized, e.g. by
+// posting a task.
+template <class T>
+class SpscRingBuffer {
+ public:
+  using value_type = T;
+
+  // |capacity| is rounded up to a power of two.
+  explicit SpscRingBuffer(size_t capacity)
+      : capacity_(internal::RoundUpRingBufferCapacity(capacity)),
+        mask_(capacity_ - 1),
+        slots_(new internal::RingBufferStorage<T>[capacity_]) {}
+
+  SpscRingBuffer(const SpscRingBuffer&) = delete;
+  SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+  ~SpscRingBuffer() {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    for (size_t i = head_.load(std::memory_order_relaxed); i != tail; ++i)
+      Slot(i)->~T();
+  }
+
+  // Producer side. Each fails and leaves its arguments untouched if the queue
+  // is full.
+
+  template <class... Args>
+  bool TryEmplace(Args&&... args) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cached_head_ == capacity_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail - cached_head_ == capacity_)
+        return false;
+    }
+    new (Slot(tail)) T(std::forward<Args>(args)...);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool TryPush(const T& value) { return TryEmplace(value); }
+  bool TryPush(T&& value) { return TryEmplace(std::move(value)); }
+
+  // Moves as many elements from the front of |values| as fit, and returns how
+  // many.
+  size_t TryPushBatch(span<T> values) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (capacity_ - (tail - cached_head_) < values.size())
+      cached_head_ = head_.load(std::memory_order_acquire);
+    const size_t count =
+        std::min(values.size(), capacity_ - (tail - cached_head_));
+    for (size_t i = 0; i < count; ++i)
+      new (Slot(tail + i)) T(std::move(values[i]));
+    tail_.store(tail + count, std::memory_order_release);
+    return count;
+  }
+
+  // Consumer side.
+
+  absl::optional<T> TryPop() {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_)
+        return absl::nullopt;
+    }
+    T* slot = Slot(head);
+    absl::optional<T> value(std::move(*slot));
+    slot->~T();
+    head_.store(head + 1, std::memory_order_release);
+    return value;
+  }
+
+  // Moves up to |out.size()| elements into the front of |out|, and returns
+  // how many.
+  size_t TryPopBatch(span<T> out) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (cached_tail_ - head < out.size())
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+    const size_t count = std::min(out.size(), cached_tail_ - head);
+    for (size_t i = 0; i < count; ++i) {
+      T* slot = Slot(head + i);
+      out[i] = std::move(*slot);
+      slot->~T();
+    }
+    head_.store(head + count, std::memory_order_release);
+    return count;
+  }
+
+  // Either side, or other threads. These are only snapshots while the queue
+  // is in use.
+
+  size_t size() const {
+    // Loads the head first, so that the size is never negative.
+    const size_t head = head_.load(std::memory_order_acquire);
+    return tail_.load(std::memory_order_acquire) - head;
+  }
+  bool empty() const { return size() == 0; }
+
+  size_t capacity() const { return capacity_; }
+
+ private:
+  T* Slot(size_t index) {
+    return reinterpret_cast<T*>(&slots_[index & mask_]);
+  }
+
+  // Read by both sides, and never written.
+  const size_t capacity_;
+  const size_t mask_;
+  const std::unique_ptr<internal::RingBufferStorage<T>[]> slots_;
+
+  // Written by the producer. |cached_head_| is its last view of |head_|, to
+  // read the consumer's cache line only when the queue looks full.
+  char padding1_[internal::kRingBufferCacheLineSize];
+  std::atomic<size_t> tail_{0};
+  size_t cached_head_ = 0;
+
+  // Written by the consumer.
+  char padding2_[internal::kRingBufferCacheLineSize];
+  std::atomic<size_t> head_{0};
+  size_t cached_tail_ = 0;
+
+  char padding3_[internal::kRingBufferCacheLineSize];
+};
+
+// A queue for any number of producer and consumer threads, after Dmitry
+// Vyukov's bounded MPMC queue. Each slot has a sequence number that tells
+// which turn of the producers or consumers it is waiting for, so that threads
+// claim slots with a compare-and-swap of the shared index, and then fill or
+// empty them without blocking the others.
+template <class T>
+class MpmcRingBuffer {
+ public:
+  using value_type = T;
+
+  // |capacity| is rounded up to a power of two, and to at least 2: with a
+  // single slot, the sequence number of a full slot would also let the next
+  // producer in.
+  explicit MpmcRingBuffer(size_t capacity)
+      : capacity_(
+            internal::RoundUpRingBufferCapacity(std::max<size_t>(capacity, 2))),
+        mask_(capacity_ - 1),
+        cells_(new Cell[capacity_]) {
+    for (size_t i = 0; i < capacity_; ++i)
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  MpmcRingBuffer(const MpmcRingBuffer&) = delete;
+  MpmcRingBuffer& operator=(const MpmcRingBuffer&) = delete;
+
+  ~MpmcRingBuffer() {
+    while (TryPop()) {
+    }
+  }
+
+  // Each fails and leaves its arguments untouched if the queue is full.
+
+  template <class... Args>
+  bool TryEmplace(Args&&... args) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      const intptr_t dif = SequenceDifference(pos, 0);
+      if (dif == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (dif < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    Cell& cell = cells_[pos & mask_];
+    new (&cell.storage) T(std::forward<Args>(args)...);
+    cell.sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool TryPush(const T& value) { return TryEmplace(value); }
+  bool TryPush(T&& value) { return TryEmplace(std::move(value)); }
+
+  // Moves as many elements from the front of |values| as there are
+  // consecutive free slots, and returns how many.
+  size_t TryPushBatch(span<T> values) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    const size_t count = ClaimBatch(&enqueue_pos_, &pos, 0, values.size());
+    for (size_t i = 0; i < count; ++i) {
+      Cell& cell = cells_[(pos + i) & mask_];
+      new (&cell.storage) T(std::move(values[i]));
+      cell.sequence.store(pos + i + 1, std::memory_order_release);
+    }
+    return count;
+  }
+
+  absl::optional<T> TryPop() {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      const intptr_t dif = SequenceDifference(pos, 1);
+      if (dif == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (dif < 0) {
+        return absl::nullopt;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    Cell& cell = cells_[pos & mask_];
+    T* slot = reinterpret_cast<T*>(&cell.storage);
+    absl::optional<T> value(std::move(*slot));
+    slot->~T();
+    cell.sequence.store(pos + capacity_, std::memory_order_release);
+    return value;
+  }
+
+  // Moves up to |out.size()| elements into the front of |out|, and returns
+  // how many.
+  size_t TryPopBatch(span<T> out) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    const size_t count = ClaimBatch(&dequeue_pos_, &pos, 1, out.size());
+    for (size_t i = 0; i < count; ++i) {
+      Cell& cell = cells_[(pos + i) & mask_];
+      T* slot = reinterpret_cast<T*>(&cell.storage);
+      out[i] = std::move(*slot);
+      slot->~T();
+      cell.sequence.store(pos + i + capacity_, std::memory_order_release);
+    }
+    return count;
+  }
+
+  // These are only snapshots while the queue is in use.
+
+  size_t size() const {
+    const size_t dequeue_pos = dequeue_pos_.load(std::memory_order_acquire);
+    const size_t enqueue_pos = enqueue_pos_.load(std::memory_order_acquire);
+    // The positions are read at different times, so the difference can be
+    // out of range.
+    const intptr_t size = static_cast<intptr_t>(enqueue_pos - dequeue_pos);
+    return static_cast<size_t>(
+        std::min(std::max<intptr_t>(size, 0), static_cast<intptr_t>(capacity_)));
+  }
+  bool empty() const { return size() == 0; }
+
+  size_t capacity() const { return capacity_; }
+
+ private:
+  struct Cell {
+    // |pos| when the slot is free for the producer of |pos|, and |pos| + 1
+    // when it holds the element for the consumer of |pos|.
+    std::atomic<size_t> sequence;
+    internal::RingBufferStorage<T> storage;
+  };
+
+  // Returns how far the slot of |pos| is from the turn of |pos|: zero when it
+  // is its turn, negative when the slot is still in use by the previous turn,
+  // and positive when another thread already took |pos|. |offset| is 0 for
+  // producers and 1 for consumers.
+  intptr_t SequenceDifference(size_t pos, size_t offset) const {
+    const size_t sequence =
+        cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+    return static_cast<intptr_t>(sequence - (pos + offset));
+  }
+
+  // Claims up to |max_count| consecutive slots whose turn it is, starting at
+  // |*pos| which it updates, by moving |*index| past them. Returns how many.
+  size_t ClaimBatch(std::atomic<size_t>* index,
+                    size_t* pos,
+                    size_t offset,
+                    size_t max_count) {
+    while (max_count) {
+      size_t count = 0;
+      intptr_t dif = 0;
+      while (count < max_count) {
+        dif = SequenceDifference(*pos + count, offset);
+        if (dif != 0)
+          break;
+        ++count;
+      }
+      if (count == 0 && dif < 0)
+        return 0;
+      if (count > 0 && index->compare_exchange_weak(
+                           *pos, *pos + count, std::memory_order_relaxed)) {
+        return count;
+      }
+      if (count == 0)
+        *pos = index->load(std::memory_order_relaxed);
+    }
+    return 0;
+  }
+
+  const size_t capacity_;
+  const size_t mask_;
+  const std::unique_ptr<Cell[]> cells_;
+
+  char padding1_[internal::kRingBufferCacheLineSize];
+  std::atomic<size_t> enqueue_pos_{0};
+  char padding2_[internal::kRingBufferCacheLineSize];
+  std::atomic<size_t> dequeue_pos_{0};
+  char padding3_[internal::kRingBufferCacheLineSize];
+};
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_LOCK_FREE_RING_BUFFER_H_
@@ -0,0 +1,329 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/lock_free_ring_buffer.h"
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "base/containers/span.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+
+namespace {
+
+constexpr int kNumElements = 100000;
+
+// Counts how many of its instances are alive.
+class Counted {
+ public:
+  explicit Counted(int* num_alive) : num_alive_(num_alive) { ++*num_alive_; }
+  Counted(const Counted& other) : num_alive_(other.num_alive_) {
+    ++*num_alive_;
+  }
+  ~Counted() { --*num_alive_; }
+
+ private:
+  int* const num_alive_;
+};
+
+// Pushes |count| consecutive integers from |first|, in batches of
+// |batch_size| if it is not zero.
+template <class RingBuffer>
+class Producer : public DelegateSimpleThread::Delegate {
+ public:
+  Producer(RingBuffer* ring_buffer, int first, int count, size_t batch_size)
+      : ring_buffer_(ring_buffer),
+        first_(first),
+        count_(count),
+        batch_size_(batch_size) {}
+
+  void Run() override {
+    const int end = first_ + count_;
+    if (!batch_size_) {
+      for (int i = first_; i < end;) {
+        if (ring_buffer_->TryPush(i))
+          ++i;
+        else
+          PlatformThread::YieldCurrentThread();
+      }
+      return;
+    }
+    std::vector<int> batch;
+    for (int i = first_; i < end;) {
+      batch.clear();
+      while (batch.size() < batch_size_ && i < end)
+        batch.push_back(i++);
+      span<int> values(batch);
+      while (!values.empty()) {
+        const size_t pushed = ring_buffer_->TryPushBatch(values);
+        if (!pushed)
+          PlatformThread::YieldCurrentThread();
+        values = values.subspan(pushed);
+      }
+    }
+  }
+
+ private:
+  RingBuffer* const ring_buffer_;
+  const int first_;
+  const int count_;
+  const size_t batch_size_;
+};
+
+// Pops |count| elements, in batches of |batch_size| if it is not zero, into
+// |popped|.
+template <class RingBuffer>
+class Consumer : public DelegateSimpleThread::Delegate {
+ public:
+  Consumer(RingBuffer* ring_buffer, int count, size_t batch_size)
+      : ring_buffer_(ring_buffer), count_(count), batch_size_(batch_size) {}
+
+  void Run() override {
+    popped_.reserve(count_);
+    std::vector<int> batch(batch_size_);
+    while (popped_.size() < static_cast<size_t>(count_)) {
+      if (!batch_size_) {
+        if (absl::optional<int> value = ring_buffer_->TryPop())
+          popped_.push_back(*value);
+        else
+          PlatformThread::YieldCurrentThread();
+        continue;
+      }
+      const size_t max_count =
+          std::min(batch.size(), static_cast<size_t>(count_) - popped_.size());
+      const size_t count =
+          ring_buffer_->TryPopBatch(make_span(batch.data(), max_count));
+      if (!count)
+        PlatformThread::YieldCurrentThread();
+      popped_.insert(popped_.end(), batch.begin(), batch.begin() + count);
+    }
+  }
+
+  const std::vector<int>& popped() const { return popped_; }
+
+ private:
+  RingBuffer* const ring_buffer_;
+  const int count_;
+  const size_t batch_size_;
+  std::vector<int> popped_;
+};
+
+template <class RingBuffer>
+void TestOneProducerOneConsumer(size_t batch_size) {
+  RingBuffer ring_buffer(64);
+  Producer<RingBuffer> producer(&ring_buffer, 0, kNumElements, batch_size);
+  Consumer<RingBuffer> consumer(&ring_buffer, kNumElements, batch_size);
+  DelegateSimpleThread producer_thread(&producer, "Producer");
+  DelegateSimpleThread consumer_thread(&consumer, "Consumer");
+  producer_thread.Start();
+  consumer_thread.Start();
+  producer_thread.Join();
+  consumer_thread.Join();
+
+  ASSERT_EQ(static_cast<size_t>(kNumElements), consumer.popped().size());
+  for (int i = 0; i < kNumElements; ++i)
+    ASSERT_EQ(i, consumer.popped()[i]);
+  EXPECT_TRUE(ring_buffer.empty());
+}
+
+}  // namespace
+
+template <class RingBuffer>
+class LockFreeRingBufferTest : public testing::Test {};
+
+using RingBufferTypes =
+    testing::Types<SpscRingBuffer<int>, MpmcRingBuffer<int>>;
+TYPED_TEST_SUITE(LockFreeRingBufferTest, RingBufferTypes);
+
+TYPED_TEST(LockFreeRingBufferTest, RoundsCapacityUp) {
+  EXPECT_EQ(2u, TypeParam(2).capacity());
+  EXPECT_EQ(8u, TypeParam(5).capacity());
+  EXPECT_EQ(64u, TypeParam(64).capacity());
+}
+
+TYPED_TEST(LockFreeRingBufferTest, PushPop) {
+  TypeParam ring_buffer(4);
+  EXPECT_TRUE(ring_buffer.empty());
+  EXPECT_EQ(absl::nullopt, ring_buffer.TryPop());
+
+  // Goes around the buffer several times.
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(ring_buffer.TryPush(3 * i));
+    EXPECT_TRUE(ring_buffer.TryPush(3 * i + 1));
+    EXPECT_TRUE(ring_buffer.TryPush(3 * i + 2));
+    EXPECT_EQ(3u, ring_buffer.size());
+    EXPECT_EQ(3 * i, ring_buffer.TryPop());
+    EXPECT_EQ(3 * i + 1, ring_buffer.TryPop());
+    EXPECT_EQ(3 * i + 2, ring_buffer.TryPop());
+    EXPECT_TRUE(ring_buffer.empty());
+  }
+}
+
+TYPED_TEST(LockFreeRingBufferTest, Full) {
+  TypeParam ring_buffer(4);
+  for (int i = 0; i < 4; ++i)
+    EXPECT_TRUE(ring_buffer.TryPush(i));
+  EXPECT_FALSE(ring_buffer.TryPush(4));
+  EXPECT_EQ(4u, ring_buffer.size());
+
+  EXPECT_EQ(0, ring_buffer.TryPop());
+  EXPECT_TRUE(ring_buffer.TryPush(4));
+  for (int i = 1; i <= 4; ++i)
+    EXPECT_EQ(i, ring_buffer.TryPop());
+}
+
+TYPED_TEST(LockFreeRingBufferTest, Batches) {
+  TypeParam ring_buffer(8);
+  std::vector<int> values = {0, 1, 2, 3, 4, 5};
+  EXPECT_EQ(6u, ring_buffer.TryPushBatch(values));
+
+  std::vector<int> out(4);
+  EXPECT_EQ(4u, ring_buffer.TryPopBatch(out));
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3}), out);
+
+  // Wraps around, and only pushes what fits.
+  values = {6, 7, 8, 9, 10, 11, 12};
+  EXPECT_EQ(6u, ring_buffer.TryPushBatch(values));
+  EXPECT_EQ(0u, ring_buffer.TryPushBatch(values));
+  EXPECT_EQ(8u, ring_buffer.size());
+
+  out.assign(10, -1);
+  EXPECT_EQ(8u, ring_buffer.TryPopBatch(out));
+  EXPECT_EQ(std::vector<int>({4, 5, 6, 7, 8, 9, 10, 11, -1, -1}), out);
+  EXPECT_EQ(0u, ring_buffer.TryPopBatch(out));
+}
+
+TYPED_TEST(LockFreeRingBufferTest, OneProducerOneConsumer) {
+  TestOneProducerOneConsumer<TypeParam>(0);
+}
+
+TYPED_TEST(LockFreeRingBufferTest, OneProducerOneConsumerBatches) {
+  TestOneProducerOneConsumer<TypeParam>(16);
+}
+
+TEST(SpscRingBufferTest, MoveOnly) {
+  SpscRingBuffer<std::unique_ptr<int>> ring_buffer(1);
+  EXPECT_TRUE(ring_buffer.TryPush(std::make_unique<int>(1)));
+
+  // A failed push leaves the value where it was.
+  auto value = std::make_unique<int>(2);
+  EXPECT_FALSE(ring_buffer.TryPush(std::move(value)));
+  ASSERT_TRUE(value);
+
+  EXPECT_EQ(1, **ring_buffer.TryPop());
+  EXPECT_TRUE(ring_buffer.TryPush(std::move(value)));
+  EXPECT_EQ(2, **ring_buffer.TryPop());
+}
+
+TEST(SpscRingBufferTest, DestroysRemainingElements) {
+  int num_alive = 0;
+  {
+    SpscRingBuffer<Counted> ring_buffer(4);
+    for (int i = 0; i < 3; ++i)
+      EXPECT_TRUE(ring_buffer.TryEmplace(&num_alive));
+    ring_buffer.TryPop();
+    EXPECT_EQ(2, num_alive);
+  }
+  EXPECT_EQ(0, num_alive);
+}
+
+TEST(SpscRingBufferTest, CapacityOne) {
+  SpscRingBuffer<int> ring_buffer(1);
+  EXPECT_EQ(1u, ring_buffer.capacity());
+  EXPECT_TRUE(ring_buffer.TryPush(1));
+  EXPECT_FALSE(ring_buffer.TryPush(2));
+  EXPECT_EQ(1, ring_buffer.TryPop());
+  EXPECT_EQ(absl::nullopt, ring_buffer.TryPop());
+}
+
+TEST(MpmcRingBufferTest, MoveOnly) {
+  MpmcRingBuffer<std::unique_ptr<int>> ring_buffer(2);
+  EXPECT_TRUE(ring_buffer.TryPush(std::make_unique<int>(1)));
+  EXPECT_TRUE(ring_buffer.TryPush(std::make_unique<int>(2)));
+
+  auto value = std::make_unique<int>(3);
+  EXPECT_FALSE(ring_buffer.TryPush(std::move(value)));
+  ASSERT_TRUE(value);
+
+  EXPECT_EQ(1, **ring_buffer.TryPop());
+  EXPECT_TRUE(ring_buffer.TryPush(std::move(value)));
+  EXPECT_EQ(2, **ring_buffer.TryPop());
+  EXPECT_EQ(3, **ring_buffer.TryPop());
+}
+
+TEST(MpmcRingBufferTest, CapacityOne) {
+  MpmcRingBuffer<int> ring_buffer(1);
+  EXPECT_EQ(2u, ring_buffer.capacity());
+  EXPECT_TRUE(ring_buffer.TryPush(1));
+  EXPECT_TRUE(ring_buffer.TryPush(2));
+  EXPECT_FALSE(ring_buffer.TryPush(3));
+  EXPECT_EQ(1, ring_buffer.TryPop());
+  EXPECT_EQ(2, ring_buffer.TryPop());
+  EXPECT_EQ(absl::nullopt, ring_buffer.TryPop());
+}
+
+TEST(MpmcRingBufferTest, DestroysRemainingElements) {
+  int num_alive = 0;
+  {
+    MpmcRingBuffer<Counted> ring_buffer(4);
+    for (int i = 0; i < 3; ++i)
+      EXPECT_TRUE(ring_buffer.TryEmplace(&num_alive));
+    ring_buffer.TryPop();
+    EXPECT_EQ(2, num_alive);
+  }
+  EXPECT_EQ(0, num_alive);
+}
+
+// Each element is popped exactly once, whichever thread pushes or pops it.
+TEST(MpmcRingBufferTest, ManyProducersManyConsumers) {
+  using RingBuffer = MpmcRingBuffer<int>;
+  constexpr int kNumThreads = 4;
+  constexpr int kElementsPerThread = kNumElements / kNumThreads;
+  RingBuffer ring_buffer(64);
+
+  std::vector<std::unique_ptr<Producer<RingBuffer>>> producers;
+  std::vector<std::unique_ptr<Consumer<RingBuffer>>> consumers;
+  std::vector<std::unique_ptr<DelegateSimpleThread>> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    // Half of the threads use batches.
+    const size_t batch_size = i % 2 ? 8 : 0;
+    producers.push_back(std::make_unique<Producer<RingBuffer>>(
+        &ring_buffer, i * kElementsPerThread, kElementsPerThread, batch_size));
+    consumers.push_back(std::make_unique<Consumer<RingBuffer>>(
+        &ring_buffer, kElementsPerThread, batch_size));
+    threads.push_back(std::make_unique<DelegateSimpleThread>(
+        producers.back().get(), "Producer"));
+    threads.push_back(std::make_unique<DelegateSimpleThread>(
+        consumers.back().get(), "Consumer"));
+  }
+  for (auto& thread : threads)
+    thread->Start();
+  for (auto& thread : threads)
+    thread->Join();
+
+  std::vector<int> times_popped(kNumThreads * kElementsPerThread);
+  for (const auto& consumer : consumers) {
+    // Elements of the same producer come out in order.
+    std::vector<int> last_popped(kNumThreads, -1);
+    for (int value : consumer->popped()) {
+      ++times_popped[value];
+      const int producer = value / kElementsPerThread;
+      EXPECT_LT(last_popped[producer], value);
+      last_popped[producer] = value;
+    }
+  }
+  for (int times : times_popped)
+    ASSERT_EQ(1, times);
+  EXPECT_TRUE(ring_buffer.empty());
+}
+
+}  // namespace base
@@ -0,0 +1,156 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_CONTAINERS_SEQUENCE_DRAINED_RING_BUFFER_H_
+#define BASE_CONTAINERS_SEQUENCE_DRAINED_RING_BUFFER_H_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/callback.h"
+#include "base/containers/lock_free_ring_buffer.h"
+#include "base/containers/span.h"
+#include "base/location.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/memory/weak_ptr.h"
+#include "base/sequence_checker.h"
+#include "base/sequenced_task_runner.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+
+// SequenceDrainedRingBuffer hands the elements that any thread pushes into a
+// SpscRingBuffer or an MpmcRingBuffer to a callback on the sequence that
+// created it.
+//
+// It posts a task when the queue becomes non-empty, rather than a task per
+// element, and that task drains all the elements that arrive until the queue
+// is empty again. Producers that push while a drain is pending only pay for a
+// memory fence.
+//
+// Producers must stop pushing before the SequenceDrainedRingBuffer is
+// destroyed. The elements that are still in the queue then are destroyed
+// without being handed to the callback.
+//
+// Example:
+//
+//   SequenceDrainedRingBuffer<MpmcRingBuffer<Sample>> samples_(
+//       /*capacity=*/1024,
+//       BindRepeating(&Profiler::OnSample, Unretained(this)));
+//
+//   // Sampling threads.
+//   if (!samples_.TryPush(sample))
+//     dropped_samples_.fetch_add(1, std::memory_order_relaxed);
+template <class RingBuffer>
+class SequenceDrainedRingBuffer {
+ public:
+  using value_type = typename RingBuffer::value_type;
+  using DrainCallback = RepeatingCallback<void(value_type)>;
+
+  // The drain task hands out at most this many elements before it yields the
+  // sequence to other tasks, and posts itself again.
+  static constexpr size_t kMaxElementsPerTask = 64;
+
+  SequenceDrainedRingBuffer(size_t capacity, DrainCallback drain_callback)
+      : ring_buffer_(capacity),
+        task_runner_(SequencedTaskRunnerHandle::Get()),
+        drain_callback_(std::move(drain_callback)) {
+    weak_this_ = weak_factory_.GetWeakPtr();
+  }
+
+  SequenceDrainedRingBuffer(const SequenceDrainedRingBuffer&) = delete;
+  SequenceDrainedRingBuffer& operator=(const SequenceDrainedRingBuffer&) =
+      delete;
+
+  ~SequenceDrainedRingBuffer() {
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  }
+
+  // These can be called on any thread, and fail if the queue is full.
+
+  bool TryPush(const value_type& value) {
+    if (!ring_buffer_.TryPush(value))
+      return false;
+    ScheduleDrain();
+    return true;
+  }
+
+  bool TryPush(value_type&& value) {
+    if (!ring_buffer_.TryPush(std::move(value)))
+      return false;
+    ScheduleDrain();
+    return true;
+  }
+
+  size_t TryPushBatch(span<value_type> values) {
+    const size_t count = ring_buffer_.TryPushBatch(values);
+    if (count)
+      ScheduleDrain();
+    return count;
+  }
+
+  size_t size() const { return ring_buffer_.size(); }
+  bool empty() const { return ring_buffer_.empty(); }
+  size_t capacity() const { return ring_buffer_.capacity(); }
+
+ private:
+  void ScheduleDrain() {
+    // Pairs with the fence in Drain(): either this thread sees the drain
+    // still pending, or the drain sees the element that this thread pushed.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (drain_pending_.load(std::memory_order_relaxed) ||
+        drain_pending_.exchange(true, std::memory_order_relaxed)) {
+      return;
+    }
+    task_runner_->PostTask(
+        FROM_HERE, BindOnce(&SequenceDrainedRingBuffer::Drain, weak_this_));
+  }
+
+  void Drain() {
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+    // The callback may destroy |this|.
+    const WeakPtr<SequenceDrainedRingBuffer> self = weak_this_;
+    for (size_t i = 0; i < kMaxElementsPerTask; ++i) {
+      absl::optional<value_type> value = ring_buffer_.TryPop();
+      if (!value) {
+        drain_pending_.store(false, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // An element that was pushed before the fence is handed out now.
+        // Producers that push after it post another drain.
+        if (ring_buffer_.empty() ||
+            drain_pending_.exchange(true, std::memory_order_relaxed)) {
+          return;
+        }
+        continue;
+      }
+      drain_callback_.Run(std::move(*value));
+      if (!self)
+        return;
+    }
+    task_runner_->PostTask(
+        FROM_HERE, BindOnce(&SequenceDrainedRingBuffer::Drain, weak_this_));
+  }
+
+  RingBuffer ring_buffer_;
+  const scoped_refptr<SequencedTaskRunner> task_runner_;
+  const DrainCallback drain_callback_;
+
+  // Whether a drain task is posted or running, and will hand out the elements
+  // that are pushed before it finds the queue empty.
+  std::atomic<bool> drain_pending_{false};
+
+  SEQUENCE_CHECKER(sequence_checker_);
+
+  // Copied by producers on other threads, which WeakPtrFactory does not allow.
+  WeakPtr<SequenceDrainedRingBuffer> weak_this_;
+  WeakPtrFactory<SequenceDrainedRingBuffer> weak_factory_{this};
+};
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_SEQUENCE_DRAINED_RING_BUFFER_H_
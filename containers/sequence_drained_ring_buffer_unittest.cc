@@ -0,0 +1,141 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/sequence_drained_ring_buffer.h"
+
+#include <memory>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/containers/lock_free_ring_buffer.h"
+#include "base/run_loop.h"
+#include "base/test/bind.h"
+#include "base/test/task_environment.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+// Pushes |count| consecutive integers from |first|.
+template <class RingBuffer>
+class Producer : public DelegateSimpleThread::Delegate {
+ public:
+  Producer(RingBuffer* ring_buffer, int first, int count)
+      : ring_buffer_(ring_buffer), first_(first), count_(count) {}
+
+  void Run() override {
+    for (int i = first_; i < first_ + count_;) {
+      if (ring_buffer_->TryPush(i))
+        ++i;
+      else
+        PlatformThread::YieldCurrentThread();
+    }
+  }
+
+ private:
+  RingBuffer* const ring_buffer_;
+  const int first_;
+  const int count_;
+};
+
+}  // namespace
+
+class SequenceDrainedRingBufferTest : public testing::Test {
+ protected:
+  test::SingleThreadTaskEnvironment task_environment_;
+};
+
+TEST_F(SequenceDrainedRingBufferTest, DrainsOnSequence) {
+  std::vector<int> drained;
+  SequenceDrainedRingBuffer<SpscRingBuffer<int>> ring_buffer(
+      8, BindLambdaForTesting([&](int value) { drained.push_back(value); }));
+  EXPECT_TRUE(ring_buffer.TryPush(1));
+  EXPECT_TRUE(ring_buffer.TryPush(2));
+  std::vector<int> values = {3, 4};
+  EXPECT_EQ(2u, ring_buffer.TryPushBatch(values));
+  EXPECT_TRUE(drained.empty());
+
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(std::vector<int>({1, 2, 3, 4}), drained);
+  EXPECT_TRUE(ring_buffer.empty());
+
+  // The next push posts another drain.
+  EXPECT_TRUE(ring_buffer.TryPush(5));
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(std::vector<int>({1, 2, 3, 4, 5}), drained);
+}
+
+TEST_F(SequenceDrainedRingBufferTest, YieldsToOtherTasks) {
+  using RingBuffer = SequenceDrainedRingBuffer<MpmcRingBuffer<int>>;
+  std::vector<int> drained;
+  RingBuffer ring_buffer(
+      256, BindLambdaForTesting([&](int value) { drained.push_back(value); }));
+  constexpr int kNumElements = RingBuffer::kMaxElementsPerTask + 10;
+  for (int i = 0; i < kNumElements; ++i)
+    EXPECT_TRUE(ring_buffer.TryPush(i));
+  // Runs between the first drain task and the next one.
+  SequencedTaskRunnerHandle::Get()->PostTask(
+      FROM_HERE, BindLambdaForTesting([&] { drained.push_back(-1); }));
+
+  RunLoop().RunUntilIdle();
+  std::vector<int> expected;
+  for (int i = 0; i < kNumElements; ++i) {
+    if (i == static_cast<int>(RingBuffer::kMaxElementsPerTask))
+      expected.push_back(-1);
+    expected.push_back(i);
+  }
+  EXPECT_EQ(expected, drained);
+}
+
+TEST_F(SequenceDrainedRingBufferTest, CallbackDestroysRingBuffer) {
+  using RingBuffer = SequenceDrainedRingBuffer<SpscRingBuffer<int>>;
+  std::unique_ptr<RingBuffer> ring_buffer;
+  int num_drained = 0;
+  ring_buffer = std::make_unique<RingBuffer>(
+      8, BindLambdaForTesting([&](int value) {
+        ++num_drained;
+        ring_buffer.reset();
+      }));
+  EXPECT_TRUE(ring_buffer->TryPush(1));
+  EXPECT_TRUE(ring_buffer->TryPush(2));
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(1, num_drained);
+}
+
+TEST_F(SequenceDrainedRingBufferTest, ManyProducers) {
+  using RingBuffer = SequenceDrainedRingBuffer<MpmcRingBuffer<int>>;
+  constexpr int kNumThreads = 4;
+  constexpr int kElementsPerThread = 10000;
+  RunLoop run_loop;
+  std::vector<int> times_drained(kNumThreads * kElementsPerThread);
+  int num_drained = 0;
+  RingBuffer ring_buffer(64, BindLambdaForTesting([&](int value) {
+                           ++times_drained[value];
+                           if (++num_drained == kNumThreads * kElementsPerThread)
+                             run_loop.Quit();
+                         }));
+
+  std::vector<std::unique_ptr<Producer<RingBuffer>>> producers;
+  std::vector<std::unique_ptr<DelegateSimpleThread>> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    producers.push_back(std::make_unique<Producer<RingBuffer>>(
+        &ring_buffer, i * kElementsPerThread, kElementsPerThread));
+    threads.push_back(std::make_unique<DelegateSimpleThread>(
+        producers.back().get(), "Producer"));
+    threads.back()->Start();
+  }
+  run_loop.Run();
+  for (auto& thread : threads)
+    thread->Join();
+
+  for (int times : times_drained)
+    ASSERT_EQ(1, times);
+  EXPECT_TRUE(ring_buffer.empty());
+}
+
+}  // namespace base
@@ -0,0 +1,252 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This file contains a thread-safe cache that approximates least-recently-used
+// eviction, for caches that are shared by many threads and would otherwise be
+// an MRUCache behind a global lock.
+//
+// The keys are spread over shards, each with its own lock, so that threads
+// working on different keys rarely contend. Each shard keeps its entries in a
+// contiguous array, and evicts with the CLOCK algorithm: a hit only sets a bit
+// on the entry instead of moving it to the front of a list, and eviction
+// sweeps over the array, sparing and clearing entries that have their bit set.
+//
+// Entries have a cost, which is 1 by default so that the cache is bounded by
+// its number of entries, but can be e.g. their size in bytes. The maximum cost
+// is split evenly between the shards.
+//
+// Example:
+//
+//   ShardedLRUCache<std::string, scoped_refptr<Session>> sessions(
+//       /*max_cost=*/1000);
+//   sessions.ListenForMemoryPressure();
+//   ...
+//   sessions.Put(host, session);
+//   ...
+//   absl::optional<scoped_refptr<Session>> session = sessions.Get(host);
+
+#ifndef BASE_CONTAINERS_SHARDED_LRU_CACHE_H_
+#define BASE_CONTAINERS_SHARDED_LRU_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/bits.h"
+#include "base/check_op.h"
+#include "base/location.h"
+#include "base/memory/memory_pressure_listener.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+
+template <class KeyType, class ValueType, class HashType = std::hash<KeyType>>
+class ShardedLRUCache {
+ public:
+  static constexpr size_t kDefaultNumShards = 16;
+
+  // |max_cost| is split evenly between |num_shards| shards, which must be a
+  // power of two. An entry that costs more than the share of its shard is not
+  // kept.
+  explicit ShardedLRUCache(size_t max_cost,
+                           size_t num_shards = kDefaultNumShards)
+      : shards_(new Shard[num_shards]),
+        num_shards_(num_shards),
+        shard_shift_(64 - bits::Log2Floor(static_cast<uint32_t>(num_shards))) {
+    DCHECK(bits::IsPowerOfTwo(num_shards));
+    DCHECK_LE(num_shards, 1u << 16);
+    DCHECK_GE(max_cost, num_shards);
+    for (size_t i = 0; i < num_shards_; ++i)
+      shards_[i].max_cost = max_cost / num_shards_;
+  }
+
+  ShardedLRUCache(const ShardedLRUCache&) = delete;
+  ShardedLRUCache& operator=(const ShardedLRUCache&) = delete;
+
+  ~ShardedLRUCache() = default;
+
+  // Returns a copy of the value of |key|, or nullopt if it is not in the
+  // cache, and marks it as recently used.
+  absl::optional<ValueType> Get(const KeyType& key) {
+    Shard& shard = ShardFor(key);
+    AutoLock lock(shard.lock);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end())
+      return absl::nullopt;
+    Slot& slot = shard.slots[it->second];
+    slot.referenced = true;
+    return slot.value;
+  }
+
+  // Returns whether |key| is in the cache, without marking it as used.
+  bool Contains(const KeyType& key) const {
+    const Shard& shard = ShardFor(key);
+    AutoLock lock(shard.lock);
+    return shard.index.find(key) != shard.index.end();
+  }
+
+  // Inserts |value| for |key|, replacing any previous value, and evicts
+  // entries of the same shard until its cost fits again. |cost| must be
+  // positive.
+  void Put(const KeyType& key, ValueType value, size_t cost = 1) {
+    DCHECK_GT(cost, 0u);
+    Shard& shard = ShardFor(key);
+    AutoLock lock(shard.lock);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end())
+      shard.EraseSlot(it->second);
+    if (cost > shard.max_cost)
+      return;
+    shard.ShrinkToCost(shard.max_cost - cost);
+    shard.index.emplace(key, shard.slots.size());
+    shard.slots.push_back({key, std::move(value), cost, true});
+    shard.total_cost += cost;
+  }
+
+  // Removes |key| from the cache. Returns whether it was there.
+  bool Erase(const KeyType& key) {
+    Shard& shard = ShardFor(key);
+    AutoLock lock(shard.lock);
+    auto it = shard.index.find(key);
+    if (it == shard.index.end())
+      return false;
+    shard.EraseSlot(it->second);
+    return true;
+  }
+
+  // Removes all the entries.
+  void Clear() {
+    for (size_t i = 0; i < num_shards_; ++i) {
+      AutoLock lock(shards_[i].lock);
+      shards_[i].ShrinkToCost(0);
+    }
+  }
+
+  // Returns the number of entries and their total cost. These are only
+  // snapshots when other threads use the cache.
+  size_t size() const {
+    size_t size = 0;
+    for (size_t i = 0; i < num_shards_; ++i) {
+      AutoLock lock(shards_[i].lock);
+      size += shards_[i].slots.size();
+    }
+    return size;
+  }
+
+  size_t total_cost() const {
+    size_t total_cost = 0;
+    for (size_t i = 0; i < num_shards_; ++i) {
+      AutoLock lock(shards_[i].lock);
+      total_cost += shards_[i].total_cost;
+    }
+    return total_cost;
+  }
+
+  // Sheds entries on memory pressure notifications: at moderate pressure until
+  // each shard is down to half its maximum cost, and all of them at critical
+  // pressure. Notifications are received on the current sequence, but the cache
+  // can still be used from any thread.
+  void ListenForMemoryPressure() {
+    memory_pressure_listener_ = std::make_unique<MemoryPressureListener>(
+        FROM_HERE, BindRepeating(&ShardedLRUCache::OnMemoryPressure,
+                                 Unretained(this)));
+  }
+
+  // Sheds entries as above. Owners that already listen for memory pressure can
+  // call this instead of ListenForMemoryPressure().
+  void OnMemoryPressure(
+      MemoryPressureListener::MemoryPressureLevel memory_pressure_level) {
+    switch (memory_pressure_level) {
+      case MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE:
+        break;
+      case MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE:
+        for (size_t i = 0; i < num_shards_; ++i) {
+          AutoLock lock(shards_[i].lock);
+          shards_[i].ShrinkToCost(shards_[i].max_cost / 2);
+        }
+        break;
+      case MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL:
+        Clear();
+        break;
+    }
+  }
+
+ private:
+  struct Slot {
+    KeyType key;
+    ValueType value;
+    size_t cost;
+    // Set on insertion and on every hit, and cleared when the clock hand
+    // passes.
+    bool referenced;
+  };
+
+  struct Shard {
+    // Removes the entry at |pos|, and moves the last entry into its place so
+    // that the entries stay contiguous.
+    void EraseSlot(size_t pos) EXCLUSIVE_LOCKS_REQUIRED(lock) {
+      total_cost -= slots[pos].cost;
+      index.erase(slots[pos].key);
+      if (pos != slots.size() - 1) {
+        slots[pos] = std::move(slots.back());
+        index[slots[pos].key] = pos;
+      }
+      slots.pop_back();
+    }
+
+    // Evicts entries until the total cost is at most |cost|, sparing the ones
+    // used since the clock hand last passed them.
+    void ShrinkToCost(size_t cost) EXCLUSIVE_LOCKS_REQUIRED(lock) {
+      while (total_cost > cost) {
+        if (hand >= slots.size())
+          hand = 0;
+        Slot& slot = slots[hand];
+        if (slot.referenced) {
+          slot.referenced = false;
+          ++hand;
+        } else {
+          // Moves the last entry, which is one of the newest, into the hole,
+          // and leaves it for the next sweep.
+          EraseSlot(hand);
+          ++hand;
+        }
+      }
+    }
+
+    mutable Lock lock;
+    std::vector<Slot> slots GUARDED_BY(lock);
+    // Maps each key to the position of its entry in |slots|.
+    std::unordered_map<KeyType, size_t, HashType> index GUARDED_BY(lock);
+    size_t hand GUARDED_BY(lock) = 0;
+    size_t total_cost GUARDED_BY(lock) = 0;
+    size_t max_cost = 0;
+  };
+
+  // Picks the shard from the high bits of the mixed hash, as the low bits are
+  // the ones hash tables use, and std::hash of integers is the identity.
+  Shard& ShardFor(const KeyType& key) const {
+    const uint64_t hash =
+        static_cast<uint64_t>(HashType()(key)) * 0x9e3779b97f4a7c15;
+    return num_shards_ == 1 ? shards_[0] : shards_[hash >> shard_shift_];
+  }
+
+  const std::unique_ptr<Shard[]> shards_;
+  const size_t num_shards_;
+  const int shard_shift_;
+
+  // Declared last, so that notifications stop before the shards go away.
+  std::unique_ptr<MemoryPressureListener> memory_pressure_listener_;
+};
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_SHARDED_LRU_CACHE_H_
@@ -0,0 +1,172 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/sharded_lru_cache.h"
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/memory/memory_pressure_listener.h"
+#include "base/run_loop.h"
+#include "base/test/task_environment.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+
+namespace {
+
+using Cache = ShardedLRUCache<int, std::string>;
+
+// Puts and gets keys of its own range, and checks what it gets back.
+class CacheUser : public DelegateSimpleThread::Delegate {
+ public:
+  CacheUser(Cache* cache, int first_key)
+      : cache_(cache), first_key_(first_key) {}
+
+  void Run() override {
+    for (int i = 0; i < 1000; ++i) {
+      const int key = first_key_ + i % 100;
+      cache_->Put(key, std::to_string(key));
+      absl::optional<std::string> value = cache_->Get(first_key_ + i % 50);
+      if (value)
+        EXPECT_EQ(std::to_string(first_key_ + i % 50), *value);
+      if (i % 7 == 0)
+        cache_->Erase(key);
+    }
+  }
+
+ private:
+  Cache* const cache_;
+  const int first_key_;
+};
+
+}  // namespace
+
+TEST(ShardedLRUCacheTest, Basic) {
+  Cache cache(100, 1);
+  EXPECT_EQ(absl::nullopt, cache.Get(1));
+  EXPECT_FALSE(cache.Contains(1));
+
+  cache.Put(1, "one");
+  cache.Put(2, "two");
+  EXPECT_EQ("one", cache.Get(1));
+  EXPECT_EQ("two", cache.Get(2));
+  EXPECT_TRUE(cache.Contains(1));
+  EXPECT_EQ(2u, cache.size());
+
+  // Replaces the value.
+  cache.Put(1, "uno");
+  EXPECT_EQ("uno", cache.Get(1));
+  EXPECT_EQ(2u, cache.size());
+
+  EXPECT_TRUE(cache.Erase(1));
+  EXPECT_FALSE(cache.Erase(1));
+  EXPECT_EQ(absl::nullopt, cache.Get(1));
+  EXPECT_EQ("two", cache.Get(2));
+  EXPECT_EQ(1u, cache.size());
+
+  cache.Clear();
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ(0u, cache.total_cost());
+  EXPECT_EQ(absl::nullopt, cache.Get(2));
+}
+
+TEST(ShardedLRUCacheTest, EvictsLeastRecentlyUsed) {
+  Cache cache(4, 1);
+  for (int key = 0; key < 4; ++key)
+    cache.Put(key, std::to_string(key));
+
+  // All the entries were used since the last eviction, so the oldest goes.
+  cache.Put(4, "4");
+  EXPECT_EQ(4u, cache.size());
+  EXPECT_FALSE(cache.Contains(0));
+
+  // Entries that were used since are spared by the next eviction, but not the
+  // others.
+  EXPECT_EQ("1", cache.Get(1));
+  cache.Put(5, "5");
+  EXPECT_TRUE(cache.Contains(1));
+  EXPECT_FALSE(cache.Contains(2));
+  EXPECT_TRUE(cache.Contains(3));
+  EXPECT_TRUE(cache.Contains(4));
+  EXPECT_TRUE(cache.Contains(5));
+
+  // Contains() does not count as a use.
+  cache.Put(6, "6");
+  EXPECT_FALSE(cache.Contains(3));
+  EXPECT_EQ(4u, cache.size());
+}
+
+TEST(ShardedLRUCacheTest, Cost) {
+  Cache cache(100, 1);
+  cache.Put(1, "a", 40);
+  cache.Put(2, "b", 40);
+  EXPECT_EQ(80u, cache.total_cost());
+
+  // Evicts as many entries as needed for the cost to fit.
+  cache.Put(3, "c", 70);
+  EXPECT_EQ(70u, cache.total_cost());
+  EXPECT_EQ(1u, cache.size());
+  EXPECT_TRUE(cache.Contains(3));
+
+  // Replacing an entry replaces its cost.
+  cache.Put(3, "c", 10);
+  EXPECT_EQ(10u, cache.total_cost());
+
+  // An entry that costs more than the whole cache is not kept, and neither is
+  // its previous value.
+  cache.Put(3, "d", 101);
+  EXPECT_FALSE(cache.Contains(3));
+  EXPECT_EQ(0u, cache.total_cost());
+}
+
+TEST(ShardedLRUCacheTest, Shards) {
+  // Each of the 4 shards gets a quarter of the maximum cost.
+  Cache cache(400, 4);
+  for (int key = 0; key < 1000; ++key)
+    cache.Put(key, std::to_string(key));
+  // The keys are spread well enough for each shard to be full.
+  EXPECT_EQ(400u, cache.size());
+  EXPECT_EQ(400u, cache.total_cost());
+  EXPECT_TRUE(cache.Contains(999));
+}
+
+TEST(ShardedLRUCacheTest, MemoryPressure) {
+  test::TaskEnvironment task_environment;
+  Cache cache(64, 4);
+  cache.ListenForMemoryPressure();
+  for (int key = 0; key < 1000; ++key)
+    cache.Put(key, std::to_string(key));
+  EXPECT_EQ(64u, cache.size());
+
+  MemoryPressureListener::NotifyMemoryPressure(
+      MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE);
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(32u, cache.size());
+
+  MemoryPressureListener::NotifyMemoryPressure(
+      MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL);
+  RunLoop().RunUntilIdle();
+  EXPECT_EQ(0u, cache.size());
+}
+
+TEST(ShardedLRUCacheTest, Threads) {
+  Cache cache(256);
+  DelegateSimpleThreadPool pool("ShardedLRUCacheTest", 8);
+  std::vector<std::unique_ptr<CacheUser>> users;
+  for (int i = 0; i < 8; ++i) {
+    users.push_back(std::make_unique<CacheUser>(&cache, i * 1000));
+    pool.AddWork(users.back().get(), 1);
+  }
+  pool.Start();
+  pool.JoinAll();
+  EXPECT_LE(cache.total_cost(), 256u);
+  EXPECT_EQ(cache.size(), cache.total_cost());
+}
+
+}  // namespace base
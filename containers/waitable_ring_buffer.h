@@ -0,0 +1,168 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_CONTAINERS_WAITABLE_RING_BUFFER_H_
+#define BASE_CONTAINERS_WAITABLE_RING_BUFFER_H_
+
+#include <stddef.h>
+
+#include <atomic>
+#include <utility>
+
+#include "base/containers/lock_free_ring_buffer.h"
+#include "base/containers/span.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/time/time.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+
+// WaitableRingBuffer adds blocking Push() and Pop() to a SpscRingBuffer or an
+// MpmcRingBuffer. Threads that find the queue full or empty sleep on a
+// WaitableEvent until another thread makes room or pushes an element, so
+// threads that only try to push or pop never block.
+//
+// Waking up a thread is as costly as posting a task, but threads that push and
+// pop while nobody waits only pay for a memory fence.
+//
+// Example:
+//
+//   WaitableRingBuffer<MpmcRingBuffer<Job>> jobs(/*capacity=*/256);
+//
+//   // Worker threads.
+//   while (true) {
+//     Job job = jobs.Pop();
+//     ...
+//   }
+template <class RingBuffer>
+class WaitableRingBuffer {
+ public:
+  using value_type = typename RingBuffer::value_type;
+
+  explicit WaitableRingBuffer(size_t capacity) : ring_buffer_(capacity) {}
+
+  WaitableRingBuffer(const WaitableRingBuffer&) = delete;
+  WaitableRingBuffer& operator=(const WaitableRingBuffer&) = delete;
+
+  ~WaitableRingBuffer() = default;
+
+  // As in RingBuffer, these never block.
+
+  bool TryPush(const value_type& value) {
+    if (!ring_buffer_.TryPush(value))
+      return false;
+    Wake(&num_waiting_consumers_, &not_empty_);
+    return true;
+  }
+
+  bool TryPush(value_type&& value) {
+    if (!ring_buffer_.TryPush(std::move(value)))
+      return false;
+    Wake(&num_waiting_consumers_, &not_empty_);
+    return true;
+  }
+
+  size_t TryPushBatch(span<value_type> values) {
+    const size_t count = ring_buffer_.TryPushBatch(values);
+    if (count)
+      Wake(&num_waiting_consumers_, &not_empty_);
+    return count;
+  }
+
+  absl::optional<value_type> TryPop() {
+    absl::optional<value_type> value = ring_buffer_.TryPop();
+    if (value)
+      Wake(&num_waiting_producers_, &not_full_);
+    return value;
+  }
+
+  size_t TryPopBatch(span<value_type> out) {
+    const size_t count = ring_buffer_.TryPopBatch(out);
+    if (count)
+      Wake(&num_waiting_producers_, &not_full_);
+    return count;
+  }
+
+  // Pushes |value|, after waiting for room if the queue is full.
+  void Push(value_type value) {
+    while (!TryPush(std::move(value))) {
+      Wait(&num_waiting_producers_, &not_full_, TimeDelta::Max(),
+           [this] { return ring_buffer_.size() < ring_buffer_.capacity(); });
+    }
+    // Signals can be lost when several threads are about to wait, so each
+    // thread that gets through passes the wake-up on.
+    if (ring_buffer_.size() < ring_buffer_.capacity())
+      Wake(&num_waiting_producers_, &not_full_);
+  }
+
+  // Pops an element, after waiting for one if the queue is empty.
+  value_type Pop() {
+    absl::optional<value_type> value;
+    while (!(value = TryPop())) {
+      Wait(&num_waiting_consumers_, &not_empty_, TimeDelta::Max(),
+           [this] { return !ring_buffer_.empty(); });
+    }
+    if (!ring_buffer_.empty())
+      Wake(&num_waiting_consumers_, &not_empty_);
+    return std::move(*value);
+  }
+
+  // As Pop(), but gives up after |timeout|.
+  absl::optional<value_type> TimedPop(TimeDelta timeout) {
+    const TimeTicks deadline = TimeTicks::Now() + timeout;
+    absl::optional<value_type> value;
+    while (!(value = TryPop())) {
+      const TimeDelta remaining = deadline - TimeTicks::Now();
+      if (remaining <= TimeDelta())
+        return absl::nullopt;
+      Wait(&num_waiting_consumers_, &not_empty_, remaining,
+           [this] { return !ring_buffer_.empty(); });
+    }
+    if (!ring_buffer_.empty())
+      Wake(&num_waiting_consumers_, &not_empty_);
+    return value;
+  }
+
+  size_t size() const { return ring_buffer_.size(); }
+  bool empty() const { return ring_buffer_.empty(); }
+  size_t capacity() const { return ring_buffer_.capacity(); }
+
+ private:
+  // Waits on |event| unless |ready| returns true once this thread is counted
+  // in |num_waiters|.
+  template <class Predicate>
+  static void Wait(std::atomic<int>* num_waiters,
+                   WaitableEvent* event,
+                   TimeDelta timeout,
+                   Predicate ready) {
+    num_waiters->fetch_add(1, std::memory_order_relaxed);
+    // Pairs with the fence in Wake(): either the other thread sees this one
+    // waiting, or this one sees the element or the room that it made.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!ready()) {
+      if (timeout.is_max())
+        event->Wait();
+      else
+        event->TimedWait(timeout);
+    }
+    num_waiters->fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  static void Wake(std::atomic<int>* num_waiters, WaitableEvent* event) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (num_waiters->load(std::memory_order_relaxed) > 0)
+      event->Signal();
+  }
+
+  RingBuffer ring_buffer_;
+
+  std::atomic<int> num_waiting_producers_{0};
+  std::atomic<int> num_waiting_consumers_{0};
+  WaitableEvent not_full_{WaitableEvent::ResetPolicy::AUTOMATIC};
+  WaitableEvent not_empty_{WaitableEvent::ResetPolicy::AUTOMATIC};
+};
+
+}  // namespace base
+
+#endif  // BASE_CONTAINERS_WAITABLE_RING_BUFFER_H_
@@ -0,0 +1,139 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/containers/waitable_ring_buffer.h"
+
+#include <memory>
+#include <vector>
+
+#include "base/containers/lock_free_ring_buffer.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+
+namespace {
+
+constexpr int kNumElements = 10000;
+
+// Pushes |count| consecutive integers from |first|, and waits when the queue
+// is full.
+template <class RingBuffer>
+class Producer : public DelegateSimpleThread::Delegate {
+ public:
+  Producer(RingBuffer* ring_buffer, int first, int count)
+      : ring_buffer_(ring_buffer), first_(first), count_(count) {}
+
+  void Run() override {
+    for (int i = first_; i < first_ + count_; ++i)
+      ring_buffer_->Push(i);
+  }
+
+ private:
+  RingBuffer* const ring_buffer_;
+  const int first_;
+  const int count_;
+};
+
+// Pops |count| elements into |popped|, and waits when the queue is empty.
+template <class RingBuffer>
+class Consumer : public DelegateSimpleThread::Delegate {
+ public:
+  Consumer(RingBuffer* ring_buffer, int count)
+      : ring_buffer_(ring_buffer), count_(count) {}
+
+  void Run() override {
+    for (int i = 0; i < count_; ++i)
+      popped_.push_back(ring_buffer_->Pop());
+  }
+
+  const std::vector<int>& popped() const { return popped_; }
+
+ private:
+  RingBuffer* const ring_buffer_;
+  const int count_;
+  std::vector<int> popped_;
+};
+
+}  // namespace
+
+template <class RingBuffer>
+class WaitableRingBufferTest : public testing::Test {};
+
+using RingBufferTypes = testing::Types<WaitableRingBuffer<SpscRingBuffer<int>>,
+                                       WaitableRingBuffer<MpmcRingBuffer<int>>>;
+TYPED_TEST_SUITE(WaitableRingBufferTest, RingBufferTypes);
+
+TYPED_TEST(WaitableRingBufferTest, DoesNotWaitWhenNotNeeded) {
+  TypeParam ring_buffer(2);
+  ring_buffer.Push(1);
+  EXPECT_TRUE(ring_buffer.TryPush(2));
+  EXPECT_FALSE(ring_buffer.TryPush(3));
+  EXPECT_EQ(1, ring_buffer.Pop());
+  EXPECT_EQ(2, ring_buffer.TryPop());
+  EXPECT_EQ(absl::nullopt, ring_buffer.TryPop());
+}
+
+TYPED_TEST(WaitableRingBufferTest, TimedPop) {
+  TypeParam ring_buffer(2);
+  EXPECT_EQ(absl::nullopt, ring_buffer.TimedPop(TimeDelta()));
+  EXPECT_EQ(absl::nullopt, ring_buffer.TimedPop(TimeDelta::FromMilliseconds(1)));
+  ring_buffer.Push(1);
+  EXPECT_EQ(1, ring_buffer.TimedPop(TimeDelta::FromMilliseconds(1)));
+}
+
+// The producer waits for room and the consumer for elements, since the queue
+// is much smaller than what goes through it.
+TYPED_TEST(WaitableRingBufferTest, OneProducerOneConsumer) {
+  TypeParam ring_buffer(4);
+  Producer<TypeParam> producer(&ring_buffer, 0, kNumElements);
+  Consumer<TypeParam> consumer(&ring_buffer, kNumElements);
+  DelegateSimpleThread producer_thread(&producer, "Producer");
+  DelegateSimpleThread consumer_thread(&consumer, "Consumer");
+  consumer_thread.Start();
+  producer_thread.Start();
+  producer_thread.Join();
+  consumer_thread.Join();
+
+  ASSERT_EQ(static_cast<size_t>(kNumElements), consumer.popped().size());
+  for (int i = 0; i < kNumElements; ++i)
+    ASSERT_EQ(i, consumer.popped()[i]);
+}
+
+TEST(WaitableRingBufferTest, ManyProducersManyConsumers) {
+  using RingBuffer = WaitableRingBuffer<MpmcRingBuffer<int>>;
+  constexpr int kNumThreads = 4;
+  RingBuffer ring_buffer(4);
+
+  std::vector<std::unique_ptr<Producer<RingBuffer>>> producers;
+  std::vector<std::unique_ptr<Consumer<RingBuffer>>> consumers;
+  std::vector<std::unique_ptr<DelegateSimpleThread>> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    producers.push_back(std::make_unique<Producer<RingBuffer>>(
+        &ring_buffer, i * kNumElements, kNumElements));
+    consumers.push_back(
+        std::make_unique<Consumer<RingBuffer>>(&ring_buffer, kNumElements));
+    threads.push_back(std::make_unique<DelegateSimpleThread>(
+        producers.back().get(), "Producer"));
+    threads.push_back(std::make_unique<DelegateSimpleThread>(
+        consumers.back().get(), "Consumer"));
+  }
+  for (auto& thread : threads)
+    thread->Start();
+  for (auto& thread : threads)
+    thread->Join();
+
+  std::vector<int> times_popped(kNumThreads * kNumElements);
+  for (const auto& consumer : consumers) {
+    for (int value : consumer->popped())
+      ++times_popped[value];
+  }
+  for (int times : times_popped)
+    ASSERT_EQ(1, times);
+  EXPECT_TRUE(ring_buffer.empty());
+}
+
+}  // namespace base
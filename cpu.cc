@@ -294,7 +294,9 @@ void CPU::Initialize(bool require_branding) {
         (cpu_info[2] & 0x08000000) != 0 /* OSXSAVE */ &&
         (xgetbv(0) & 6) == 6 /* XSAVE enabled by kernel */;
     has_aesni_ = (cpu_info[2] & 0x02000000) != 0;
+    has_pclmul_ = (cpu_info[2] & 0x00000002) != 0;
     has_avx2_ = has_avx_ && (cpu_info7[1] & 0x00000020) != 0;
+    has_sha_ = (cpu_info7[1] & 0x20000000) != 0;
   }
 
   // Get the brand string of the cpu.
@@ -351,6 +353,8 @@ void CPU::Initialize(bool require_branding) {
   }
 
 #if defined(ARCH_CPU_ARM64)
+  has_crc32_ = getauxval(AT_HWCAP) & HWCAP_CRC32;
+
   // Check for Armv8.5-A BTI/MTE support, exposed via HWCAP2
   unsigned long hwcap2 = getauxval(AT_HWCAP2);
   has_mte_ = hwcap2 & HWCAP2_MTE;
@@ -77,6 +77,9 @@ class BASE_EXPORT CPU final {
   bool has_avx() const { return has_avx_; }
   bool has_avx2() const { return has_avx2_; }
   bool has_aesni() const { return has_aesni_; }
+  bool has_pclmul() const { return has_pclmul_; }
+  // The SHA-1 and SHA-256 extensions.
+  bool has_sha() const { return has_sha_; }
   bool has_non_stop_time_stamp_counter() const {
     return has_non_stop_time_stamp_counter_;
   }
@@ -89,6 +92,9 @@ class BASE_EXPORT CPU final {
   uint8_t implementer() const { return implementer_; }
   uint32_t part_number() const { return part_number_; }
 
+  // Armv8 CRC32 instructions.
+  bool has_crc32() const { return has_crc32_; }
+
   // Armv8.5-A extensions for control flow and memory safety.
   bool has_mte() const { return has_mte_; }
   bool has_bti() const { return has_bti_; }
@@ -175,6 +181,9 @@ class BASE_EXPORT CPU final {
   bool has_avx_ = false;
   bool has_avx2_ = false;
   bool has_aesni_ = false;
+  bool has_pclmul_ = false;
+  bool has_sha_ = false;
+  bool has_crc32_ = false;  // Armv8 CRC32 instructions
   bool has_mte_ = false;  // Armv8.5-A MTE (Memory Taggging Extension)
   bool has_bti_ = false;  // Armv8.5-A BTI (Branch Target Identification)
   bool has_non_stop_time_stamp_counter_ = false;
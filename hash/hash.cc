@@ -4,10 +4,13 @@
 
 #include "base/hash/hash.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "base/check_op.h"
 #include "base/notreached.h"
 #include "base/rand_util.h"
-#include "base/third_party/cityhash/city.h"
 #include "build/build_config.h"
 
 // Definition in base/third_party/superfasthash/superfasthash.c. (Third-party
@@ -19,18 +22,123 @@ namespace base {
 
 namespace {
 
-size_t FastHashImpl(base::span<const uint8_t> data) {
-  // We use the updated CityHash within our namespace (not the deprecated
-  // version from third_party/smhasher).
-#if defined(ARCH_CPU_64_BITS)
-  return base::internal::cityhash_v111::CityHash64(
-      reinterpret_cast<const char*>(data.data()), data.size());
+constexpr size_t kStripeSize = FastHasher::kStripeSize;
+
+// FastHash() is a 64-bit hash in the style of wyhash
+// (https://github.com/wangyi-fudan/wyhash), which mixes 16 bytes at a time
+// with a single 64x64->128-bit multiplication. Inputs longer than
+// kStripeSize are processed in stripes of 48 bytes by three independent
+// multiplications, which keeps the multiplier busy. That is faster than
+// vectorizing, as SSE2 and NEON lack a full 64-bit multiplication.
+constexpr uint64_t kSecret[4] = {0x2d358dccaa6c78a5, 0x8bb84b93962eacc9,
+                                 0x4b33a62ed433d4a3, 0x4d5a2da51de1aa47};
+
+// Sets |a| and |b| to the low and high halves of their 128-bit product.
+inline void Multiply128(uint64_t* a, uint64_t* b) {
+#if defined(__SIZEOF_INT128__)
+  const __uint128_t product = static_cast<__uint128_t>(*a) * *b;
+  *a = static_cast<uint64_t>(product);
+  *b = static_cast<uint64_t>(product >> 64);
 #else
-  return base::internal::cityhash_v111::CityHash32(
-      reinterpret_cast<const char*>(data.data()), data.size());
+  const uint64_t a_low = *a & 0xFFFFFFFF;
+  const uint64_t a_high = *a >> 32;
+  const uint64_t b_low = *b & 0xFFFFFFFF;
+  const uint64_t b_high = *b >> 32;
+  const uint64_t low_low = a_low * b_low;
+  const uint64_t high_low = a_high * b_low;
+  const uint64_t low_high = a_low * b_high;
+  const uint64_t high_high = a_high * b_high;
+  const uint64_t cross =
+      (low_low >> 32) + (high_low & 0xFFFFFFFF) + low_high;
+  *a = (cross << 32) | (low_low & 0xFFFFFFFF);
+  *b = high_high + (high_low >> 32) + (cross >> 32);
 #endif
 }
 
+inline uint64_t Mix(uint64_t a, uint64_t b) {
+  Multiply128(&a, &b);
+  return a ^ b;
+}
+
+inline uint64_t Read8(const uint8_t* p) {
+  uint64_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint64_t Read4(const uint8_t* p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+// Returns the hash of |size| bytes, given |a| and |b| read from them and the
+// |seed| they were mixed into so far.
+inline uint64_t FinishHash(uint64_t a, uint64_t b, uint64_t seed, size_t size) {
+  a ^= kSecret[1];
+  b ^= seed;
+  Multiply128(&a, &b);
+  return Mix(a ^ kSecret[0] ^ size, b ^ kSecret[1]);
+}
+
+// Mixes a stripe of kStripeSize bytes at |p| into three independent seeds.
+inline void MixStripe(const uint8_t* p,
+                      uint64_t* seed,
+                      uint64_t* seed1,
+                      uint64_t* seed2) {
+  *seed = Mix(Read8(p) ^ kSecret[1], Read8(p + 8) ^ *seed);
+  *seed1 = Mix(Read8(p + 16) ^ kSecret[2], Read8(p + 24) ^ *seed1);
+  *seed2 = Mix(Read8(p + 32) ^ kSecret[3], Read8(p + 40) ^ *seed2);
+}
+
+// Hashes the last |tail_size| bytes at |p| of an input of |size| bytes, given
+// the |seed| that the bytes before them were mixed into. 0 < |tail_size| <=
+// kStripeSize, and at least 16 bytes must be readable before |p| + |tail_size|.
+inline uint64_t HashTail(uint64_t seed,
+                         const uint8_t* p,
+                         size_t tail_size,
+                         size_t size) {
+  for (; tail_size > 16; p += 16, tail_size -= 16)
+    seed = Mix(Read8(p) ^ kSecret[1], Read8(p + 8) ^ seed);
+  return FinishHash(Read8(p + tail_size - 16), Read8(p + tail_size - 8), seed,
+                    size);
+}
+
+// The seed that all inputs start with.
+inline uint64_t InitialSeed() {
+  return Mix(kSecret[0], kSecret[1]);
+}
+
+uint64_t FastHash64(const uint8_t* p, size_t size) {
+  uint64_t seed = InitialSeed();
+  if (size <= 16) {
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (size >= 4) {
+      // Reads four possibly overlapping words, which cover all the bytes.
+      const size_t middle = (size >> 3) << 2;
+      a = (Read4(p) << 32) | Read4(p + middle);
+      b = (Read4(p + size - 4) << 32) | Read4(p + size - 4 - middle);
+    } else if (size > 0) {
+      a = (uint64_t{p[0]} << 16) | (uint64_t{p[size >> 1]} << 8) | p[size - 1];
+    }
+    return FinishHash(a, b, seed, size);
+  }
+
+  size_t tail_size = size;
+  if (tail_size > kStripeSize) {
+    uint64_t seed1 = seed;
+    uint64_t seed2 = seed;
+    do {
+      MixStripe(p, &seed, &seed1, &seed2);
+      p += kStripeSize;
+      tail_size -= kStripeSize;
+    } while (tail_size > kStripeSize);
+    seed ^= seed1 ^ seed2;
+  }
+  return HashTail(seed, p, tail_size, size);
+}
+
 // Implement hashing for pairs of at-most 32 bit integer values.
 // When size_t is 32 bits, we turn the 64-bit hash code into 32 bits by using
 // multiply-add hashing. This algorithm, as described in
@@ -116,7 +224,50 @@ T Scramble(T input) {
 }  // namespace
 
 size_t FastHash(base::span<const uint8_t> data) {
-  return Scramble(FastHashImpl(data));
+  return Scramble(static_cast<size_t>(FastHash64(data.data(), data.size())));
+}
+
+FastHasher::FastHasher()
+    : seed_(InitialSeed()), seed1_(seed_), seed2_(seed_) {}
+
+void FastHasher::Update(span<const uint8_t> data) {
+  size_ += data.size();
+  while (!data.empty()) {
+    // A stripe is only mixed in once more data follows it, as the last bytes
+    // are hashed differently.
+    if (buffered_size_ == kStripeSize) {
+      MixStripe(stripe(), &seed_, &seed1_, &seed2_);
+      memcpy(buffer_, buffer_ + kStripeSize, kHistorySize);
+      buffered_size_ = 0;
+    }
+
+    // Mix stripes in place rather than copying them to the buffer.
+    if (buffered_size_ == 0 && data.size() > kStripeSize) {
+      do {
+        MixStripe(data.data(), &seed_, &seed1_, &seed2_);
+        data = data.subspan(kStripeSize);
+      } while (data.size() > kStripeSize);
+      memcpy(buffer_, data.data() - kHistorySize, kHistorySize);
+    }
+
+    const size_t copied =
+        std::min(kStripeSize - buffered_size_, data.size());
+    memcpy(stripe() + buffered_size_, data.data(), copied);
+    buffered_size_ += copied;
+    data = data.subspan(copied);
+  }
+}
+
+size_t FastHasher::Finalize() const {
+  uint64_t hash;
+  if (size_ == buffered_size_) {
+    // No stripe was mixed in.
+    hash = FastHash64(stripe(), size_);
+  } else {
+    // The history before the stripe is read if it is shorter than 16 bytes.
+    hash = HashTail(seed_ ^ seed1_ ^ seed2_, stripe(), buffered_size_, size_);
+  }
+  return Scramble(static_cast<size_t>(hash));
 }
 
 uint32_t Hash(const void* data, size_t length) {
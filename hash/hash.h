@@ -40,6 +40,46 @@ inline size_t FastHash(StringPiece str) {
   return FastHash(as_bytes(make_span(str)));
 }
 
+// Computes FastHash() of data passed in pieces, as if they were concatenated:
+//
+//   base::FastHasher hasher;
+//   hasher.Update(header);
+//   hasher.Update(body);
+//   size_t hash = hasher.Finalize();  // FastHash(header + body)
+class BASE_EXPORT FastHasher {
+ public:
+  // Stripes of this many bytes are hashed at once.
+  static constexpr size_t kStripeSize = 48;
+
+  FastHasher();
+  FastHasher(const FastHasher&) = default;
+  FastHasher& operator=(const FastHasher&) = default;
+
+  void Update(span<const uint8_t> data);
+  void Update(StringPiece str) { Update(as_bytes(make_span(str))); }
+
+  // Returns the hash of the data passed to Update() so far. More data can
+  // still be added afterwards.
+  size_t Finalize() const;
+
+ private:
+  // The number of bytes of the last stripe that are kept, as the end of the
+  // input is hashed from its last 16 bytes.
+  static constexpr size_t kHistorySize = 16;
+
+  uint8_t* stripe() { return buffer_ + kHistorySize; }
+  const uint8_t* stripe() const { return buffer_ + kHistorySize; }
+
+  uint64_t seed_;
+  uint64_t seed1_;
+  uint64_t seed2_;
+  size_t size_ = 0;
+  // The bytes of the current stripe, at stripe(), preceded by the end of the
+  // previous one.
+  uint8_t buffer_[kHistorySize + kStripeSize];
+  size_t buffered_size_ = 0;
+};
+
 // Computes a hash of a memory buffer. This hash function must not change so
 // that code can use the hashed values for persistent storage purposes or
 // sending across the network. If a new persistent hash function is desired, a
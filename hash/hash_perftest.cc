@@ -6,10 +6,13 @@
 
 #include <stddef.h>
 #include <stdint.h>
+
+#include <algorithm>
 #include <string>
 #include <vector>
 
 #include "base/hash/hash.h"
+#include "base/hash/md5.h"
 #include "base/rand_util.h"
 #include "base/ranges/algorithm.h"
 #include "base/strings/string_number_conversions.h"
@@ -28,7 +31,21 @@ void Sha1Hash(void* data, size_t size) {
 }
 
 void FastHash(void* data, size_t size) {
-  base::Hash(reinterpret_cast<uint8_t*>(data), size);
+  base::FastHash(make_span(reinterpret_cast<uint8_t*>(data), size));
+}
+
+void StreamingFastHash(void* data, size_t size) {
+  // Hashes pieces of a page or less, as in a chain of buffers.
+  constexpr size_t kPieceSize = 4096;
+  auto bytes = make_span(reinterpret_cast<uint8_t*>(data), size);
+  FastHasher hasher;
+  for (size_t i = 0; i < size; i += kPieceSize)
+    hasher.Update(bytes.subspan(i, std::min(kPieceSize, size - i)));
+  hasher.Finalize();
+}
+
+void PersistentHash(void* data, size_t size) {
+  base::PersistentHash(data, size);
 }
 
 void RunTest(const char* hash_name,
@@ -47,6 +64,9 @@ void RunTest(const char* hash_name,
   reporter.RegisterImportantMetric(kMetricMedianThroughput, "bytesPerSecond");
 
   constexpr int kNumRuns = 111;
+  // Hashes short inputs repeatedly in each run, so that it takes long enough
+  // to be timed.
+  const size_t repeats = std::max<size_t>(1, 64 * 1024 / len);
   std::vector<TimeDelta> utime(kNumRuns);
   TimeDelta total_test_time;
   {
@@ -55,7 +75,8 @@ void RunTest(const char* hash_name,
 
     for (int i = 0; i < kNumRuns; ++i) {
       const auto start = TimeTicks::Now();
-      hash(buf.data(), len);
+      for (size_t j = 0; j < repeats; ++j)
+        hash(buf.data(), len);
       utime[i] = TimeTicks::Now() - start;
       total_test_time += utime[i];
     }
@@ -70,8 +91,8 @@ void RunTest(const char* hash_name,
   // MB/s = (len * 1,000,000)/(usecs * 1,000,000)
   // MB/s = len/utime
   constexpr int kBytesPerMegabyte = 1'000'000;
-  const auto rate = [len](TimeDelta t) {
-    return kBytesPerMegabyte * (len / t.InMicrosecondsF());
+  const auto rate = [len, repeats](TimeDelta t) {
+    return kBytesPerMegabyte * (len * repeats / t.InMicrosecondsF());
   };
 
   reporter.AddResult(kMetricMedianThroughput, rate(utime[kNumRuns / 2]));
@@ -83,8 +104,80 @@ void RunTest(const char* hash_name,
   reporter.AddResultList(kMetricThroughput, JoinString(rate_strings, ","));
 }
 
+std::vector<SHA1Digest> Sha1HashOneByOne(
+    span<const span<const uint8_t>> messages) {
+  std::vector<SHA1Digest> digests;
+  for (span<const uint8_t> message : messages)
+    digests.push_back(SHA1HashSpan(message));
+  return digests;
+}
+
+std::vector<MD5Digest> MD5SumOneByOne(
+    span<const span<const uint8_t>> messages) {
+  std::vector<MD5Digest> digests(messages.size());
+  for (size_t i = 0; i < messages.size(); ++i)
+    MD5Sum(messages[i].data(), messages[i].size(), &digests[i]);
+  return digests;
+}
+
+// Digests batches of |batch_size| messages of |message_size| bytes with
+// |digest_batch|, and reports the time taken per batch and the throughput.
+template <typename Digest>
+void RunBatchTest(const std::string& hash_name,
+                  std::vector<Digest> (*digest_batch)(
+                      span<const span<const uint8_t>>),
+                  size_t batch_size,
+                  size_t message_size) {
+  constexpr char kMetricLatency[] = "batch_latency";
+  constexpr char kMetricThroughput[] = "batch_throughput";
+
+  perf_test::PerfResultReporter reporter(
+      hash_name, NumberToString(batch_size) + "_messages_of_" +
+                     NumberToString(message_size) + "_bytes");
+  reporter.RegisterImportantMetric(kMetricLatency, "us");
+  reporter.RegisterImportantMetric(kMetricThroughput, "bytesPerSecond");
+
+  std::vector<uint8_t> buf(batch_size * message_size);
+  RandBytes(buf.data(), buf.size());
+  std::vector<span<const uint8_t>> messages;
+  for (size_t i = 0; i < batch_size; ++i)
+    messages.push_back(make_span(buf).subspan(i * message_size, message_size));
+
+  // Digests about 16 MB in total.
+  const size_t iterations = std::max<size_t>(1, (16 << 20) / buf.size());
+  const auto start = TimeTicks::Now();
+  for (size_t i = 0; i < iterations; ++i)
+    digest_batch(messages);
+  const TimeDelta elapsed = TimeTicks::Now() - start;
+
+  reporter.AddResult(kMetricLatency, elapsed.InMicrosecondsF() / iterations);
+  reporter.AddResult(kMetricThroughput,
+                     iterations * buf.size() / elapsed.InSecondsF());
+}
+
+// Batches of 1 to 64 messages of typical sizes of small cached blobs.
+template <typename Digest>
+void RunBatchTests(const std::string& hash_name,
+                   std::vector<Digest> (*digest_batch)(
+                       span<const span<const uint8_t>>)) {
+  for (size_t batch_size : {1, 4, 16, 64}) {
+    for (size_t message_size : {64, 1024, 16 * 1024})
+      RunBatchTest(hash_name, digest_batch, batch_size, message_size);
+  }
+}
+
 }  // namespace
 
+TEST(SHA1PerfTest, Batches) {
+  RunBatchTests("SHA1Batch.", &SHA1HashSpans);
+  RunBatchTests("SHA1OneByOne.", &Sha1HashOneByOne);
+}
+
+TEST(MD5PerfTest, Batches) {
+  RunBatchTests("MD5Batch.", &MD5SumSpans);
+  RunBatchTests("MD5OneByOne.", &MD5SumOneByOne);
+}
+
 TEST(SHA1PerfTest, Speed) {
   for (int shift : {1, 5, 6, 7}) {
     RunTest("SHA1.", Sha1Hash, 1024 * 1024U >> shift);
@@ -92,8 +185,10 @@ TEST(SHA1PerfTest, Speed) {
 }
 
 TEST(HashPerfTest, Speed) {
-  for (int shift : {1, 5, 6, 7}) {
-    RunTest("FastHash.", FastHash, 1024 * 1024U >> shift);
+  for (size_t len : {8U, 64U, 512U, 4096U, 64 * 1024U, 1024 * 1024U}) {
+    RunTest("FastHash.", FastHash, len);
+    RunTest("FastHasher.", StreamingFastHash, len);
+    RunTest("PersistentHash.", PersistentHash, len);
   }
 }
 
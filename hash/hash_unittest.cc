@@ -4,6 +4,8 @@
 
 #include "base/hash/hash.h"
 
+#include <algorithm>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -85,4 +87,55 @@ TEST(HashTest, FastHash) {
   EXPECT_EQ(FastHash(s), FastHash(kEmptyString));
 }
 
+// Every byte of every size of input changes the hash.
+TEST(HashTest, FastHashChangesWithEveryByte) {
+  std::string str(200, 'a');
+  for (size_t size = 0; size <= str.size(); ++size) {
+    std::set<size_t> hashes;
+    const StringPiece piece(str.data(), size);
+    hashes.insert(FastHash(piece));
+    for (size_t i = 0; i < size; ++i) {
+      str[i] = 'b';
+      hashes.insert(FastHash(piece));
+      str[i] = 'a';
+    }
+    EXPECT_EQ(size + 1, hashes.size()) << size;
+  }
+}
+
+TEST(HashTest, FastHasher) {
+  std::string str;
+  for (int i = 0; i < 300; ++i)
+    str.push_back(static_cast<char>(i * 37 + i / 7));
+
+  for (size_t size = 0; size <= str.size(); ++size) {
+    const StringPiece piece(str.data(), size);
+    const size_t expected = FastHash(piece);
+
+    FastHasher hasher;
+    hasher.Update(piece);
+    EXPECT_EQ(expected, hasher.Finalize()) << size;
+
+    // A byte at a time.
+    FastHasher byte_hasher;
+    for (size_t i = 0; i < size; ++i) {
+      EXPECT_EQ(FastHash(piece.substr(0, i)), byte_hasher.Finalize());
+      byte_hasher.Update(piece.substr(i, 1));
+    }
+    EXPECT_EQ(expected, byte_hasher.Finalize()) << size;
+
+    // In two and three pieces.
+    for (size_t split : {size_t{1}, size_t{17}, size_t{48}, size_t{49},
+                         size_t{100}}) {
+      if (split > size)
+        break;
+      FastHasher split_hasher;
+      split_hasher.Update(piece.substr(0, split));
+      split_hasher.Update(piece.substr(split, split));
+      split_hasher.Update(piece.substr(std::min(2 * split, size)));
+      EXPECT_EQ(expected, split_hasher.Finalize()) << size << " " << split;
+    }
+  }
+}
+
 }  // namespace base
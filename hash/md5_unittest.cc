@@ -5,6 +5,7 @@
 #include <string.h>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/hash/md5.h"
 
@@ -182,4 +183,27 @@ TEST(MD5, ContextWithStringData) {
   EXPECT_EQ(expected, actual);
 }
 
+// Every message digested in a batch has the same sum as on its own, whatever
+// the sizes of the other messages in the batch.
+TEST(MD5, MD5SumSpans) {
+  std::vector<uint8_t> data(300);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<uint8_t>(i * 13 + 7);
+
+  std::vector<span<const uint8_t>> messages;
+  for (size_t size = 0; size <= data.size(); size += size < 130 ? 1 : 17)
+    messages.push_back(make_span(data).subspan(data.size() - size));
+  for (size_t batch_size : {size_t{0}, size_t{1}, size_t{3}, messages.size()}) {
+    const auto batch = make_span(messages).first(batch_size);
+    const std::vector<MD5Digest> digests = MD5SumSpans(batch);
+    ASSERT_EQ(batch_size, digests.size());
+    for (size_t i = 0; i < batch_size; ++i) {
+      MD5Digest expected;
+      MD5Sum(batch[i].data(), batch[i].size(), &expected);
+      EXPECT_EQ(MD5DigestToBase16(expected), MD5DigestToBase16(digests[i]))
+          << i;
+    }
+  }
+}
+
 }  // namespace base
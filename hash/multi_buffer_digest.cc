@@ -0,0 +1,460 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// SHA1HashSpans() and MD5SumSpans(), which digest several messages at once.
+//
+// On x86-64, the messages are digested four at a time in the 32-bit lanes of
+// SSE2 registers: SHA-1 and MD5 only use 32-bit additions, rotations and
+// bitwise operations, so each lane runs the compression function of a
+// different message. Messages of different sizes share the lanes: when one
+// is done, the next message starts in its lane.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "base/compiler_specific.h"
+#include "base/hash/md5.h"
+#include "base/hash/sha1.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_64)
+#include <emmintrin.h>
+
+#include "base/cpu.h"
+#include "base/sys_byteorder.h"
+#endif
+
+namespace base {
+
+namespace {
+
+#if defined(ARCH_CPU_X86_64)
+
+constexpr size_t kLanes = 4;
+constexpr size_t kBlockSize = 64;
+
+template <int n>
+inline __m128i RotateLeft(__m128i x) {
+  return _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - n));
+}
+
+inline __m128i Add(__m128i a, __m128i b) {
+  return _mm_add_epi32(a, b);
+}
+
+inline __m128i Xor(__m128i a, __m128i b) {
+  return _mm_xor_si128(a, b);
+}
+
+inline __m128i And(__m128i a, __m128i b) {
+  return _mm_and_si128(a, b);
+}
+
+inline __m128i Or(__m128i a, __m128i b) {
+  return _mm_or_si128(a, b);
+}
+
+inline __m128i Constant(uint32_t value) {
+  return _mm_set1_epi32(static_cast<int>(value));
+}
+
+// Swaps the bytes of each 32-bit word.
+inline __m128i ByteSwapWords(__m128i x) {
+  x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+  return _mm_shufflelo_epi16(_mm_shufflehi_epi16(x, 0xb1), 0xb1);
+}
+
+// Sets |words[i]| to the |i|th 32-bit word of the block of each lane.
+template <bool big_endian>
+inline void LoadWords(const uint8_t* const blocks[kLanes], __m128i words[16]) {
+  for (size_t i = 0; i < 16; i += 4) {
+    // Transpose four words of each lane.
+    const __m128i lane0 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[0] + 4 * i));
+    const __m128i lane1 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[1] + 4 * i));
+    const __m128i lane2 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[2] + 4 * i));
+    const __m128i lane3 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[3] + 4 * i));
+    const __m128i low01 = _mm_unpacklo_epi32(lane0, lane1);
+    const __m128i low23 = _mm_unpacklo_epi32(lane2, lane3);
+    const __m128i high01 = _mm_unpackhi_epi32(lane0, lane1);
+    const __m128i high23 = _mm_unpackhi_epi32(lane2, lane3);
+    words[i] = _mm_unpacklo_epi64(low01, low23);
+    words[i + 1] = _mm_unpackhi_epi64(low01, low23);
+    words[i + 2] = _mm_unpacklo_epi64(high01, high23);
+    words[i + 3] = _mm_unpackhi_epi64(high01, high23);
+  }
+  if (big_endian) {
+    for (size_t i = 0; i < 16; ++i)
+      words[i] = ByteSwapWords(words[i]);
+  }
+}
+
+// The steps of the compression functions are unrolled at compile time, so
+// that the constants, rotations and word indices of each step are immediates.
+template <typename Step, size_t... steps>
+inline void RunSteps(Step step, std::index_sequence<steps...>) {
+  int unused[] = {(step(std::integral_constant<size_t, steps>()), 0)...};
+  ALLOW_UNUSED_LOCAL(unused);
+}
+
+constexpr uint32_t kSHA1Constants[4] = {0x5a827999, 0x6ed9eba1, 0x8f1bbcdc,
+                                        0xca62c1d6};
+
+// The function of the rounds of SHA-1, 20 steps each.
+inline __m128i SHA1Function(std::integral_constant<size_t, 0>,
+                            __m128i b,
+                            __m128i c,
+                            __m128i d) {
+  // (b & c) | (~b & d)
+  return Xor(d, And(b, Xor(c, d)));
+}
+
+inline __m128i SHA1Function(std::integral_constant<size_t, 2>,
+                            __m128i b,
+                            __m128i c,
+                            __m128i d) {
+  // (b & c) | (b & d) | (c & d)
+  return Or(And(b, c), And(d, Or(b, c)));
+}
+
+template <size_t round>
+inline __m128i SHA1Function(std::integral_constant<size_t, round>,
+                            __m128i b,
+                            __m128i c,
+                            __m128i d) {
+  return Xor(Xor(b, c), d);
+}
+
+struct SHA1 {
+  static constexpr size_t kStateWords = 5;
+  static constexpr bool kBigEndian = true;
+  using Digest = SHA1Digest;
+
+  static void Init(uint32_t state[kStateWords]) {
+    state[0] = 0x67452301;
+    state[1] = 0xefcdab89;
+    state[2] = 0x98badcfe;
+    state[3] = 0x10325476;
+    state[4] = 0xc3d2e1f0;
+  }
+
+  static void Compress(__m128i state[kStateWords], __m128i w[16]) {
+    __m128i a = state[0];
+    __m128i b = state[1];
+    __m128i c = state[2];
+    __m128i d = state[3];
+    __m128i e = state[4];
+
+    RunSteps(
+        [&](auto step) {
+          constexpr size_t t = decltype(step)::value;
+          // Words 16 to 79 replace the word 16 before them.
+          if (t >= 16) {
+            w[t % 16] = RotateLeft<1>(Xor(Xor(w[(t - 3) % 16], w[(t - 8) % 16]),
+                                          Xor(w[(t - 14) % 16], w[t % 16])));
+          }
+          const __m128i f = SHA1Function(
+              std::integral_constant<size_t, t / 20>(), b, c, d);
+          const __m128i temp =
+              Add(Add(RotateLeft<5>(a), f),
+                  Add(Add(e, Constant(kSHA1Constants[t / 20])), w[t % 16]));
+          e = d;
+          d = c;
+          c = RotateLeft<30>(b);
+          b = a;
+          a = temp;
+        },
+        std::make_index_sequence<80>());
+
+    state[0] = Add(state[0], a);
+    state[1] = Add(state[1], b);
+    state[2] = Add(state[2], c);
+    state[3] = Add(state[3], d);
+    state[4] = Add(state[4], e);
+  }
+
+  static void Final(const uint32_t state[kStateWords], Digest* digest) {
+    for (size_t i = 0; i < kStateWords; ++i) {
+      const uint32_t word = ByteSwap(state[i]);
+      memcpy(digest->data() + 4 * i, &word, sizeof(word));
+    }
+  }
+};
+
+// floor(abs(sin(i + 1)) * 2^32).
+constexpr uint32_t kMD5Constants[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a,
+    0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+    0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340,
+    0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+    0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+    0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+    0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92,
+    0xffeff47d, 0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+    0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391};
+
+// The rotations of the steps of each round of MD5, 16 steps each.
+constexpr int kMD5Rotations[4][4] = {
+    {7, 12, 17, 22}, {5, 9, 14, 20}, {4, 11, 16, 23}, {6, 10, 15, 21}};
+
+// The index of the message word added at step |i|.
+constexpr size_t MD5WordIndex(size_t i) {
+  return i < 16 ? i
+                : i < 32 ? (5 * i + 1) % 16
+                         : i < 48 ? (3 * i + 5) % 16 : (7 * i) % 16;
+}
+
+// The function of the rounds of MD5.
+inline __m128i MD5Function(std::integral_constant<size_t, 0>,
+                           __m128i b,
+                           __m128i c,
+                           __m128i d) {
+  // (b & c) | (~b & d)
+  return Xor(d, And(b, Xor(c, d)));
+}
+
+inline __m128i MD5Function(std::integral_constant<size_t, 1>,
+                           __m128i b,
+                           __m128i c,
+                           __m128i d) {
+  // (d & b) | (~d & c)
+  return Xor(c, And(d, Xor(b, c)));
+}
+
+inline __m128i MD5Function(std::integral_constant<size_t, 2>,
+                           __m128i b,
+                           __m128i c,
+                           __m128i d) {
+  return Xor(Xor(b, c), d);
+}
+
+inline __m128i MD5Function(std::integral_constant<size_t, 3>,
+                           __m128i b,
+                           __m128i c,
+                           __m128i d) {
+  // c ^ (b | ~d)
+  return Xor(c, Or(b, Xor(d, Constant(0xffffffff))));
+}
+
+struct MD5 {
+  static constexpr size_t kStateWords = 4;
+  static constexpr bool kBigEndian = false;
+  using Digest = MD5Digest;
+
+  static void Init(uint32_t state[kStateWords]) {
+    state[0] = 0x67452301;
+    state[1] = 0xefcdab89;
+    state[2] = 0x98badcfe;
+    state[3] = 0x10325476;
+  }
+
+  static void Compress(__m128i state[kStateWords], __m128i m[16]) {
+    __m128i a = state[0];
+    __m128i b = state[1];
+    __m128i c = state[2];
+    __m128i d = state[3];
+
+    RunSteps(
+        [&](auto step) {
+          constexpr size_t i = decltype(step)::value;
+          const __m128i f =
+              MD5Function(std::integral_constant<size_t, i / 16>(), b, c, d);
+          const __m128i sum = Add(Add(a, f), Add(Constant(kMD5Constants[i]),
+                                                 m[MD5WordIndex(i)]));
+          a = d;
+          d = c;
+          c = b;
+          b = Add(b, RotateLeft<kMD5Rotations[i / 16][i % 4]>(sum));
+        },
+        std::make_index_sequence<64>());
+
+    state[0] = Add(state[0], a);
+    state[1] = Add(state[1], b);
+    state[2] = Add(state[2], c);
+    state[3] = Add(state[3], d);
+  }
+
+  static void Final(const uint32_t state[kStateWords], Digest* digest) {
+    memcpy(digest->a, state, sizeof(digest->a));
+  }
+};
+
+// The progress of one message through a lane.
+struct Lane {
+  // Sets up the padded blocks of |message|.
+  template <typename Hash>
+  void Start(span<const uint8_t> message, size_t index) {
+    message_index = index;
+    data = message.data();
+    full_blocks = message.size() / kBlockSize;
+    block = 0;
+
+    // The end of the message is followed by a 1 bit, zeros and the size in
+    // bits, which take one or two more blocks.
+    const size_t remainder = message.size() % kBlockSize;
+    total_blocks =
+        full_blocks + (remainder + 1 + sizeof(uint64_t) > kBlockSize ? 2 : 1);
+    const size_t tail_size = (total_blocks - full_blocks) * kBlockSize;
+    memset(tail, 0, tail_size);
+    if (remainder)
+      memcpy(tail, data + full_blocks * kBlockSize, remainder);
+    tail[remainder] = 0x80;
+    uint64_t size_in_bits = uint64_t{message.size()} * 8;
+    if (Hash::kBigEndian)
+      size_in_bits = ByteSwap(size_in_bits);
+    memcpy(tail + tail_size - sizeof(uint64_t), &size_in_bits,
+           sizeof(uint64_t));
+  }
+
+  const uint8_t* CurrentBlock() const {
+    return block < full_blocks ? data + block * kBlockSize
+                               : tail + (block - full_blocks) * kBlockSize;
+  }
+
+  size_t message_index;
+  const uint8_t* data;
+  size_t full_blocks;
+  size_t block;
+  size_t total_blocks;
+  uint8_t tail[2 * kBlockSize];
+};
+
+template <typename Hash>
+std::vector<typename Hash::Digest> HashInLanes(
+    span<const span<const uint8_t>> messages) {
+  constexpr size_t kStateWords = Hash::kStateWords;
+  std::vector<typename Hash::Digest> digests(messages.size());
+
+  // The state words of each lane, transposed.
+  alignas(16) uint32_t state[kStateWords][kLanes];
+  Lane lanes[kLanes];
+  bool active[kLanes] = {};
+  size_t active_lanes = 0;
+  size_t next_message = 0;
+
+  // Starts the next message in |lane|, if any.
+  auto start_next = [&](size_t lane) {
+    if (next_message == messages.size()) {
+      active[lane] = false;
+      return;
+    }
+    lanes[lane].template Start<Hash>(messages[next_message], next_message);
+    ++next_message;
+    uint32_t initial_state[kStateWords];
+    Hash::Init(initial_state);
+    for (size_t i = 0; i < kStateWords; ++i)
+      state[i][lane] = initial_state[i];
+    active[lane] = true;
+  };
+  for (size_t lane = 0; lane < kLanes; ++lane) {
+    start_next(lane);
+    active_lanes += active[lane];
+  }
+
+  // Idle lanes hash a block of zeros, whose result is ignored.
+  static const uint8_t kIdleBlock[kBlockSize] = {};
+  while (active_lanes) {
+    const uint8_t* blocks[kLanes];
+    for (size_t lane = 0; lane < kLanes; ++lane)
+      blocks[lane] = active[lane] ? lanes[lane].CurrentBlock() : kIdleBlock;
+
+    __m128i words[16];
+    LoadWords<Hash::kBigEndian>(blocks, words);
+    __m128i vector_state[kStateWords];
+    for (size_t i = 0; i < kStateWords; ++i) {
+      vector_state[i] =
+          _mm_load_si128(reinterpret_cast<const __m128i*>(state[i]));
+    }
+    Hash::Compress(vector_state, words);
+    for (size_t i = 0; i < kStateWords; ++i)
+      _mm_store_si128(reinterpret_cast<__m128i*>(state[i]), vector_state[i]);
+
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      if (!active[lane] || ++lanes[lane].block < lanes[lane].total_blocks)
+        continue;
+      uint32_t final_state[kStateWords];
+      for (size_t i = 0; i < kStateWords; ++i)
+        final_state[i] = state[i][lane];
+      Hash::Final(final_state, &digests[lanes[lane].message_index]);
+      start_next(lane);
+      active_lanes -= !active[lane];
+    }
+  }
+  return digests;
+}
+
+// The lanes pay off for SHA-1 when the messages are small enough that the cost
+// of a call per message dominates. Without the SHA extensions, the lanes are
+// faster up to 1 KiB per message and slower from 2 KiB on (0.59 vs. 0.52 GB/s
+// for 64 x 16 KiB). With them, which BoringSSL uses, one message at a time is
+// about as fast at 512 bytes, and faster above.
+constexpr size_t kMaxSHA1LaneMessageSize = 1024;
+constexpr size_t kMaxSHA1LaneMessageSizeWithSHAExtensions = 256;
+
+// NaCl doesn't use BoringSSL.
+bool HasSHAExtensions() {
+#if defined(OS_NACL)
+  return false;
+#else
+  static const bool has_sha = CPU().has_sha();
+  return has_sha;
+#endif
+}
+
+// Returns whether the average size of |messages|, which share the lanes, is
+// at most |max_size|.
+bool AreSmallMessages(span<const span<const uint8_t>> messages,
+                      size_t max_size) {
+  size_t total_size = 0;
+  for (span<const uint8_t> message : messages)
+    total_size += message.size();
+  return total_size <= max_size * messages.size();
+}
+
+#endif  // defined(ARCH_CPU_X86_64)
+
+}  // namespace
+
+std::vector<SHA1Digest> SHA1HashSpans(
+    span<const span<const uint8_t>> messages) {
+#if defined(ARCH_CPU_X86_64)
+  if (messages.size() > 1 &&
+      AreSmallMessages(messages, HasSHAExtensions()
+                                     ? kMaxSHA1LaneMessageSizeWithSHAExtensions
+                                     : kMaxSHA1LaneMessageSize)) {
+    return HashInLanes<SHA1>(messages);
+  }
+#endif
+
+  std::vector<SHA1Digest> digests;
+  digests.reserve(messages.size());
+  for (span<const uint8_t> message : messages)
+    digests.push_back(SHA1HashSpan(message));
+  return digests;
+}
+
+std::vector<MD5Digest> MD5SumSpans(span<const span<const uint8_t>> messages) {
+#if defined(ARCH_CPU_X86_64)
+  // MD5 has no instructions of its own, so the lanes are faster at any size.
+  if (messages.size() > 1)
+    return HashInLanes<MD5>(messages);
+#endif
+
+  std::vector<MD5Digest> digests(messages.size());
+  for (size_t i = 0; i < messages.size(); ++i)
+    MD5Sum(messages[i].data(), messages[i].size(), &digests[i]);
+  return digests;
+}
+
+}  // namespace base
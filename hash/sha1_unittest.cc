@@ -7,6 +7,7 @@
 #include <stddef.h>
 
 #include <string>
+#include <vector>
 
 #include "base/base64.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -155,4 +156,42 @@ TEST(SHA1Test, StreamingSHA1WithChunkedInput) {
   for (size_t i = 0; i < base::kSHA1Length; ++i) {
     EXPECT_EQ(kExpected[i], digest_array[i]);
   }
-}
\ No newline at end of file
+}
+
+// Every message hashed in a batch has the same hash as on its own, whatever
+// the sizes of the other messages in the batch.
+TEST(SHA1Test, Spans) {
+  std::vector<uint8_t> data(300);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<uint8_t>(i * 13 + 7);
+
+  std::vector<base::span<const uint8_t>> messages;
+  for (size_t size = 0; size <= data.size(); size += size < 130 ? 1 : 17)
+    messages.push_back(base::make_span(data).subspan(data.size() - size));
+  for (size_t batch_size : {size_t{0}, size_t{1}, size_t{3}, messages.size()}) {
+    const auto batch = base::make_span(messages).first(batch_size);
+    const std::vector<base::SHA1Digest> digests = base::SHA1HashSpans(batch);
+    ASSERT_EQ(batch_size, digests.size());
+    for (size_t i = 0; i < batch_size; ++i)
+      EXPECT_EQ(base::SHA1HashSpan(batch[i]), digests[i]) << i;
+  }
+}
+
+// Batches of large messages, which are hashed one at a time, and batches that
+// mix large and small messages have the same hashes too.
+TEST(SHA1Test, LargeSpans) {
+  std::vector<uint8_t> data(16384);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<uint8_t>(i * 13 + 7);
+
+  const auto all = base::make_span(data);
+  const std::vector<base::span<const uint8_t>> messages = {
+      all, all.first(4096), all.subspan(1), all.first(3), all.first(100)};
+  for (size_t batch_size = 2; batch_size <= messages.size(); ++batch_size) {
+    const auto batch = base::make_span(messages).first(batch_size);
+    const std::vector<base::SHA1Digest> digests = base::SHA1HashSpans(batch);
+    ASSERT_EQ(batch_size, digests.size());
+    for (size_t i = 0; i < batch_size; ++i)
+      EXPECT_EQ(base::SHA1HashSpan(batch[i]), digests[i]) << i;
+  }
+}
@@ -4,7 +4,9 @@
 
 #include "base/json/json_parser.h"
 
+#include <algorithm>
 #include <cmath>
+#include <iterator>
 #include <utility>
 #include <vector>
 
@@ -13,6 +15,7 @@
 #include "base/notreached.h"
 #include "base/numerics/safe_conversions.h"
 #include "base/ranges/algorithm.h"
+#include "base/strings/char_scan.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_piece.h"
 #include "base/strings/string_util.h"
@@ -77,6 +80,17 @@ bool UnprefixedHexStringToInt(StringPiece input, int* output) {
   return HexStringToInt(input, output);
 }
 
+// Returns the number of bytes at the start of |input| that can be copied
+// verbatim into a string being parsed: ASCII bytes that neither end the
+// string, start an escape sequence, nor affect line counting. Strings in large
+// inputs are mostly long runs of such bytes, so they are scanned in bulk
+// rather than decoded one code point at a time.
+size_t CountPlainStringChars(StringPiece input) {
+  const size_t count =
+      internal::FindFirstInSetOrOutOfRange(input, "\"\\\r\n", 0, 0x7F);
+  return count == StringPiece::npos ? input.size() : count;
+}
+
 }  // namespace
 
 // This is U+FFFD.
@@ -113,50 +127,32 @@ JSONParser::JSONParser(int options, size_t max_depth)
 JSONParser::~JSONParser() = default;
 
 absl::optional<Value> JSONParser::Parse(StringPiece input) {
-  input_ = input;
-  index_ = 0;
-  // Line and column counting is 1-based, but |index_| is 0-based. For example,
-  // if input is "Aaa\nB" then 'A' and 'B' are both in column 1 (at lines 1 and
-  // 2) and have indexes of 0 and 4. We track the line number explicitly (the
-  // |line_number_| field) and the column number implicitly (the difference
-  // between |index_| and |index_last_line_|). In calculating that difference,
-  // |index_last_line_| is the index of the '\r' or '\n', not the index of the
-  // first byte after the '\n'. For the 'B' in "Aaa\nB", its |index_| and
-  // |index_last_line_| would be 4 and 3: 'B' is in column (4 - 3) = 1. We
-  // initialize |index_last_line_| to -1, not 0, since -1 is the (out of range)
-  // index of the imaginary '\n' immediately before the start of the string:
-  // 'A' is in column (0 - -1) = 1.
-  line_number_ = 1;
-  index_last_line_ = -1;
-
-  error_code_ = JSON_NO_ERROR;
-  error_line_ = 0;
-  error_column_ = 0;
-
-  // ICU and ReadUnicodeCharacter() use int32_t for lengths, so ensure
-  // that the index_ will not overflow when parsing.
-  if (!base::IsValueInRangeForNumericType<int32_t>(input.length())) {
-    ReportError(JSON_TOO_LARGE, -1);
+  if (!StartParsing(input))
     return absl::nullopt;
-  }
-
-  // When the input JSON string starts with a UTF-8 Byte-Order-Mark,
-  // advance the start position to avoid the ParseNextToken function mis-
-  // treating a Unicode BOM as an invalid character and returning NULL.
-  ConsumeIfMatch("\xEF\xBB\xBF");
 
   // Parse the first and any nested tokens.
   absl::optional<Value> root(ParseNextToken());
-  if (!root)
+  if (!root || !FinishParsing())
     return absl::nullopt;
 
-  // Make sure the input stream is at an end.
-  if (GetNextToken() != T_END_OF_INPUT) {
-    ReportError(JSON_UNEXPECTED_DATA_AFTER_ROOT, 0);
+  return root;
+}
+
+absl::optional<JSONDocument> JSONParser::ParseDocument(StringPiece input) {
+  if (!StartParsing(input))
     return absl::nullopt;
-  }
 
-  return root;
+  JSONDocument document(input.size());
+  document_ = &document;
+  const bool success =
+      ParseNextTokenToView(&document.root_) && FinishParsing();
+  document_ = nullptr;
+  list_stack_.clear();
+  dict_stack_.clear();
+  if (!success)
+    return absl::nullopt;
+
+  return document;
 }
 
 JSONParser::JsonParseError JSONParser::error_code() const {
@@ -204,6 +200,15 @@ void JSONParser::StringBuilder::Append(uint32_t point) {
   }
 }
 
+void JSONParser::StringBuilder::AppendASCII(StringPiece run) {
+  if (string_) {
+    string_->append(run.data(), run.size());
+  } else {
+    DCHECK_EQ(pos_ + length_, run.data());
+    length_ += run.size();
+  }
+}
+
 void JSONParser::StringBuilder::Convert() {
   if (string_)
     return;
@@ -216,8 +221,59 @@ std::string JSONParser::StringBuilder::DestructiveAsString() {
   return std::string(pos_, length_);
 }
 
+StringPiece JSONParser::StringBuilder::AsStringPiece() const {
+  if (string_)
+    return *string_;
+  return StringPiece(pos_, length_);
+}
+
 // JSONParser private //////////////////////////////////////////////////////////
 
+bool JSONParser::StartParsing(StringPiece input) {
+  input_ = input;
+  index_ = 0;
+  // Line and column counting is 1-based, but |index_| is 0-based. For example,
+  // if input is "Aaa\nB" then 'A' and 'B' are both in column 1 (at lines 1 and
+  // 2) and have indexes of 0 and 4. We track the line number explicitly (the
+  // |line_number_| field) and the column number implicitly (the difference
+  // between |index_| and |index_last_line_|). In calculating that difference,
+  // |index_last_line_| is the index of the '\r' or '\n', not the index of the
+  // first byte after the '\n'. For the 'B' in "Aaa\nB", its |index_| and
+  // |index_last_line_| would be 4 and 3: 'B' is in column (4 - 3) = 1. We
+  // initialize |index_last_line_| to -1, not 0, since -1 is the (out of range)
+  // index of the imaginary '\n' immediately before the start of the string:
+  // 'A' is in column (0 - -1) = 1.
+  line_number_ = 1;
+  index_last_line_ = -1;
+
+  error_code_ = JSON_NO_ERROR;
+  error_line_ = 0;
+  error_column_ = 0;
+
+  // ICU and ReadUnicodeCharacter() use int32_t for lengths, so ensure
+  // that the index_ will not overflow when parsing.
+  if (!base::IsValueInRangeForNumericType<int32_t>(input.length())) {
+    ReportError(JSON_TOO_LARGE, -1);
+    return false;
+  }
+
+  // When the input JSON string starts with a UTF-8 Byte-Order-Mark,
+  // advance the start position to avoid the ParseNextToken function mis-
+  // treating a Unicode BOM as an invalid character and returning NULL.
+  ConsumeIfMatch("\xEF\xBB\xBF");
+
+  return true;
+}
+
+bool JSONParser::FinishParsing() {
+  // Make sure the input stream is at an end.
+  if (GetNextToken() != T_END_OF_INPUT) {
+    ReportError(JSON_UNEXPECTED_DATA_AFTER_ROOT, 0);
+    return false;
+  }
+  return true;
+}
+
 absl::optional<StringPiece> JSONParser::PeekChars(size_t count) {
   if (index_ + count > input_.length())
     return absl::nullopt;
@@ -488,6 +544,207 @@ absl::optional<Value> JSONParser::ConsumeList() {
   return Value(std::move(list_storage));
 }
 
+bool JSONParser::ParseNextTokenToView(JSONValueView* out) {
+  return ParseTokenToView(GetNextToken(), out);
+}
+
+bool JSONParser::ParseTokenToView(Token token, JSONValueView* out) {
+  absl::optional<Value> scalar;
+  switch (token) {
+    case T_OBJECT_BEGIN:
+      return ConsumeDictionaryToView(out);
+    case T_ARRAY_BEGIN:
+      return ConsumeListToView(out);
+    case T_STRING:
+      return ConsumeStringToView(out);
+    case T_NUMBER:
+      scalar = ConsumeNumber();
+      break;
+    case T_BOOL_TRUE:
+    case T_BOOL_FALSE:
+    case T_NULL:
+      scalar = ConsumeLiteral();
+      break;
+    default:
+      ReportError(JSON_UNEXPECTED_TOKEN, 0);
+      return false;
+  }
+  if (!scalar)
+    return false;
+
+  // Numbers and literals never allocate, so they are parsed as Values.
+  out->type_ = scalar->type();
+  out->size_ = 0;
+  switch (scalar->type()) {
+    case Value::Type::NONE:
+      out->int_value_ = 0;
+      break;
+    case Value::Type::BOOLEAN:
+      out->bool_value_ = scalar->GetBool();
+      break;
+    case Value::Type::INTEGER:
+      out->int_value_ = scalar->GetInt();
+      break;
+    case Value::Type::DOUBLE:
+      out->double_value_ = scalar->GetDouble();
+      break;
+    default:
+      NOTREACHED();
+      return false;
+  }
+  return true;
+}
+
+bool JSONParser::ConsumeDictionaryToView(JSONValueView* out) {
+  if (ConsumeChar() != '{') {
+    ReportError(JSON_UNEXPECTED_TOKEN, 0);
+    return false;
+  }
+
+  StackMarker depth_check(max_depth_, &stack_depth_);
+  if (depth_check.IsTooDeep()) {
+    ReportError(JSON_TOO_MUCH_NESTING, -1);
+    return false;
+  }
+
+  const size_t first_entry = dict_stack_.size();
+
+  Token token = GetNextToken();
+  while (token != T_OBJECT_END) {
+    if (token != T_STRING) {
+      ReportError(JSON_UNQUOTED_DICTIONARY_KEY, 0);
+      return false;
+    }
+
+    // First consume the key.
+    StringBuilder key;
+    if (!ConsumeStringRaw(&key)) {
+      return false;
+    }
+
+    // Read the separator.
+    token = GetNextToken();
+    if (token != T_OBJECT_PAIR_SEPARATOR) {
+      ReportError(JSON_SYNTAX_ERROR, 0);
+      return false;
+    }
+
+    ConsumeChar();
+    JSONValueDictEntry entry;
+    entry.key = key.converted() ? document_->CopyString(key.AsStringPiece())
+                                : key.AsStringPiece();
+    if (!ParseNextTokenToView(&entry.value)) {
+      // ReportError from deeper level.
+      return false;
+    }
+    dict_stack_.push_back(entry);
+
+    token = GetNextToken();
+    if (token == T_LIST_SEPARATOR) {
+      ConsumeChar();
+      token = GetNextToken();
+      if (token == T_OBJECT_END && !(options_ & JSON_ALLOW_TRAILING_COMMAS)) {
+        ReportError(JSON_TRAILING_COMMA, 0);
+        return false;
+      }
+    } else if (token != T_OBJECT_END) {
+      ReportError(JSON_SYNTAX_ERROR, 0);
+      return false;
+    }
+  }
+
+  ConsumeChar();  // Closing '}'.
+
+  // Sort the entries by key, keeping only the last of those with the same key
+  // in the input, like base::Value does.
+  auto first = dict_stack_.begin() + first_entry;
+  std::stable_sort(
+      first, dict_stack_.end(),
+      [](const JSONValueDictEntry& a, const JSONValueDictEntry& b) {
+        return a.key < b.key;
+      });
+  auto last_unique = first;
+  for (auto it = first; it != dict_stack_.end(); ++it) {
+    if (std::next(it) != dict_stack_.end() && std::next(it)->key == it->key)
+      continue;
+    *last_unique++ = *it;
+  }
+
+  const size_t size = static_cast<size_t>(last_unique - first);
+  JSONValueDictEntry* entries =
+      document_->AllocateArray<JSONValueDictEntry>(size);
+  std::copy(first, last_unique, entries);
+  dict_stack_.resize(first_entry);
+
+  out->type_ = Value::Type::DICTIONARY;
+  out->size_ = static_cast<uint32_t>(size);
+  out->dict_data_ = entries;
+  return true;
+}
+
+bool JSONParser::ConsumeListToView(JSONValueView* out) {
+  if (ConsumeChar() != '[') {
+    ReportError(JSON_UNEXPECTED_TOKEN, 0);
+    return false;
+  }
+
+  StackMarker depth_check(max_depth_, &stack_depth_);
+  if (depth_check.IsTooDeep()) {
+    ReportError(JSON_TOO_MUCH_NESTING, -1);
+    return false;
+  }
+
+  const size_t first_element = list_stack_.size();
+
+  Token token = GetNextToken();
+  while (token != T_ARRAY_END) {
+    JSONValueView item;
+    if (!ParseTokenToView(token, &item)) {
+      // ReportError from deeper level.
+      return false;
+    }
+    list_stack_.push_back(item);
+
+    token = GetNextToken();
+    if (token == T_LIST_SEPARATOR) {
+      ConsumeChar();
+      token = GetNextToken();
+      if (token == T_ARRAY_END && !(options_ & JSON_ALLOW_TRAILING_COMMAS)) {
+        ReportError(JSON_TRAILING_COMMA, 0);
+        return false;
+      }
+    } else if (token != T_ARRAY_END) {
+      ReportError(JSON_SYNTAX_ERROR, 0);
+      return false;
+    }
+  }
+
+  ConsumeChar();  // Closing ']'.
+
+  const size_t size = list_stack_.size() - first_element;
+  JSONValueView* elements = document_->AllocateArray<JSONValueView>(size);
+  std::copy(list_stack_.begin() + first_element, list_stack_.end(), elements);
+  list_stack_.resize(first_element);
+
+  out->type_ = Value::Type::LIST;
+  out->size_ = static_cast<uint32_t>(size);
+  out->list_data_ = elements;
+  return true;
+}
+
+bool JSONParser::ConsumeStringToView(JSONValueView* out) {
+  StringBuilder string;
+  if (!ConsumeStringRaw(&string))
+    return false;
+  StringPiece value = string.converted()
+                          ? document_->CopyString(string.AsStringPiece())
+                          : string.AsStringPiece();
+  out->type_ = Value::Type::STRING;
+  out->size_ = static_cast<uint32_t>(value.size());
+  out->string_data_ = value.data();
+  return true;
+}
+
 absl::optional<Value> JSONParser::ConsumeString() {
   StringBuilder string;
   if (!ConsumeStringRaw(&string))
@@ -507,6 +764,15 @@ bool JSONParser::ConsumeStringRaw(StringBuilder* out) {
   StringBuilder string(pos());
 
   while (PeekChar()) {
+    // Copy any run of characters that need no decoding in bulk.
+    const size_t plain_chars =
+        CountPlainStringChars(input_.substr(static_cast<size_t>(index_)));
+    if (plain_chars) {
+      string.AppendASCII(StringPiece(input_.data() + index_, plain_chars));
+      index_ += static_cast<int>(plain_chars);
+      continue;
+    }
+
     uint32_t next_char = 0;
     if (!ReadUnicodeCharacter(input_.data(),
                               static_cast<int32_t>(input_.length()), &index_,
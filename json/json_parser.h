@@ -10,11 +10,13 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/base_export.h"
 #include "base/compiler_specific.h"
 #include "base/gtest_prod_util.h"
 #include "base/json/json_common.h"
+#include "base/json/json_value_view.h"
 #include "base/macros.h"
 #include "base/strings/string_piece.h"
 #include "base/values.h"
@@ -81,6 +83,11 @@ class BASE_EXPORT JSONParser {
   // convert to a FooValue at the same time.
   absl::optional<Value> Parse(StringPiece input);
 
+  // Parses the input string like Parse(), but into a tree of JSONValueViews
+  // allocated in the arena of the returned JSONDocument. Strings that need no
+  // decoding are not copied, so |input| must outlive the result.
+  absl::optional<JSONDocument> ParseDocument(StringPiece input);
+
   // Returns the error code.
   JsonParseError error_code() const;
 
@@ -134,6 +141,11 @@ class BASE_EXPORT JSONParser {
     // converted, or by appending the UTF8 bytes for the code point.
     void Append(uint32_t point);
 
+    // Appends |run|, which must consist of ASCII characters and, unless the
+    // builder has been converted, directly follow the string built so far in
+    // the input.
+    void AppendASCII(StringPiece run);
+
     // Converts the builder from its default StringPiece to a full std::string,
     // performing a copy. Once a builder is converted, it cannot be made a
     // StringPiece again.
@@ -144,6 +156,12 @@ class BASE_EXPORT JSONParser {
     // in cases where the builder will not be needed any more.
     std::string DestructiveAsString();
 
+    // Returns the string built so far, which is a substring of the input
+    // unless the builder has been converted.
+    StringPiece AsStringPiece() const;
+
+    bool converted() const { return string_.has_value(); }
+
    private:
     // The beginning of the input string.
     const char* pos_;
@@ -156,6 +174,14 @@ class BASE_EXPORT JSONParser {
     absl::optional<std::string> string_;
   };
 
+  // Resets the parser to parse |input|, skipping any Byte-Order-Mark. Returns
+  // false with error information set if |input| can't be parsed.
+  bool StartParsing(StringPiece input);
+
+  // Returns true if only whitespace and comments follow the root value, and
+  // false with error information set otherwise.
+  bool FinishParsing();
+
   // Returns the next |count| bytes of the input stream, or nullopt if fewer
   // than |count| bytes remain.
   absl::optional<StringPiece> PeekChars(size_t count);
@@ -199,6 +225,15 @@ class BASE_EXPORT JSONParser {
   // Value.
   absl::optional<Value> ConsumeList();
 
+  // Counterparts of the functions above that parse into JSONValueViews in the
+  // arena of |document_|. Each returns false on error, with error information
+  // set.
+  bool ParseNextTokenToView(JSONValueView* out);
+  bool ParseTokenToView(Token token, JSONValueView* out);
+  bool ConsumeDictionaryToView(JSONValueView* out);
+  bool ConsumeListToView(JSONValueView* out);
+  bool ConsumeStringToView(JSONValueView* out);
+
   // Calls through ConsumeStringRaw and wraps it in a value.
   absl::optional<Value> ConsumeString();
 
@@ -266,11 +301,22 @@ class BASE_EXPORT JSONParser {
   int error_line_;
   int error_column_;
 
+  // The document being built by ParseDocument(), if any.
+  JSONDocument* document_ = nullptr;
+
+  // The entries of all lists and dictionaries that are being parsed by
+  // ParseDocument(), innermost last. Each container is copied into the arena
+  // at once when it is complete, so that it occupies exactly the space it
+  // needs. Reusing these as a stack avoids allocations per container.
+  std::vector<JSONValueView> list_stack_;
+  std::vector<JSONValueDictEntry> dict_stack_;
+
   friend class JSONParserTest;
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, NextChar);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeDictionary);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeList);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeString);
+  FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeLongString);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeLiterals);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ConsumeNumbers);
   FRIEND_TEST_ALL_PREFIXES(JSONParserTest, ErrorMessages);
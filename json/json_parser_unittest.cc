@@ -65,6 +65,24 @@ TEST_F(JSONParserTest, ConsumeString) {
   EXPECT_EQ("test", str);
 }
 
+TEST_F(JSONParserTest, ConsumeLongString) {
+  // Long runs of plain ASCII are copied in bulk; make sure escapes, line
+  // breaks and non-ASCII characters at any offset within them still work.
+  const std::string run(37, 'a');
+  std::string input = "\"" + run + "\\n" + run + "\xC3\xA9" + run + "\\u00e9" +
+                      run + "\n" + run + "\",|";
+  std::unique_ptr<JSONParser> parser(NewTestParser(input));
+  absl::optional<Value> value(parser->ConsumeString());
+  EXPECT_EQ(',', *parser->pos());
+
+  TestLastThree(parser.get());
+
+  ASSERT_TRUE(value);
+  ASSERT_TRUE(value->is_string());
+  EXPECT_EQ(run + "\n" + run + "\xC3\xA9" + run + "\xC3\xA9" + run + "\n" + run,
+            value->GetString());
+}
+
 TEST_F(JSONParserTest, ConsumeList) {
   std::string input("[true, false],|");
   std::unique_ptr<JSONParser> parser(NewTestParser(input));
@@ -2,15 +2,24 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/callback.h"
 #include "base/json/json_reader.h"
+#include "base/json/json_value_view.h"
 #include "base/json/json_writer.h"
 #include "base/memory/ptr_util.h"
 #include "base/strings/string_number_conversions.h"
+#include "base/strings/string_piece.h"
 #include "base/time/time.h"
 #include "base/values.h"
 #include "build/build_config.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/perf/perf_result_reporter.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
 
 namespace base {
 
@@ -18,12 +27,20 @@ namespace {
 
 constexpr char kMetricPrefixJSON[] = "JSON.";
 constexpr char kMetricReadTime[] = "read_time";
+constexpr char kMetricFreeTime[] = "free_time";
+constexpr char kMetricReadDocumentTime[] = "read_document_time";
+constexpr char kMetricFreeDocumentTime[] = "free_document_time";
 constexpr char kMetricWriteTime[] = "write_time";
+constexpr char kMetricWriteToSinkTime[] = "write_to_sink_time";
 
 perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
   perf_test::PerfResultReporter reporter(kMetricPrefixJSON, story_name);
   reporter.RegisterImportantMetric(kMetricReadTime, "ms");
+  reporter.RegisterImportantMetric(kMetricFreeTime, "ms");
+  reporter.RegisterImportantMetric(kMetricReadDocumentTime, "ms");
+  reporter.RegisterImportantMetric(kMetricFreeDocumentTime, "ms");
   reporter.RegisterImportantMetric(kMetricWriteTime, "ms");
+  reporter.RegisterImportantMetric(kMetricWriteToSinkTime, "ms");
   return reporter;
 }
 
@@ -61,6 +78,44 @@ Value GenerateLayeredDict(int breadth, int depth) {
   return root;
 }
 
+// Generates a list of |size| numbers and strings, a few of which need
+// escaping.
+Value GenerateLargeList(int size) {
+  Value::ListStorage list;
+  list.reserve(size);
+  for (int i = 0; i < size; ++i) {
+    switch (i % 4) {
+      case 0:
+        list.emplace_back(i);
+        break;
+      case 1:
+        list.emplace_back(i / 7.0);
+        break;
+      case 2:
+        list.emplace_back("A string of moderate length, number " +
+                          NumberToString(i));
+        break;
+      case 3:
+        list.emplace_back("Quoted \"" + NumberToString(i) + "\"\n");
+        break;
+    }
+  }
+  return Value(std::move(list));
+}
+
+// Generates a flat dictionary of |size| entries with string values.
+Value GenerateLargeDict(int size) {
+  std::vector<std::pair<std::string, Value>> entries;
+  entries.reserve(size);
+  for (int i = 0; i < size; ++i) {
+    entries.emplace_back(
+        "key_" + NumberToString(i),
+        Value("The value of an entry in a large dictionary, number " +
+              NumberToString(i)));
+  }
+  return Value(Value::DictStorage(std::move(entries)));
+}
+
 }  // namespace
 
 class JSONPerfTest : public testing::Test {
@@ -79,9 +134,46 @@ class JSONPerfTest : public testing::Test {
     reporter.AddResult(kMetricWriteTime, end_write - start_write);
 
     TimeTicks start_read = TimeTicks::Now();
-    JSONReader::Read(json);
+    absl::optional<Value> value = JSONReader::Read(json);
     TimeTicks end_read = TimeTicks::Now();
     reporter.AddResult(kMetricReadTime, end_read - start_read);
+
+    value.reset();
+    TimeTicks end_free = TimeTicks::Now();
+    reporter.AddResult(kMetricFreeTime, end_free - end_read);
+
+    TimeTicks start_read_document = TimeTicks::Now();
+    absl::optional<JSONDocument> document = JSONReader::ReadDocument(json);
+    TimeTicks end_read_document = TimeTicks::Now();
+    reporter.AddResult(kMetricReadDocumentTime,
+                       end_read_document - start_read_document);
+
+    document.reset();
+    TimeTicks end_free_document = TimeTicks::Now();
+    reporter.AddResult(kMetricFreeDocumentTime,
+                       end_free_document - end_read_document);
+  }
+
+  void TestWrite(const std::string& story_name, const Value& value) {
+    auto reporter = SetUpReporter(story_name);
+
+    std::string json;
+    TimeTicks start_write = TimeTicks::Now();
+    JSONWriter::Write(value, &json);
+    TimeTicks end_write = TimeTicks::Now();
+    reporter.AddResult(kMetricWriteTime, end_write - start_write);
+
+    size_t size = 0;
+    TimeTicks start_write_to_sink = TimeTicks::Now();
+    JSONWriter::WriteToSink(
+        value, 0,
+        BindRepeating(
+            [](size_t* size, StringPiece json) { *size += json.size(); },
+            &size));
+    TimeTicks end_write_to_sink = TimeTicks::Now();
+    reporter.AddResult(kMetricWriteToSinkTime,
+                       end_write_to_sink - start_write_to_sink);
+    EXPECT_EQ(json.size(), size);
   }
 };
 
@@ -97,4 +189,12 @@ TEST_F(JSONPerfTest, StressTest) {
   }
 }
 
+TEST_F(JSONPerfTest, WriteLargeList) {
+  TestWrite("large_list", GenerateLargeList(1000000));
+}
+
+TEST_F(JSONPerfTest, WriteLargeDict) {
+  TestWrite("large_dict", GenerateLargeDict(200000));
+}
+
 }  // namespace base
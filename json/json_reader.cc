@@ -36,6 +36,14 @@ std::unique_ptr<Value> JSONReader::ReadDeprecated(StringPiece json,
   return value ? Value::ToUniquePtrValue(std::move(*value)) : nullptr;
 }
 
+// static
+absl::optional<JSONDocument> JSONReader::ReadDocument(StringPiece json,
+                                                      int options,
+                                                      size_t max_depth) {
+  internal::JSONParser parser(options, max_depth);
+  return parser.ParseDocument(json);
+}
+
 // static
 JSONReader::ValueWithError JSONReader::ReadAndReturnValueWithError(
     StringPiece json,
@@ -43,6 +43,7 @@
 
 #include "base/base_export.h"
 #include "base/json/json_common.h"
+#include "base/json/json_value_view.h"
 #include "base/strings/string_piece.h"
 #include "base/values.h"
 #include "third_party/abseil-cpp/absl/types/optional.h"
@@ -107,6 +108,14 @@ class BASE_EXPORT JSONReader {
       StringPiece json,
       int options = JSON_PARSE_RFC);
 
+  // Reads and parses |json| like Read(), but into a read-only JSONDocument,
+  // which is much cheaper to build and destroy than a Value. Strings in the
+  // document may point into |json|, which therefore must outlive it.
+  static absl::optional<JSONDocument> ReadDocument(
+      StringPiece json,
+      int options = JSON_PARSE_RFC,
+      size_t max_depth = internal::kAbsoluteMaxDepth);
+
   // This class contains only static methods.
   JSONReader() = delete;
   DISALLOW_COPY_AND_ASSIGN(JSONReader);
@@ -0,0 +1,591 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_stream_reader.h"
+
+#include <cmath>
+
+#include "base/check.h"
+#include "base/compiler_specific.h"
+#include "base/json/json_parser.h"
+#include "base/notreached.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/strings/utf_string_conversion_utils.h"
+#include "base/third_party/icu/icu_utf.h"
+
+namespace base {
+
+namespace {
+
+using internal::JSONParser;
+
+constexpr char kByteOrderMark[] = "\xEF\xBB\xBF";
+
+bool IsNumberChar(char c) {
+  return IsAsciiDigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' ||
+         c == 'E';
+}
+
+// Returns true if |number| matches the JSON number grammar.
+bool IsValidNumber(StringPiece number) {
+  size_t i = 0;
+  auto consume_digits = [&number, &i]() {
+    const size_t start = i;
+    while (i < number.size() && IsAsciiDigit(number[i]))
+      ++i;
+    return i > start;
+  };
+
+  if (i < number.size() && number[i] == '-')
+    ++i;
+  // No leading zeros.
+  if (i < number.size() && number[i] == '0')
+    ++i;
+  else if (!consume_digits())
+    return false;
+
+  if (i < number.size() && number[i] == '.') {
+    ++i;
+    if (!consume_digits())
+      return false;
+  }
+
+  if (i < number.size() && (number[i] == 'e' || number[i] == 'E')) {
+    ++i;
+    if (i < number.size() && (number[i] == '+' || number[i] == '-'))
+      ++i;
+    if (!consume_digits())
+      return false;
+  }
+  return i == number.size();
+}
+
+// Replaces the invalid UTF-8 sequences of |str| with U+FFFD.
+std::string ReplaceInvalidUTF8(StringPiece str) {
+  std::string result;
+  result.reserve(str.size());
+  const int32_t length = static_cast<int32_t>(str.size());
+  for (int32_t i = 0; i < length; ++i) {
+    uint32_t code_point;
+    if (ReadUnicodeCharacter(str.data(), length, &i, &code_point) &&
+        IsValidCodepoint(code_point)) {
+      WriteUnicodeCharacter(code_point, &result);
+    } else {
+      result.append(internal::kUnicodeReplacementString);
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+bool JSONStreamReader::Delegate::OnDictionaryStart() {
+  return true;
+}
+
+bool JSONStreamReader::Delegate::OnDictionaryKey(StringPiece key) {
+  return true;
+}
+
+bool JSONStreamReader::Delegate::OnListStart() {
+  return true;
+}
+
+JSONStreamReader::JSONStreamReader(Delegate* delegate,
+                                   int options,
+                                   size_t max_depth)
+    : delegate_(delegate), options_(options), max_depth_(max_depth) {
+  DCHECK(delegate_);
+  CHECK_LE(max_depth, internal::kAbsoluteMaxDepth);
+}
+
+JSONStreamReader::~JSONStreamReader() = default;
+
+bool JSONStreamReader::Append(StringPiece chunk) {
+  if (error_description_)
+    return false;
+
+  chunk_begin_ = chunk.data();
+  const char* p = chunk.data();
+  const char* const end = p + chunk.size();
+  while (p && p < end) {
+    switch (token_) {
+      case Token::kNone:
+        p = ConsumeStructuralChar(p);
+        break;
+      case Token::kString:
+        p = ConsumeStringChars(p, end);
+        break;
+      case Token::kNumber:
+        p = ConsumeNumberChars(p, end);
+        break;
+      case Token::kLiteral:
+        p = ConsumeLiteralChars(p, end);
+        break;
+    }
+  }
+  chunk_offset_ += chunk.size();
+  return p != nullptr;
+}
+
+bool JSONStreamReader::Finish() {
+  if (error_description_)
+    return false;
+
+  // Errors are reported at the end of the input.
+  chunk_begin_ = nullptr;
+
+  // A number is only known to be complete at the end of the input.
+  if (token_ == Token::kNumber) {
+    token_ = Token::kNone;
+    if (!FinishNumber(nullptr))
+      return false;
+  }
+
+  if (token_ != Token::kNone || state_ != State::kDone) {
+    ReportError(state_ == State::kRootValue && token_ == Token::kNone
+                    ? JSONParser::kUnexpectedToken
+                    : JSONParser::kSyntaxError,
+                nullptr);
+    return false;
+  }
+  return true;
+}
+
+std::string JSONStreamReader::GetErrorMessage() const {
+  if (!error_description_)
+    return std::string();
+  return StringPrintf("Line: %i, column: %i, %s", error_line_, error_column_,
+                      error_description_);
+}
+
+const char* JSONStreamReader::ConsumeStructuralChar(const char* p) {
+  const char c = *p;
+
+  // Skip a UTF-8 Byte-Order-Mark at the very start of the input.
+  if (state_ == State::kRootValue && OffsetOf(p) == bom_bytes_ &&
+      bom_bytes_ < sizeof(kByteOrderMark) - 1) {
+    if (c == kByteOrderMark[bom_bytes_]) {
+      ++bom_bytes_;
+      return p + 1;
+    }
+    if (bom_bytes_) {
+      ReportError(JSONParser::kUnexpectedToken, p);
+      return nullptr;
+    }
+  }
+
+  switch (c) {
+    case '\r':
+    case '\n':
+      TrackLineBreak(c, p);
+      return p + 1;
+    case ' ':
+    case '\t':
+      after_cr_ = false;
+      return p + 1;
+  }
+  after_cr_ = false;
+
+  switch (state_) {
+    case State::kListFirstValue:
+    case State::kListValue:
+      if (c == ']') {
+        if (state_ == State::kListValue &&
+            !(options_ & JSON_ALLOW_TRAILING_COMMAS)) {
+          ReportError(JSONParser::kTrailingComma, p);
+          return nullptr;
+        }
+        return EndContainer(Container::kList, p) ? p + 1 : nullptr;
+      }
+      FALLTHROUGH;
+    case State::kRootValue:
+    case State::kDictValue:
+      switch (c) {
+        case '{':
+          return StartContainer(Container::kDictionary, p) ? p + 1 : nullptr;
+        case '[':
+          return StartContainer(Container::kList, p) ? p + 1 : nullptr;
+        case '"':
+          token_ = Token::kString;
+          string_is_key_ = false;
+          buffer_.clear();
+          return p + 1;
+        case 't':
+          token_ = Token::kLiteral;
+          literal_ = c;
+          literal_rest_ = "rue";
+          return p + 1;
+        case 'f':
+          token_ = Token::kLiteral;
+          literal_ = c;
+          literal_rest_ = "alse";
+          return p + 1;
+        case 'n':
+          token_ = Token::kLiteral;
+          literal_ = c;
+          literal_rest_ = "ull";
+          return p + 1;
+        default:
+          if (c == '-' || IsAsciiDigit(c)) {
+            token_ = Token::kNumber;
+            buffer_.assign(1, c);
+            return p + 1;
+          }
+          ReportError(JSONParser::kUnexpectedToken, p);
+          return nullptr;
+      }
+
+    case State::kDictFirstKey:
+    case State::kDictKey:
+      if (c == '"') {
+        token_ = Token::kString;
+        string_is_key_ = true;
+        buffer_.clear();
+        return p + 1;
+      }
+      if (c == '}') {
+        if (state_ == State::kDictKey &&
+            !(options_ & JSON_ALLOW_TRAILING_COMMAS)) {
+          ReportError(JSONParser::kTrailingComma, p);
+          return nullptr;
+        }
+        return EndContainer(Container::kDictionary, p) ? p + 1 : nullptr;
+      }
+      ReportError(JSONParser::kUnquotedDictionaryKey, p);
+      return nullptr;
+
+    case State::kColon:
+      if (c == ':') {
+        state_ = State::kDictValue;
+        return p + 1;
+      }
+      ReportError(JSONParser::kSyntaxError, p);
+      return nullptr;
+
+    case State::kAfterValue:
+      if (c == ',') {
+        state_ = stack_.back() == Container::kList ? State::kListValue
+                                                   : State::kDictKey;
+        return p + 1;
+      }
+      if (c == ']' || c == '}') {
+        const Container container =
+            c == ']' ? Container::kList : Container::kDictionary;
+        return EndContainer(container, p) ? p + 1 : nullptr;
+      }
+      ReportError(JSONParser::kSyntaxError, p);
+      return nullptr;
+
+    case State::kDone:
+      ReportError(JSONParser::kUnexpectedDataAfterRoot, p);
+      return nullptr;
+  }
+  NOTREACHED();
+  return nullptr;
+}
+
+const char* JSONStreamReader::ConsumeStringChars(const char* p,
+                                                 const char* end) {
+  while (p < end) {
+    if (escape_ != Escape::kNone) {
+      if (!ConsumeEscapeChar(*p, p))
+        return nullptr;
+      ++p;
+      continue;
+    }
+    if (high_surrogate_ && *p != '\\' && !HandleUnpairedSurrogate(p))
+      return nullptr;
+
+    // Copy runs of characters that need no special handling in bulk.
+    const char* run = p;
+    while (p < end && *p != '"' && *p != '\\' && *p != '\r' && *p != '\n')
+      ++p;
+    if (p != run) {
+      after_cr_ = false;
+      if (reporting())
+        buffer_.append(run, p - run);
+    }
+    if (p == end)
+      break;
+
+    const char c = *p;
+    if (c == '\r' || c == '\n') {
+      // The JSON spec forbids unescaped line breaks within strings, but
+      // JSONReader is more lenient.
+      TrackLineBreak(c, p);
+      if (reporting())
+        buffer_.push_back(c);
+      ++p;
+      continue;
+    }
+    after_cr_ = false;
+    if (c == '"') {
+      token_ = Token::kNone;
+      return FinishString(p) ? p + 1 : nullptr;
+    }
+    escape_ = Escape::kBackslash;
+    ++p;
+  }
+  return p;
+}
+
+const char* JSONStreamReader::ConsumeNumberChars(const char* p,
+                                                 const char* end) {
+  while (p < end && IsNumberChar(*p))
+    buffer_.push_back(*p++);
+  if (p == end)
+    return p;
+
+  // The number ends before |p|, which is parsed as a structural character.
+  token_ = Token::kNone;
+  return FinishNumber(p) ? p : nullptr;
+}
+
+const char* JSONStreamReader::ConsumeLiteralChars(const char* p,
+                                                  const char* end) {
+  for (; p < end && *literal_rest_; ++p, ++literal_rest_) {
+    if (*p != *literal_rest_) {
+      ReportError(JSONParser::kSyntaxError, p);
+      return nullptr;
+    }
+  }
+  if (*literal_rest_)
+    return p;
+
+  token_ = Token::kNone;
+  if (reporting()) {
+    if (literal_ == 'n')
+      delegate_->OnNull();
+    else
+      delegate_->OnBool(literal_ == 't');
+  }
+  EndValue();
+  return p;
+}
+
+bool JSONStreamReader::ConsumeEscapeChar(char c, const char* at) {
+  if (escape_ == Escape::kUnicode || escape_ == Escape::kHex) {
+    if (!IsHexDigit(c)) {
+      ReportError(JSONParser::kInvalidEscape, at);
+      return false;
+    }
+    code_unit_ = code_unit_ * 16 + HexDigitToInt(c);
+    if (--hex_digits_left_)
+      return true;
+
+    const Escape escape = escape_;
+    escape_ = Escape::kNone;
+    if (escape == Escape::kUnicode)
+      return AppendUTF16CodeUnit(code_unit_, at);
+
+    // UTF-8 \x escape sequences are not allowed in the spec, but JSONReader
+    // supports them for backwards-compatibility.
+    if (!IsValidCharacter(code_unit_)) {
+      ReportError(JSONParser::kInvalidEscape, at);
+      return false;
+    }
+    if (reporting())
+      WriteUnicodeCharacter(code_unit_, &buffer_);
+    return true;
+  }
+
+  DCHECK_EQ(escape_, Escape::kBackslash);
+  escape_ = Escape::kNone;
+  if (high_surrogate_ && c != 'u' && !HandleUnpairedSurrogate(at))
+    return false;
+
+  char decoded;
+  switch (c) {
+    case 'u':
+    case 'x':
+      escape_ = c == 'u' ? Escape::kUnicode : Escape::kHex;
+      hex_digits_left_ = c == 'u' ? 4 : 2;
+      code_unit_ = 0;
+      return true;
+    case '"':
+    case '\\':
+    case '/':
+      decoded = c;
+      break;
+    case 'b':
+      decoded = '\b';
+      break;
+    case 'f':
+      decoded = '\f';
+      break;
+    case 'n':
+      decoded = '\n';
+      break;
+    case 'r':
+      decoded = '\r';
+      break;
+    case 't':
+      decoded = '\t';
+      break;
+    case 'v':  // Not listed as valid escape sequence in the RFC.
+      decoded = '\v';
+      break;
+    default:
+      ReportError(JSONParser::kInvalidEscape, at);
+      return false;
+  }
+  if (reporting())
+    buffer_.push_back(decoded);
+  return true;
+}
+
+bool JSONStreamReader::AppendUTF16CodeUnit(uint32_t code_unit,
+                                           const char* at) {
+  if (high_surrogate_) {
+    if (CBU16_IS_TRAIL(code_unit)) {
+      const uint32_t code_point =
+          CBU16_GET_SUPPLEMENTARY(high_surrogate_, code_unit);
+      high_surrogate_ = 0;
+      if (reporting())
+        WriteUnicodeCharacter(code_point, &buffer_);
+      return true;
+    }
+    if (!HandleUnpairedSurrogate(at))
+      return false;
+  }
+
+  if (CBU16_IS_LEAD(code_unit)) {
+    high_surrogate_ = code_unit;
+    return true;
+  }
+  if (CBU16_IS_TRAIL(code_unit)) {
+    high_surrogate_ = code_unit;
+    return HandleUnpairedSurrogate(at);
+  }
+  if (reporting())
+    WriteUnicodeCharacter(code_unit, &buffer_);
+  return true;
+}
+
+bool JSONStreamReader::HandleUnpairedSurrogate(const char* at) {
+  high_surrogate_ = 0;
+  if (!(options_ & JSON_REPLACE_INVALID_CHARACTERS)) {
+    ReportError(JSONParser::kInvalidEscape, at);
+    return false;
+  }
+  if (reporting())
+    buffer_.append(internal::kUnicodeReplacementString);
+  return true;
+}
+
+bool JSONStreamReader::StartContainer(Container container, const char* at) {
+  if (stack_.size() >= max_depth_) {
+    ReportError(JSONParser::kTooMuchNesting, at);
+    return false;
+  }
+  stack_.push_back(container);
+  state_ = container == Container::kList ? State::kListFirstValue
+                                         : State::kDictFirstKey;
+
+  if (skip_depth_) {
+    ++skip_depth_;
+  } else if (skip_next_value_) {
+    skip_next_value_ = false;
+    skip_depth_ = 1;
+  } else if (container == Container::kList ? !delegate_->OnListStart()
+                                           : !delegate_->OnDictionaryStart()) {
+    skip_depth_ = 1;
+  }
+  return true;
+}
+
+bool JSONStreamReader::EndContainer(Container container, const char* at) {
+  if (stack_.empty() || stack_.back() != container) {
+    ReportError(JSONParser::kSyntaxError, at);
+    return false;
+  }
+  stack_.pop_back();
+
+  if (skip_depth_) {
+    --skip_depth_;
+  } else if (container == Container::kList) {
+    delegate_->OnListEnd();
+  } else {
+    delegate_->OnDictionaryEnd();
+  }
+  EndValue();
+  return true;
+}
+
+bool JSONStreamReader::FinishString(const char* at) {
+  if (high_surrogate_ && !HandleUnpairedSurrogate(at))
+    return false;
+
+  const bool report = reporting();
+  if (report && !IsStringUTF8AllowingNoncharacters(buffer_)) {
+    if (!(options_ & JSON_REPLACE_INVALID_CHARACTERS)) {
+      ReportError(JSONParser::kUnsupportedEncoding, at);
+      return false;
+    }
+    buffer_ = ReplaceInvalidUTF8(buffer_);
+  }
+
+  if (string_is_key_) {
+    state_ = State::kColon;
+    if (report && !delegate_->OnDictionaryKey(buffer_))
+      skip_next_value_ = true;
+    return true;
+  }
+
+  if (report)
+    delegate_->OnString(buffer_);
+  EndValue();
+  return true;
+}
+
+bool JSONStreamReader::FinishNumber(const char* at) {
+  if (!IsValidNumber(buffer_)) {
+    ReportError(JSONParser::kSyntaxError, at);
+    return false;
+  }
+
+  if (reporting()) {
+    int int_value;
+    double double_value;
+    if (StringToInt(buffer_, &int_value)) {
+      delegate_->OnInt(int_value);
+    } else if (StringToDouble(buffer_, &double_value) &&
+               std::isfinite(double_value)) {
+      delegate_->OnDouble(double_value);
+    } else {
+      ReportError(JSONParser::kUnrepresentableNumber, at);
+      return false;
+    }
+  }
+  EndValue();
+  return true;
+}
+
+void JSONStreamReader::EndValue() {
+  skip_next_value_ = false;
+  state_ = stack_.empty() ? State::kDone : State::kAfterValue;
+}
+
+void JSONStreamReader::TrackLineBreak(char c, const char* at) {
+  const bool crlf = c == '\n' && after_cr_;
+  after_cr_ = c == '\r';
+  line_start_ = OffsetOf(at) + 1;
+  if (!crlf)
+    ++line_;
+}
+
+size_t JSONStreamReader::OffsetOf(const char* at) const {
+  return chunk_offset_ + static_cast<size_t>(at - chunk_begin_);
+}
+
+void JSONStreamReader::ReportError(const char* description, const char* at) {
+  error_description_ = description;
+  error_line_ = line_;
+  error_column_ = static_cast<int>(OffsetOf(at) - line_start_ + 1);
+}
+
+}  // namespace base
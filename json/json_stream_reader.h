@@ -0,0 +1,230 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_JSON_JSON_STREAM_READER_H_
+#define BASE_JSON_JSON_STREAM_READER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/json/json_common.h"
+#include "base/json/json_reader.h"
+#include "base/strings/string_piece.h"
+
+namespace base {
+
+// Parses JSON incrementally, reporting its structure to a Delegate as it goes
+// instead of building a Value tree. The input may be fed in chunks of any size,
+// e.g. as they are read from a file or socket, and values the delegate isn't
+// interested in can be skipped without being decoded. Memory use is bounded by
+// the nesting depth and the longest string or number reported, regardless of
+// the size of the document.
+//
+// The accepted syntax is that of JSONReader with the same options, except that
+// comments are not supported. Skipped strings are only checked for
+// well-formedness, not for valid UTF-8.
+//
+// Example: reading a single field from a large file.
+//
+//   class NameReader : public JSONStreamReader::Delegate {
+//    public:
+//     bool OnDictionaryStart() override { return ++depth_ == 1; }
+//     bool OnDictionaryKey(StringPiece key) override { return key == "name"; }
+//     void OnString(StringPiece value) override { name_ = std::string(value); }
+//     ...
+//   };
+//
+//   NameReader delegate;
+//   JSONStreamReader reader(&delegate);
+//   while (... read |chunk| ...) {
+//     if (!reader.Append(chunk))
+//       break;
+//   }
+//   if (!reader.Finish())
+//     LOG(ERROR) << reader.GetErrorMessage();
+class BASE_EXPORT JSONStreamReader {
+ public:
+  // Receives the values of the document in order. Callbacks are made
+  // synchronously from Append() and Finish(); strings passed to them are only
+  // valid for the duration of the call. The default implementations ignore
+  // everything but descend into every list and dictionary.
+  class BASE_EXPORT Delegate {
+   public:
+    virtual ~Delegate() = default;
+
+    // Called at the start of a dictionary. If this returns false, the whole
+    // dictionary is skipped and OnDictionaryEnd() is not called for it.
+    virtual bool OnDictionaryStart();
+    // Called with each key of a dictionary, before its value. If this returns
+    // false, the value is skipped.
+    virtual bool OnDictionaryKey(StringPiece key);
+    virtual void OnDictionaryEnd() {}
+
+    // Called at the start of a list. If this returns false, the whole list is
+    // skipped and OnListEnd() is not called for it.
+    virtual bool OnListStart();
+    virtual void OnListEnd() {}
+
+    virtual void OnString(StringPiece value) {}
+    // Numbers are reported like JSONReader stores them: as an int if they
+    // are integers in range, as a double otherwise.
+    virtual void OnInt(int value) {}
+    virtual void OnDouble(double value) {}
+    virtual void OnBool(bool value) {}
+    virtual void OnNull() {}
+  };
+
+  // |delegate| must outlive this reader. |options| is a bitmask of
+  // JSONParserOptions.
+  explicit JSONStreamReader(Delegate* delegate,
+                            int options = JSON_PARSE_RFC,
+                            size_t max_depth = internal::kAbsoluteMaxDepth);
+  JSONStreamReader(const JSONStreamReader&) = delete;
+  JSONStreamReader& operator=(const JSONStreamReader&) = delete;
+  ~JSONStreamReader();
+
+  // Parses the next |chunk| of input. Returns false if the input so far is not
+  // a valid prefix of a JSON document, after which all calls fail.
+  bool Append(StringPiece chunk);
+
+  // Signals the end of the input. Returns true if the input was exactly one
+  // JSON value, optionally surrounded by whitespace.
+  bool Finish();
+
+  // Returns a human-readable description of the error, with its location, if
+  // Append() or Finish() failed.
+  std::string GetErrorMessage() const;
+
+  // Returns the 1-based location of the error, or 0 if there is none.
+  int error_line() const { return error_line_; }
+  int error_column() const { return error_column_; }
+
+ private:
+  // What the parser expects next, outside of multi-byte tokens.
+  enum class State : uint8_t {
+    kRootValue,
+    kListFirstValue,  // A value or the end of the list.
+    kListValue,       // A value after a comma.
+    kDictFirstKey,    // A key or the end of the dictionary.
+    kDictKey,         // A key after a comma.
+    kColon,
+    kDictValue,
+    kAfterValue,  // A comma or the end of the enclosing container.
+    kDone,
+  };
+
+  // The multi-byte token being parsed, if any.
+  enum class Token : uint8_t {
+    kNone,
+    kString,
+    kNumber,
+    kLiteral,
+  };
+
+  // Where the parser is within an escape sequence of a string.
+  enum class Escape : uint8_t {
+    kNone,
+    kBackslash,  // After '\'.
+    kUnicode,    // Within the four hex digits of \uXXXX.
+    kHex,        // Within the two hex digits of \xXX.
+  };
+
+  enum class Container : uint8_t {
+    kList,
+    kDictionary,
+  };
+
+  // Each of these consumes input from [|p|, |end|) and returns the position
+  // after what it consumed, or nullptr on error.
+  const char* ConsumeStructuralChar(const char* p);
+  const char* ConsumeStringChars(const char* p, const char* end);
+  const char* ConsumeNumberChars(const char* p, const char* end);
+  const char* ConsumeLiteralChars(const char* p, const char* end);
+
+  // Handles a character of a string after a backslash.
+  bool ConsumeEscapeChar(char c, const char* at);
+  // Appends a code point decoded from \uXXXX, pairing surrogates.
+  bool AppendUTF16CodeUnit(uint32_t code_unit, const char* at);
+  // Handles a high surrogate that isn't followed by a low one.
+  bool HandleUnpairedSurrogate(const char* at);
+
+  bool StartContainer(Container container, const char* at);
+  bool EndContainer(Container container, const char* at);
+  bool FinishString(const char* at);
+  bool FinishNumber(const char* at);
+
+  // Updates the state after a complete value.
+  void EndValue();
+
+  // Returns true if the value being parsed is to be reported to the delegate.
+  bool reporting() const { return !skip_depth_ && !skip_next_value_; }
+
+  // Tracks line breaks, either of "\r", "\n" or "\r\n".
+  void TrackLineBreak(char c, const char* at);
+
+  // Returns the offset of |at| from the start of the input.
+  size_t OffsetOf(const char* at) const;
+
+  void ReportError(const char* description, const char* at);
+
+  Delegate* const delegate_;
+  const int options_;
+  const size_t max_depth_;
+
+  State state_ = State::kRootValue;
+  Token token_ = Token::kNone;
+  Escape escape_ = Escape::kNone;
+
+  // The containers enclosing the current position, innermost last.
+  std::vector<Container> stack_;
+
+  // While greater than zero, the number of skipped containers enclosing the
+  // current position.
+  size_t skip_depth_ = 0;
+
+  // Whether the delegate asked to skip the value that comes next.
+  bool skip_next_value_ = false;
+
+  // The contents of the current string or number token, if it is reported.
+  std::string buffer_;
+
+  // Whether the current string is a dictionary key.
+  bool string_is_key_ = false;
+
+  // The code point being decoded from a \u or \x escape sequence, and the
+  // number of hex digits of it still to come.
+  uint32_t code_unit_ = 0;
+  int hex_digits_left_ = 0;
+
+  // A high surrogate decoded from \uXXXX that awaits its low surrogate.
+  uint32_t high_surrogate_ = 0;
+
+  // The first and the remaining characters of the literal being parsed.
+  char literal_ = 0;
+  const char* literal_rest_ = nullptr;
+
+  // The number of bytes of a leading UTF-8 Byte-Order-Mark seen.
+  size_t bom_bytes_ = 0;
+
+  // Position tracking. |chunk_begin_| and |chunk_offset_| describe the chunk
+  // being parsed, which starts |chunk_offset_| bytes into the input.
+  const char* chunk_begin_ = nullptr;
+  size_t chunk_offset_ = 0;
+  int line_ = 1;
+  size_t line_start_ = 0;
+  bool after_cr_ = false;
+
+  // Error information.
+  const char* error_description_ = nullptr;
+  int error_line_ = 0;
+  int error_column_ = 0;
+};
+
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_STREAM_READER_H_
@@ -0,0 +1,358 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_stream_reader.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/json/json_parser.h"
+#include "base/json/json_reader.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+
+namespace {
+
+// Records the callbacks it gets as a compact string, e.g. "[1,s:a,{k:n}]".
+// Containers whose first character is in |skip_containers_| and keys in
+// |skip_keys_| are skipped.
+class RecordingDelegate : public JSONStreamReader::Delegate {
+ public:
+  RecordingDelegate() = default;
+  RecordingDelegate(StringPiece skip_containers, StringPiece skip_keys)
+      : skip_containers_(skip_containers), skip_keys_(skip_keys) {}
+
+  bool OnDictionaryStart() override {
+    if (skip_containers_.find('{') != StringPiece::npos)
+      return Record("{}");
+    Separate();
+    result_ += "{";
+    return true;
+  }
+  bool OnDictionaryKey(StringPiece key) override {
+    Separate();
+    result_ += std::string(key) + ":";
+    after_key_ = true;
+    if (skip_keys_ == key)
+      return Record("-");
+    return true;
+  }
+  void OnDictionaryEnd() override { result_ += "}"; }
+
+  bool OnListStart() override {
+    if (skip_containers_.find('[') != StringPiece::npos)
+      return Record("[]");
+    Separate();
+    result_ += "[";
+    return true;
+  }
+  void OnListEnd() override { result_ += "]"; }
+
+  void OnString(StringPiece value) override {
+    Record("s:" + std::string(value));
+  }
+  void OnInt(int value) override { Record(NumberToString(value)); }
+  void OnDouble(double value) override {
+    Record("d:" + NumberToString(value));
+  }
+  void OnBool(bool value) override { Record(value ? "t" : "f"); }
+  void OnNull() override { Record("n"); }
+
+  const std::string& result() const { return result_; }
+
+ private:
+  // Adds a comma between the elements of a container.
+  void Separate() {
+    if (!after_key_ && !result_.empty() && result_.back() != '[' &&
+        result_.back() != '{') {
+      result_ += ",";
+    }
+    after_key_ = false;
+  }
+
+  // Records a value or a skipped container, and returns false.
+  bool Record(const std::string& value) {
+    Separate();
+    result_ += value;
+    return false;
+  }
+
+  const std::string skip_containers_;
+  const std::string skip_keys_;
+  std::string result_;
+  bool after_key_ = false;
+};
+
+// Parses |input| in chunks of |chunk_size| bytes, or all at once if it is 0.
+bool Parse(StringPiece input,
+           JSONStreamReader* reader,
+           size_t chunk_size = 0) {
+  if (!chunk_size)
+    chunk_size = input.size();
+  for (size_t i = 0; i < input.size(); i += chunk_size) {
+    if (!reader->Append(input.substr(i, chunk_size)))
+      return false;
+  }
+  return reader->Finish();
+}
+
+// Returns what RecordingDelegate records for |input|, or "error" if it fails
+// to parse, checking that the result does not depend on how |input| is split.
+std::string Record(StringPiece input, int options = JSON_PARSE_RFC) {
+  std::string expected;
+  for (size_t chunk_size : {0, 1, 2, 3, 7}) {
+    RecordingDelegate delegate;
+    JSONStreamReader reader(&delegate, options);
+    const std::string result =
+        Parse(input, &reader, chunk_size) ? delegate.result() : "error";
+    if (chunk_size)
+      EXPECT_EQ(expected, result) << "chunk size " << chunk_size;
+    else
+      expected = result;
+  }
+  return expected;
+}
+
+}  // namespace
+
+TEST(JSONStreamReaderTest, Values) {
+  EXPECT_EQ("n", Record("null"));
+  EXPECT_EQ("t", Record(" true "));
+  EXPECT_EQ("f", Record("\nfalse\r\n"));
+  EXPECT_EQ("42", Record("42"));
+  EXPECT_EQ("-1", Record("-1"));
+  EXPECT_EQ("d:0.5", Record("0.5"));
+  EXPECT_EQ("d:100", Record("1e2"));
+  EXPECT_EQ("d:3000000000", Record("3000000000"));
+  EXPECT_EQ("s:foo", Record("\"foo\""));
+  EXPECT_EQ("s:", Record("\"\""));
+  EXPECT_EQ("[]", Record("[]"));
+  EXPECT_EQ("{}", Record("{ }"));
+  EXPECT_EQ("[1,s:two,[t,n],{}]", Record("[1, \"two\", [true, null], {}]"));
+  EXPECT_EQ("{a:1,b:{c:[f]},d:s:e}",
+            Record(R"({"a": 1, "b": {"c": [false]}, "d": "e"})"));
+}
+
+TEST(JSONStreamReaderTest, Escapes) {
+  EXPECT_EQ("s:\"\\/\b\f\n\r\t\v", Record(R"("\"\\\/\b\f\n\r\t\v")"));
+  EXPECT_EQ("s:A\xC3\xA9\xE2\x82\xAC", Record(R"("\u0041\u00e9\u20AC")"));
+  EXPECT_EQ("s:\xF0\x9F\x98\x80", Record(R"("\uD83D\uDE00")"));
+  EXPECT_EQ("s:\xC3\xA9", Record(R"("\xe9")"));
+  EXPECT_EQ(std::string("s:a\0b", 5), Record(R"("a\u0000b")"));
+
+  EXPECT_EQ("error", Record(R"("\q")"));
+  EXPECT_EQ("error", Record(R"("\u00G0")"));
+  EXPECT_EQ("error", Record(R"("\uD83D")"));
+  EXPECT_EQ("error", Record(R"("\uD83Dx")"));
+  EXPECT_EQ("error", Record(R"("\uDE00")"));
+  EXPECT_EQ("error", Record(R"("\uD83D\u0041")"));
+
+  EXPECT_EQ("s:\xEF\xBF\xBD", Record(R"("\uD83D")",
+                                     JSON_REPLACE_INVALID_CHARACTERS));
+  EXPECT_EQ("s:\xEF\xBF\xBD" "A",
+            Record(R"("\uD83D\u0041")", JSON_REPLACE_INVALID_CHARACTERS));
+}
+
+TEST(JSONStreamReaderTest, InvalidUTF8) {
+  EXPECT_EQ("error", Record("\"\xFF\""));
+  EXPECT_EQ("s:a\xEF\xBF\xBD" "b",
+            Record("\"a\xFF" "b\"", JSON_REPLACE_INVALID_CHARACTERS));
+  // Multi-byte characters may be split across chunks.
+  EXPECT_EQ("s:\xF0\x9F\x98\x80", Record("\"\xF0\x9F\x98\x80\""));
+}
+
+TEST(JSONStreamReaderTest, ByteOrderMark) {
+  EXPECT_EQ("[1]", Record("\xEF\xBB\xBF[1]"));
+  EXPECT_EQ("error", Record("\xEF\xBB[1]"));
+  EXPECT_EQ("error", Record(" \xEF\xBB\xBF[1]"));
+}
+
+TEST(JSONStreamReaderTest, Numbers) {
+  EXPECT_EQ("[0,0,d:1.5,d:-0.25,d:1e+20]",
+            Record("[0, -0, 1.5, -2.5e-1, 1E+20]"));
+  EXPECT_EQ("error", Record("01"));
+  EXPECT_EQ("error", Record("-"));
+  EXPECT_EQ("error", Record("1."));
+  EXPECT_EQ("error", Record(".5"));
+  EXPECT_EQ("error", Record("1e"));
+  EXPECT_EQ("error", Record("+1"));
+  EXPECT_EQ("error", Record("1e1000"));
+}
+
+TEST(JSONStreamReaderTest, TrailingCommas) {
+  EXPECT_EQ("error", Record("[1,]"));
+  EXPECT_EQ("error", Record(R"({"a": 1,})"));
+  EXPECT_EQ("[1]", Record("[1,]", JSON_ALLOW_TRAILING_COMMAS));
+  EXPECT_EQ("{a:1}", Record(R"({"a": 1,})", JSON_ALLOW_TRAILING_COMMAS));
+  EXPECT_EQ("error", Record("[,]", JSON_ALLOW_TRAILING_COMMAS));
+  EXPECT_EQ("error", Record("[1,,]", JSON_ALLOW_TRAILING_COMMAS));
+}
+
+TEST(JSONStreamReaderTest, SyntaxErrors) {
+  EXPECT_EQ("error", Record(""));
+  EXPECT_EQ("error", Record("  "));
+  EXPECT_EQ("error", Record("[1"));
+  EXPECT_EQ("error", Record("[1}"));
+  EXPECT_EQ("error", Record("{\"a\"}"));
+  EXPECT_EQ("error", Record("{\"a\" 1}"));
+  EXPECT_EQ("error", Record("{a: 1}"));
+  EXPECT_EQ("error", Record("[1 2]"));
+  EXPECT_EQ("error", Record("\"abc"));
+  EXPECT_EQ("error", Record("tru"));
+  EXPECT_EQ("error", Record("trve"));
+  EXPECT_EQ("error", Record("nullx"));
+  EXPECT_EQ("error", Record("1 2"));
+  EXPECT_EQ("error", Record("/* comment */ 1"));
+}
+
+TEST(JSONStreamReaderTest, ErrorMessages) {
+  struct {
+    const char* input;
+    const char* description;
+    int line;
+    int column;
+  } kCases[] = {
+      {"[1,]", internal::JSONParser::kTrailingComma, 1, 4},
+      {"[\n  1,\n  x]", internal::JSONParser::kUnexpectedToken, 3, 3},
+      {"\r\n\r\n{a: 1}", internal::JSONParser::kUnquotedDictionaryKey, 3, 2},
+      // Only a line feed right after a carriage return is part of a CRLF.
+      {"[\"a\r\"\nx]", internal::JSONParser::kSyntaxError, 3, 1},
+      {"[\"a\r\\n\"\nx]", internal::JSONParser::kSyntaxError, 3, 1},
+      {"[1] [2]", internal::JSONParser::kUnexpectedDataAfterRoot, 1, 5},
+      {"[1", internal::JSONParser::kSyntaxError, 1, 3},
+      {"", internal::JSONParser::kUnexpectedToken, 1, 1},
+      {"\"\\q\"", internal::JSONParser::kInvalidEscape, 1, 3},
+      {"[1e999]", internal::JSONParser::kUnrepresentableNumber, 1, 7},
+  };
+  for (const auto& test_case : kCases) {
+    SCOPED_TRACE(test_case.input);
+    RecordingDelegate delegate;
+    JSONStreamReader reader(&delegate);
+    EXPECT_FALSE(Parse(test_case.input, &reader));
+    EXPECT_EQ(test_case.line, reader.error_line());
+    EXPECT_EQ(test_case.column, reader.error_column());
+    EXPECT_EQ(StringPrintf("Line: %i, column: %i, %s", test_case.line,
+                           test_case.column, test_case.description),
+              reader.GetErrorMessage());
+
+    // Calls after an error keep failing.
+    EXPECT_FALSE(reader.Append("1"));
+    EXPECT_FALSE(reader.Finish());
+  }
+}
+
+TEST(JSONStreamReaderTest, MaxDepth) {
+  RecordingDelegate delegate;
+  JSONStreamReader reader(&delegate, JSON_PARSE_RFC, 2);
+  EXPECT_TRUE(Parse("[[1]]", &reader));
+
+  JSONStreamReader too_deep(&delegate, JSON_PARSE_RFC, 2);
+  EXPECT_FALSE(Parse("[[{}]]", &too_deep));
+  EXPECT_EQ(StringPrintf("Line: 1, column: 3, %s",
+                         internal::JSONParser::kTooMuchNesting),
+            too_deep.GetErrorMessage());
+}
+
+TEST(JSONStreamReaderTest, SkipContainers) {
+  const char kInput[] =
+      R"({"a": [1, {"b": "\u00e9"}], "c": {"d": [[]]}, "e": 2})";
+  RecordingDelegate skip_lists("[", "");
+  JSONStreamReader lists_reader(&skip_lists);
+  EXPECT_TRUE(Parse(kInput, &lists_reader, 1));
+  EXPECT_EQ("{a:[],c:{d:[]},e:2}", skip_lists.result());
+
+  RecordingDelegate skip_dicts("{", "");
+  JSONStreamReader dicts_reader(&skip_dicts);
+  EXPECT_TRUE(Parse(kInput, &dicts_reader, 1));
+  EXPECT_EQ("{}", skip_dicts.result());
+
+  // Skipped values must still be well-formed.
+  RecordingDelegate skip_invalid("[", "");
+  JSONStreamReader invalid_reader(&skip_invalid);
+  EXPECT_FALSE(Parse("[1, \"\\q\"]", &invalid_reader));
+}
+
+TEST(JSONStreamReaderTest, SkipKeys) {
+  const char kInput[] =
+      R"({"a": {"x": [1]}, "b": 2, "a": "str", "c": [{"a": null}]})";
+  RecordingDelegate delegate("", "a");
+  JSONStreamReader reader(&delegate);
+  EXPECT_TRUE(Parse(kInput, &reader, 2));
+  EXPECT_EQ("{a:-,b:2,a:-,c:[{a:-}]}", delegate.result());
+}
+
+TEST(JSONStreamReaderTest, MatchesJSONReader) {
+  // Reassembles a Value from the callbacks.
+  class ValueBuilder : public JSONStreamReader::Delegate {
+   public:
+    bool OnDictionaryStart() override {
+      return Push(Value(Value::Type::DICTIONARY));
+    }
+    bool OnDictionaryKey(StringPiece key) override {
+      key_ = std::string(key);
+      return true;
+    }
+    void OnDictionaryEnd() override { Pop(); }
+    bool OnListStart() override { return Push(Value(Value::Type::LIST)); }
+    void OnListEnd() override { Pop(); }
+    void OnString(StringPiece value) override { Add(Value(value)); }
+    void OnInt(int value) override { Add(Value(value)); }
+    void OnDouble(double value) override { Add(Value(value)); }
+    void OnBool(bool value) override { Add(Value(value)); }
+    void OnNull() override { Add(Value()); }
+
+    Value TakeResult() { return std::move(stack_.back().second); }
+
+   private:
+    bool Push(Value container) {
+      stack_.emplace_back(key_, std::move(container));
+      return true;
+    }
+    void Pop() {
+      if (stack_.size() == 1)
+        return;
+      std::pair<std::string, Value> top = std::move(stack_.back());
+      stack_.pop_back();
+      key_ = std::move(top.first);
+      Add(std::move(top.second));
+    }
+    void Add(Value value) {
+      if (stack_.empty()) {
+        stack_.emplace_back(std::string(), std::move(value));
+      } else if (stack_.back().second.is_list()) {
+        stack_.back().second.Append(std::move(value));
+      } else {
+        stack_.back().second.SetKey(key_, std::move(value));
+      }
+    }
+
+    std::vector<std::pair<std::string, Value>> stack_;
+    std::string key_;
+  };
+
+  const char* const kInputs[] = {
+      "null",
+      "[1, 2.5, -3e-2, true, \"x\\ny\", \"\\u00e9\", []]",
+      R"({"k": {"nested": [{}, [], null]}, "k": 1, "a\u0062": "c"})",
+      "\xEF\xBB\xBF {\"bom\": [\"\xE2\x82\xAC\"]}\r\n",
+  };
+  for (const char* input : kInputs) {
+    SCOPED_TRACE(input);
+    absl::optional<Value> expected = JSONReader::Read(input);
+    ASSERT_TRUE(expected);
+
+    ValueBuilder builder;
+    JSONStreamReader reader(&builder);
+    ASSERT_TRUE(Parse(input, &reader, 1));
+    EXPECT_EQ(*expected, builder.TakeResult());
+  }
+}
+
+}  // namespace base
@@ -18,6 +18,15 @@ bool BasicValueConverter<int>::Convert(
   return true;
 }
 
+bool BasicValueConverter<int>::Convert(const JSONValueView& value,
+                                       int* field) const {
+  if (!value.is_int())
+    return false;
+  if (field)
+    *field = value.GetInt();
+  return true;
+}
+
 bool BasicValueConverter<std::string>::Convert(
     const base::Value& value, std::string* field) const {
   if (!value.is_string())
@@ -27,6 +36,15 @@ bool BasicValueConverter<std::string>::Convert(
   return true;
 }
 
+bool BasicValueConverter<std::string>::Convert(const JSONValueView& value,
+                                               std::string* field) const {
+  if (!value.is_string())
+    return false;
+  if (field)
+    *field = std::string(value.GetString());
+  return true;
+}
+
 bool BasicValueConverter<std::u16string>::Convert(const base::Value& value,
                                                   std::u16string* field) const {
   if (!value.is_string())
@@ -36,6 +54,15 @@ bool BasicValueConverter<std::u16string>::Convert(const base::Value& value,
   return true;
 }
 
+bool BasicValueConverter<std::u16string>::Convert(const JSONValueView& value,
+                                                  std::u16string* field) const {
+  if (!value.is_string())
+    return false;
+  if (field)
+    *field = base::UTF8ToUTF16(value.GetString());
+  return true;
+}
+
 bool BasicValueConverter<double>::Convert(
     const base::Value& value, double* field) const {
   if (!value.is_double() && !value.is_int())
@@ -45,6 +72,15 @@ bool BasicValueConverter<double>::Convert(
   return true;
 }
 
+bool BasicValueConverter<double>::Convert(const JSONValueView& value,
+                                          double* field) const {
+  if (!value.is_double() && !value.is_int())
+    return false;
+  if (field)
+    *field = value.GetDouble();
+  return true;
+}
+
 bool BasicValueConverter<bool>::Convert(
     const base::Value& value, bool* field) const {
   if (!value.is_bool())
@@ -54,6 +90,15 @@ bool BasicValueConverter<bool>::Convert(
   return true;
 }
 
+bool BasicValueConverter<bool>::Convert(const JSONValueView& value,
+                                        bool* field) const {
+  if (!value.is_bool())
+    return false;
+  if (field)
+    *field = value.GetBool();
+  return true;
+}
+
 }  // namespace internal
 }  // namespace base
 
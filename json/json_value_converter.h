@@ -7,11 +7,13 @@
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "base/base_export.h"
+#include "base/json/json_value_view.h"
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/memory/ptr_util.h"
@@ -83,6 +85,16 @@
 //           "your_enum", &Message::ye, &ConvertFunc);
 //     }
 //   };
+//
+// Convert() also accepts a JSONValueView, which decodes the struct straight
+// from a document parsed by JSONReader::ReadDocument() without building a
+// base::Value tree first. The registered fields are compiled into a table
+// sorted by key, so they are found in a single pass over each dictionary.
+// Only fields registered with RegisterCustomValueField() or
+// RegisterRepeatedCustomValue() make a base::Value copy of their own value.
+//   absl::optional<JSONDocument> document = JSONReader::ReadDocument(json);
+//   if (document)
+//     converter.Convert(document->root(), &message);
 
 namespace base {
 
@@ -98,6 +110,8 @@ class FieldConverterBase {
   virtual ~FieldConverterBase() = default;
   virtual bool ConvertField(const base::Value& value, StructType* obj)
       const = 0;
+  virtual bool ConvertField(const JSONValueView& value,
+                            StructType* obj) const = 0;
   const std::string& field_path() const { return field_path_; }
 
  private:
@@ -110,6 +124,11 @@ class ValueConverter {
  public:
   virtual ~ValueConverter() = default;
   virtual bool Convert(const base::Value& value, FieldType* field) const = 0;
+  // Converts a copy of |value| with the overload above. Converters that can
+  // read JSONValueViews directly should override this.
+  virtual bool Convert(const JSONValueView& value, FieldType* field) const {
+    return Convert(value.ToValue(), field);
+  }
 };
 
 template <typename StructType, typename FieldType>
@@ -127,6 +146,11 @@ class FieldConverter : public FieldConverterBase<StructType> {
     return value_converter_->Convert(value, &(dst->*field_pointer_));
   }
 
+  bool ConvertField(const JSONValueView& value,
+                    StructType* dst) const override {
+    return value_converter_->Convert(value, &(dst->*field_pointer_));
+  }
+
  private:
   FieldType StructType::* field_pointer_;
   std::unique_ptr<ValueConverter<FieldType>> value_converter_;
@@ -142,6 +166,7 @@ class BASE_EXPORT BasicValueConverter<int> : public ValueConverter<int> {
   BasicValueConverter() = default;
 
   bool Convert(const base::Value& value, int* field) const override;
+  bool Convert(const JSONValueView& value, int* field) const override;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(BasicValueConverter);
@@ -154,6 +179,7 @@ class BASE_EXPORT BasicValueConverter<std::string>
   BasicValueConverter() = default;
 
   bool Convert(const base::Value& value, std::string* field) const override;
+  bool Convert(const JSONValueView& value, std::string* field) const override;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(BasicValueConverter);
@@ -166,6 +192,8 @@ class BASE_EXPORT BasicValueConverter<std::u16string>
   BasicValueConverter() = default;
 
   bool Convert(const base::Value& value, std::u16string* field) const override;
+  bool Convert(const JSONValueView& value,
+               std::u16string* field) const override;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(BasicValueConverter);
@@ -177,6 +205,7 @@ class BASE_EXPORT BasicValueConverter<double> : public ValueConverter<double> {
   BasicValueConverter() = default;
 
   bool Convert(const base::Value& value, double* field) const override;
+  bool Convert(const JSONValueView& value, double* field) const override;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(BasicValueConverter);
@@ -188,6 +217,7 @@ class BASE_EXPORT BasicValueConverter<bool> : public ValueConverter<bool> {
   BasicValueConverter() = default;
 
   bool Convert(const base::Value& value, bool* field) const override;
+  bool Convert(const JSONValueView& value, bool* field) const override;
 
  private:
   DISALLOW_COPY_AND_ASSIGN(BasicValueConverter);
@@ -205,6 +235,11 @@ class ValueFieldConverter : public ValueConverter<FieldType> {
     return convert_func_(&value, field);
   }
 
+  bool Convert(const JSONValueView& value, FieldType* field) const override {
+    const Value copy = value.ToValue();
+    return convert_func_(&copy, field);
+  }
+
  private:
   ConvertFunc convert_func_;
 
@@ -223,6 +258,10 @@ class CustomFieldConverter : public ValueConverter<FieldType> {
     return value.is_string() && convert_func_(value.GetString(), field);
   }
 
+  bool Convert(const JSONValueView& value, FieldType* field) const override {
+    return value.is_string() && convert_func_(value.GetString(), field);
+  }
+
  private:
   ConvertFunc convert_func_;
 
@@ -238,6 +277,10 @@ class NestedValueConverter : public ValueConverter<NestedType> {
     return converter_.Convert(value, field);
   }
 
+  bool Convert(const JSONValueView& value, NestedType* field) const override {
+    return converter_.Convert(value, field);
+  }
+
  private:
   JSONValueConverter<NestedType> converter_;
   DISALLOW_COPY_AND_ASSIGN(NestedValueConverter);
@@ -255,10 +298,21 @@ class RepeatedValueConverter
       // The field is not a list.
       return false;
     }
+    return ConvertList(value.GetList(), field);
+  }
+
+  bool Convert(const JSONValueView& value,
+               std::vector<std::unique_ptr<Element>>* field) const override {
+    return value.is_list() && ConvertList(value.GetList(), field);
+  }
 
-    field->reserve(value.GetList().size());
+ private:
+  template <typename List>
+  bool ConvertList(const List& list,
+                   std::vector<std::unique_ptr<Element>>* field) const {
+    field->reserve(list.size());
     size_t i = 0;
-    for (const Value& element : value.GetList()) {
+    for (const auto& element : list) {
       auto e = std::make_unique<Element>();
       if (basic_converter_.Convert(element, e.get())) {
         field->push_back(std::move(e));
@@ -271,7 +325,6 @@ class RepeatedValueConverter
     return true;
   }
 
- private:
   BasicValueConverter<Element> basic_converter_;
   DISALLOW_COPY_AND_ASSIGN(RepeatedValueConverter);
 };
@@ -284,12 +337,21 @@ class RepeatedMessageConverter
 
   bool Convert(const base::Value& value,
                std::vector<std::unique_ptr<NestedType>>* field) const override {
-    if (!value.is_list())
-      return false;
+    return value.is_list() && ConvertList(value.GetList(), field);
+  }
+
+  bool Convert(const JSONValueView& value,
+               std::vector<std::unique_ptr<NestedType>>* field) const override {
+    return value.is_list() && ConvertList(value.GetList(), field);
+  }
 
-    field->reserve(value.GetList().size());
+ private:
+  template <typename List>
+  bool ConvertList(const List& list,
+                   std::vector<std::unique_ptr<NestedType>>* field) const {
+    field->reserve(list.size());
     size_t i = 0;
-    for (const Value& element : value.GetList()) {
+    for (const auto& element : list) {
       auto nested = std::make_unique<NestedType>();
       if (converter_.Convert(element, nested.get())) {
         field->push_back(std::move(nested));
@@ -302,7 +364,6 @@ class RepeatedMessageConverter
     return true;
   }
 
- private:
   JSONValueConverter<NestedType> converter_;
   DISALLOW_COPY_AND_ASSIGN(RepeatedMessageConverter);
 };
@@ -318,14 +379,23 @@ class RepeatedCustomValueConverter
 
   bool Convert(const base::Value& value,
                std::vector<std::unique_ptr<NestedType>>* field) const override {
-    if (!value.is_list())
-      return false;
+    return value.is_list() && ConvertList(value.GetList(), field);
+  }
 
-    field->reserve(value.GetList().size());
+  bool Convert(const JSONValueView& value,
+               std::vector<std::unique_ptr<NestedType>>* field) const override {
+    return value.is_list() && ConvertList(value.GetList(), field);
+  }
+
+ private:
+  template <typename List>
+  bool ConvertList(const List& list,
+                   std::vector<std::unique_ptr<NestedType>>* field) const {
+    field->reserve(list.size());
     size_t i = 0;
-    for (const Value& element : value.GetList()) {
+    for (const auto& element : list) {
       auto nested = std::make_unique<NestedType>();
-      if ((*convert_func_)(&element, nested.get())) {
+      if (ConvertElement(element, nested.get())) {
         field->push_back(std::move(nested));
       } else {
         DVLOG(1) << "failure at " << i << "-th element";
@@ -336,7 +406,15 @@ class RepeatedCustomValueConverter
     return true;
   }
 
- private:
+  bool ConvertElement(const base::Value& element, NestedType* field) const {
+    return (*convert_func_)(&element, field);
+  }
+
+  bool ConvertElement(const JSONValueView& element, NestedType* field) const {
+    const Value copy = element.ToValue();
+    return (*convert_func_)(&copy, field);
+  }
+
   ConvertFunc convert_func_;
   DISALLOW_COPY_AND_ASSIGN(RepeatedCustomValueConverter);
 };
@@ -349,6 +427,15 @@ class JSONValueConverter {
  public:
   JSONValueConverter() {
     StructType::RegisterJSONConverter(this);
+
+    sorted_fields_.reserve(fields_.size());
+    for (const auto& field : fields_)
+      sorted_fields_.push_back(field.get());
+    std::stable_sort(sorted_fields_.begin(), sorted_fields_.end(),
+                     [](const internal::FieldConverterBase<StructType>* a,
+                        const internal::FieldConverterBase<StructType>* b) {
+                       return a->field_path() < b->field_path();
+                     });
   }
 
   void RegisterIntField(const std::string& field_name,
@@ -502,10 +589,47 @@ class JSONValueConverter {
     return true;
   }
 
+  bool Convert(const JSONValueView& value, StructType* output) const {
+    if (!value.is_dict())
+      return false;
+    DCHECK_EQ(fields_.size(), sorted_fields_.size())
+        << "Fields must be registered in RegisterJSONConverter()";
+
+    // Both the fields and the entries of |value| are sorted by key, so each
+    // lookup only needs to search the entries after the previous match.
+    span<const JSONValueDictEntry> entries = value.GetDict();
+    auto next_entry = entries.begin();
+    for (const internal::FieldConverterBase<StructType>* field_converter :
+         sorted_fields_) {
+      const StringPiece path = field_converter->field_path();
+      const JSONValueView* field = nullptr;
+      if (path.find('.') == StringPiece::npos) {
+        next_entry = std::lower_bound(
+            next_entry, entries.end(), path,
+            [](const JSONValueDictEntry& entry, StringPiece key) {
+              return entry.key < key;
+            });
+        if (next_entry != entries.end() && next_entry->key == path)
+          field = &next_entry->value;
+      } else {
+        field = value.FindPath(path);
+      }
+
+      if (field && !field_converter->ConvertField(*field, output)) {
+        DVLOG(1) << "failure at field " << field_converter->field_path();
+        return false;
+      }
+    }
+    return true;
+  }
+
  private:
   std::vector<std::unique_ptr<internal::FieldConverterBase<StructType>>>
       fields_;
 
+  // |fields_| sorted by path, for converting JSONValueViews.
+  std::vector<const internal::FieldConverterBase<StructType>*> sorted_fields_;
+
   DISALLOW_COPY_AND_ASSIGN(JSONValueConverter);
 };
 
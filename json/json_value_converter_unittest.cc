@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "base/json/json_reader.h"
+#include "base/json/json_value_view.h"
 #include "base/strings/string_piece.h"
 #include "base/values.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -91,6 +92,38 @@ struct NestedMessage {
   }
 };
 
+// For fields at nested paths.
+struct PathMessage {
+  int inner = 0;
+  std::string first;
+  double last = 0;
+
+  static void RegisterJSONConverter(
+      base::JSONValueConverter<PathMessage>* converter) {
+    converter->RegisterDoubleField("z", &PathMessage::last);
+    converter->RegisterIntField("outer.inner", &PathMessage::inner);
+    converter->RegisterStringField("a", &PathMessage::first);
+  }
+};
+
+// Converts a list of integers to their sum, and only knows about base::Value.
+class SumConverter : public internal::ValueConverter<int> {
+ public:
+  using internal::ValueConverter<int>::Convert;
+
+  bool Convert(const base::Value& value, int* field) const override {
+    if (!value.is_list())
+      return false;
+    *field = 0;
+    for (const Value& item : value.GetList()) {
+      if (!item.is_int())
+        return false;
+      *field += item.GetInt();
+    }
+    return true;
+  }
+};
+
 }  // namespace
 
 TEST(JSONValueConverterTest, ParseSimpleMessage) {
@@ -258,4 +291,108 @@ TEST(JSONValueConverterTest, RepeatedValueErrorInTheMiddle) {
   // No check the values as mentioned above.
 }
 
+TEST(JSONValueConverterTest, ParseNestedMessageFromDocument) {
+  const char normal_data[] =
+      "{\n"
+      "  \"foo\": 1.5,\n"
+      "  \"unknown\": [1, {\"bar\": 2}],\n"
+      "  \"child\": {\n"
+      "    \"foo\": 1,\n"
+      "    \"bar\": \"bar\",\n"
+      "    \"bstruct\": {},\n"
+      "    \"string_values\": [{\"val\": \"value_1\"}],"
+      "    \"simple_enum\": \"bar\","
+      "    \"ints\": [1, 2],"
+      "    \"baz\": true\n"
+      "  },\n"
+      "  \"children\": [{\"foo\": 2}, {\"foo\": 3, \"bar\": \"baz\"}]\n"
+      "}\n";
+
+  absl::optional<JSONDocument> document =
+      base::JSONReader::ReadDocument(normal_data);
+  ASSERT_TRUE(document);
+  NestedMessage message;
+  base::JSONValueConverter<NestedMessage> converter;
+  EXPECT_TRUE(converter.Convert(document->root(), &message));
+
+  EXPECT_EQ(1.5, message.foo);
+  EXPECT_EQ(1, message.child.foo);
+  EXPECT_EQ("bar", message.child.bar);
+  EXPECT_TRUE(message.child.baz);
+  EXPECT_TRUE(message.child.bstruct);
+  EXPECT_EQ(SimpleMessage::BAR, message.child.simple_enum);
+  ASSERT_EQ(2U, message.child.ints.size());
+  EXPECT_EQ(1, *message.child.ints[0]);
+  EXPECT_EQ(2, *message.child.ints[1]);
+  ASSERT_EQ(1U, message.child.string_values.size());
+  EXPECT_EQ("value_1", *message.child.string_values[0]);
+
+  ASSERT_EQ(2U, message.children.size());
+  EXPECT_EQ(2, message.children[0]->foo);
+  EXPECT_EQ("", message.children[0]->bar);
+  EXPECT_EQ(3, message.children[1]->foo);
+  EXPECT_EQ("baz", message.children[1]->bar);
+}
+
+TEST(JSONValueConverterTest, ParsePathsFromDocument) {
+  absl::optional<JSONDocument> document = base::JSONReader::ReadDocument(
+      R"({"z": 2, "outer": {"inner": 3}, "b": null, "a": "first"})");
+  ASSERT_TRUE(document);
+  PathMessage message;
+  base::JSONValueConverter<PathMessage> converter;
+  EXPECT_TRUE(converter.Convert(document->root(), &message));
+  EXPECT_EQ(3, message.inner);
+  EXPECT_EQ("first", message.first);
+  EXPECT_EQ(2.0, message.last);
+
+  // A path through a non-dictionary is a missing field.
+  document = base::JSONReader::ReadDocument(R"({"outer": [1]})");
+  ASSERT_TRUE(document);
+  EXPECT_TRUE(converter.Convert(document->root(), &message));
+  EXPECT_EQ(3, message.inner);
+
+  document = base::JSONReader::ReadDocument(R"({"outer": {"inner": "3"}})");
+  ASSERT_TRUE(document);
+  EXPECT_FALSE(converter.Convert(document->root(), &message));
+}
+
+TEST(JSONValueConverterTest, ValueOnlyConverterConvertsViews) {
+  absl::optional<JSONDocument> document =
+      base::JSONReader::ReadDocument("[1, 2, 3]");
+  ASSERT_TRUE(document);
+  const SumConverter converter;
+  int sum = 0;
+  EXPECT_TRUE(converter.Convert(document->root(), &sum));
+  EXPECT_EQ(6, sum);
+
+  document = base::JSONReader::ReadDocument("[1, \"2\"]");
+  ASSERT_TRUE(document);
+  EXPECT_FALSE(converter.Convert(document->root(), &sum));
+}
+
+TEST(JSONValueConverterTest, DocumentFailuresMatchValue) {
+  const char* const kInputs[] = {
+      "[]",
+      R"({"foo": 1, "bar": 2})",
+      R"({"simple_enum": "baz"})",
+      R"({"ints": [1, false]})",
+      R"({"ints": 1})",
+      R"({"string_values": [{"val": 1}]})",
+      R"({"foo": 1, "bar": "bar", "ints": [], "simple_enum": "foo"})",
+  };
+  base::JSONValueConverter<SimpleMessage> converter;
+  for (const char* input : kInputs) {
+    SCOPED_TRACE(input);
+    absl::optional<Value> value = base::JSONReader::Read(input);
+    absl::optional<JSONDocument> document =
+        base::JSONReader::ReadDocument(input);
+    ASSERT_TRUE(value);
+    ASSERT_TRUE(document);
+    SimpleMessage from_value;
+    SimpleMessage from_document;
+    EXPECT_EQ(converter.Convert(*value, &from_value),
+              converter.Convert(document->root(), &from_document));
+  }
+}
+
 }  // namespace base
@@ -0,0 +1,158 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_value_view.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/check.h"
+#include "base/notreached.h"
+
+namespace base {
+
+namespace {
+
+// The arena grows geometrically from a first block sized after the input, so a
+// document takes O(log n) allocations, but never reserves more than this much
+// memory it may not need.
+constexpr size_t kMinBlockSize = 1024;
+constexpr size_t kMaxBlockSize = 4 * 1024 * 1024;
+
+}  // namespace
+
+static_assert(std::is_trivially_copyable<JSONValueView>::value,
+              "JSONValueView must be a trivially copyable handle");
+static_assert(std::is_trivially_destructible<JSONValueDictEntry>::value,
+              "JSONValueDictEntry must not need destruction");
+
+bool JSONValueView::GetBool() const {
+  CHECK(is_bool());
+  return bool_value_;
+}
+
+int JSONValueView::GetInt() const {
+  CHECK(is_int());
+  return int_value_;
+}
+
+double JSONValueView::GetDouble() const {
+  if (is_double())
+    return double_value_;
+  CHECK(is_int());
+  return int_value_;
+}
+
+StringPiece JSONValueView::GetString() const {
+  CHECK(is_string());
+  return StringPiece(string_data_, size_);
+}
+
+span<const JSONValueView> JSONValueView::GetList() const {
+  CHECK(is_list());
+  return make_span(list_data_, size_);
+}
+
+span<const JSONValueDictEntry> JSONValueView::GetDict() const {
+  CHECK(is_dict());
+  return make_span(dict_data_, size_);
+}
+
+const JSONValueView* JSONValueView::FindKey(StringPiece key) const {
+  span<const JSONValueDictEntry> dict = GetDict();
+  auto it = std::lower_bound(dict.begin(), dict.end(), key,
+                             [](const JSONValueDictEntry& entry,
+                                StringPiece key) { return entry.key < key; });
+  if (it == dict.end() || it->key != key)
+    return nullptr;
+  return &it->value;
+}
+
+const JSONValueView* JSONValueView::FindPath(StringPiece path) const {
+  CHECK(is_dict());
+  const JSONValueView* cur = this;
+  while (!path.empty()) {
+    const size_t dot = path.find('.');
+    const StringPiece key = path.substr(0, dot);
+    path = dot == StringPiece::npos ? StringPiece() : path.substr(dot + 1);
+    if (!cur->is_dict() || (cur = cur->FindKey(key)) == nullptr)
+      return nullptr;
+  }
+  return cur;
+}
+
+Value JSONValueView::ToValue() const {
+  switch (type_) {
+    case Value::Type::NONE:
+      return Value();
+    case Value::Type::BOOLEAN:
+      return Value(bool_value_);
+    case Value::Type::INTEGER:
+      return Value(int_value_);
+    case Value::Type::DOUBLE:
+      return Value(double_value_);
+    case Value::Type::STRING:
+      return Value(GetString());
+    case Value::Type::LIST: {
+      Value::ListStorage list;
+      list.reserve(size_);
+      for (const JSONValueView& element : GetList())
+        list.push_back(element.ToValue());
+      return Value(std::move(list));
+    }
+    case Value::Type::DICTIONARY: {
+      // The entries are already sorted and unique, so this does not need to
+      // sort them again.
+      std::vector<Value::DictStorage::value_type> dict;
+      dict.reserve(size_);
+      for (const JSONValueDictEntry& entry : GetDict())
+        dict.emplace_back(std::string(entry.key), entry.value.ToValue());
+      return Value(Value::DictStorage(sorted_unique, std::move(dict)));
+    }
+    case Value::Type::BINARY:
+      break;
+  }
+  NOTREACHED();
+  return Value();
+}
+
+JSONDocument::JSONDocument(size_t input_size)
+    : next_block_size_(
+          std::max(kMinBlockSize, std::min(input_size, kMaxBlockSize))) {}
+
+JSONDocument::JSONDocument(JSONDocument&& other) = default;
+
+JSONDocument& JSONDocument::operator=(JSONDocument&& other) = default;
+
+JSONDocument::~JSONDocument() = default;
+
+StringPiece JSONDocument::CopyString(StringPiece str) {
+  if (str.empty())
+    return StringPiece();
+  char* data = AllocateArray<char>(str.size());
+  memcpy(data, str.data(), str.size());
+  return StringPiece(data, str.size());
+}
+
+void* JSONDocument::Allocate(size_t size) {
+  if (!size)
+    return nullptr;
+  size = (size + kAlignment - 1) & ~(kAlignment - 1);
+  if (size > remaining_) {
+    const size_t block_size = std::max(size, next_block_size_);
+    // Not std::make_unique(), which would needlessly zero the block.
+    blocks_.push_back(std::unique_ptr<char[]>(new char[block_size]));
+    next_ = blocks_.back().get();
+    remaining_ = block_size;
+    next_block_size_ = std::min(next_block_size_ * 2, kMaxBlockSize);
+  }
+  void* result = next_;
+  next_ += size;
+  remaining_ -= size;
+  return result;
+}
+
+}  // namespace base
@@ -0,0 +1,147 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_JSON_JSON_VALUE_VIEW_H_
+#define BASE_JSON_JSON_VALUE_VIEW_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "base/base_export.h"
+#include "base/containers/span.h"
+#include "base/strings/string_piece.h"
+#include "base/values.h"
+
+namespace base {
+
+namespace internal {
+class JSONParser;
+}  // namespace internal
+
+struct JSONValueDictEntry;
+
+// A read-only JSON value that lives in the arena of a JSONDocument. Unlike
+// base::Value, a tree of JSONValueViews is built without a heap allocation per
+// string, list or dictionary, and is freed all at once with its document.
+// Strings that need no unescaping point directly into the parsed input.
+//
+// JSONValueViews are trivially copyable handles; they and everything they
+// point to are only valid as long as both the JSONDocument they come from and
+// the input it was parsed from are alive. Use ToValue() to get an owned copy.
+class BASE_EXPORT JSONValueView {
+ public:
+  constexpr JSONValueView()
+      : type_(Value::Type::NONE), size_(0), int_value_(0) {}
+
+  Value::Type type() const { return type_; }
+
+  bool is_none() const { return type_ == Value::Type::NONE; }
+  bool is_bool() const { return type_ == Value::Type::BOOLEAN; }
+  bool is_int() const { return type_ == Value::Type::INTEGER; }
+  bool is_double() const { return type_ == Value::Type::DOUBLE; }
+  bool is_string() const { return type_ == Value::Type::STRING; }
+  bool is_dict() const { return type_ == Value::Type::DICTIONARY; }
+  bool is_list() const { return type_ == Value::Type::LIST; }
+
+  // These must only be called on views of the corresponding type, like their
+  // base::Value counterparts. GetDouble() also accepts integers.
+  bool GetBool() const;
+  int GetInt() const;
+  double GetDouble() const;
+  StringPiece GetString() const;
+
+  // Returns the elements of a list.
+  span<const JSONValueView> GetList() const;
+
+  // Returns the entries of a dictionary, sorted by key. As with base::Value,
+  // only the last of several entries with the same key in the input is kept.
+  span<const JSONValueDictEntry> GetDict() const;
+
+  // Returns the value of |key| in a dictionary, or nullptr if there is none.
+  // Takes O(log n) time.
+  const JSONValueView* FindKey(StringPiece key) const;
+
+  // Like Value::FindPath(), returns the value at a '.'-separated |path| of
+  // keys in nested dictionaries, or nullptr if there is none.
+  const JSONValueView* FindPath(StringPiece path) const;
+
+  // Returns a deep copy of this view as a base::Value.
+  Value ToValue() const;
+
+ private:
+  friend class internal::JSONParser;
+
+  Value::Type type_;
+
+  // The length of a string, or the number of elements of a list or entries of
+  // a dictionary.
+  uint32_t size_;
+
+  union {
+    bool bool_value_;
+    int int_value_;
+    double double_value_;
+    const char* string_data_;
+    const JSONValueView* list_data_;
+    const JSONValueDictEntry* dict_data_;
+  };
+};
+
+struct JSONValueDictEntry {
+  StringPiece key;
+  JSONValueView value;
+};
+
+// Owns the arena holding a tree of JSONValueViews parsed by
+// JSONReader::ReadDocument(). Destroying the document frees the whole tree
+// with a handful of deallocations, regardless of its size.
+class BASE_EXPORT JSONDocument {
+ public:
+  JSONDocument(JSONDocument&& other);
+  JSONDocument& operator=(JSONDocument&& other);
+  JSONDocument(const JSONDocument&) = delete;
+  JSONDocument& operator=(const JSONDocument&) = delete;
+  ~JSONDocument();
+
+  const JSONValueView& root() const { return root_; }
+
+ private:
+  friend class internal::JSONParser;
+
+  // |input_size| is the size of the JSON text the document is parsed from,
+  // which is used to size the first block of the arena.
+  explicit JSONDocument(size_t input_size);
+
+  // Returns uninitialized, suitably aligned storage for |count| objects of
+  // type T, which must be trivially destructible.
+  template <typename T>
+  T* AllocateArray(size_t count) {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "Arena objects are never destroyed");
+    static_assert(alignof(T) <= kAlignment, "Unsupported alignment");
+    return static_cast<T*>(Allocate(count * sizeof(T)));
+  }
+
+  // Copies |str| into the arena.
+  StringPiece CopyString(StringPiece str);
+
+  void* Allocate(size_t size);
+
+  static constexpr size_t kAlignment = alignof(double);
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char* next_ = nullptr;
+  size_t remaining_ = 0;
+  size_t next_block_size_;
+
+  JSONValueView root_;
+};
+
+}  // namespace base
+
+#endif  // BASE_JSON_JSON_VALUE_VIEW_H_
@@ -0,0 +1,131 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/json/json_value_view.h"
+
+#include <string>
+#include <utility>
+
+#include "base/json/json_reader.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+
+TEST(JSONValueViewTest, Types) {
+  const std::string json =
+      R"({"null": null, "bool": true, "int": 42, "double": 4.5,)"
+      R"( "string": "foo", "list": [1, "two", [], {}], "dict": {"a": false}})";
+  absl::optional<JSONDocument> document = JSONReader::ReadDocument(json);
+  ASSERT_TRUE(document);
+  const JSONValueView& root = document->root();
+  ASSERT_TRUE(root.is_dict());
+  EXPECT_EQ(7u, root.GetDict().size());
+
+  EXPECT_TRUE(root.FindKey("null")->is_none());
+  EXPECT_TRUE(root.FindKey("bool")->GetBool());
+  EXPECT_EQ(42, root.FindKey("int")->GetInt());
+  EXPECT_EQ(42.0, root.FindKey("int")->GetDouble());
+  EXPECT_EQ(4.5, root.FindKey("double")->GetDouble());
+  EXPECT_EQ("foo", root.FindKey("string")->GetString());
+
+  const JSONValueView* list = root.FindKey("list");
+  ASSERT_TRUE(list->is_list());
+  ASSERT_EQ(4u, list->GetList().size());
+  EXPECT_EQ(1, list->GetList()[0].GetInt());
+  EXPECT_EQ("two", list->GetList()[1].GetString());
+  EXPECT_TRUE(list->GetList()[2].GetList().empty());
+  EXPECT_TRUE(list->GetList()[3].GetDict().empty());
+
+  const JSONValueView* dict = root.FindKey("dict");
+  ASSERT_TRUE(dict->is_dict());
+  EXPECT_FALSE(dict->FindKey("a")->GetBool());
+  EXPECT_FALSE(dict->FindKey("b"));
+  EXPECT_FALSE(root.FindKey("missing"));
+
+  EXPECT_FALSE(root.FindPath("dict.a")->GetBool());
+  EXPECT_FALSE(root.FindPath("dict.b"));
+  EXPECT_FALSE(root.FindPath("list.a"));
+  EXPECT_EQ(&root, root.FindPath(""));
+}
+
+TEST(JSONValueViewTest, StringsPointIntoInput) {
+  const std::string json = R"(["plain", "esc\"aped", "\u00e9"])";
+  absl::optional<JSONDocument> document = JSONReader::ReadDocument(json);
+  ASSERT_TRUE(document);
+  span<const JSONValueView> list = document->root().GetList();
+  ASSERT_EQ(3u, list.size());
+
+  EXPECT_EQ("plain", list[0].GetString());
+  EXPECT_EQ(json.data() + 2, list[0].GetString().data());
+
+  // Strings with escape sequences are decoded into the arena.
+  EXPECT_EQ("esc\"aped", list[1].GetString());
+  EXPECT_EQ("\xC3\xA9", list[2].GetString());
+}
+
+TEST(JSONValueViewTest, DictionaryKeysAreSortedAndUnique) {
+  absl::optional<JSONDocument> document =
+      JSONReader::ReadDocument(R"({"b": 1, "c": 2, "a": 3, "b": 4})");
+  ASSERT_TRUE(document);
+  span<const JSONValueDictEntry> dict = document->root().GetDict();
+  ASSERT_EQ(3u, dict.size());
+  EXPECT_EQ("a", dict[0].key);
+  EXPECT_EQ("b", dict[1].key);
+  EXPECT_EQ("c", dict[2].key);
+  // Like base::Value, the last value of a duplicated key wins.
+  EXPECT_EQ(4, dict[1].value.GetInt());
+}
+
+TEST(JSONValueViewTest, ToValueMatchesRead) {
+  const char* const kInputs[] = {
+      "null",
+      "[1, 2.5, true, \"x\\ny\"]",
+      R"({"k": {"nested": [{}, [], null]}, "k": 1, "a\u0062": "c"})",
+      "\xEF\xBB\xBF{\"bom\": 1}",
+  };
+  for (const char* input : kInputs) {
+    SCOPED_TRACE(input);
+    absl::optional<Value> value = JSONReader::Read(input);
+    absl::optional<JSONDocument> document = JSONReader::ReadDocument(input);
+    ASSERT_TRUE(value);
+    ASSERT_TRUE(document);
+    EXPECT_EQ(*value, document->root().ToValue());
+  }
+}
+
+TEST(JSONValueViewTest, Errors) {
+  EXPECT_FALSE(JSONReader::ReadDocument(""));
+  EXPECT_FALSE(JSONReader::ReadDocument("[1,]"));
+  EXPECT_FALSE(JSONReader::ReadDocument("{\"a\": 1} 2"));
+  EXPECT_FALSE(JSONReader::ReadDocument("{a: 1}"));
+  EXPECT_TRUE(JSONReader::ReadDocument("[1,]", JSON_ALLOW_TRAILING_COMMAS));
+  EXPECT_FALSE(JSONReader::ReadDocument("[[[1]]]", JSON_PARSE_RFC, 2));
+}
+
+TEST(JSONValueViewTest, LargeDocument) {
+  // Large enough to need several arena blocks.
+  std::string json = "[";
+  constexpr int kCount = 100000;
+  for (int i = 0; i < kCount; ++i) {
+    json += i ? "," : "";
+    json += "{\"i\":" + NumberToString(i) + ",\"s\":\"\\t\"}";
+  }
+  json += "]";
+
+  absl::optional<JSONDocument> parsed = JSONReader::ReadDocument(json);
+  ASSERT_TRUE(parsed);
+  // Views stay valid when the document is moved.
+  JSONDocument document = std::move(*parsed);
+  span<const JSONValueView> list = document.root().GetList();
+  ASSERT_EQ(static_cast<size_t>(kCount), list.size());
+  for (int i = 0; i < kCount; ++i) {
+    EXPECT_EQ(i, list[i].FindKey("i")->GetInt());
+    EXPECT_EQ("\t", list[i].FindKey("s")->GetString());
+  }
+}
+
+}  // namespace base
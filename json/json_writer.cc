@@ -9,12 +9,14 @@
 #include <cmath>
 #include <limits>
 
+#include "base/callback.h"
 #include "base/json/string_escape.h"
 #include "base/logging.h"
 #include "base/notreached.h"
 #include "base/numerics/safe_conversions.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/third_party/double_conversion/double-conversion/double-conversion.h"
 #include "base/values.h"
 #include "build/build_config.h"
 
@@ -26,6 +28,112 @@ const char kPrettyPrintLineEnding[] = "\r\n";
 const char kPrettyPrintLineEnding[] = "\n";
 #endif
 
+namespace {
+
+constexpr size_t kPrettyPrintLineEndingSize =
+    sizeof(kPrettyPrintLineEnding) - 1;
+
+// Returns roughly the size of the JSON written for |node|, assuming that its
+// strings need no escaping, so that the output can be allocated once up front
+// instead of being grown repeatedly. |depth| is the indentation level of
+// |node| and |nesting_left| how many more levels of lists and dictionaries the
+// writer accepts.
+size_t EstimateJSONSize(const Value& node,
+                        bool pretty_print,
+                        size_t depth,
+                        size_t nesting_left) {
+  switch (node.type()) {
+    case Value::Type::NONE:
+      return 4;
+
+    case Value::Type::BOOLEAN:
+      return 5;
+
+    case Value::Type::INTEGER: {
+      int value = node.GetInt();
+      size_t size = value < 0 ? 2 : 1;
+      while (value /= 10)
+        ++size;
+      return size;
+    }
+
+    case Value::Type::DOUBLE:
+      // Most doubles are short, and long ones need at most 24 characters.
+      return 12;
+
+    case Value::Type::STRING:
+      return node.GetString().size() + 2;
+
+    case Value::Type::LIST: {
+      if (!nesting_left)
+        return 0;
+      // The brackets and commas, and spaces around them if pretty printing.
+      const size_t separator_size = pretty_print ? 2 : 1;
+      size_t size = pretty_print ? 4 : 2;
+      for (const Value& value : node.GetList()) {
+        size += separator_size +
+                EstimateJSONSize(value, pretty_print, depth, nesting_left - 1);
+      }
+      return size;
+    }
+
+    case Value::Type::DICTIONARY: {
+      if (!nesting_left)
+        return 0;
+      // The braces, quotes and colons, and line breaks and indentation if
+      // pretty printing.
+      const size_t entry_overhead =
+          pretty_print ? 5 + kPrettyPrintLineEndingSize + (depth + 1) * 3 : 4;
+      size_t size =
+          pretty_print ? 2 + 2 * kPrettyPrintLineEndingSize + depth * 3 : 2;
+      for (const auto pair : node.DictItems()) {
+        size += entry_overhead + pair.first.size() +
+                EstimateJSONSize(pair.second, pretty_print, depth + 1,
+                                 nesting_left - 1);
+      }
+      return size;
+    }
+
+    case Value::Type::BINARY:
+      return 0;
+  }
+
+  NOTREACHED();
+  return 0;
+}
+
+// Appends the shortest representation of |value| that reads back as the same
+// double, as NumberToString() does but without a temporary string. Doubles are
+// always written with a fraction or an exponent, so they are read back as
+// doubles rather than ints.
+void AppendDouble(double value, std::string* dest) {
+  static const double_conversion::DoubleToStringConverter converter(
+      double_conversion::DoubleToStringConverter::EMIT_POSITIVE_EXPONENT_SIGN,
+      nullptr, nullptr, 'e', -6, 12, 0, 0);
+  char buffer[32];
+  double_conversion::StringBuilder builder(buffer, sizeof(buffer));
+  converter.ToShortest(value, &builder);
+  StringPiece real(buffer, builder.position());
+
+  // Ensure that the number has a .0 if there's no decimal or 'e'.
+  const bool needs_fraction = real.find_first_of(".eE") == StringPiece::npos;
+
+  // The JSON spec requires that non-integer values in the range (-1,1)
+  // have a zero before the decimal point - ".52" is not valid, "0.52" is.
+  if (!real.empty() && real[0] == '-') {
+    dest->push_back('-');
+    real.remove_prefix(1);
+  }
+  if (real.empty() || real[0] == '.')
+    dest->push_back('0');
+
+  dest->append(real.data(), real.size());
+  if (needs_fraction)
+    dest->append(".0");
+}
+
+}  // namespace
+
 // static
 bool JSONWriter::Write(const Value& node, std::string* json, size_t max_depth) {
   return WriteWithOptions(node, 0, json, max_depth);
@@ -37,9 +145,11 @@ bool JSONWriter::WriteWithOptions(const Value& node,
                                   std::string* json,
                                   size_t max_depth) {
   json->clear();
-  // Is there a better way to estimate the size of the output?
-  if (json->capacity() < 1024)
-    json->reserve(1024);
+  const size_t estimated_size =
+      EstimateJSONSize(node, options & OPTIONS_PRETTY_PRINT, 0U, max_depth) +
+      kPrettyPrintLineEndingSize;
+  if (json->capacity() < estimated_size)
+    json->reserve(estimated_size);
 
   JSONWriter writer(options, json, max_depth);
   bool result = writer.BuildJSONString(node, 0U);
@@ -50,6 +160,27 @@ bool JSONWriter::WriteWithOptions(const Value& node,
   return result;
 }
 
+// static
+bool JSONWriter::WriteToSink(const Value& node,
+                             int options,
+                             const RepeatingCallback<void(StringPiece)>& sink,
+                             size_t max_depth) {
+  DCHECK(sink);
+  std::string buffer;
+  buffer.reserve(kSinkBufferSize);
+
+  JSONWriter writer(options, &buffer, max_depth);
+  writer.sink_ = &sink;
+  bool result = writer.BuildJSONString(node, 0U);
+
+  if (options & OPTIONS_PRETTY_PRINT)
+    buffer.append(kPrettyPrintLineEnding);
+  if (!buffer.empty())
+    sink.Run(buffer);
+
+  return result;
+}
+
 JSONWriter::JSONWriter(int options, std::string* json, size_t max_depth)
     : omit_binary_values_((options & OPTIONS_OMIT_BINARY_VALUES) != 0),
       omit_double_type_preservation_(
@@ -89,22 +220,7 @@ bool JSONWriter::BuildJSONString(const Value& node, size_t depth) {
         json_string_->append(NumberToString(static_cast<int64_t>(value)));
         return true;
       }
-      std::string real = NumberToString(value);
-      // Ensure that the number has a .0 if there's no decimal or 'e'.  This
-      // makes sure that when we read the JSON back, it's interpreted as a
-      // real rather than an int.
-      if (real.find_first_of(".eE") == std::string::npos)
-        real.append(".0");
-
-      // The JSON spec requires that non-integer values in the range (-1,1)
-      // have a zero before the decimal point - ".52" is not valid, "0.52" is.
-      if (real[0] == '.') {
-        real.insert(static_cast<size_t>(0), static_cast<size_t>(1), '0');
-      } else if (real.length() > 1 && real[0] == '-' && real[1] == '.') {
-        // "-.1" bad "-0.1" good
-        real.insert(static_cast<size_t>(1), static_cast<size_t>(1), '0');
-      }
-      json_string_->append(real);
+      AppendDouble(value, json_string_);
       return true;
     }
 
@@ -136,6 +252,7 @@ bool JSONWriter::BuildJSONString(const Value& node, size_t depth) {
           result = false;
 
         first_value_has_been_output = true;
+        MaybeFlushToSink();
       }
 
       if (pretty_print_)
@@ -178,6 +295,7 @@ bool JSONWriter::BuildJSONString(const Value& node, size_t depth) {
           result = false;
 
         first_value_has_been_output = true;
+        MaybeFlushToSink();
       }
 
       if (pretty_print_) {
@@ -199,6 +317,13 @@ bool JSONWriter::BuildJSONString(const Value& node, size_t depth) {
   return false;
 }
 
+void JSONWriter::MaybeFlushToSink() {
+  if (!sink_ || json_string_->size() < kSinkBufferSize)
+    return;
+  sink_->Run(*json_string_);
+  json_string_->clear();
+}
+
 void JSONWriter::IndentLine(size_t depth) {
   json_string_->append(depth * 3U, ' ');
 }
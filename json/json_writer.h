@@ -10,8 +10,10 @@
 #include <string>
 
 #include "base/base_export.h"
+#include "base/callback_forward.h"
 #include "base/json/json_common.h"
 #include "base/macros.h"
+#include "base/strings/string_piece.h"
 
 namespace base {
 
@@ -54,11 +56,26 @@ class BASE_EXPORT JSONWriter {
                                std::string* json,
                                size_t max_depth = internal::kAbsoluteMaxDepth);
 
+  // Same as above, but passes the JSON to |sink| in pieces of about
+  // kSinkBufferSize bytes as it is generated instead of building one string,
+  // e.g. to write a large value to a file without holding all of its JSON in
+  // memory. |sink| is run synchronously and may have received part of the
+  // output on failure.
+  static bool WriteToSink(const Value& node,
+                          int options,
+                          const RepeatingCallback<void(StringPiece)>& sink,
+                          size_t max_depth = internal::kAbsoluteMaxDepth);
+
+  static constexpr size_t kSinkBufferSize = 64 * 1024;
+
  private:
   JSONWriter(int options,
              std::string* json,
              size_t max_depth = internal::kAbsoluteMaxDepth);
 
+  // Passes the output so far to |sink_|, if any, once it is large enough.
+  void MaybeFlushToSink();
+
   // Called recursively to build the JSON string. When completed,
   // |json_string_| will contain the JSON.
   bool BuildJSONString(const Value& node, size_t depth);
@@ -73,6 +90,10 @@ class BASE_EXPORT JSONWriter {
   // Where we write JSON data as we generate it.
   std::string* json_string_;
 
+  // If set, receives the contents of |json_string_| whenever they exceed
+  // kSinkBufferSize bytes.
+  const RepeatingCallback<void(StringPiece)>* sink_ = nullptr;
+
   // Maximum depth to write.
   const size_t max_depth_;
 
@@ -5,12 +5,19 @@
 #include "base/json/json_writer.h"
 #include "base/json/json_reader.h"
 
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/callback.h"
 #include "base/containers/span.h"
 #include "base/memory/ptr_util.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/stringprintf.h"
 #include "base/values.h"
 #include "build/build_config.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
 
 namespace base {
 
@@ -157,6 +164,57 @@ TEST(JSONWriterTest, DoublesAsInts) {
   EXPECT_EQ("10000000000", output_js);
 }
 
+TEST(JSONWriterTest, DoublesRoundTrip) {
+  const double kValues[] = {0.0,   -0.0,    0.5,        -0.25,  1.0 / 3,
+                            1e-7,  -1e-7,   1e21,       3.0,    -3.0,
+                            1e300, 5e-324,  123456.789, 2.5e12, 0.1 + 0.2};
+  for (double value : kValues) {
+    SCOPED_TRACE(value);
+    std::string output_js;
+    EXPECT_TRUE(JSONWriter::Write(Value(value), &output_js));
+    // The output is the shortest that reads back as the same double.
+    EXPECT_EQ(0u, output_js.find(NumberToString(value)));
+    absl::optional<Value> read = JSONReader::Read(output_js);
+    ASSERT_TRUE(read);
+    ASSERT_TRUE(read->is_double());
+    EXPECT_EQ(value, read->GetDouble());
+  }
+}
+
+TEST(JSONWriterTest, WriteToSink) {
+  Value list(Value::Type::LIST);
+  Value dict(Value::Type::DICTIONARY);
+  for (int i = 0; i < 20000; ++i) {
+    list.Append(StringPrintf("entry \"%d\"", i));
+    dict.SetIntKey(NumberToString(i), i);
+  }
+
+  for (int options : {0, int{JSONWriter::OPTIONS_PRETTY_PRINT}}) {
+    for (const Value* value : {&list, &dict}) {
+      std::string expected;
+      EXPECT_TRUE(JSONWriter::WriteWithOptions(*value, options, &expected));
+      ASSERT_GT(expected.size(), 2 * JSONWriter::kSinkBufferSize);
+
+      std::vector<std::string> pieces;
+      EXPECT_TRUE(JSONWriter::WriteToSink(
+          *value, options, BindRepeating(
+                               [](std::vector<std::string>* pieces,
+                                  StringPiece piece) {
+                                 pieces->emplace_back(piece);
+                               },
+                               &pieces)));
+      ASSERT_GT(pieces.size(), 1u);
+      std::string output;
+      for (size_t i = 0; i < pieces.size(); ++i) {
+        if (i + 1 < pieces.size())
+          EXPECT_GE(pieces[i].size(), JSONWriter::kSinkBufferSize);
+        output += pieces[i];
+      }
+      EXPECT_EQ(expected, output);
+    }
+  }
+}
+
 TEST(JSONWriterTest, StackOverflow) {
   std::string output_js;
 
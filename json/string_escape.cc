@@ -10,6 +10,7 @@
 #include <limits>
 #include <string>
 
+#include "base/strings/char_scan.h"
 #include "base/strings/string_util.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/utf_string_conversion_utils.h"
@@ -77,6 +78,38 @@ bool EscapeSpecialCodePoint(uint32_t code_point, std::string* dest) {
   return true;
 }
 
+// The characters that EscapeSpecialCodePoint() escapes, besides those outside
+// [kMinUnescapedChar, kMaxUnescapedChar].
+constexpr char kEscapedASCIIChars[] = "\"\\<";
+constexpr char16_t kEscapedASCIIChars16[] = u"\"\\<";
+constexpr uint8_t kMinUnescapedChar = 0x20;
+constexpr uint8_t kMaxUnescapedChar = 0x7F;
+
+// Appends the run of characters of |str| that start at index |*i| and are
+// output as is, i.e. printable ASCII that EscapeSpecialCodePoint() leaves
+// alone, to |dest| and advances |*i| past it. Most strings are long runs of
+// such characters, so they are scanned and copied in bulk rather than decoded
+// and re-encoded one code point at a time.
+void AppendUnescapedChars(StringPiece str, int32_t* i, std::string* dest) {
+  const StringPiece rest = str.substr(static_cast<size_t>(*i));
+  size_t count = internal::FindFirstInSetOrOutOfRange(
+      rest, kEscapedASCIIChars, kMinUnescapedChar, kMaxUnescapedChar);
+  if (count == StringPiece::npos)
+    count = rest.size();
+  dest->append(rest.data(), count);
+  *i += static_cast<int32_t>(count);
+}
+
+void AppendUnescapedChars(StringPiece16 str, int32_t* i, std::string* dest) {
+  const StringPiece16 rest = str.substr(static_cast<size_t>(*i));
+  size_t count = internal::FindFirstInSetOrOutOfRange(
+      rest, kEscapedASCIIChars16, kMinUnescapedChar, kMaxUnescapedChar);
+  if (count == StringPiece16::npos)
+    count = rest.size();
+  dest->append(rest.begin(), rest.begin() + count);
+  *i += static_cast<int32_t>(count);
+}
+
 template <typename S>
 bool EscapeJSONStringImpl(const S& str, bool put_in_quotes, std::string* dest) {
   bool did_replacement = false;
@@ -90,6 +123,10 @@ bool EscapeJSONStringImpl(const S& str, bool put_in_quotes, std::string* dest) {
   const int32_t length = static_cast<int32_t>(str.length());
 
   for (int32_t i = 0; i < length; ++i) {
+    AppendUnescapedChars(str, &i, dest);
+    if (i == length)
+      break;
+
     uint32_t code_point;
     if (!ReadUnicodeCharacter(str.data(), length, &i, &code_point) ||
         code_point == static_cast<decltype(code_point)>(CBU_SENTINEL) ||
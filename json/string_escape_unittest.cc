@@ -108,6 +108,37 @@ TEST(JSONStringEscapeTest, EscapeUTF8) {
   EXPECT_TRUE(IsStringUTF8AllowingNoncharacters(out));
 }
 
+TEST(JSONStringEscapeTest, EscapeLongUTF8) {
+  // Long runs of characters that need no escaping are copied in bulk; check
+  // that special characters are found wherever they are within them.
+  const struct {
+    const char* to_escape;
+    const char* escaped;
+  } cases[] = {
+      {"\"", "\\\""},
+      {"\\", "\\\\"},
+      {"<", "\\u003C"},
+      {"\n", "\\n"},
+      {"\x01", "\\u0001"},
+      {"\x7F", "\x7F"},
+      {"\xC3\xA9", "\xC3\xA9"},
+      {"\xE2\x80\xA8", "\\u2028"},
+      {"\xFF", "\xEF\xBF\xBD"},
+  };
+
+  constexpr size_t kLength = 40;
+  for (const auto& i : cases) {
+    for (size_t pos = 0; pos <= kLength; ++pos) {
+      SCOPED_TRACE(pos);
+      const std::string prefix(pos, 'a');
+      const std::string suffix(kLength - pos, 'z');
+      std::string out;
+      EscapeJSONString(prefix + i.to_escape + suffix, true, &out);
+      EXPECT_EQ("\"" + prefix + i.escaped + suffix + "\"", out);
+    }
+  }
+}
+
 TEST(JSONStringEscapeTest, EscapeUTF16) {
   const struct {
     const wchar_t* to_escape;
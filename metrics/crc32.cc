@@ -4,6 +4,22 @@
 
 #include "base/metrics/crc32.h"
 
+#include "base/check_op.h"
+#include "base/cpu.h"
+#include "base/notreached.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_64)
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#define CRC32_HARDWARE_SUPPORTED
+#elif defined(ARCH_CPU_ARM64) && defined(__clang__)
+#include <arm_acle.h>
+#include <string.h>
+#define CRC32_HARDWARE_SUPPORTED
+#endif
+
 namespace base {
 
 // Static table of checksums for all possible 8 bit bytes.
@@ -62,20 +78,252 @@ const uint32_t kCrcTable[256] = {
     0x2d02ef8dL,
 };
 
-// We generate the CRC-32 using the low order bits to select whether to XOR in
-// the reversed polynomial 0xEDB88320.  This is nice and simple, and allows us
-// to keep the quotient in a uint32_t.  Since we're not concerned about the
-// nature of corruptions (i.e., we don't care about bit sequencing, since we are
-// handling memory changes, which are more grotesque) so we don't bother to get
-// the CRC correct for big-endian vs little-ending calculations.  All we need is
-// a nice hash, that tends to depend on all the bits of the sample, with very
-// little chance of changes in one place impacting changes in another place.
-uint32_t Crc32(uint32_t sum, const void* data, size_t size) {
-  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+namespace {
+
+// The reversed CRC-32 polynomial.
+constexpr uint32_t kPolynomial = 0xEDB88320;
+
+struct SlicingTables {
+  // |table[k][i]| is the CRC of the byte |i| followed by |k| zero bytes, so
+  // |table[0]| is kCrcTable.
+  uint32_t table[8][256];
+};
+
+constexpr SlicingTables MakeSlicingTables() {
+  SlicingTables tables = {};
+  // The CRC of each byte is generated bit by bit, least significant bit
+  // first, with the low order bit selecting whether to XOR in the reversed
+  // polynomial. This is the bit order of the standard (zlib) CRC-32, which the
+  // hardware kernels below compute as well.
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t checksum = i;
+    for (int j = 0; j < 8; ++j)
+      checksum = (checksum >> 1) ^ (checksum & 1 ? kPolynomial : 0);
+    tables.table[0][i] = checksum;
+  }
+  for (int k = 1; k < 8; ++k) {
+    for (int i = 0; i < 256; ++i) {
+      const uint32_t previous = tables.table[k - 1][i];
+      tables.table[k][i] = (previous >> 8) ^ tables.table[0][previous & 0xFF];
+    }
+  }
+  return tables;
+}
+
+constexpr SlicingTables kSlicingTables = MakeSlicingTables();
+
+uint32_t Crc32ByteTable(uint32_t sum, const uint8_t* bytes, size_t size) {
   for (size_t i = 0; i < size; ++i) {
     sum = kCrcTable[(sum & 0x000000FF) ^ bytes[i]] ^ (sum >> 8);
   }
   return sum;
 }
 
+uint32_t Crc32SlicingBy8(uint32_t sum, const uint8_t* bytes, size_t size) {
+  const auto& table = kSlicingTables.table;
+  for (; size >= 8; bytes += 8, size -= 8) {
+    const uint32_t low = sum ^ (bytes[0] | bytes[1] << 8 | bytes[2] << 16 |
+                                static_cast<uint32_t>(bytes[3]) << 24);
+    sum = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^
+          table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24] ^
+          table[3][bytes[4]] ^ table[2][bytes[5]] ^ table[1][bytes[6]] ^
+          table[0][bytes[7]];
+  }
+  return Crc32ByteTable(sum, bytes, size);
+}
+
+#if defined(ARCH_CPU_X86_64)
+
+// The smallest input folded with PCLMULQDQ; shorter ones are faster with
+// tables.
+constexpr size_t kMinFoldSize = 64;
+
+// Folds |x| over 128 bits with the constants in |k| and adds |next|.
+__attribute__((target("pclmul"))) inline __m128i Fold(__m128i x,
+                                                      __m128i k,
+                                                      __m128i next) {
+  return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00),
+                                     _mm_clmulepi64_si128(x, k, 0x11)),
+                       next);
+}
+
+// Folds 64 bytes at a time into four 128-bit accumulators with carry-less
+// multiplication, then reduces them with Barrett reduction, as described in
+// "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+// by Gopal et al. The constants are powers of x modulo the polynomial, in its
+// reversed bit order. |size| must be a multiple of 16 and at least
+// kMinFoldSize.
+__attribute__((target("pclmul,sse4.1"))) uint32_t
+Crc32Fold(uint32_t sum, const uint8_t* bytes, size_t size) {
+  const __m128i k1k2 = _mm_set_epi64x(0x01C6E41596, 0x0154442BD4);
+  const __m128i k3k4 = _mm_set_epi64x(0x00CCAA009E, 0x01751997D0);
+  const __m128i k5 = _mm_set_epi64x(0, 0x0163CD6124);
+  const __m128i polynomial = _mm_set_epi64x(0x01F7011641, 0x01DB710641);
+  const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+  const __m128i* blocks = reinterpret_cast<const __m128i*>(bytes);
+
+  __m128i x1 = _mm_loadu_si128(blocks);
+  __m128i x2 = _mm_loadu_si128(blocks + 1);
+  __m128i x3 = _mm_loadu_si128(blocks + 2);
+  __m128i x4 = _mm_loadu_si128(blocks + 3);
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(sum)));
+  blocks += 4;
+  size -= 64;
+
+  for (; size >= 64; blocks += 4, size -= 64) {
+    x1 = Fold(x1, k1k2, _mm_loadu_si128(blocks));
+    x2 = Fold(x2, k1k2, _mm_loadu_si128(blocks + 1));
+    x3 = Fold(x3, k1k2, _mm_loadu_si128(blocks + 2));
+    x4 = Fold(x4, k1k2, _mm_loadu_si128(blocks + 3));
+  }
+
+  // Fold the accumulators, then the remaining blocks, into one.
+  x1 = Fold(x1, k3k4, x2);
+  x1 = Fold(x1, k3k4, x3);
+  x1 = Fold(x1, k3k4, x4);
+  for (; size >= 16; ++blocks, size -= 16)
+    x1 = Fold(x1, k3k4, _mm_loadu_si128(blocks));
+  DCHECK_EQ(0u, size);
+
+  // Fold 128 bits down to 64.
+  x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, mask32);
+  x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k5, 0x00), x2);
+
+  // Barrett reduction to 32 bits.
+  x2 = _mm_and_si128(x1, mask32);
+  x2 = _mm_clmulepi64_si128(x2, polynomial, 0x10);
+  x2 = _mm_and_si128(x2, mask32);
+  x2 = _mm_clmulepi64_si128(x2, polynomial, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+  return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+uint32_t Crc32Hardware(uint32_t sum, const uint8_t* bytes, size_t size) {
+  if (size >= kMinFoldSize) {
+    const size_t folded_size = size & ~size_t{15};
+    sum = Crc32Fold(sum, bytes, folded_size);
+    bytes += folded_size;
+    size -= folded_size;
+  }
+  return Crc32SlicingBy8(sum, bytes, size);
+}
+
+bool IsHardwareSupported() {
+  const CPU cpu;
+  return cpu.has_pclmul() && cpu.has_sse41();
+}
+
+#elif defined(CRC32_HARDWARE_SUPPORTED)  // Armv8
+
+__attribute__((target("crc"))) uint32_t Crc32Hardware(uint32_t sum,
+                                                      const uint8_t* bytes,
+                                                      size_t size) {
+  for (; size >= 8; bytes += 8, size -= 8) {
+    uint64_t word;
+    memcpy(&word, bytes, sizeof(word));
+    sum = __crc32d(sum, word);
+  }
+  for (; size > 0; ++bytes, --size)
+    sum = __crc32b(sum, *bytes);
+  return sum;
+}
+
+bool IsHardwareSupported() {
+#if defined(__ARM_FEATURE_CRC32)
+  return true;
+#else
+  return CPU::CreateNoAllocation().has_crc32();
+#endif
+}
+
+#endif
+
+using Crc32Function = uint32_t (*)(uint32_t, const uint8_t*, size_t);
+
+Crc32Function GetCrc32Function(internal::Crc32Kernel kernel) {
+  switch (kernel) {
+    case internal::Crc32Kernel::kByteTable:
+      return &Crc32ByteTable;
+    case internal::Crc32Kernel::kSlicingBy8:
+      return &Crc32SlicingBy8;
+    case internal::Crc32Kernel::kHardware:
+#if defined(CRC32_HARDWARE_SUPPORTED)
+      return &Crc32Hardware;
+#else
+      break;
+#endif
+  }
+  NOTREACHED();
+  return &Crc32ByteTable;
+}
+
+Crc32Function ChooseCrc32Function() {
+#if defined(CRC32_HARDWARE_SUPPORTED)
+  if (IsHardwareSupported())
+    return &Crc32Hardware;
+#endif
+  return &Crc32SlicingBy8;
+}
+
+// Returns |a| * |b| modulo the polynomial, in its reversed bit order. |a| must
+// not be 0.
+uint32_t MultiplyModPolynomial(uint32_t a, uint32_t b) {
+  uint32_t product = 0;
+  for (uint32_t bit = 1u << 31;; bit >>= 1) {
+    if (a & bit) {
+      product ^= b;
+      if (!(a & (bit - 1)))
+        return product;
+    }
+    b = (b >> 1) ^ (b & 1 ? kPolynomial : 0);
+  }
+}
+
+}  // namespace
+
+uint32_t Crc32(uint32_t sum, const void* data, size_t size) {
+  static const Crc32Function crc32_function = ChooseCrc32Function();
+  return crc32_function(sum, reinterpret_cast<const uint8_t*>(data), size);
+}
+
+uint32_t Crc32Combine(uint32_t crc1, uint32_t crc2, size_t size2) {
+  // Appending |size2| bytes multiplies |crc1| by x^(8 * size2), and adds the
+  // CRC of the bytes themselves, which is |crc2|. In the reversed bit order,
+  // bit 31 - n holds the coefficient of x^n.
+  uint32_t factor = 1u << 31;
+  for (uint32_t power = 1u << 23; size2; size2 >>= 1) {
+    if (size2 & 1)
+      factor = MultiplyModPolynomial(factor, power);
+    power = MultiplyModPolynomial(power, power);
+  }
+  return MultiplyModPolynomial(factor, crc1) ^ crc2;
+}
+
+namespace internal {
+
+bool IsCrc32KernelSupported(Crc32Kernel kernel) {
+#if defined(CRC32_HARDWARE_SUPPORTED)
+  if (kernel == Crc32Kernel::kHardware)
+    return IsHardwareSupported();
+#else
+  if (kernel == Crc32Kernel::kHardware)
+    return false;
+#endif
+  return true;
+}
+
+uint32_t Crc32WithKernel(Crc32Kernel kernel,
+                         uint32_t sum,
+                         const void* data,
+                         size_t size) {
+  DCHECK(IsCrc32KernelSupported(kernel));
+  return GetCrc32Function(kernel)(
+      sum, reinterpret_cast<const uint8_t*>(data), size);
+}
+
+}  // namespace internal
+
 }  // namespace base
@@ -17,8 +17,40 @@ BASE_EXPORT extern const uint32_t kCrcTable[256];
 // This provides a simple, fast CRC-32 calculation that can be used for checking
 // the integrity of data.  It is not a "secure" calculation!  |sum| can start
 // with any seed or be used to continue an operation began with previous data.
+// Uses carry-less multiplication or CRC instructions where the CPU has them.
 BASE_EXPORT uint32_t Crc32(uint32_t sum, const void* data, size_t size);
 
+// Returns the CRC of two consecutive blocks of data from |crc1|, the CRC of
+// the first block, and |crc2|, the CRC of the second one with a |sum| of 0,
+// and the |size2| of the second one. This allows large buffers to be
+// checksummed in pieces, in parallel:
+//   Crc32(sum, data, size) ==
+//       Crc32Combine(Crc32(sum, data, n), Crc32(0, data + n, size - n),
+//                    size - n)
+BASE_EXPORT uint32_t Crc32Combine(uint32_t crc1, uint32_t crc2, size_t size2);
+
+namespace internal {
+
+// The implementations Crc32() chooses from, for tests and benchmarks.
+enum class Crc32Kernel {
+  // Looks up one byte at a time in kCrcTable.
+  kByteTable,
+  // Looks up eight bytes at a time in eight tables.
+  kSlicingBy8,
+  // PCLMULQDQ folding on x86-64, or the CRC32 instructions on Armv8.
+  kHardware,
+};
+
+BASE_EXPORT bool IsCrc32KernelSupported(Crc32Kernel kernel);
+
+// |kernel| must be supported.
+BASE_EXPORT uint32_t Crc32WithKernel(Crc32Kernel kernel,
+                                     uint32_t sum,
+                                     const void* data,
+                                     size_t size);
+
+}  // namespace internal
+
 }  // namespace base
 
 #endif  // BASE_METRICS_CRC32_H_
@@ -0,0 +1,59 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/metrics/crc32.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/rand_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace base {
+namespace {
+
+constexpr char kMetricThroughput[] = "throughput";
+
+void RunTest(const char* kernel_name,
+             internal::Crc32Kernel kernel,
+             size_t size) {
+  if (!internal::IsCrc32KernelSupported(kernel))
+    return;
+
+  perf_test::PerfResultReporter reporter(
+      std::string("Crc32.") + kernel_name + ".",
+      NumberToString(size) + "_bytes");
+  reporter.RegisterImportantMetric(kMetricThroughput, "bytesPerSecond");
+
+  std::vector<uint8_t> buffer(size);
+  RandBytes(buffer.data(), buffer.size());
+
+  // Checksum about 1 GB, whatever the size of the buffer.
+  const size_t iterations = (1u << 30) / size;
+  uint32_t sum = 0;
+  const TimeTicks start = TimeTicks::Now();
+  for (size_t i = 0; i < iterations; ++i)
+    sum = internal::Crc32WithKernel(kernel, sum, buffer.data(), size);
+  const TimeDelta elapsed = TimeTicks::Now() - start;
+  reporter.AddResult(kMetricThroughput,
+                     iterations * size / elapsed.InSecondsF());
+}
+
+}  // namespace
+
+TEST(Crc32PerfTest, Kernels) {
+  for (size_t size : {64u, 1024u, 64u * 1024u, 1024u * 1024u}) {
+    RunTest("ByteTable", internal::Crc32Kernel::kByteTable, size);
+    RunTest("SlicingBy8", internal::Crc32Kernel::kSlicingBy8, size);
+    RunTest("Hardware", internal::Crc32Kernel::kHardware, size);
+  }
+}
+
+}  // namespace base
@@ -6,6 +6,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include "testing/gtest/include/gtest/gtest.h"
 
 namespace base {
@@ -31,4 +33,51 @@ TEST(Crc32Test, ZeroTest) {
   EXPECT_EQ(0U, Crc32(0, nullptr, 0));
 }
 
+// The standard check value of CRC-32, which is computed with an inverted seed
+// and result.
+TEST(Crc32Test, CheckValue) {
+  const char kData[] = "123456789";
+  EXPECT_EQ(0xCBF43926u, ~Crc32(~0u, kData, sizeof(kData) - 1));
+}
+
+// Every kernel computes the same CRC as the byte table, for every size and
+// alignment.
+TEST(Crc32Test, Kernels) {
+  std::vector<uint8_t> data(1024 + 16);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<uint8_t>(i * 7919 + (i >> 8));
+
+  for (internal::Crc32Kernel kernel :
+       {internal::Crc32Kernel::kByteTable, internal::Crc32Kernel::kSlicingBy8,
+        internal::Crc32Kernel::kHardware}) {
+    if (!internal::IsCrc32KernelSupported(kernel))
+      continue;
+    for (size_t offset = 0; offset < 16; ++offset) {
+      for (size_t size = 0; size <= 1024; size += size < 160 ? 1 : 37) {
+        const uint8_t* bytes = data.data() + offset;
+        uint32_t expected = 0x12345678;
+        for (size_t i = 0; i < size; ++i)
+          expected = kCrcTable[(expected & 0xFF) ^ bytes[i]] ^ (expected >> 8);
+        EXPECT_EQ(expected, internal::Crc32WithKernel(kernel, 0x12345678,
+                                                      bytes, size))
+            << static_cast<int>(kernel) << " " << offset << " " << size;
+      }
+    }
+  }
+}
+
+TEST(Crc32Test, Combine) {
+  std::vector<uint8_t> data(3000);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<uint8_t>(i * 31 + 5);
+
+  const uint32_t crc = Crc32(~0u, data.data(), data.size());
+  for (size_t split : {size_t{0}, size_t{1}, size_t{15}, size_t{64},
+                       size_t{1000}, size_t{2999}, size_t{3000}}) {
+    const uint32_t crc1 = Crc32(~0u, data.data(), split);
+    const uint32_t crc2 = Crc32(0, data.data() + split, data.size() - split);
+    EXPECT_EQ(crc, Crc32Combine(crc1, crc2, data.size() - split)) << split;
+  }
+}
+
 }  // namespace base
@@ -282,13 +282,89 @@ PersistentMemoryAllocator::Iterator::GetNext(uint32_t* type_return) {
 
 PersistentMemoryAllocator::Reference
 PersistentMemoryAllocator::Iterator::GetNextOfType(uint32_t type_match) {
-  Reference ref;
-  uint32_t type_found;
-  while ((ref = GetNext(&type_found)) != 0) {
-    if (type_found == type_match)
-      return ref;
+  // Calling GetNext() for every record would perform a compare-exchange of
+  // |last_record_| and an increment of |record_count_| for each record that
+  // is skipped because of a type mismatch. With many thousands of records of
+  // other types in the segment, those shared writes dominate. Instead, walk
+  // the queue privately up to the next matching record (or the end of the
+  // queue) and then publish the new position with a single exchange. The
+  // on-disk format is unchanged; this only changes how the list is walked.
+  //
+  // See GetNext() for why |record_count_| must be acquired before "freeptr"
+  // is loaded below.
+  uint32_t count = record_count_.load(std::memory_order_acquire);
+
+  // Absolute limit on the number of records that could possibly exist. It is
+  // used to break out of a corrupted (looping) list during the private walk;
+  // the tighter check using "freeptr" is done once the walk is complete.
+  const uint32_t abs_max_records =
+      allocator_->mem_size_ / (sizeof(BlockHeader) + kAllocAlignment);
+
+  Reference last = last_record_.load(std::memory_order_acquire);
+  Reference cursor;
+  Reference found;
+  uint32_t skipped;
+  while (true) {
+    cursor = last;
+    found = kReferenceNull;
+    skipped = 0;
+    while (true) {
+      const volatile BlockHeader* block =
+          allocator_->GetBlock(cursor, 0, 0, true, false);
+      if (!block)  // Invalid iterator state.
+        return kReferenceNull;
+
+      // Acquire "next" for the same reasons as described in GetNext().
+      Reference next = block->next.load(std::memory_order_acquire);
+      if (next == kReferenceQueue)  // No next allocation in queue.
+        break;
+      block = allocator_->GetBlock(next, 0, 0, false, false);
+      if (!block) {  // Memory is corrupt.
+        allocator_->SetCorrupt();
+        return kReferenceNull;
+      }
+
+      cursor = next;
+      if (count + ++skipped > abs_max_records) {
+        allocator_->SetCorrupt();
+        return kReferenceNull;
+      }
+      if (block->type_id.load(std::memory_order_relaxed) == type_match) {
+        found = next;
+        break;
+      }
+    }
+
+    // Nothing new has been added since the last call.
+    if (cursor == last)
+      return kReferenceNull;
+
+    // Publish the new position. If it fails then another thread has moved
+    // the iterator in the meantime so the walk has to be redone from the
+    // (freshly loaded) |last| position.
+    if (last_record_.compare_exchange_strong(
+            last, cursor, std::memory_order_acq_rel,
+            std::memory_order_acquire)) {
+      break;
+    }
+    count = record_count_.load(std::memory_order_acquire);
+  }
+
+  // Same loop detection as in GetNext(), accounting for every record that
+  // was passed over during the walk.
+  const uint32_t freeptr = std::min(
+      allocator_->shared_meta()->freeptr.load(std::memory_order_relaxed),
+      allocator_->mem_size_);
+  const uint32_t max_records =
+      freeptr / (sizeof(BlockHeader) + kAllocAlignment);
+  if (count + skipped - 1 > max_records) {
+    allocator_->SetCorrupt();
+    return kReferenceNull;
   }
-  return kReferenceNull;
+
+  // Pairs with the Acquire at the top of this method and in GetNext().
+  record_count_.fetch_add(skipped, std::memory_order_release);
+  return found;
 }
 
 
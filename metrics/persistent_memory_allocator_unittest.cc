@@ -5,6 +5,7 @@
 #include "base/metrics/persistent_memory_allocator.h"
 
 #include <memory>
+#include <vector>
 
 #include "base/files/file.h"
 #include "base/files/file_util.h"
@@ -294,6 +295,43 @@ TEST_F(PersistentMemoryAllocatorTest, PageTest) {
   EXPECT_EQ(2U * TEST_MEMORY_PAGE, block3);
 }
 
+TEST_F(PersistentMemoryAllocatorTest, IterateOfTypeTest) {
+  // Interleave many records of a type that is never asked for with a few
+  // that are.
+  std::vector<Reference> matches;
+  for (int i = 0; i < 100; ++i) {
+    Reference ref = allocator_->Allocate(sizeof(TestObject1), 1);
+    ASSERT_NE(0U, ref);
+    allocator_->MakeIterable(ref);
+    if (i % 10 == 9) {
+      ref = allocator_->Allocate(sizeof(TestObject2), 2);
+      ASSERT_NE(0U, ref);
+      allocator_->MakeIterable(ref);
+      matches.push_back(ref);
+    }
+  }
+
+  PersistentMemoryAllocator::Iterator iter(allocator_.get());
+  for (Reference expected : matches) {
+    EXPECT_EQ(expected, iter.GetNextOfType(2));
+    EXPECT_EQ(expected, iter.GetLast());
+  }
+  EXPECT_EQ(0U, iter.GetNextOfType(2));
+  EXPECT_EQ(matches.back(), iter.GetLast());
+
+  // Trailing records of another type are passed over and new records of the
+  // requested type are found on a later call.
+  Reference other = allocator_->Allocate(sizeof(TestObject1), 1);
+  allocator_->MakeIterable(other);
+  EXPECT_EQ(0U, iter.GetNextOfType(2));
+  EXPECT_EQ(other, iter.GetLast());
+  Reference late = allocator_->Allocate(sizeof(TestObject2), 2);
+  allocator_->MakeIterable(late);
+  EXPECT_EQ(late, iter.GetNextOfType(2));
+  EXPECT_EQ(0U, iter.GetNextOfType(2));
+  EXPECT_FALSE(allocator_->IsCorrupt());
+}
+
 // A simple thread that takes an allocator and repeatedly allocates random-
 // sized chunks from it until no more can be done.
 class AllocatorThread : public SimpleThread {
@@ -264,6 +264,9 @@ Pickle::Pickle(const char* data, size_t data_len)
     header_ = nullptr;
 }
 
+Pickle::Pickle(span<const uint8_t> data)
+    : Pickle(reinterpret_cast<const char*>(data.data()), data.size()) {}
+
 Pickle::Pickle(const Pickle& other)
     : header_(nullptr),
       header_size_(other.header_size_),
@@ -444,4 +447,55 @@ inline void Pickle::WriteBytesCommon(const void* data, size_t length) {
   memcpy(write, data, length);
 }
 
+ScatterGatherPickle::ScatterGatherPickle() = default;
+
+ScatterGatherPickle::~ScatterGatherPickle() = default;
+
+void ScatterGatherPickle::WriteDataByReference(span<const uint8_t> data) {
+  if (data.size() < kMinReferencedSize) {
+    pickle_.WriteData(reinterpret_cast<const char*>(data.data()),
+                      static_cast<int>(data.size()));
+    return;
+  }
+  CHECK(IsValueInRangeForNumericType<int>(data.size()));
+  pickle_.WriteInt(static_cast<int>(data.size()));
+  references_.push_back({pickle_.payload_size(), data});
+  referenced_size_ += bits::AlignUp(data.size(), sizeof(uint32_t));
+}
+
+size_t ScatterGatherPickle::size() const {
+  return pickle_.size() + referenced_size_;
+}
+
+std::vector<span<const uint8_t>> ScatterGatherPickle::GetSegments() {
+  static constexpr uint8_t kPadding[sizeof(uint32_t) - 1] = {};
+
+  CHECK(IsValueInRangeForNumericType<uint32_t>(pickle_.payload_size() +
+                                               referenced_size_));
+  header_.payload_size =
+      static_cast<uint32_t>(pickle_.payload_size() + referenced_size_);
+
+  const uint8_t* payload =
+      reinterpret_cast<const uint8_t*>(pickle_.payload());
+  std::vector<span<const uint8_t>> segments;
+  segments.reserve(3 * references_.size() + 2);
+  segments.emplace_back(reinterpret_cast<const uint8_t*>(&header_),
+                        sizeof(header_));
+  size_t offset = 0;
+  for (const Reference& reference : references_) {
+    if (reference.offset > offset)
+      segments.emplace_back(payload + offset, reference.offset - offset);
+    segments.push_back(reference.data);
+    const size_t padding =
+        bits::AlignUp(reference.data.size(), sizeof(uint32_t)) -
+        reference.data.size();
+    if (padding)
+      segments.emplace_back(kPadding, padding);
+    offset = reference.offset;
+  }
+  if (pickle_.payload_size() > offset)
+    segments.emplace_back(payload + offset, pickle_.payload_size() - offset);
+  return segments;
+}
+
 }  // namespace base
@@ -9,6 +9,7 @@
 #include <stdint.h>
 
 #include <string>
+#include <vector>
 
 #include "base/base_export.h"
 #include "base/check_op.h"
@@ -156,6 +157,12 @@ class BASE_EXPORT Pickle {
   // padding size is deduced from the data length.
   Pickle(const char* data, size_t data_len);
 
+  // Like above, for borrowed memory such as a memory-mapped file or a
+  // ReadOnlySharedMemoryMapping, which must outlive the Pickle:
+  //
+  //   Pickle pickle(mapping.GetMemoryAsSpan<uint8_t>());
+  explicit Pickle(span<const uint8_t> data);
+
   // Initializes a Pickle as a deep copy of another Pickle.
   Pickle(const Pickle& other);
 
@@ -342,6 +349,61 @@ class BASE_EXPORT Pickle {
   FRIEND_TEST_ALL_PREFIXES(PickleTest, FindNextOverflow);
 };
 
+// Builds a Pickle whose large blobs are referenced rather than copied, so that
+// it can be sent without copying them, with a vectored write such as writev()
+// or sendmsg(). The concatenation of the segments is a serialized Pickle with
+// the default header, which is read like any other.
+//
+//   ScatterGatherPickle message;
+//   message.pickle()->WriteInt(id);
+//   message.WriteDataByReference(large_buffer);
+//   std::vector<iovec> iov;
+//   for (span<const uint8_t> segment : message.GetSegments())
+//     iov.push_back({const_cast<uint8_t*>(segment.data()), segment.size()});
+//   writev(fd, iov.data(), iov.size());
+class BASE_EXPORT ScatterGatherPickle {
+ public:
+  // Blobs smaller than this are copied, which is cheaper than writing them as
+  // separate segments.
+  static constexpr size_t kMinReferencedSize = 4096;
+
+  ScatterGatherPickle();
+  ScatterGatherPickle(const ScatterGatherPickle&) = delete;
+  ScatterGatherPickle& operator=(const ScatterGatherPickle&) = delete;
+  ~ScatterGatherPickle();
+
+  // Values are written by copying them into this Pickle, after everything
+  // written so far, including referenced blobs. Its own data() does not
+  // include the referenced blobs and is not a valid serialization.
+  Pickle* pickle() { return &pickle_; }
+
+  // Like Pickle::WriteData(), but without copying |data| unless it is small.
+  // |data| must remain valid and unchanged for as long as the segments are
+  // used.
+  void WriteDataByReference(span<const uint8_t> data);
+
+  // Returns the size of the serialized Pickle.
+  size_t size() const;
+
+  // Returns the serialized Pickle as a list of buffers, pointing into this
+  // object and into the referenced blobs. Writes invalidate them.
+  std::vector<span<const uint8_t>> GetSegments();
+
+ private:
+  // A blob inserted into the payload of |pickle_|, at |offset|.
+  struct Reference {
+    size_t offset;
+    span<const uint8_t> data;
+  };
+
+  Pickle pickle_;
+  std::vector<Reference> references_;
+  // The size of the referenced blobs, including their padding.
+  size_t referenced_size_ = 0;
+  // The header of the serialized Pickle, which counts the referenced blobs.
+  Pickle::Header header_ = {};
+};
+
 }  // namespace base
 
 #endif  // BASE_PICKLE_H_
@@ -10,6 +10,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "base/cxx17_backports.h"
 #include "base/strings/utf_string_conversions.h"
@@ -596,4 +597,68 @@ TEST(PickleTest, ReachedEnd) {
   EXPECT_TRUE(iter.ReachedEnd());
 }
 
+TEST(PickleTest, UnownedBuffer) {
+  Pickle pickle;
+  pickle.WriteInt(1);
+  pickle.WriteString("borrowed");
+
+  const uint8_t* data = static_cast<const uint8_t*>(pickle.data());
+  Pickle borrowed(make_span(data, pickle.size()));
+  EXPECT_EQ(pickle.data(), borrowed.data());
+  EXPECT_EQ(0u, borrowed.GetTotalAllocatedSize());
+
+  PickleIterator iter(borrowed);
+  int out_int;
+  StringPiece out_string;
+  EXPECT_TRUE(iter.ReadInt(&out_int));
+  EXPECT_EQ(1, out_int);
+  EXPECT_TRUE(iter.ReadStringPiece(&out_string));
+  EXPECT_EQ("borrowed", out_string);
+  EXPECT_EQ(reinterpret_cast<const char*>(data) + 12, out_string.data());
+  EXPECT_TRUE(iter.ReachedEnd());
+}
+
+TEST(PickleTest, ScatterGather) {
+  const std::vector<uint8_t> large(ScatterGatherPickle::kMinReferencedSize + 1,
+                                   'L');
+  const std::vector<uint8_t> small(3, 's');
+
+  ScatterGatherPickle message;
+  message.pickle()->WriteInt(1);
+  message.WriteDataByReference(large);
+  message.WriteDataByReference(large);
+  message.WriteDataByReference(small);
+  message.pickle()->WriteString("end");
+
+  std::vector<span<const uint8_t>> segments = message.GetSegments();
+  std::vector<uint8_t> serialized;
+  for (span<const uint8_t> segment : segments)
+    serialized.insert(serialized.end(), segment.begin(), segment.end());
+  EXPECT_EQ(message.size(), serialized.size());
+
+  // The large blob is not copied, and the small one is.
+  size_t references = 0;
+  for (span<const uint8_t> segment : segments)
+    references += segment.data() == large.data();
+  EXPECT_EQ(2u, references);
+  EXPECT_LT(message.pickle()->size(), large.size());
+
+  Pickle pickle(make_span(serialized));
+  PickleIterator iter(pickle);
+  int out_int;
+  span<const uint8_t> out_data;
+  std::string out_string;
+  EXPECT_TRUE(iter.ReadInt(&out_int));
+  EXPECT_EQ(1, out_int);
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_TRUE(iter.ReadData(&out_data));
+    EXPECT_EQ(large, std::vector<uint8_t>(out_data.begin(), out_data.end()));
+  }
+  EXPECT_TRUE(iter.ReadData(&out_data));
+  EXPECT_EQ(small, std::vector<uint8_t>(out_data.begin(), out_data.end()));
+  EXPECT_TRUE(iter.ReadString(&out_string));
+  EXPECT_EQ("end", out_string);
+  EXPECT_TRUE(iter.ReachedEnd());
+}
+
 }  // namespace base
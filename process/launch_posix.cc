@@ -38,6 +38,7 @@
 #include "base/process/environment_internal.h"
 #include "base/process/process.h"
 #include "base/process/process_metrics.h"
+#include "base/rand_util.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/threading/platform_thread.h"
 #include "base/threading/platform_thread_internal_posix.h"
@@ -746,6 +747,9 @@ pid_t ForkWithFlags(unsigned long flags, pid_t* ptid, pid_t* ctid) {
   // callbacks, we explicitly clear tid cache here (normally this call is
   // done as pthread_aftork() callback).  See crbug.com/902514.
   base::internal::ClearTidCache();
+  // Likewise, the child must not hand out the random bytes that the parent
+  // has buffered.
+  base::internal::DiscardRandBytesBuffer();
 #endif  // defined(OS_LINUX) || defined(OS_CHROMEOS)
 
   return 0;
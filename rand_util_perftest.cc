@@ -3,6 +3,14 @@
 // found in the LICENSE file.
 
 #include "base/rand_util.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/strings/string_number_conversions.h"
 #include "base/time/time.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/perf/perf_result_reporter.h"
@@ -34,6 +42,27 @@ TEST(RandUtilPerfTest, RandUint64) {
   ASSERT_NE(inclusive_or, static_cast<uint64_t>(0));
 }
 
+TEST(RandUtilPerfTest, RandBytes) {
+  // From a GUID or UnguessableToken to sizes served straight by the kernel.
+  for (size_t size : {16u, 64u, 256u, 4096u}) {
+    std::vector<uint8_t> buffer(size);
+    const int iterations = static_cast<int>(1e8 / (size + 1000));
+
+    auto before = base::TimeTicks::Now();
+    for (int iter = 0; iter < iterations; iter++)
+      base::RandBytes(buffer.data(), buffer.size());
+    auto after = base::TimeTicks::Now();
+
+    perf_test::PerfResultReporter reporter(
+        kMetricPrefix, "RandBytes_" + NumberToString(size) + "_bytes");
+    reporter.RegisterImportantMetric(kThroughput, "ns / iteration");
+
+    uint64_t nanos_per_iteration =
+        (after - before).InNanoseconds() / iterations;
+    reporter.AddResult("throughput", static_cast<size_t>(nanos_per_iteration));
+  }
+}
+
 TEST(RandUtilPerfTest, InsecureRandomRandUint64) {
   base::InsecureRandomGenerator gen;
   gen.Seed();
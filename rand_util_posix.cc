@@ -8,16 +8,23 @@
 #include <fcntl.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <iterator>
+
 #include "base/check.h"
 #include "base/compiler_specific.h"
 #include "base/files/file_util.h"
 #include "base/no_destructor.h"
 #include "base/posix/eintr_wrapper.h"
+#include "base/stl_util.h"
 #include "build/build_config.h"
 
 #if (defined(OS_LINUX) || defined(OS_CHROMEOS)) && !defined(OS_NACL)
+#include <pthread.h>
+
 #include "third_party/lss/linux_syscall_support.h"
 #elif defined(OS_MAC)
 // TODO(crbug.com/995996): Waiting for this header to appear in the iOS SDK.
@@ -52,16 +59,49 @@ class URandomFd {
   const int fd_;
 };
 
-}  // namespace
+#if (defined(OS_LINUX) || defined(OS_CHROMEOS)) && !defined(OS_NACL)
 
-namespace base {
+// Small requests are served from a buffer of ChaCha20 output, which saves a
+// system call each. The buffer is refilled with "fast key erasure": the first
+// bytes of each refill become the next key, and bytes are wiped from the
+// buffer as they are handed out, so that the state of the generator never
+// reveals past output.
+constexpr size_t kChaCha20BlockSize = 64;
+constexpr size_t kChaCha20KeySize = 32;
+constexpr size_t kBufferSize = 16 * kChaCha20BlockSize;
 
-// NOTE: In an ideal future, all implementations of this function will just
-// wrap BoringSSL's `RAND_bytes`. TODO(crbug.com/995996): Figure out the
-// build/test/performance issues with dcheng's CL
-// (https://chromium-review.googlesource.com/c/chromium/src/+/1545096) and land
-// it or some form of it.
-void RandBytes(void* output, size_t output_length) {
+// Larger requests go straight to the kernel, whose cost is then small next to
+// the copy.
+constexpr size_t kMaxBufferedRequest = 256;
+
+// The key is mixed with fresh bytes from the kernel after this much output.
+constexpr size_t kReseedInterval = 1024 * 1024;
+
+struct RandBytesBuffer {
+  uint32_t key[kChaCha20KeySize / sizeof(uint32_t)];
+  uint8_t bytes[kBufferSize];
+  // The number of bytes not handed out yet, at the end of |bytes|.
+  size_t available;
+  size_t bytes_since_seed;
+  bool seeded;
+};
+
+// Using thread_local is fine here, see the comment on g_thread_id in
+// platform_thread_posix.cc. The buffer is zero-initialized, which is the
+// unseeded state, so no initialization guard is needed.
+thread_local RandBytesBuffer g_rand_bytes_buffer;
+
+class InitAtFork {
+ public:
+  InitAtFork() {
+    pthread_atfork(nullptr, nullptr, base::internal::DiscardRandBytesBuffer);
+  }
+};
+
+#endif  // (defined(OS_LINUX) || defined(OS_CHROMEOS)) && !defined(OS_NACL)
+
+// Fills |output| straight from the kernel.
+void RandBytesFromKernel(void* output, size_t output_length) {
 #if (defined(OS_LINUX) || defined(OS_CHROMEOS)) && !defined(OS_NACL)
   // We have to call `getrandom` via Linux Syscall Support, rather than through
   // the libc wrapper, because we might not have an up-to-date libc (e.g. on
@@ -89,15 +129,138 @@ void RandBytes(void* output, size_t output_length) {
   //
   // TODO(crbug.com/995996): When we no longer need to support old Linux
   // kernels, we can get rid of this /dev/urandom branch altogether.
-  const int urandom_fd = GetUrandomFD();
+  const int urandom_fd = base::GetUrandomFD();
   const bool success =
-      ReadFromFD(urandom_fd, static_cast<char*>(output), output_length);
+      base::ReadFromFD(urandom_fd, static_cast<char*>(output), output_length);
   CHECK(success);
 }
 
+#if (defined(OS_LINUX) || defined(OS_CHROMEOS)) && !defined(OS_NACL)
+
+// Refills |buffer|, first mixing fresh bytes from the kernel into the key if
+// it is due.
+void RefillRandBytesBuffer(RandBytesBuffer& buffer) {
+  if (!buffer.seeded || buffer.bytes_since_seed >= kReseedInterval) {
+    static InitAtFork init_at_fork;
+    uint32_t seed[kChaCha20KeySize / sizeof(uint32_t)];
+    RandBytesFromKernel(seed, sizeof(seed));
+    for (size_t i = 0; i < base::size(seed); ++i)
+      buffer.key[i] ^= seed[i];
+    buffer.seeded = true;
+    buffer.bytes_since_seed = 0;
+  }
+
+  // The key is only ever used for one refill, so the nonce can stay zero.
+  for (uint32_t i = 0; i < kBufferSize / kChaCha20BlockSize; ++i) {
+    const uint32_t counter_and_nonce[4] = {i, 0, 0, 0};
+    base::internal::ChaCha20Block(buffer.key, counter_and_nonce,
+                                  buffer.bytes + i * kChaCha20BlockSize);
+  }
+  memcpy(buffer.key, buffer.bytes, kChaCha20KeySize);
+  memset(buffer.bytes, 0, kChaCha20KeySize);
+  buffer.available = kBufferSize - kChaCha20KeySize;
+}
+
+void RandBytesFromBuffer(void* output, size_t output_length) {
+  RandBytesBuffer& buffer = g_rand_bytes_buffer;
+  uint8_t* out = static_cast<uint8_t*>(output);
+  while (output_length > 0) {
+    if (buffer.available == 0)
+      RefillRandBytesBuffer(buffer);
+    const size_t size = std::min(output_length, buffer.available);
+    uint8_t* bytes = buffer.bytes + kBufferSize - buffer.available;
+    memcpy(out, bytes, size);
+    memset(bytes, 0, size);
+    buffer.available -= size;
+    buffer.bytes_since_seed += size;
+    out += size;
+    output_length -= size;
+  }
+}
+
+inline uint32_t RotateLeft(uint32_t x, int shift) {
+  return (x << shift) | (x >> (32 - shift));
+}
+
+inline void QuarterRound(uint32_t* state, int a, int b, int c, int d) {
+  state[a] += state[b];
+  state[d] = RotateLeft(state[d] ^ state[a], 16);
+  state[c] += state[d];
+  state[b] = RotateLeft(state[b] ^ state[c], 12);
+  state[a] += state[b];
+  state[d] = RotateLeft(state[d] ^ state[a], 8);
+  state[c] += state[d];
+  state[b] = RotateLeft(state[b] ^ state[c], 7);
+}
+
+#endif  // (defined(OS_LINUX) || defined(OS_CHROMEOS)) && !defined(OS_NACL)
+
+}  // namespace
+
+namespace base {
+
+// NOTE: In an ideal future, all implementations of this function will just
+// wrap BoringSSL's `RAND_bytes`. TODO(crbug.com/995996): Figure out the
+// build/test/performance issues with dcheng's CL
+// (https://chromium-review.googlesource.com/c/chromium/src/+/1545096) and land
+// it or some form of it.
+void RandBytes(void* output, size_t output_length) {
+#if (defined(OS_LINUX) || defined(OS_CHROMEOS)) && !defined(OS_NACL)
+  if (output_length <= kMaxBufferedRequest) {
+    RandBytesFromBuffer(output, output_length);
+    return;
+  }
+#endif
+  RandBytesFromKernel(output, output_length);
+}
+
 int GetUrandomFD() {
   static NoDestructor<URandomFd> urandom_fd;
   return urandom_fd->fd();
 }
 
+#if (defined(OS_LINUX) || defined(OS_CHROMEOS)) && !defined(OS_NACL)
+
+namespace internal {
+
+void DiscardRandBytesBuffer() {
+  memset(&g_rand_bytes_buffer, 0, sizeof(g_rand_bytes_buffer));
+}
+
+void ChaCha20Block(const uint32_t key[8],
+                   const uint32_t counter_and_nonce[4],
+                   uint8_t output[64]) {
+  // "expand 32-byte k", then the key, then the counter and nonce.
+  const uint32_t input[16] = {
+      0x61707865,           0x3320646e,           0x79622d32,
+      0x6b206574,           key[0],               key[1],
+      key[2],               key[3],               key[4],
+      key[5],               key[6],               key[7],
+      counter_and_nonce[0], counter_and_nonce[1], counter_and_nonce[2],
+      counter_and_nonce[3]};
+  uint32_t state[16];
+  std::copy(std::begin(input), std::end(input), state);
+  for (int i = 0; i < 10; ++i) {
+    QuarterRound(state, 0, 4, 8, 12);
+    QuarterRound(state, 1, 5, 9, 13);
+    QuarterRound(state, 2, 6, 10, 14);
+    QuarterRound(state, 3, 7, 11, 15);
+    QuarterRound(state, 0, 5, 10, 15);
+    QuarterRound(state, 1, 6, 11, 12);
+    QuarterRound(state, 2, 7, 8, 13);
+    QuarterRound(state, 3, 4, 9, 14);
+  }
+  for (int i = 0; i < 16; ++i) {
+    const uint32_t word = state[i] + input[i];
+    output[4 * i] = static_cast<uint8_t>(word);
+    output[4 * i + 1] = static_cast<uint8_t>(word >> 8);
+    output[4 * i + 2] = static_cast<uint8_t>(word >> 16);
+    output[4 * i + 3] = static_cast<uint8_t>(word >> 24);
+  }
+}
+
+}  // namespace internal
+
+#endif  // (defined(OS_LINUX) || defined(OS_CHROMEOS)) && !defined(OS_NACL)
+
 }  // namespace base
@@ -15,8 +15,16 @@
 
 #include "base/logging.h"
 #include "base/time/time.h"
+#include "build/build_config.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
+#if (defined(OS_LINUX) || defined(OS_CHROMEOS)) && !defined(OS_NACL)
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "base/posix/eintr_wrapper.h"
+#endif
+
 namespace base {
 
 namespace {
@@ -154,6 +162,72 @@ TEST(RandUtilTest, RandBytesLonger) {
   EXPECT_EQ(4097u, random_string2.size());
 }
 
+#if (defined(OS_LINUX) || defined(OS_CHROMEOS)) && !defined(OS_NACL)
+
+// Test vector from RFC 8439, section 2.3.2.
+TEST(RandUtilTest, ChaCha20Block) {
+  const uint32_t kKey[8] = {0x03020100, 0x07060504, 0x0b0a0908, 0x0f0e0d0c,
+                            0x13121110, 0x17161514, 0x1b1a1918, 0x1f1e1d1c};
+  const uint32_t kCounterAndNonce[4] = {0x00000001, 0x09000000, 0x4a000000,
+                                        0x00000000};
+  const uint8_t kExpected[64] = {
+      0x10, 0xf1, 0xe7, 0xe4, 0xd1, 0x3b, 0x59, 0x15, 0x50, 0x0f, 0xdd,
+      0x1f, 0xa3, 0x20, 0x71, 0xc4, 0xc7, 0xd1, 0xf4, 0xc7, 0x33, 0xc0,
+      0x68, 0x03, 0x04, 0x22, 0xaa, 0x9a, 0xc3, 0xd4, 0x6c, 0x4e, 0xd2,
+      0x82, 0x64, 0x46, 0x07, 0x9f, 0xaa, 0x09, 0x14, 0xc2, 0xd7, 0x05,
+      0xd9, 0x8b, 0x02, 0xa2, 0xb5, 0x12, 0x9c, 0xd1, 0xde, 0x16, 0x4e,
+      0xb9, 0xcb, 0xd0, 0x83, 0xe8, 0xa2, 0x50, 0x3c, 0x4e};
+
+  uint8_t block[64];
+  internal::ChaCha20Block(kKey, kCounterAndNonce, block);
+  EXPECT_TRUE(std::equal(std::begin(block), std::end(block),
+                         std::begin(kExpected)));
+}
+
+// The child process must not hand out the bytes the parent has buffered.
+TEST(RandUtilTest, RandBytesAfterFork) {
+  // Makes sure that this thread has buffered bytes.
+  base::RandUint64();
+
+  int pipefd[2];
+  ASSERT_EQ(0, pipe(pipefd));
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {  // child process.
+    close(pipefd[0]);
+    const uint64_t number = base::RandUint64();
+    _exit(HANDLE_EINTR(write(pipefd[1], &number, sizeof(number))) ==
+                  sizeof(number)
+              ? 0
+              : 1);
+  }
+
+  close(pipefd[1]);
+  uint64_t child_number = 0;
+  const ssize_t res =
+      HANDLE_EINTR(read(pipefd[0], &child_number, sizeof(child_number)));
+  close(pipefd[0]);
+  int status = 0;
+  ASSERT_EQ(pid, HANDLE_EINTR(waitpid(pid, &status, 0)));
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(child_number)), res);
+  EXPECT_NE(base::RandUint64(), child_number);
+}
+
+// Requests served from the buffer and from the kernel can be interleaved, and
+// the buffer is refilled as needed.
+TEST(RandUtilTest, RandBytesMixedSizes) {
+  for (size_t size : {8, 16, 255, 256, 257, 1000, 4096}) {
+    for (int i = 0; i < 100; ++i) {
+      std::vector<uint8_t> bytes(size);
+      base::RandBytes(bytes.data(), bytes.size());
+      // The chance of 8 random bytes all being zero is negligible.
+      EXPECT_NE(std::vector<uint8_t>(size), bytes) << size;
+    }
+  }
+}
+
+#endif  // (defined(OS_LINUX) || defined(OS_CHROMEOS)) && !defined(OS_NACL)
+
 // Benchmark test for RandBytes().  Disabled since it's intentionally slow and
 // does not test anything that isn't already tested by the existing RandBytes()
 // tests.
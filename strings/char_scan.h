@@ -0,0 +1,323 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Scans strings for the first character of a class: the characters of a small
+// set, and those outside a range. These are the loops behind find_first_of(),
+// IsStringASCII(), IsStringUTF8() and the JSON parser and writer, which call
+// them on short strings often enough that they are inlined.
+//
+// On x86-64, they classify 16 bytes at a time with SSE2, which is part of the
+// baseline, so they need no runtime dispatch. Elsewhere, 8-bit strings are
+// skipped a machine word at a time where possible.
+
+#ifndef BASE_STRINGS_CHAR_SCAN_H_
+#define BASE_STRINGS_CHAR_SCAN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <type_traits>
+
+#include "base/bits.h"
+#include "base/check_op.h"
+#include "base/compiler_specific.h"
+#include "base/strings/string_piece.h"
+#include "build/build_config.h"
+
+#if defined(ARCH_CPU_X86_64)
+#include <emmintrin.h>
+#endif
+
+namespace base {
+namespace internal {
+
+// The largest set that the functions below accept. Each character of the set
+// costs a comparison per block, so larger sets are better searched for with a
+// lookup table.
+constexpr size_t kMaxCharScanSetSize = 8;
+
+// The characters in |set|, and, if |kHasRange|, those outside [min, max].
+template <typename CharT, bool kHasRange>
+struct CharClass {
+  using UnsignedT = std::make_unsigned_t<CharT>;
+
+  bool Contains(CharT c) const {
+    // c - min wraps around if c < min.
+    if (kHasRange && static_cast<UnsignedT>(static_cast<UnsignedT>(c) - min) >
+                         static_cast<UnsignedT>(max - min)) {
+      return true;
+    }
+    for (CharT set_char : set) {
+      if (c == set_char)
+        return true;
+    }
+    return false;
+  }
+
+  BasicStringPiece<CharT> set;
+  UnsignedT min;
+  UnsignedT max;
+};
+
+#if defined(ARCH_CPU_X86_64)
+
+// The size, in bytes, of the shortest strings that are not scanned a character
+// at a time.
+constexpr size_t kMinCharScanBlocksSize = sizeof(uint64_t);
+
+template <typename CharT>
+__m128i BroadcastChar(std::make_unsigned_t<CharT> c) {
+  return sizeof(CharT) == 1 ? _mm_set1_epi8(static_cast<char>(c))
+                            : _mm_set1_epi16(static_cast<short>(c));
+}
+
+// Compares 16-byte blocks against a CharClass.
+template <typename CharT, bool kHasRange>
+class CharClassMatcher {
+ public:
+  using UnsignedT = std::make_unsigned_t<CharT>;
+
+  explicit CharClassMatcher(const CharClass<CharT, kHasRange>& cls)
+      : set_size_(cls.set.size()),
+        // SSE2 only compares signed integers. c is outside [min, max] if
+        // c - min, as an unsigned integer, is above max - min, which is tested
+        // by flipping the sign bit of both.
+        sign_bit_(
+            BroadcastChar<CharT>(UnsignedT{1} << (sizeof(CharT) * 8 - 1))),
+        min_(BroadcastChar<CharT>(cls.min)),
+        max_offset_(_mm_xor_si128(
+            BroadcastChar<CharT>(static_cast<UnsignedT>(cls.max - cls.min)),
+            sign_bit_)) {
+    for (size_t i = 0; i < set_size_; ++i) {
+      set_[i] =
+          BroadcastChar<CharT>(static_cast<UnsignedT>(cls.set.data()[i]));
+    }
+  }
+
+  // Returns a vector whose characters are all ones where |block| has a
+  // character of the class, and zeros elsewhere.
+  __m128i Match(__m128i block) const {
+    __m128i matches = _mm_setzero_si128();
+    for (size_t i = 0; i < set_size_; ++i) {
+      matches = _mm_or_si128(matches, sizeof(CharT) == 1
+                                          ? _mm_cmpeq_epi8(block, set_[i])
+                                          : _mm_cmpeq_epi16(block, set_[i]));
+    }
+    if (kHasRange) {
+      const __m128i offset = _mm_xor_si128(
+          sizeof(CharT) == 1 ? _mm_sub_epi8(block, min_)
+                             : _mm_sub_epi16(block, min_),
+          sign_bit_);
+      matches = _mm_or_si128(
+          matches, sizeof(CharT) == 1 ? _mm_cmpgt_epi8(offset, max_offset_)
+                                      : _mm_cmpgt_epi16(offset, max_offset_));
+    }
+    return matches;
+  }
+
+ private:
+  const size_t set_size_;
+  const __m128i sign_bit_;
+  const __m128i min_;
+  const __m128i max_offset_;
+  __m128i set_[kMaxCharScanSetSize];
+};
+
+// Scans |str|, which has at least 8 bytes, for the first character that is in
+// |cls|, or, if |kNegate|, that is not. Returns its position, or the size of
+// |str| if there is none: the blocks at the ends overlap the others, so no
+// characters are left to check one at a time.
+template <typename CharT, bool kHasRange, bool kNegate>
+ALWAYS_INLINE size_t ScanCharBlocks(BasicStringPiece<CharT> str,
+                                    const CharClass<CharT, kHasRange>& cls) {
+  constexpr size_t kBlockSize = sizeof(__m128i) / sizeof(CharT);
+  const CharClassMatcher<CharT, kHasRange> matcher(cls);
+  const CharT* const data = str.data();
+  const size_t size = str.size();
+  // Turns the matches into the characters that stop the scan.
+  const __m128i stop_mask = kNegate ? _mm_set1_epi8(-1) : _mm_setzero_si128();
+  auto stops_in = [&](__m128i block) {
+    return _mm_xor_si128(matcher.Match(block), stop_mask);
+  };
+  auto stops_at = [&](size_t i) {
+    return stops_in(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+  };
+  // One bit per byte, so two per character for 16-bit characters.
+  auto stop_bits = [](__m128i stops) {
+    return static_cast<uint32_t>(_mm_movemask_epi8(stops));
+  };
+  auto first_stop = [](uint32_t mask) {
+    return bits::CountTrailingZeroBits(mask) / sizeof(CharT);
+  };
+
+  // Short strings are checked as a single block of their first and last 8
+  // bytes.
+  if (size < kBlockSize) {
+    constexpr size_t kHalfBlockSize = kBlockSize / 2;
+    const uint32_t mask = stop_bits(stops_in(_mm_unpacklo_epi64(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data)),
+        _mm_loadl_epi64(
+            reinterpret_cast<const __m128i*>(data + size - kHalfBlockSize)))));
+    if (!mask)
+      return size;
+    const size_t i = first_stop(mask);
+    return i < kHalfBlockSize ? i : i + size - kBlockSize;
+  }
+
+  // Most scans stop early, so the first block is checked on its own.
+  if (const uint32_t mask = stop_bits(stops_at(0)))
+    return first_stop(mask);
+
+  // Long runs are checked four blocks at a time, and the block that stops the
+  // scan is found below.
+  size_t i = kBlockSize;
+  for (; i + 4 * kBlockSize <= size; i += 4 * kBlockSize) {
+    const __m128i stops =
+        _mm_or_si128(_mm_or_si128(stops_at(i), stops_at(i + kBlockSize)),
+                     _mm_or_si128(stops_at(i + 2 * kBlockSize),
+                                  stops_at(i + 3 * kBlockSize)));
+    if (stop_bits(stops))
+      break;
+  }
+  for (; i + kBlockSize <= size; i += kBlockSize) {
+    if (const uint32_t mask = stop_bits(stops_at(i)))
+      return i + first_stop(mask);
+  }
+
+  // The last block ends at the end of |str|, and overlaps characters that have
+  // been checked already.
+  if (i < size) {
+    i = size - kBlockSize;
+    if (const uint32_t mask = stop_bits(stops_at(i)))
+      return i + first_stop(mask);
+  }
+  return size;
+}
+
+#else  // defined(ARCH_CPU_X86_64)
+
+constexpr size_t kMinCharScanBlocksSize = sizeof(uint64_t);
+
+// Skips the machine words of 8-bit |str| that contain no character of |cls|,
+// using the classic "has zero byte", "has less than" and "has more than"
+// tricks, which hold for bounds below 0x80. Returns the number of characters
+// skipped; the scan goes on a character at a time from there.
+template <typename CharT, bool kHasRange, bool kNegate>
+ALWAYS_INLINE size_t ScanCharBlocks(BasicStringPiece<CharT> str,
+                                    const CharClass<CharT, kHasRange>& cls) {
+  constexpr uint64_t kOnes = 0x0101010101010101;
+  constexpr uint64_t kHighBits = 0x8080808080808080;
+  if (sizeof(CharT) != 1 || kNegate ||
+      (kHasRange && (cls.min > 0x80 || (cls.max >= 0x80 && cls.max != 0xFF)))) {
+    return 0;
+  }
+
+  auto has_byte = [](uint64_t word, CharT c) {
+    const uint64_t x = word ^ (kOnes * static_cast<uint8_t>(c));
+    return ((x - kOnes) & ~x & kHighBits) != 0;
+  };
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= str.size(); i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, str.data() + i, sizeof(word));
+    if (kHasRange && cls.min && ((word - kOnes * cls.min) & ~word & kHighBits))
+      return i;
+    if (kHasRange && cls.max < 0x80 &&
+        (((word + kOnes * (0x7F - cls.max)) | word) & kHighBits)) {
+      return i;
+    }
+    for (CharT c : cls.set) {
+      if (has_byte(word, c))
+        return i;
+    }
+  }
+  return i;
+}
+
+#endif  // defined(ARCH_CPU_X86_64)
+
+// Returns the position of the first character of |str| that is in |cls|, or,
+// if |kNegate|, that is not, or npos if there is none.
+template <typename CharT, bool kHasRange, bool kNegate>
+ALWAYS_INLINE size_t
+FindFirstInCharClass(BasicStringPiece<CharT> str,
+                     const CharClass<CharT, kHasRange>& cls) {
+  DCHECK_LE(cls.set.size(), kMaxCharScanSetSize);
+  // memchr() is vectorized too, and usually faster for a single character.
+  if (sizeof(CharT) == 1 && !kHasRange && !kNegate && cls.set.size() == 1) {
+    const void* found = str.empty() ? nullptr
+                                    : memchr(str.data(), *cls.set.data(),
+                                             str.size());
+    return found ? static_cast<size_t>(static_cast<const CharT*>(found) -
+                                       str.data())
+                 : BasicStringPiece<CharT>::npos;
+  }
+
+  size_t i = 0;
+  if (str.size() * sizeof(CharT) >= kMinCharScanBlocksSize)
+    i = ScanCharBlocks<CharT, kHasRange, kNegate>(str, cls);
+
+  // Checks the characters that are left one at a time, starting with the one
+  // that stopped the scan, if any. Indexing data() skips the bounds checks of
+  // StringPiece.
+  const CharT* const data = str.data();
+  for (; i < str.size(); ++i) {
+    if (cls.Contains(data[i]) != kNegate)
+      return i;
+  }
+  return BasicStringPiece<CharT>::npos;
+}
+
+// Returns the position of the first character of |str| that is in |set|, or
+// npos if there is none.
+ALWAYS_INLINE size_t FindFirstInSet(StringPiece str, StringPiece set) {
+  return FindFirstInCharClass<char, false, false>(str, {set, 0, 0});
+}
+ALWAYS_INLINE size_t FindFirstInSet(StringPiece16 str, StringPiece16 set) {
+  return FindFirstInCharClass<char16_t, false, false>(str, {set, 0, 0});
+}
+
+// Returns the position of the first character of |str| that is not in |set|,
+// or npos if there is none.
+ALWAYS_INLINE size_t FindFirstNotInSet(StringPiece str, StringPiece set) {
+  return FindFirstInCharClass<char, false, true>(str, {set, 0, 0});
+}
+ALWAYS_INLINE size_t FindFirstNotInSet(StringPiece16 str, StringPiece16 set) {
+  return FindFirstInCharClass<char16_t, false, true>(str, {set, 0, 0});
+}
+
+// Returns the position of the first character of |str| that is in |set| or
+// outside [|min|, |max|], or npos if there is none. Characters are compared
+// as unsigned.
+ALWAYS_INLINE size_t FindFirstInSetOrOutOfRange(StringPiece str,
+                                                StringPiece set,
+                                                uint8_t min,
+                                                uint8_t max) {
+  DCHECK_LE(min, max);
+  return FindFirstInCharClass<char, true, false>(str, {set, min, max});
+}
+ALWAYS_INLINE size_t FindFirstInSetOrOutOfRange(StringPiece16 str,
+                                                StringPiece16 set,
+                                                char16_t min,
+                                                char16_t max) {
+  DCHECK_LE(min, max);
+  return FindFirstInCharClass<char16_t, true, false>(str, {set, min, max});
+}
+
+// Returns whether all the characters of |str| are within [|min|, |max|].
+ALWAYS_INLINE bool AllInRange(StringPiece str, uint8_t min, uint8_t max) {
+  return FindFirstInSetOrOutOfRange(str, StringPiece(), min, max) ==
+         StringPiece::npos;
+}
+ALWAYS_INLINE bool AllInRange(StringPiece16 str, char16_t min, char16_t max) {
+  return FindFirstInSetOrOutOfRange(str, StringPiece16(), min, max) ==
+         StringPiece16::npos;
+}
+
+}  // namespace internal
+}  // namespace base
+
+#endif  // BASE_STRINGS_CHAR_SCAN_H_
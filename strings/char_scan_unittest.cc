@@ -0,0 +1,140 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/strings/char_scan.h"
+
+#include <string>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace base {
+namespace internal {
+
+namespace {
+
+// The scans must agree with these at every position, inside the blocks that
+// are scanned at once and in the characters left after them.
+template <typename CharT>
+size_t SlowFindFirstInSetOrOutOfRange(BasicStringPiece<CharT> str,
+                                      BasicStringPiece<CharT> set,
+                                      std::make_unsigned_t<CharT> min,
+                                      std::make_unsigned_t<CharT> max) {
+  for (size_t i = 0; i < str.size(); ++i) {
+    const auto c = static_cast<std::make_unsigned_t<CharT>>(str[i]);
+    if (c < min || c > max || set.find(str[i]) != set.npos)
+      return i;
+  }
+  return str.npos;
+}
+
+template <typename CharT>
+size_t SlowFindFirstNotInSet(BasicStringPiece<CharT> str,
+                             BasicStringPiece<CharT> set) {
+  for (size_t i = 0; i < str.size(); ++i) {
+    if (set.find(str[i]) == set.npos)
+      return i;
+  }
+  return str.npos;
+}
+
+}  // namespace
+
+TEST(CharScanTest, FindFirstInSet) {
+  EXPECT_EQ(StringPiece::npos, FindFirstInSet("", "a"));
+  EXPECT_EQ(StringPiece::npos, FindFirstInSet("abc", ""));
+  EXPECT_EQ(2u, FindFirstInSet("abc", "c"));
+  EXPECT_EQ(1u, FindFirstInSet("abc", "cb"));
+  EXPECT_EQ(StringPiece16::npos, FindFirstInSet(u"abc", u"d"));
+  EXPECT_EQ(0u, FindFirstInSet(u"\xFFFF", u"\xFFFF"));
+
+  // Every position of a match, in strings of every length up to several
+  // blocks, with sets of every size.
+  const std::string set = "\x80\xFF\"\\\r\n\t<";
+  for (size_t size = 0; size <= 40; ++size) {
+    for (size_t pos = 0; pos <= size; ++pos) {
+      for (size_t set_size = 1; set_size <= set.size(); ++set_size) {
+        std::string str(size, 'x');
+        if (pos < size)
+          str[pos] = set[set_size - 1];
+        const size_t expected = pos < size ? pos : StringPiece::npos;
+        EXPECT_EQ(expected, FindFirstInSet(str, set.substr(0, set_size)));
+        const std::u16string str16(str.begin(), str.end());
+        const std::u16string set16(set.begin(), set.begin() + set_size);
+        EXPECT_EQ(expected, FindFirstInSet(str16, set16));
+      }
+    }
+  }
+}
+
+TEST(CharScanTest, FindFirstNotInSet) {
+  EXPECT_EQ(StringPiece::npos, FindFirstNotInSet("", "a"));
+  EXPECT_EQ(0u, FindFirstNotInSet("abc", ""));
+  EXPECT_EQ(StringPiece::npos, FindFirstNotInSet("abcabc", "cba"));
+  EXPECT_EQ(3u, FindFirstNotInSet(u"   x ", u" "));
+
+  for (size_t size = 0; size <= 40; ++size) {
+    for (size_t pos = 0; pos <= size; ++pos) {
+      std::string str(size, ' ');
+      for (size_t i = 0; i < pos; ++i)
+        str[i] = i % 2 ? '\t' : ' ';
+      if (pos < size)
+        str[pos] = 'x';
+      EXPECT_EQ(SlowFindFirstNotInSet<char>(str, " \t"),
+                FindFirstNotInSet(str, " \t"));
+      const std::u16string str16(str.begin(), str.end());
+      EXPECT_EQ(SlowFindFirstNotInSet<char16_t>(str16, u" \t"),
+                FindFirstNotInSet(str16, u" \t"));
+    }
+  }
+}
+
+// Every character, at every position, against ranges that need the unsigned
+// comparisons to be right.
+TEST(CharScanTest, FindFirstInSetOrOutOfRange) {
+  const uint8_t kRanges[][2] = {{0, 0x7F}, {0x20, 0x7F}, {0x20, 0xFF},
+                                {0x80, 0xFF}, {0, 0}, {0xFF, 0xFF}};
+  for (const auto& range : kRanges) {
+    for (int c = 0; c <= 0xFF; ++c) {
+      for (size_t pos : {0, 5, 15, 16, 17, 31, 35}) {
+        std::string str(36, static_cast<char>(range[0]));
+        str[pos] = static_cast<char>(c);
+        EXPECT_EQ(SlowFindFirstInSetOrOutOfRange<char>(str, "<", range[0],
+                                                       range[1]),
+                  FindFirstInSetOrOutOfRange(str, "<", range[0], range[1]))
+            << c << " at " << pos;
+      }
+    }
+  }
+
+  const char16_t kRanges16[][2] = {
+      {0, 0x7F}, {0x20, 0x7F}, {0xD800, 0xDFFF}, {0x100, 0xFFFF}};
+  for (const auto& range : kRanges16) {
+    for (char16_t c : {0, 0x1F, 0x20, 0x7F, 0x80, 0xFF, 0x100, 0x7FFF, 0x8000,
+                       0xD7FF, 0xD800, 0xDFFF, 0xE000, 0xFFFF}) {
+      for (size_t pos : {0, 5, 7, 8, 9, 15, 19}) {
+        std::u16string str(20, range[0]);
+        str[pos] = c;
+        EXPECT_EQ(SlowFindFirstInSetOrOutOfRange<char16_t>(str, u"<", range[0],
+                                                           range[1]),
+                  FindFirstInSetOrOutOfRange(str, u"<", range[0], range[1]))
+            << c << " at " << pos;
+      }
+    }
+  }
+}
+
+TEST(CharScanTest, AllInRange) {
+  EXPECT_TRUE(AllInRange("", 'a', 'z'));
+  EXPECT_TRUE(AllInRange("the quick brown fox jumps over the lazy dog", ' ',
+                         'z'));
+  EXPECT_FALSE(AllInRange("the quick brown fox jumps over the lazy dog\n",
+                          ' ', 'z'));
+  EXPECT_TRUE(AllInRange(std::string(100, '\x7F'), 0, 0x7F));
+  EXPECT_FALSE(AllInRange(std::string(99, 'a') + "\x80", 0, 0x7F));
+  EXPECT_TRUE(AllInRange(u"\x80\xFF\x100", 0x80, 0x100));
+  EXPECT_FALSE(AllInRange(std::u16string(40, 'a') + u"\xFFFF", 0, 0xFFFE));
+}
+
+}  // namespace internal
+}  // namespace base
@@ -4,18 +4,62 @@
 
 #include "base/strings/string_piece.h"
 
+#include <string.h>
+
 #include <algorithm>
 #include <climits>
 #include <limits>
 #include <ostream>
 #include <string>
 
+#include "base/bits.h"
+#include "base/check_op.h"
+#include "base/strings/char_scan.h"
 #include "base/strings/utf_string_conversions.h"
 #include "build/build_config.h"
 
 namespace base {
 namespace {
 
+#if defined(ARCH_CPU_X86_64)
+// Small sets are searched for with SSE2, which compares blocks of 16 bytes
+// against each character of the set. Larger sets are rare, and elsewhere a
+// lookup table is faster.
+constexpr bool kScanSmallSets = true;
+#else
+constexpr bool kScanSmallSets = false;
+#endif
+
+// Returns the position of the first character of |self|, at or after |pos|,
+// that is in |s| if |in_set|, or not in |s| otherwise.
+template <typename CharT>
+size_t FindFirstInSmallSet(BasicStringPiece<CharT> self,
+                           BasicStringPiece<CharT> s,
+                           size_t pos,
+                           bool in_set) {
+  if (pos >= self.size())
+    return BasicStringPiece<CharT>::npos;
+  const BasicStringPiece<CharT> rest = self.substr(pos);
+  const size_t found = in_set ? internal::FindFirstInSet(rest, s)
+                              : internal::FindFirstNotInSet(rest, s);
+  return found == BasicStringPiece<CharT>::npos ? found : pos + found;
+}
+
+// Returns the position of the first |c| in |str|, or npos if there is none.
+size_t FindChar(StringPiece str, char c) {
+  return internal::FindFirstInSet(str, StringPiece(&c, 1));
+}
+
+size_t FindChar(StringPiece16 str, char16_t c) {
+  return internal::FindFirstInSet(str, StringPiece16(&c, 1));
+}
+
+size_t FindChar(WStringPiece str, wchar_t c) {
+  const wchar_t* found =
+      std::char_traits<wchar_t>::find(str.data(), str.size(), c);
+  return found ? static_cast<size_t>(found - str.data()) : WStringPiece::npos;
+}
+
 // For each character in characters_wanted, sets the index corresponding
 // to the ASCII code of that character to 1 in table.  This is used by
 // the find_.*_of methods below to tell whether or not a character is in
@@ -58,14 +102,27 @@ namespace internal {
 
 template <typename T, typename CharT = typename T::value_type>
 size_t findT(T self, T s, size_t pos) {
-  if (pos > self.size())
+  if (pos > self.size() || s.size() > self.size() - pos)
     return BasicStringPiece<CharT>::npos;
+  if (s.empty())
+    return pos;
 
-  typename BasicStringPiece<CharT>::const_iterator result =
-      std::search(self.begin() + pos, self.end(), s.begin(), s.end());
-  const size_t xpos =
-    static_cast<size_t>(result - self.begin());
-  return xpos + s.size() <= self.size() ? xpos : BasicStringPiece<CharT>::npos;
+  // Look for the first character with the vectorized scan, and only compare
+  // the rest where it matches.
+  const CharT* const begin = self.data();
+  const size_t last = self.size() - s.size();
+  for (size_t i = pos; i <= last; ++i) {
+    const size_t found =
+        FindChar(BasicStringPiece<CharT>(begin + i, last - i + 1), s[0]);
+    if (found == BasicStringPiece<CharT>::npos)
+      break;
+    i += found;
+    if (std::char_traits<CharT>::compare(begin + i + 1, s.data() + 1,
+                                         s.size() - 1) == 0) {
+      return i;
+    }
+  }
+  return BasicStringPiece<CharT>::npos;
 }
 
 size_t find(StringPiece self, StringPiece s, size_t pos) {
@@ -105,6 +162,9 @@ size_t find_first_of(StringPiece self, StringPiece s, size_t pos) {
   if (self.size() == 0 || s.size() == 0)
     return StringPiece::npos;
 
+  if (kScanSmallSets && s.size() <= internal::kMaxCharScanSetSize)
+    return FindFirstInSmallSet(self, s, pos, /*in_set=*/true);
+
   // Avoid the cost of BuildLookupTable() for a single-character search.
   if (s.size() == 1)
     return self.find(s.data()[0], pos);
@@ -122,6 +182,9 @@ size_t find_first_of(StringPiece self, StringPiece s, size_t pos) {
 // Generic brute force version.
 template <typename T, typename CharT = typename T::value_type>
 size_t find_first_ofT(T self, T s, size_t pos) {
+  if (pos >= self.size())
+    return BasicStringPiece<CharT>::npos;
+
   // Use the faster std::find() if searching for a single character.
   typename BasicStringPiece<CharT>::const_iterator found =
       s.size() == 1 ? std::find(self.begin() + pos, self.end(), s[0])
@@ -133,6 +196,10 @@ size_t find_first_ofT(T self, T s, size_t pos) {
 }
 
 size_t find_first_of(StringPiece16 self, StringPiece16 s, size_t pos) {
+  if (kScanSmallSets && !s.empty() &&
+      s.size() <= internal::kMaxCharScanSetSize) {
+    return FindFirstInSmallSet(self, s, pos, /*in_set=*/true);
+  }
   return find_first_ofT(self, s, pos);
 }
 
@@ -144,6 +211,9 @@ size_t find_first_not_of(StringPiece self, StringPiece s, size_t pos) {
   if (s.size() == 0)
     return pos;
 
+  if (kScanSmallSets && s.size() <= internal::kMaxCharScanSetSize)
+    return FindFirstInSmallSet(self, s, pos, /*in_set=*/false);
+
   // Avoid the cost of BuildLookupTable() for a single-character search.
   if (s.size() == 1)
     return self.find_first_not_of(s.data()[0], pos);
@@ -179,6 +249,10 @@ size_t find_first_not_ofT(T self, T s, size_t pos) {
 }
 
 size_t find_first_not_of(StringPiece16 self, StringPiece16 s, size_t pos) {
+  if (kScanSmallSets && !s.empty() &&
+      s.size() <= internal::kMaxCharScanSetSize) {
+    return FindFirstInSmallSet(self, s, pos, /*in_set=*/false);
+  }
   return find_first_not_ofT(self, s, pos);
 }
 
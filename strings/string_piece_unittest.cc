@@ -511,6 +511,44 @@ TYPED_TEST(CommonStringPieceTest, CheckFind) {
   ASSERT_EQ(d.substr(0, 99), e);
 }
 
+// Searches long strings, whose blocks may be searched at once, for sets of
+// every size.
+TYPED_TEST(CommonStringPieceTest, CheckFindInLongStrings) {
+  using Piece = BasicStringPiece<TypeParam>;
+  const std::basic_string<TypeParam> set_chars =
+      TestFixture::as_string(" ,;:\t\n\r=/|");
+  const std::basic_string<TypeParam> filler(40, 'x');
+  for (size_t set_size = 1; set_size <= set_chars.size(); ++set_size) {
+    const Piece set(set_chars.data(), set_size);
+    for (size_t i = 0; i < filler.size() - 1; ++i) {
+      std::basic_string<TypeParam> str = filler;
+      str[i] = set[set_size - 1];
+      // A character that differs from the set only in its high bits.
+      str[filler.size() - 1] = static_cast<TypeParam>(set[0] | 0x80);
+      const Piece piece(str);
+      for (size_t pos : {size_t{0}, size_t{1}, i, i + 1, Piece::npos}) {
+        const size_t expected = pos <= i ? i : Piece::npos;
+        EXPECT_EQ(expected, piece.find_first_of(set, pos)) << set_size;
+      }
+
+      // All but one character in the set.
+      std::basic_string<TypeParam> in_set(filler.size(), set[0]);
+      in_set[i] = 'x';
+      EXPECT_EQ(i, Piece(in_set).find_first_not_of(set)) << set_size;
+      EXPECT_EQ(Piece::npos, Piece(in_set).find_first_not_of(set, i + 1));
+    }
+  }
+
+  const std::basic_string<TypeParam> haystack =
+      filler + TestFixture::as_string("needle") + filler;
+  EXPECT_EQ(filler.size(),
+            Piece(haystack).find(TestFixture::as_string("needle")));
+  EXPECT_EQ(Piece::npos,
+            Piece(haystack).find(TestFixture::as_string("needles")));
+  EXPECT_EQ(Piece::npos,
+            Piece(haystack).find(TestFixture::as_string("needle"), 41));
+}
+
 TYPED_TEST(CommonStringPieceTest, CheckCustom) {
   std::basic_string<TypeParam> foobar(TestFixture::as_string("foobar"));
   BasicStringPiece<TypeParam> a(foobar);
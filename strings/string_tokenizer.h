@@ -207,6 +207,12 @@ class StringTokenizerT {
     options_ = 0;
     token_is_delim_ = true;
     whitespace_policy_ = whitespace_policy;
+
+    token_end_chars_ = delims;
+    if (whitespace_policy == WhitespacePolicy::kSkipOver) {
+      for (char c : {' ', '\r', '\n', '\t', '\f'})
+        token_end_chars_.push_back(c);
+    }
   }
 
   bool ShouldSkip(char_type c) const {
@@ -239,9 +245,12 @@ class StringTokenizerT {
       }
       // else skip over delimiter or skippable character.
     }
-    while (token_end_ != end_ && delims_.find(*token_end_) == str::npos &&
-           !ShouldSkip(*token_end_)) {
-      ++token_end_;
+    // Find the end of the token with a single search, which is vectorized for
+    // small sets of delimiters.
+    if (token_end_ != end_) {
+      const BasicStringPiece<char_type> rest(&*token_end_, end_ - token_end_);
+      const size_t token_end = rest.find_first_of(token_end_chars_);
+      token_end_ += token_end == str::npos ? rest.size() : token_end;
     }
     return true;
   }
@@ -342,6 +351,9 @@ class StringTokenizerT {
   const_iterator token_end_;
   const_iterator end_;
   str delims_;
+  // The characters that end a token outside quotes: the delimiters, and the
+  // whitespace if it is skipped over.
+  str token_end_chars_;
   str quotes_;
   int options_;
   bool token_is_delim_;
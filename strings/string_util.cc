@@ -245,11 +245,11 @@ bool ContainsOnlyChars(StringPiece16 input, StringPiece16 characters) {
 
 
 bool IsStringASCII(StringPiece str) {
-  return internal::DoIsStringASCII(str.data(), str.length());
+  return internal::AllInRange(str, 0, 0x7F);
 }
 
 bool IsStringASCII(StringPiece16 str) {
-  return internal::DoIsStringASCII(str.data(), str.length());
+  return internal::AllInRange(str, 0, 0x7F);
 }
 
 #if defined(WCHAR_T_IS_UTF32)
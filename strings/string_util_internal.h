@@ -5,11 +5,14 @@
 #ifndef BASE_STRINGS_STRING_UTIL_INTERNAL_H_
 #define BASE_STRINGS_STRING_UTIL_INTERNAL_H_
 
+#include <string.h>
+
 #include <algorithm>
 
 #include "base/logging.h"
 #include "base/notreached.h"
 #include "base/ranges/algorithm.h"
+#include "base/strings/char_scan.h"
 #include "base/strings/string_piece.h"
 #include "base/third_party/icu/icu_utf.h"
 
@@ -232,6 +235,15 @@ inline bool DoIsStringUTF8(StringPiece str) {
   int32_t char_index = 0;
 
   while (char_index < src_len) {
+    // ASCII is always valid, so skip runs of it in bulk.
+    if (static_cast<unsigned char>(src[char_index]) < 0x80) {
+      const size_t ascii_chars = FindFirstInSetOrOutOfRange(
+          str.substr(char_index), StringPiece(), 0, 0x7F);
+      if (ascii_chars == StringPiece::npos)
+        break;
+      char_index += static_cast<int32_t>(ascii_chars);
+    }
+
     int32_t code_point;
     CBU8_NEXT(src, char_index, src_len, code_point);
     if (!Validator(code_point))
@@ -311,7 +323,7 @@ struct SubstringMatcher {
   BasicStringPiece<CharT> find_this;
 
   size_t Find(const std::basic_string<CharT>& input, size_t pos) {
-    return input.find(find_this.data(), pos, find_this.length());
+    return BasicStringPiece<CharT>(input).find(find_this, pos);
   }
   size_t MatchSize() { return find_this.length(); }
 };
@@ -328,8 +340,8 @@ struct CharacterMatcher {
   BasicStringPiece<CharT> find_any_of_these;
 
   size_t Find(const std::basic_string<CharT>& input, size_t pos) {
-    return input.find_first_of(find_any_of_these.data(), pos,
-                               find_any_of_these.length());
+    return BasicStringPiece<CharT>(input).find_first_of(find_any_of_these,
+                                                        pos);
   }
   constexpr size_t MatchSize() { return 1; }
 };
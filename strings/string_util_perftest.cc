@@ -6,6 +6,9 @@
 
 #include <cinttypes>
 
+#include "base/strings/string_split.h"
+#include "base/strings/string_tokenizer.h"
+#include "base/strings/utf_string_conversions.h"
 #include "base/time/time.h"
 #include "build/build_config.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -43,4 +46,87 @@ TEST(StringUtilTest, DISABLED_IsStringASCIIPerf) {
   }
 }
 
+// Converts |str_length| characters of ASCII text, or of text that is mostly
+// ASCII with a two-byte UTF-8 character every 32 characters.
+void MeasureUTFConversions(size_t str_length, bool ascii_only) {
+  std::string utf8;
+  while (utf8.size() < str_length) {
+    utf8 += "The quick brown fox jumps over ";
+    utf8 += ascii_only ? "t" : "\xC3\xA9";
+  }
+  const std::u16string utf16 = UTF8ToUTF16(utf8);
+  const size_t iterations = 100000000 / str_length;
+
+  std::u16string utf16_out;
+  TimeTicks t0 = TimeTicks::Now();
+  for (size_t i = 0; i < iterations; ++i)
+    UTF8ToUTF16(utf8.data(), utf8.size(), &utf16_out);
+  TimeDelta utf8_to_utf16_time = TimeTicks::Now() - t0;
+
+  std::string utf8_out;
+  t0 = TimeTicks::Now();
+  for (size_t i = 0; i < iterations; ++i)
+    UTF16ToUTF8(utf16.data(), utf16.size(), &utf8_out);
+  TimeDelta utf16_to_utf8_time = TimeTicks::Now() - t0;
+
+  EXPECT_EQ(utf16, utf16_out);
+  EXPECT_EQ(utf8, utf8_out);
+  printf("length:\t%zu\tascii-only:\t%d\tutf8-to-utf16-ms:\t%" PRIu64
+         "\tutf16-to-utf8-ms:\t%" PRIu64 "\n",
+         utf8.size(), ascii_only, utf8_to_utf16_time.InMilliseconds(),
+         utf16_to_utf8_time.InMilliseconds());
+}
+
+TEST(StringUtilTest, DISABLED_UTFConversionsPerf) {
+  for (size_t str_length = 16; str_length <= 65536; str_length *= 16) {
+    MeasureUTFConversions(str_length, true);
+    MeasureUTFConversions(str_length, false);
+  }
+}
+
+// Splits, tokenizes and validates |str_length| characters of text made of
+// words separated by a few different delimiters.
+void MeasureStringSearch(size_t str_length) {
+  std::string str;
+  while (str.size() < str_length)
+    str += "name=value; path=/some/resource/path, flag ";
+  const size_t iterations = 100000000 / str_length;
+
+  size_t pieces = 0;
+  TimeTicks t0 = TimeTicks::Now();
+  for (size_t i = 0; i < iterations; ++i) {
+    pieces += SplitStringPiece(str, ",;", TRIM_WHITESPACE, SPLIT_WANT_ALL)
+                  .size();
+  }
+  TimeDelta split_time = TimeTicks::Now() - t0;
+
+  size_t tokens = 0;
+  t0 = TimeTicks::Now();
+  for (size_t i = 0; i < iterations; ++i) {
+    StringTokenizer tokenizer(str, ",;=");
+    while (tokenizer.GetNext())
+      ++tokens;
+  }
+  TimeDelta tokenize_time = TimeTicks::Now() - t0;
+
+  size_t valid = 0;
+  t0 = TimeTicks::Now();
+  for (size_t i = 0; i < iterations; ++i)
+    valid += IsStringUTF8(str);
+  TimeDelta utf8_time = TimeTicks::Now() - t0;
+
+  EXPECT_GT(pieces, 0u);
+  EXPECT_GT(tokens, 0u);
+  EXPECT_EQ(iterations, valid);
+  printf("length:\t%zu\tsplit-ms:\t%" PRIu64 "\ttokenize-ms:\t%" PRIu64
+         "\tis-utf8-ms:\t%" PRIu64 "\n",
+         str.size(), split_time.InMilliseconds(),
+         tokenize_time.InMilliseconds(), utf8_time.InMilliseconds());
+}
+
+TEST(StringUtilTest, DISABLED_StringSearchPerf) {
+  for (size_t str_length = 64; str_length <= 65536; str_length *= 16)
+    MeasureStringSearch(str_length);
+}
+
 }  // namespace base
@@ -16,6 +16,10 @@
 #include "base/third_party/icu/icu_utf.h"
 #include "build/build_config.h"
 
+#if defined(ARCH_CPU_X86_64)
+#include <emmintrin.h>
+#endif
+
 namespace base {
 
 namespace {
@@ -85,6 +89,80 @@ void UnicodeAppendUnsafe(Char* out, int32_t* size, uint32_t code_point) {
   out[(*size)++] = code_point;
 }
 
+// ConvertASCIIPrefix ---------------------------------------------------------
+// Most text is ASCII, whose code units are the same in every encoding. These
+// convert the longest ASCII prefix of |src|, of at most |length| code units,
+// into |dest|, checking many code units at a time, and return its length.
+
+template <typename Char>
+bool IsASCIICodeUnit(Char c) {
+  return static_cast<std::make_unsigned_t<Char>>(c) < 0x80;
+}
+
+template <typename SrcChar, typename DestChar>
+size_t ConvertASCIIPrefix(const SrcChar* src, size_t length, DestChar* dest) {
+  // Check each block with a single branch, which compilers can vectorize.
+  constexpr size_t kBlockSize = 16;
+  size_t i = 0;
+  for (; i + kBlockSize <= length; i += kBlockSize) {
+    std::make_unsigned_t<SrcChar> bits = 0;
+    for (size_t j = 0; j < kBlockSize; ++j)
+      bits |= static_cast<std::make_unsigned_t<SrcChar>>(src[i + j]);
+    if (!IsASCIICodeUnit(bits))
+      break;
+    for (size_t j = 0; j < kBlockSize; ++j)
+      dest[i + j] = static_cast<DestChar>(src[i + j]);
+  }
+  for (; i < length && IsASCIICodeUnit(src[i]); ++i)
+    dest[i] = static_cast<DestChar>(src[i]);
+  return i;
+}
+
+#if defined(ARCH_CPU_X86_64)
+
+// SSE2 is part of x86-64, so these need no runtime check.
+
+size_t ConvertASCIIPrefix(const char* src, size_t length, char16_t* dest) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= length; i += 16) {
+    const __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    if (_mm_movemask_epi8(bytes))
+      break;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i),
+                     _mm_unpacklo_epi8(bytes, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 8),
+                     _mm_unpackhi_epi8(bytes, zero));
+  }
+  for (; i < length && IsASCIICodeUnit(src[i]); ++i)
+    dest[i] = src[i];
+  return i;
+}
+
+size_t ConvertASCIIPrefix(const char16_t* src, size_t length, char* dest) {
+  const __m128i non_ascii_bits = _mm_set1_epi16(static_cast<short>(0xFF80));
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= length; i += 16) {
+    const __m128i low =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const __m128i high =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+    const __m128i non_ascii =
+        _mm_and_si128(_mm_or_si128(low, high), non_ascii_bits);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(non_ascii, zero)) != 0xFFFF)
+      break;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i),
+                     _mm_packus_epi16(low, high));
+  }
+  for (; i < length && IsASCIICodeUnit(src[i]); ++i)
+    dest[i] = static_cast<char>(src[i]);
+  return i;
+}
+
+#endif  // defined(ARCH_CPU_X86_64)
+
 // DoUTFConversion ------------------------------------------------------------
 // Main driver of UTFConversion specialized for different Src encodings.
 // dest has to have enough room for the converted text.
@@ -97,6 +175,14 @@ bool DoUTFConversion(const char* src,
   bool success = true;
 
   for (int32_t i = 0; i < src_len;) {
+    if (IsASCIICodeUnit(src[i])) {
+      const int32_t ascii_len = static_cast<int32_t>(
+          ConvertASCIIPrefix(src + i, src_len - i, dest + *dest_len));
+      i += ascii_len;
+      *dest_len += ascii_len;
+      continue;
+    }
+
     int32_t code_point;
     CBU8_NEXT(src, i, src_len, code_point);
 
@@ -131,6 +217,14 @@ bool DoUTFConversion(const char16_t* src,
   // Always have another symbol in order to avoid checking boundaries in the
   // middle of the surrogate pair.
   while (i < src_len - 1) {
+    if (IsASCIICodeUnit(src[i])) {
+      const int32_t ascii_len = static_cast<int32_t>(
+          ConvertASCIIPrefix(src + i, src_len - i, dest + *dest_len));
+      i += ascii_len;
+      *dest_len += ascii_len;
+      continue;
+    }
+
     int32_t code_point;
 
     if (CBU16_IS_LEAD(src[i]) && CBU16_IS_TRAIL(src[i + 1])) {
@@ -184,23 +278,27 @@ bool DoUTFConversion(const wchar_t* src,
 
 template <typename InputString, typename DestString>
 bool UTFConversion(const InputString& src_str, DestString* dest_str) {
-  if (IsStringASCII(src_str)) {
-    dest_str->assign(src_str.begin(), src_str.end());
+  // Convert the ASCII prefix first, which is usually the whole string, so that
+  // ASCII strings are only sized for themselves.
+  dest_str->resize(src_str.length());
+  const size_t ascii_len =
+      ConvertASCIIPrefix(src_str.data(), src_str.length(), &(*dest_str)[0]);
+  if (ascii_len == src_str.length())
     return true;
-  }
 
   dest_str->resize(src_str.length() *
                    size_coefficient_v<typename InputString::value_type,
                                       typename DestString::value_type>);
 
-  // Empty string is ASCII => it OK to call operator[].
   auto* dest = &(*dest_str)[0];
 
-  // ICU requires 32 bit numbers.
-  int32_t src_len32 = static_cast<int32_t>(src_str.length());
-  int32_t dest_len32 = 0;
+  // ICU requires 32 bit numbers. An ASCII prefix ends at a code point
+  // boundary, so the conversion can resume after it.
+  int32_t src_len32 = static_cast<int32_t>(src_str.length() - ascii_len);
+  int32_t dest_len32 = static_cast<int32_t>(ascii_len);
 
-  bool res = DoUTFConversion(src_str.data(), src_len32, dest, &dest_len32);
+  bool res = DoUTFConversion(src_str.data() + ascii_len, src_len32, dest,
+                             &dest_len32);
 
   dest_str->resize(dest_len32);
   dest_str->shrink_to_fit();
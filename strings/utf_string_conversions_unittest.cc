@@ -200,4 +200,37 @@ TEST(UTFStringConversionsTest, ConvertMultiString) {
   EXPECT_EQ(expected, converted);
 }
 
+// Non-ASCII characters at every offset around the blocks of ASCII that are
+// converted at once.
+TEST(UTFStringConversionsTest, ConvertMostlyASCII) {
+  const std::string ascii(40, 'a');
+  const std::u16string ascii16(40, 'a');
+  for (size_t i = 0; i <= ascii.size(); ++i) {
+    const std::string utf8 =
+        ascii.substr(0, i) + "\xC3\xA9" + ascii.substr(i);
+    const std::u16string utf16 =
+        ascii16.substr(0, i) + u"\u00E9" + ascii16.substr(i);
+    std::u16string utf16_out;
+    EXPECT_TRUE(UTF8ToUTF16(utf8.data(), utf8.size(), &utf16_out));
+    EXPECT_EQ(utf16, utf16_out);
+    std::string utf8_out;
+    EXPECT_TRUE(UTF16ToUTF8(utf16.data(), utf16.size(), &utf8_out));
+    EXPECT_EQ(utf8, utf8_out);
+
+    // Invalid code units are replaced.
+    const std::string invalid_utf8 =
+        ascii.substr(0, i) + "\xFF" + ascii.substr(i);
+    EXPECT_FALSE(
+        UTF8ToUTF16(invalid_utf8.data(), invalid_utf8.size(), &utf16_out));
+    EXPECT_EQ(ascii16.substr(0, i) + u"\uFFFD" + ascii16.substr(i),
+              utf16_out);
+    const std::u16string invalid_utf16 =
+        ascii16.substr(0, i) + u'\xD800' + ascii16.substr(i);
+    EXPECT_FALSE(
+        UTF16ToUTF8(invalid_utf16.data(), invalid_utf16.size(), &utf8_out));
+    EXPECT_EQ(ascii.substr(0, i) + "\xEF\xBF\xBD" + ascii.substr(i),
+              utf8_out);
+  }
+}
+
 }  // namespace base
@@ -2,13 +2,23 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
 #include "base/compiler_specific.h"
+#include "base/containers/circular_deque.h"
+#include "base/containers/lock_free_ring_buffer.h"
+#include "base/containers/span.h"
 #include "base/synchronization/lock.h"
 #include "base/threading/platform_thread.h"
 #include "base/time/time.h"
 #include "base/timer/lap_timer.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/perf/perf_result_reporter.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
 
 namespace base {
 namespace {
@@ -22,6 +32,13 @@ constexpr char kMetricLockUnlockThroughput[] = "lock_unlock_throughput";
 constexpr char kStoryBaseline[] = "baseline_story";
 constexpr char kStoryWithCompetingThread[] = "with_competing_thread";
 
+constexpr char kMetricPrefixHandoff[] = "CrossThreadHandoff.";
+constexpr char kMetricHandoffThroughput[] = "handoff_throughput";
+
+constexpr size_t kHandoffCapacity = 1024;
+constexpr size_t kHandoffBatchSize = 32;
+constexpr uint32_t kNumHandoffs = 1000000;
+
 perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
   perf_test::PerfResultReporter reporter(kMetricPrefixLock, story_name);
   reporter.RegisterImportantMetric(kMetricLockUnlockThroughput, "runs/s");
@@ -58,6 +75,129 @@ class Spin : public PlatformThread::Delegate {
   std::atomic<bool> should_stop_;
 };
 
+// The lock-based way to hand elements to another thread, with the interface
+// of the ring buffers.
+class LockedQueue {
+ public:
+  explicit LockedQueue(size_t capacity) : capacity_(capacity) {}
+
+  bool TryPush(uint32_t value) {
+    AutoLock auto_lock(lock_);
+    if (queue_.size() == capacity_)
+      return false;
+    queue_.push_back(value);
+    return true;
+  }
+
+  size_t TryPushBatch(span<uint32_t> values) {
+    AutoLock auto_lock(lock_);
+    const size_t count = std::min(values.size(), capacity_ - queue_.size());
+    queue_.insert(queue_.end(), values.begin(), values.begin() + count);
+    return count;
+  }
+
+  absl::optional<uint32_t> TryPop() {
+    AutoLock auto_lock(lock_);
+    if (queue_.empty())
+      return absl::nullopt;
+    const uint32_t value = queue_.front();
+    queue_.pop_front();
+    return value;
+  }
+
+  size_t TryPopBatch(span<uint32_t> out) {
+    AutoLock auto_lock(lock_);
+    const size_t count = std::min(out.size(), queue_.size());
+    std::copy_n(queue_.begin(), count, out.begin());
+    queue_.erase(queue_.begin(), queue_.begin() + count);
+    return count;
+  }
+
+ private:
+  const size_t capacity_;
+  Lock lock_;
+  circular_deque<uint32_t> queue_ GUARDED_BY(lock_);
+};
+
+// Pushes the integers from 1 to kNumHandoffs, one at a time or in batches.
+// Yields when the queue is full, so that the consumer gets to run even on a
+// single core.
+template <class Queue>
+class HandoffProducer : public PlatformThread::Delegate {
+ public:
+  HandoffProducer(Queue* queue, size_t batch_size)
+      : queue_(queue), batch_size_(batch_size) {}
+  ~HandoffProducer() override = default;
+
+  void ThreadMain() override {
+    if (batch_size_ == 1) {
+      for (uint32_t i = 1; i <= kNumHandoffs;) {
+        if (queue_->TryPush(i))
+          ++i;
+        else
+          PlatformThread::YieldCurrentThread();
+      }
+      return;
+    }
+    std::vector<uint32_t> batch;
+    for (uint32_t i = 1; i <= kNumHandoffs;) {
+      batch.clear();
+      while (batch.size() < batch_size_ && i <= kNumHandoffs)
+        batch.push_back(i++);
+      span<uint32_t> values(batch);
+      while (!values.empty()) {
+        const size_t count = queue_->TryPushBatch(values);
+        if (!count)
+          PlatformThread::YieldCurrentThread();
+        values = values.subspan(count);
+      }
+    }
+  }
+
+ private:
+  Queue* const queue_;
+  const size_t batch_size_;
+};
+
+// Hands kNumHandoffs integers from a producer thread to this one through
+// |queue|, and reports how many went through per second.
+template <class Queue>
+void RunHandoffTest(const std::string& story_name, size_t batch_size) {
+  Queue queue(kHandoffCapacity);
+  HandoffProducer<Queue> producer(&queue, batch_size);
+  const TimeTicks start = TimeTicks::Now();
+  PlatformThreadHandle thread_handle;
+  ASSERT_TRUE(PlatformThread::Create(0, &producer, &thread_handle));
+
+  uint64_t sum = 0;
+  uint32_t num_popped = 0;
+  std::vector<uint32_t> batch(batch_size);
+  while (num_popped < kNumHandoffs) {
+    size_t count = 0;
+    if (batch_size == 1) {
+      if (absl::optional<uint32_t> value = queue.TryPop()) {
+        sum += *value;
+        count = 1;
+      }
+    } else {
+      count = queue.TryPopBatch(batch);
+      for (size_t i = 0; i < count; ++i)
+        sum += batch[i];
+    }
+    if (!count)
+      PlatformThread::YieldCurrentThread();
+    num_popped += count;
+  }
+  const TimeDelta elapsed = TimeTicks::Now() - start;
+  PlatformThread::Join(thread_handle);
+  EXPECT_EQ(uint64_t{kNumHandoffs} * (kNumHandoffs + 1) / 2, sum);
+
+  perf_test::PerfResultReporter reporter(kMetricPrefixHandoff, story_name);
+  reporter.RegisterImportantMetric(kMetricHandoffThroughput, "elements/s");
+  reporter.AddResult(kMetricHandoffThroughput,
+                     kNumHandoffs / elapsed.InSecondsF());
+}
+
 }  // namespace
 
 TEST(LockPerfTest, Simple) {
@@ -102,4 +242,21 @@ TEST(LockPerfTest, WithCompetingThread) {
   auto reporter = SetUpReporter(kStoryWithCompetingThread);
   reporter.AddResult(kMetricLockUnlockThroughput, timer.LapsPerSecond());
 }
+
+// Compares handing elements to another thread through a Lock-guarded
+// circular_deque with the lock-free ring buffers.
+TEST(LockPerfTest, CrossThreadHandoff) {
+  RunHandoffTest<LockedQueue>("locked_circular_deque", 1);
+  RunHandoffTest<SpscRingBuffer<uint32_t>>("spsc_ring_buffer", 1);
+  RunHandoffTest<MpmcRingBuffer<uint32_t>>("mpmc_ring_buffer", 1);
+}
+
+TEST(LockPerfTest, CrossThreadHandoffBatches) {
+  RunHandoffTest<LockedQueue>("locked_circular_deque_batch",
+                              kHandoffBatchSize);
+  RunHandoffTest<SpscRingBuffer<uint32_t>>("spsc_ring_buffer_batch",
+                                           kHandoffBatchSize);
+  RunHandoffTest<MpmcRingBuffer<uint32_t>>("mpmc_ring_buffer_batch",
+                                           kHandoffBatchSize);
+}
 }  // namespace base
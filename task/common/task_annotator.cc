@@ -5,6 +5,8 @@
 #include "base/task/common/task_annotator.h"
 
 #include <array>
+#include <memory>
+#include <utility>
 
 #include "base/check_op.h"
 #include "base/debug/activity_tracker.h"
@@ -18,6 +20,8 @@
 #include "base/tracing_buildflags.h"
 
 #if BUILDFLAG(ENABLE_BASE_TRACING)
+#include "base/trace_event/thread_perf_counters.h"
+#include "base/trace_event/traced_value.h"
 #include "third_party/perfetto/protos/perfetto/trace/track_event/chrome_mojo_event_info.pbzero.h"  // nogncheck
 #endif
 
@@ -62,6 +66,43 @@ bool IsDummyPendingTask(const PendingTask* task) {
   return false;
 }
 
+#if BUILDFLAG(ENABLE_BASE_TRACING)
+constexpr char kPerfCountersCategory[] =
+    TRACE_DISABLED_BY_DEFAULT("toplevel.perf_counters");
+
+// Reads the current thread's performance counters into |counters| if the
+// category is enabled. Returns false if they shouldn't be reported for the
+// task about to run.
+bool ReadPerfCountersBeforeTask(
+    trace_event::ThreadPerfCounterValues* counters) {
+  bool enabled = false;
+  TRACE_EVENT_CATEGORY_GROUP_ENABLED(kPerfCountersCategory, &enabled);
+  return enabled && trace_event::ThreadPerfCounters::Now(counters);
+}
+
+// Emits the performance counters accumulated since |before| on the current
+// thread, attributed to the location |pending_task| was posted from.
+void EmitPerfCountersAfterTask(
+    const PendingTask& pending_task,
+    const trace_event::ThreadPerfCounterValues& before) {
+  trace_event::ThreadPerfCounterValues after;
+  if (!trace_event::ThreadPerfCounters::Now(&after))
+    return;
+  const trace_event::ThreadPerfCounterValues delta = after - before;
+
+  auto value = std::make_unique<trace_event::TracedValue>();
+  value->SetString("file", pending_task.posted_from.file_name()
+                               ? pending_task.posted_from.file_name()
+                               : "");
+  value->SetString("function", pending_task.posted_from.function_name()
+                                   ? pending_task.posted_from.function_name()
+                                   : "");
+  delta.AsValueInto(value.get());
+  TRACE_EVENT_INSTANT1(kPerfCountersCategory, "TaskAnnotator::PerfCounters",
+                       TRACE_EVENT_SCOPE_THREAD, "counters", std::move(value));
+}
+#endif  // BUILDFLAG(ENABLE_BASE_TRACING)
+
 }  // namespace
 
 const PendingTask* TaskAnnotator::CurrentTaskForThread() {
@@ -175,8 +216,20 @@ void TaskAnnotator::RunTask(const char* trace_event_name,
 
   if (g_task_annotator_observer)
     g_task_annotator_observer->BeforeRunTask(pending_task);
+
+#if BUILDFLAG(ENABLE_BASE_TRACING)
+  trace_event::ThreadPerfCounterValues perf_counters_before;
+  const bool report_perf_counters =
+      ReadPerfCountersBeforeTask(&perf_counters_before);
+#endif
+
   std::move(pending_task->task).Run();
 
+#if BUILDFLAG(ENABLE_BASE_TRACING)
+  if (report_perf_counters)
+    EmitPerfCountersAfterTask(*pending_task, perf_counters_before);
+#endif
+
   tls->Set(previous_pending_task);
 
   // Stomp the markers. Otherwise they can stick around on the unused parts of
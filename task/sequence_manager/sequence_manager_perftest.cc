@@ -26,6 +26,7 @@
 #include "base/task/thread_pool.h"
 #include "base/task/thread_pool/thread_pool_impl.h"
 #include "base/task/thread_pool/thread_pool_instance.h"
+#include "base/test/allocation_counter.h"
 #include "base/threading/thread.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "base/time/default_tick_clock.h"
@@ -41,11 +42,13 @@ const int kNumTasks = 1000000;
 
 constexpr char kMetricPrefixSequenceManager[] = "SequenceManager.";
 constexpr char kMetricPostTimePerTask[] = "post_time_per_task";
+constexpr char kMetricAllocationsPerTask[] = "allocations_per_task";
 
 perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
   perf_test::PerfResultReporter reporter(kMetricPrefixSequenceManager,
                                          story_name);
   reporter.RegisterImportantMetric(kMetricPostTimePerTask, "us");
+  reporter.RegisterImportantMetric(kMetricAllocationsPerTask, "count");
   return reporter;
 }
 
@@ -583,16 +586,26 @@ class SequenceManagerPerfTest : public testing::TestWithParam<PerfTestType> {
   }
 
   void Benchmark(const std::string& story_prefix, TestCase* TestCase) {
+    absl::optional<test::AllocationCounter> allocation_counter;
+    if (test::AllocationCounter::IsSupported())
+      allocation_counter.emplace();
     TimeTicks start = TimeTicks::Now();
     TimeTicks now;
     TestCase->Start();
     delegate_->WaitUntilDone();
     now = TimeTicks::Now();
+    const size_t num_allocations =
+        allocation_counter ? allocation_counter->GetCount() : 0;
+    allocation_counter.reset();
 
     auto reporter = SetUpReporter(story_prefix + delegate_->GetName());
     reporter.AddResult(
         kMetricPostTimePerTask,
         (now - start).InMicroseconds() / static_cast<double>(kNumTasks));
+    if (test::AllocationCounter::IsSupported()) {
+      reporter.AddResult(kMetricAllocationsPerTask,
+                         num_allocations / static_cast<double>(kNumTasks));
+    }
   }
 
   std::unique_ptr<PerfTestDelegate> delegate_;
@@ -14,6 +14,7 @@
 #include "base/synchronization/waitable_event.h"
 #include "base/task/thread_pool.h"
 #include "base/task/thread_pool/thread_pool_instance.h"
+#include "base/test/allocation_counter.h"
 #include "base/threading/simple_thread.h"
 #include "base/time/time.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -29,6 +30,7 @@ constexpr char kMetricPrefixThreadPool[] = "ThreadPool.";
 constexpr char kMetricPostTaskThroughput[] = "post_task_throughput";
 constexpr char kMetricRunTaskThroughput[] = "run_task_throughput";
 constexpr char kMetricNumTasksPosted[] = "num_tasks_posted";
+constexpr char kMetricAllocationsPerTask[] = "allocations_per_task";
 constexpr char kStoryBindPostThenRunNoOp[] = "bind_post_then_run_noop_tasks";
 constexpr char kStoryPostThenRunNoOp[] = "post_then_run_noop_tasks";
 constexpr char kStoryPostThenRunNoOpManyThreads[] =
@@ -46,6 +48,7 @@ perf_test::PerfResultReporter SetUpReporter(const std::string& story_name) {
   reporter.RegisterImportantMetric(kMetricPostTaskThroughput, "runs/s");
   reporter.RegisterImportantMetric(kMetricRunTaskThroughput, "runs/s");
   reporter.RegisterImportantMetric(kMetricNumTasksPosted, "count");
+  reporter.RegisterImportantMetric(kMetricAllocationsPerTask, "count");
   return reporter;
 }
 
@@ -167,6 +170,11 @@ class ThreadPoolPerfTest : public testing::Test {
     if (execution_mode == ExecutionMode::kPostThenRun) {
       execution_fence.emplace();
     }
+    // Counts the allocations made to post and run the tasks, including those
+    // of posting threads and workers.
+    absl::optional<test::AllocationCounter> allocation_counter;
+    if (test::AllocationCounter::IsSupported())
+      allocation_counter.emplace();
     TimeTicks tasks_run_start = TimeTicks::Now();
     start_posting_tasks_.Signal();
     complete_posting_tasks_.Wait();
@@ -181,6 +189,9 @@ class ThreadPoolPerfTest : public testing::Test {
     ThreadPoolInstance::Get()->FlushForTesting();
     tasks_run_duration_ = TimeTicks::Now() - tasks_run_start;
     ASSERT_EQ(0U, num_tasks_pending_);
+    const size_t num_allocations =
+        allocation_counter ? allocation_counter->GetCount() : 0;
+    allocation_counter.reset();
 
     for (auto& thread : threads_)
       thread->Join();
@@ -196,6 +207,11 @@ class ThreadPoolPerfTest : public testing::Test {
         num_posted_tasks_ /
             static_cast<double>(tasks_run_duration_.InSecondsF()));
     reporter.AddResult(kMetricNumTasksPosted, num_posted_tasks_);
+    if (test::AllocationCounter::IsSupported()) {
+      reporter.AddResult(kMetricAllocationsPerTask,
+                         num_allocations /
+                             static_cast<double>(num_posted_tasks_));
+    }
   }
 
  private:
@@ -0,0 +1,186 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/test/allocation_counter.h"
+
+#include <atomic>
+
+#include "base/allocator/buildflags.h"
+#include "base/check.h"
+
+#if BUILDFLAG(USE_ALLOCATOR_SHIM)
+#include "base/allocator/allocator_shim.h"
+#endif
+
+namespace base {
+namespace test {
+
+namespace {
+
+std::atomic_bool g_counting{false};
+std::atomic_size_t g_count{0};
+
+#if BUILDFLAG(USE_ALLOCATOR_SHIM)
+
+using allocator::AllocatorDispatch;
+
+void Count(size_t num_allocations) {
+  if (g_counting.load(std::memory_order_relaxed))
+    g_count.fetch_add(num_allocations, std::memory_order_relaxed);
+}
+
+void* AllocFn(const AllocatorDispatch* self, size_t size, void* context) {
+  Count(1);
+  return self->next->alloc_function(self->next, size, context);
+}
+
+void* AllocUncheckedFn(const AllocatorDispatch* self,
+                       size_t size,
+                       void* context) {
+  Count(1);
+  return self->next->alloc_unchecked_function(self->next, size, context);
+}
+
+void* AllocZeroInitializedFn(const AllocatorDispatch* self,
+                             size_t n,
+                             size_t size,
+                             void* context) {
+  Count(1);
+  return self->next->alloc_zero_initialized_function(self->next, n, size,
+                                                      context);
+}
+
+void* AllocAlignedFn(const AllocatorDispatch* self,
+                     size_t alignment,
+                     size_t size,
+                     void* context) {
+  Count(1);
+  return self->next->alloc_aligned_function(self->next, alignment, size,
+                                             context);
+}
+
+void* ReallocFn(const AllocatorDispatch* self,
+                void* address,
+                size_t size,
+                void* context) {
+  Count(1);
+  return self->next->realloc_function(self->next, address, size, context);
+}
+
+void FreeFn(const AllocatorDispatch* self, void* address, void* context) {
+  self->next->free_function(self->next, address, context);
+}
+
+size_t GetSizeEstimateFn(const AllocatorDispatch* self,
+                         void* address,
+                         void* context) {
+  return self->next->get_size_estimate_function(self->next, address, context);
+}
+
+unsigned BatchMallocFn(const AllocatorDispatch* self,
+                       size_t size,
+                       void** results,
+                       unsigned num_requested,
+                       void* context) {
+  unsigned num_allocated = self->next->batch_malloc_function(
+      self->next, size, results, num_requested, context);
+  Count(num_allocated);
+  return num_allocated;
+}
+
+void BatchFreeFn(const AllocatorDispatch* self,
+                 void** to_be_freed,
+                 unsigned num_to_be_freed,
+                 void* context) {
+  self->next->batch_free_function(self->next, to_be_freed, num_to_be_freed,
+                                  context);
+}
+
+void FreeDefiniteSizeFn(const AllocatorDispatch* self,
+                        void* address,
+                        size_t size,
+                        void* context) {
+  self->next->free_definite_size_function(self->next, address, size, context);
+}
+
+void* AlignedMallocFn(const AllocatorDispatch* self,
+                      size_t size,
+                      size_t alignment,
+                      void* context) {
+  Count(1);
+  return self->next->aligned_malloc_function(self->next, size, alignment,
+                                             context);
+}
+
+void* AlignedReallocFn(const AllocatorDispatch* self,
+                       void* address,
+                       size_t size,
+                       size_t alignment,
+                       void* context) {
+  Count(1);
+  return self->next->aligned_realloc_function(self->next, address, size,
+                                              alignment, context);
+}
+
+void AlignedFreeFn(const AllocatorDispatch* self,
+                   void* address,
+                   void* context) {
+  self->next->aligned_free_function(self->next, address, context);
+}
+
+AllocatorDispatch g_allocator_dispatch = {&AllocFn,
+                                          &AllocUncheckedFn,
+                                          &AllocZeroInitializedFn,
+                                          &AllocAlignedFn,
+                                          &ReallocFn,
+                                          &FreeFn,
+                                          &GetSizeEstimateFn,
+                                          &BatchMallocFn,
+                                          &BatchFreeFn,
+                                          &FreeDefiniteSizeFn,
+                                          &AlignedMallocFn,
+                                          &AlignedReallocFn,
+                                          &AlignedFreeFn,
+                                          nullptr};
+
+bool g_dispatch_inserted = false;
+
+#endif  // BUILDFLAG(USE_ALLOCATOR_SHIM)
+
+}  // namespace
+
+// static
+bool AllocationCounter::IsSupported() {
+#if BUILDFLAG(USE_ALLOCATOR_SHIM)
+  return true;
+#else
+  return false;
+#endif
+}
+
+AllocationCounter::AllocationCounter() {
+#if BUILDFLAG(USE_ALLOCATOR_SHIM)
+  // The dispatch stays in the chain once inserted, since other threads may be
+  // in its functions at any time. It only counts while an AllocationCounter
+  // exists.
+  if (!g_dispatch_inserted) {
+    allocator::InsertAllocatorDispatch(&g_allocator_dispatch);
+    g_dispatch_inserted = true;
+  }
+#endif
+  g_count.store(0, std::memory_order_relaxed);
+  const bool was_counting = g_counting.exchange(true);
+  DCHECK(!was_counting);
+}
+
+AllocationCounter::~AllocationCounter() {
+  g_counting.store(false);
+}
+
+size_t AllocationCounter::GetCount() const {
+  return g_count.load(std::memory_order_relaxed);
+}
+
+}  // namespace test
+}  // namespace base
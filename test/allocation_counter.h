@@ -0,0 +1,36 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TEST_ALLOCATION_COUNTER_H_
+#define BASE_TEST_ALLOCATION_COUNTER_H_
+
+#include <stddef.h>
+
+namespace base {
+namespace test {
+
+// Counts the heap allocations that all threads make while it is alive, e.g. to
+// report the allocations per operation in a perf test. At most one
+// AllocationCounter may exist at a time.
+//
+// Allocations are seen through the allocator shim, so IsSupported() is false
+// and GetCount() always 0 in builds without it.
+class AllocationCounter {
+ public:
+  static bool IsSupported();
+
+  AllocationCounter();
+  AllocationCounter(const AllocationCounter&) = delete;
+  AllocationCounter& operator=(const AllocationCounter&) = delete;
+  ~AllocationCounter();
+
+  // Returns the number of allocations since this was created, including those
+  // that reallocations made.
+  size_t GetCount() const;
+};
+
+}  // namespace test
+}  // namespace base
+
+#endif  // BASE_TEST_ALLOCATION_COUNTER_H_
@@ -6,18 +6,28 @@
 
 #include "base/base_switches.h"
 #include "base/bind.h"
+#include "base/check_op.h"
 #include "base/command_line.h"
-#include "base/files/file_util.h"
 #include "base/memory/ref_counted_memory.h"
 #include "base/run_loop.h"
+#include "base/task/sequenced_task_runner.h"
+#include "base/task/thread_pool.h"
+#include "base/task/thread_pool/thread_pool_instance.h"
 #include "base/test/task_environment.h"
+#include "base/threading/thread_restrictions.h"
 #include "base/threading/thread_task_runner_handle.h"
-#include "base/trace_event/trace_buffer.h"
 #include "base/trace_event/trace_log.h"
 
 namespace base {
 namespace test {
 
+namespace {
+
+// Each fragment holds about 100 KiB of JSON.
+constexpr size_t kMaxPendingFragments = 4;
+
+}  // namespace
+
 TraceToFile::TraceToFile() : started_(false) {
 }
 
@@ -61,27 +71,67 @@ void TraceToFile::BeginTracing(const FilePath& path,
 }
 
 void TraceToFile::WriteFileHeader() {
-  WriteFile(path_, "{\"traceEvents\": [");
+  file_.Initialize(path_, File::FLAG_CREATE_ALWAYS | File::FLAG_WRITE);
+  DCHECK(file_.IsValid());
+  append_comma_ = false;
+  WriteToFile("{\"traceEvents\": [");
 }
 
 void TraceToFile::AppendFileFooter() {
-  const char str[] = "]}";
-  AppendToFile(path_, str);
-}
-
-void TraceToFile::TraceOutputCallback(const std::string& data) {
-  bool ret = AppendToFile(path_, data);
-  DCHECK(ret);
+  WriteToFile("]}");
+  file_.Close();
 }
 
-static void OnTraceDataCollected(
-    OnceClosure quit_closure,
-    trace_event::TraceResultBuffer* buffer,
+void TraceToFile::OnTraceDataCollected(
+    const RepeatingClosure& quit_closure,
     const scoped_refptr<RefCountedString>& json_events_str,
     bool has_more_events) {
-  buffer->AddFragment(json_events_str->data());
+  if (!write_task_runner_) {
+    WriteFragment(json_events_str->data());
+    if (!has_more_events)
+      quit_closure.Run();
+    return;
+  }
+
+  {
+    AutoLock lock(lock_);
+    ScopedAllowBaseSyncPrimitivesForTesting allow_wait;
+    while (num_pending_fragments_ == kMaxPendingFragments)
+      fragment_written_.Wait();
+    ++num_pending_fragments_;
+  }
+  write_task_runner_->PostTask(
+      FROM_HERE, BindOnce(&TraceToFile::WritePendingFragment, Unretained(this),
+                          json_events_str));
+  // Quits once every fragment before it has been written.
   if (!has_more_events)
-    std::move(quit_closure).Run();
+    write_task_runner_->PostTask(FROM_HERE, quit_closure);
+}
+
+void TraceToFile::WritePendingFragment(
+    scoped_refptr<RefCountedString> fragment) {
+  DCHECK(write_task_runner_->RunsTasksInCurrentSequence());
+  WriteFragment(fragment->data());
+  AutoLock lock(lock_);
+  DCHECK_GT(num_pending_fragments_, 0u);
+  --num_pending_fragments_;
+  fragment_written_.Signal();
+}
+
+void TraceToFile::WriteFragment(const std::string& fragment) {
+  if (fragment.empty())
+    return;
+  if (append_comma_)
+    WriteToFile(",");
+  append_comma_ = true;
+  WriteToFile(fragment);
+}
+
+void TraceToFile::WriteToFile(const std::string& data) {
+  if (!file_.IsValid())
+    return;
+  int ret = file_.WriteAtCurrentPos(data.data(), static_cast<int>(data.size()));
+  DCHECK_EQ(static_cast<int>(data.size()), ret);
 }
 
 void TraceToFile::EndTracingIfNeeded() {
@@ -91,19 +141,28 @@ void TraceToFile::EndTracingIfNeeded() {
 
   trace_event::TraceLog::GetInstance()->SetDisabled();
 
-  trace_event::TraceResultBuffer buffer;
-  buffer.SetOutputCallback(
-      BindRepeating(&TraceToFile::TraceOutputCallback, Unretained(this)));
-
-  // In tests we might not have a TaskEnvironment, create one if needed.
-  std::unique_ptr<SingleThreadTaskEnvironment> task_environment;
-  if (!ThreadTaskRunnerHandle::IsSet())
-    task_environment = std::make_unique<SingleThreadTaskEnvironment>();
+  // In tests we might not have a TaskEnvironment, create one if needed. The
+  // fragments are converted and written on the thread pool when there is one.
+  std::unique_ptr<TaskEnvironment> task_environment;
+  if (!ThreadTaskRunnerHandle::IsSet()) {
+    if (ThreadPoolInstance::Get())
+      task_environment = std::make_unique<SingleThreadTaskEnvironment>();
+    else
+      task_environment = std::make_unique<TaskEnvironment>();
+  }
+  const bool use_worker_thread = ThreadPoolInstance::Get() != nullptr;
+  if (use_worker_thread) {
+    write_task_runner_ = ThreadPool::CreateSequencedTaskRunner(
+        {MayBlock(), TaskPriority::USER_BLOCKING});
+  }
 
   RunLoop run_loop;
-  trace_event::TraceLog::GetInstance()->Flush(BindRepeating(
-      &OnTraceDataCollected, run_loop.QuitClosure(), Unretained(&buffer)));
+  trace_event::TraceLog::GetInstance()->Flush(
+      BindRepeating(&TraceToFile::OnTraceDataCollected, Unretained(this),
+                    run_loop.QuitClosure()),
+      use_worker_thread);
   run_loop.Run();
+  write_task_runner_ = nullptr;
 
   AppendFileFooter();
 }
@@ -5,9 +5,23 @@
 #ifndef BASE_TEST_TRACE_TO_FILE_H_
 #define BASE_TEST_TRACE_TO_FILE_H_
 
+#include <stddef.h>
+
+#include <string>
+
+#include "base/callback_forward.h"
+#include "base/files/file.h"
 #include "base/files/file_path.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_annotations.h"
 
 namespace base {
+
+class RefCountedString;
+class SequencedTaskRunner;
+
 namespace test {
 
 class TraceToFile {
@@ -23,10 +37,35 @@ class TraceToFile {
   void WriteFileHeader();
   void AppendFileFooter();
 
-  void TraceOutputCallback(const std::string& data);
+  // Receives the JSON fragments produced by TraceLog::Flush(), on the thread
+  // pool when there is one. Blocks while |kMaxPendingFragments| fragments are
+  // waiting to be written.
+  void OnTraceDataCollected(
+      const base::RepeatingClosure& quit_closure,
+      const scoped_refptr<base::RefCountedString>& json_events_str,
+      bool has_more_events);
+  // Runs on |write_task_runner_|.
+  void WritePendingFragment(scoped_refptr<base::RefCountedString> fragment);
+  void WriteFragment(const std::string& fragment);
+  void WriteToFile(const std::string& data);
 
   base::FilePath path_;
+  base::File file_;
   bool started_;
+  // Whether a fragment has been written since the file header.
+  bool append_comma_ = false;
+
+  // Sequence that writes the fragments while the flush converts the next ones,
+  // or null if there is no thread pool, in which case the fragments are
+  // written by the flushing thread.
+  scoped_refptr<base::SequencedTaskRunner> write_task_runner_;
+
+  // Number of fragments posted to |write_task_runner_| and not yet written.
+  // This bounds the memory held by a flush when the disk is slower than the
+  // JSON conversion.
+  base::Lock lock_;
+  base::ConditionVariable fragment_written_{&lock_};
+  size_t num_pending_fragments_ GUARDED_BY(lock_) = 0;
 };
 
 }  // namespace test
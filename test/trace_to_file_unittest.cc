@@ -0,0 +1,85 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/test/trace_to_file.h"
+
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/json/json_reader.h"
+#include "base/test/task_environment.h"
+#include "base/trace_event/trace_event.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+namespace base {
+namespace test {
+
+namespace {
+
+// Enough events for the flush to produce a few dozen 100 KiB fragments, more
+// than TraceToFile lets wait for the writer at once.
+constexpr int kNumEvents = 20000;
+
+void TraceEventsToFile(const FilePath& path) {
+  TraceToFile trace_to_file;
+  trace_to_file.BeginTracing(path, "test_category");
+  for (int i = 0; i < kNumEvents; ++i) {
+    TRACE_EVENT_INSTANT1("test_category", "TraceToFileEvent",
+                         TRACE_EVENT_SCOPE_THREAD, "index", i);
+  }
+  trace_to_file.EndTracingIfNeeded();
+}
+
+// Checks that |path| holds valid JSON with every event, in order.
+void ExpectCompleteTrace(const FilePath& path) {
+  std::string contents;
+  ASSERT_TRUE(ReadFileToString(path, &contents));
+  EXPECT_GT(contents.size(), 10u * 100 * 1024);
+
+  absl::optional<Value> trace = JSONReader::Read(contents);
+  ASSERT_TRUE(trace);
+  const Value* events = trace->FindListKey("traceEvents");
+  ASSERT_TRUE(events);
+
+  int next_index = 0;
+  for (const Value& event : events->GetList()) {
+    const std::string* name = event.FindStringKey("name");
+    if (!name || *name != "TraceToFileEvent")
+      continue;
+    absl::optional<int> index = event.FindIntPath("args.index");
+    ASSERT_TRUE(index);
+    EXPECT_EQ(next_index, *index);
+    next_index = *index + 1;
+  }
+  EXPECT_EQ(kNumEvents, next_index);
+}
+
+}  // namespace
+
+TEST(TraceToFileTest, WritesOnThreadPool) {
+  TaskEnvironment task_environment;
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const FilePath path = temp_dir.GetPath().AppendASCII("trace.json");
+
+  TraceEventsToFile(path);
+  ExpectCompleteTrace(path);
+}
+
+TEST(TraceToFileTest, WritesWithoutThreadPool) {
+  SingleThreadTaskEnvironment task_environment;
+  ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+  const FilePath path = temp_dir.GetPath().AppendASCII("trace.json");
+
+  TraceEventsToFile(path);
+  ExpectCompleteTrace(path);
+}
+
+}  // namespace test
+}  // namespace base
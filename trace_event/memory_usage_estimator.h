@@ -22,7 +22,11 @@
 #include <vector>
 
 #include "base/base_export.h"
+#include "base/containers/btree_map.h"
+#include "base/containers/btree_set.h"
 #include "base/containers/circular_deque.h"
+#include "base/containers/flat_hash_map.h"
+#include "base/containers/flat_hash_set.h"
 #include "base/containers/flat_map.h"
 #include "base/containers/flat_set.h"
 #include "base/containers/linked_list.h"
@@ -177,6 +181,18 @@ size_t EstimateMemoryUsage(const base::flat_set<T, C>& set);
 template <class K, class V, class C>
 size_t EstimateMemoryUsage(const base::flat_map<K, V, C>& map);
 
+template <class T, class H, class KE>
+size_t EstimateMemoryUsage(const base::FlatHashSet<T, H, KE>& set);
+
+template <class K, class V, class H, class KE>
+size_t EstimateMemoryUsage(const base::FlatHashMap<K, V, H, KE>& map);
+
+template <class T, class C>
+size_t EstimateMemoryUsage(const base::btree_set<T, C>& set);
+
+template <class K, class V, class C>
+size_t EstimateMemoryUsage(const base::btree_map<K, V, C>& map);
+
 template <class Key,
           class Payload,
           class HashOrComp,
@@ -506,6 +522,18 @@ size_t HashMapBucketCountForTesting(size_t bucket_count) {
   return bucket_count;
 }
 
+// The table has a slot and a control byte per slot, and a group of control
+// bytes past the end that are copies of the first ones.
+template <class Table>
+size_t DoEstimateMemoryUsageForFlatHashTable(const Table& table) {
+  using value_type = typename Table::value_type;
+  if (!table.capacity())
+    return 0;
+  return (sizeof(value_type) + 1) * table.capacity() +
+         base::internal::FlatHashGroup::kWidth +
+         EstimateIterableMemoryUsage(table);
+}
+
 template <class MruCacheType>
 size_t DoEstimateMemoryUsageForMruCache(const MruCacheType& mru_cache) {
   return EstimateMemoryUsage(mru_cache.ordering_) +
@@ -650,6 +678,28 @@ size_t EstimateMemoryUsage(const base::flat_map<K, V, C>& map) {
   return sizeof(value_type) * map.capacity() + EstimateIterableMemoryUsage(map);
 }
 
+template <class T, class H, class KE>
+size_t EstimateMemoryUsage(const base::FlatHashSet<T, H, KE>& set) {
+  return internal::DoEstimateMemoryUsageForFlatHashTable(set);
+}
+
+template <class K, class V, class H, class KE>
+size_t EstimateMemoryUsage(const base::FlatHashMap<K, V, H, KE>& map) {
+  return internal::DoEstimateMemoryUsageForFlatHashTable(map);
+}
+
+// B-tree containers
+
+template <class T, class C>
+size_t EstimateMemoryUsage(const base::btree_set<T, C>& set) {
+  return set.bytes_used() + EstimateIterableMemoryUsage(set);
+}
+
+template <class K, class V, class C>
+size_t EstimateMemoryUsage(const base::btree_map<K, V, C>& map) {
+  return map.bytes_used() + EstimateIterableMemoryUsage(map);
+}
+
 template <class Key,
           class Payload,
           class HashOrComp,
@@ -226,6 +226,56 @@ TEST(EstimateMemoryUsageTest, UnorderedMultiMap) {
   EXPECT_EQ_32_64(515540u, 531580u, EstimateMemoryUsage(map));
 }
 
+TEST(EstimateMemoryUsageTest, FlatHashSet) {
+  FlatHashSet<Data, Data::Hasher> set;
+  EXPECT_EQ(0u, EstimateMemoryUsage(set));
+  for (int i = 0; i != 1000; ++i) {
+    set.insert(Data(i));
+  }
+  // The items, plus a slot and a control byte per slot, plus at most a group
+  // of control bytes.
+  const size_t min_expected_usage =
+      499500u + set.capacity() * (sizeof(Data) + 1);
+  EXPECT_LE(min_expected_usage, EstimateMemoryUsage(set));
+  EXPECT_GE(min_expected_usage + 16, EstimateMemoryUsage(set));
+}
+
+TEST(EstimateMemoryUsageTest, FlatHashMap) {
+  FlatHashMap<Data, short, Data::Hasher> map;
+  for (int i = 0; i != 1000; ++i) {
+    map.insert({Data(i), static_cast<short>(i)});
+  }
+  const size_t min_expected_usage =
+      499500u + map.capacity() * (sizeof(std::pair<Data, short>) + 1);
+  EXPECT_LE(min_expected_usage, EstimateMemoryUsage(map));
+  EXPECT_GE(min_expected_usage + 16, EstimateMemoryUsage(map));
+}
+
+TEST(EstimateMemoryUsageTest, BTreeSet) {
+  btree_set<Data> set;
+  EXPECT_EQ(0u, EstimateMemoryUsage(set));
+  for (int i = 0; i != 1000; ++i) {
+    set.insert(Data(i));
+  }
+  // The items, plus the nodes, which are at least half full.
+  const size_t min_expected_usage = 499500u + set.size() * sizeof(Data);
+  EXPECT_LE(min_expected_usage, EstimateMemoryUsage(set));
+  EXPECT_GE(499500u + 3 * set.size() * sizeof(Data),
+            EstimateMemoryUsage(set));
+}
+
+TEST(EstimateMemoryUsageTest, BTreeMap) {
+  btree_map<Data, short> map;
+  for (int i = 0; i != 1000; ++i) {
+    map.insert({Data(i), static_cast<short>(i)});
+  }
+  const size_t min_expected_usage =
+      499500u + map.size() * sizeof(std::pair<Data, short>);
+  EXPECT_LE(min_expected_usage, EstimateMemoryUsage(map));
+  EXPECT_GE(499500u + 3 * map.size() * sizeof(std::pair<Data, short>),
+            EstimateMemoryUsage(map));
+}
+
 TEST(EstimateMemoryUsageTest, Deque) {
   std::deque<Data> deque;
 
@@ -0,0 +1,244 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/thread_perf_counters.h"
+
+#include <algorithm>
+#include <memory>
+
+#include "base/base_switches.h"
+#include "base/check_op.h"
+#include "base/command_line.h"
+#include "base/logging.h"
+#include "base/no_destructor.h"
+#include "base/threading/thread_local_storage.h"
+#include "base/trace_event/traced_value.h"
+#include "build/build_config.h"
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS)
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+
+// Order in which the hardware counters are opened, which is also the order in
+// which the kernel reports them when the group is read.
+enum CounterIndex {
+  kCycles,
+  kInstructions,
+  kCacheMisses,
+  kBranchMisses,
+  kNumHardwareCounters,
+};
+
+// The file descriptors of the counters of a thread. The hardware counters are
+// all -1 if they can't be used on the thread.
+struct CounterGroup {
+  ~CounterGroup() {
+    CloseHardwareCounters();
+    if (context_switches_fd >= 0)
+      close(context_switches_fd);
+  }
+
+  void CloseHardwareCounters() {
+    for (int& fd : fds) {
+      if (fd >= 0)
+        close(fd);
+      fd = -1;
+    }
+  }
+
+  bool is_valid() const { return fds[kCycles] >= 0; }
+
+  // The first counter is the group leader, which is used to read all of them
+  // at once.
+  int fds[kNumHardwareCounters] = {-1, -1, -1, -1};
+  // Counts kernel events, so it is in a group of its own: opening it fails
+  // under perf_event_paranoid >= 2, which mustn't disable the other counters.
+  int context_switches_fd = -1;
+};
+
+ThreadLocalStorage::Slot& CounterGroupSlot() {
+  static NoDestructor<ThreadLocalStorage::Slot> group_slot(
+      [](void* group) { delete static_cast<CounterGroup*>(group); });
+  return *group_slot;
+}
+
+int PerfEventOpen(struct perf_event_attr* attr, int group_fd) {
+  return syscall(__NR_perf_event_open, attr, /* pid */ 0, /* cpu */ -1,
+                 group_fd, /* flags */ 0);
+}
+
+ThreadPerfCounters::PerfEventOpenFunction g_perf_event_open = &PerfEventOpen;
+
+// Opens a counter of the calling thread, in the group led by |group_fd|, or
+// as the leader of a new group if it is -1.
+int OpenCounter(uint32_t type,
+                uint64_t config,
+                int group_fd,
+                bool count_kernel_events) {
+  struct perf_event_attr pe = {0};
+  pe.type = type;
+  pe.size = sizeof(struct perf_event_attr);
+  pe.config = config;
+  pe.exclude_kernel = !count_kernel_events;
+  pe.exclude_hv = 1;
+  if (group_fd < 0)
+    pe.read_format = PERF_FORMAT_GROUP;
+  return g_perf_event_open(&pe, group_fd);
+}
+
+// Opens the counters for the calling thread. The returned group is invalid if
+// performance counters are disabled in the calling process or opening any of
+// the hardware counters failed, so that opening them isn't retried.
+std::unique_ptr<CounterGroup> OpenCounterGroupForCurrentThread() {
+  auto group = std::make_unique<CounterGroup>();
+
+  // This switch is only propagated for processes that are unaffected by the
+  // BPF sandbox, such as the browser process or renderers with --no-sandbox.
+  const base::CommandLine& command_line =
+      *base::CommandLine::ForCurrentProcess();
+  if (!command_line.HasSwitch(switches::kEnableThreadPerfCounters))
+    return group;
+
+  static constexpr uint64_t kHardwareCounters[kNumHardwareCounters] = {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES,
+  };
+  for (int i = 0; i < kNumHardwareCounters; ++i) {
+    group->fds[i] =
+        OpenCounter(PERF_TYPE_HARDWARE, kHardwareCounters[i],
+                    group->fds[kCycles], /*count_kernel_events=*/false);
+    if (group->fds[i] < 0) {
+      LOG(ERROR) << "perf_event_open failed, omitting perf counters";
+      group->CloseHardwareCounters();
+      return group;
+    }
+  }
+
+  group->context_switches_fd =
+      OpenCounter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES,
+                  /*group_fd=*/-1, /*count_kernel_events=*/true);
+  return group;
+}
+
+// Retrieves the counter group for the current thread, performing
+// lazy-initialization if necessary.
+CounterGroup* CounterGroupForCurrentThread() {
+  auto& slot = CounterGroupSlot();
+  auto* group = static_cast<CounterGroup*>(slot.Get());
+  if (!group) {
+    group = OpenCounterGroupForCurrentThread().release();
+    slot.Set(group);
+  }
+  return group;
+}
+
+// Reads the |num_counters| counters of the group led by |fd| into |values|.
+bool ReadGroup(int fd, size_t num_counters, uint64_t* values) {
+  // Layout of a read() from a group leader opened with PERF_FORMAT_GROUP.
+  uint64_t data[1 + kNumHardwareCounters];
+  DCHECK_LE(num_counters, static_cast<size_t>(kNumHardwareCounters));
+  const ssize_t size = (1 + num_counters) * sizeof(uint64_t);
+  if (read(fd, data, size) != size || data[0] != num_counters)
+    return false;
+  std::copy(data + 1, data + 1 + num_counters, values);
+  return true;
+}
+
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS)
+
+}  // namespace
+
+ThreadPerfCounterValues::ThreadPerfCounterValues() = default;
+
+ThreadPerfCounterValues::ThreadPerfCounterValues(
+    const ThreadPerfCounterValues& other) = default;
+
+ThreadPerfCounterValues& ThreadPerfCounterValues::operator=(
+    const ThreadPerfCounterValues& other) = default;
+
+ThreadPerfCounterValues::~ThreadPerfCounterValues() = default;
+
+ThreadPerfCounterValues ThreadPerfCounterValues::operator-(
+    const ThreadPerfCounterValues& other) const {
+  ThreadPerfCounterValues delta;
+  delta.cycles = cycles - other.cycles;
+  delta.instructions = instructions - other.instructions;
+  delta.cache_misses = cache_misses - other.cache_misses;
+  delta.branch_misses = branch_misses - other.branch_misses;
+  if (context_switches && other.context_switches)
+    delta.context_switches = *context_switches - *other.context_switches;
+  return delta;
+}
+
+void ThreadPerfCounterValues::AsValueInto(TracedValue* value) const {
+  // TracedValue integers are 32-bit, which a long task can exceed in cycles.
+  value->SetDouble("cycles", cycles);
+  value->SetDouble("instructions", instructions);
+  value->SetDouble("cache_misses", cache_misses);
+  value->SetDouble("branch_misses", branch_misses);
+  if (context_switches)
+    value->SetDouble("context_switches", *context_switches);
+}
+
+// static
+bool ThreadPerfCounters::IsSupported() {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  return CounterGroupForCurrentThread()->is_valid();
+#else
+  return false;
+#endif
+}
+
+// static
+bool ThreadPerfCounters::Now(ThreadPerfCounterValues* values) {
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  CounterGroup* group = CounterGroupForCurrentThread();
+  if (!group->is_valid())
+    return false;
+
+  uint64_t counters[kNumHardwareCounters];
+  if (!ReadGroup(group->fds[kCycles], kNumHardwareCounters, counters))
+    return false;
+  values->cycles = counters[kCycles];
+  values->instructions = counters[kInstructions];
+  values->cache_misses = counters[kCacheMisses];
+  values->branch_misses = counters[kBranchMisses];
+
+  uint64_t context_switches;
+  if (group->context_switches_fd >= 0 &&
+      ReadGroup(group->context_switches_fd, 1, &context_switches)) {
+    values->context_switches = context_switches;
+  } else {
+    values->context_switches = absl::nullopt;
+  }
+  return true;
+#else
+  return false;
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS)
+}
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+// static
+void ThreadPerfCounters::SetPerfEventOpenFunctionForTesting(
+    PerfEventOpenFunction perf_event_open) {
+  g_perf_event_open = perf_event_open ? perf_event_open : &PerfEventOpen;
+  auto& slot = CounterGroupSlot();
+  delete static_cast<CounterGroup*>(slot.Get());
+  slot.Set(nullptr);
+}
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS)
+
+}  // namespace trace_event
+}  // namespace base
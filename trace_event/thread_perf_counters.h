@@ -0,0 +1,77 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef BASE_TRACE_EVENT_THREAD_PERF_COUNTERS_H_
+#define BASE_TRACE_EVENT_THREAD_PERF_COUNTERS_H_
+
+#include <stdint.h>
+
+#include "base/base_export.h"
+#include "build/build_config.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+struct perf_event_attr;
+#endif
+
+namespace base {
+namespace trace_event {
+
+class TracedValue;
+
+// A snapshot of the current thread's hardware performance counters. Values
+// are relative to some epoch, so only the difference between two snapshots
+// taken on the same thread is meaningful.
+struct BASE_EXPORT ThreadPerfCounterValues {
+  ThreadPerfCounterValues();
+  ThreadPerfCounterValues(const ThreadPerfCounterValues& other);
+  ThreadPerfCounterValues& operator=(const ThreadPerfCounterValues& other);
+  ~ThreadPerfCounterValues();
+
+  ThreadPerfCounterValues operator-(const ThreadPerfCounterValues& other) const;
+
+  // Writes the counters into |value|, omitting the unavailable ones.
+  void AsValueInto(TracedValue* value) const;
+
+  int64_t cycles = 0;
+  int64_t instructions = 0;
+  int64_t cache_misses = 0;
+  int64_t branch_misses = 0;
+  // Context switches happen in the kernel, so they are only counted if the
+  // process may count kernel events, which perf_event_paranoid >= 2 forbids.
+  absl::optional<int64_t> context_switches;
+};
+
+// Uses a group of the system's performance counters to measure cycles,
+// retired instructions, cache misses and branch misses of the current thread
+// in user space, and a separate counter for its context switches. All
+// counters of the group are read atomically. Only supported on Linux when
+// --enable-thread-perf-counters is passed, as it requires the BPF sandbox to
+// be disabled.
+class BASE_EXPORT ThreadPerfCounters {
+ public:
+  ThreadPerfCounters() = delete;
+
+  // Returns true if the counter group can be used on the current thread.
+  static bool IsSupported();
+
+  // Reads the counters of the current thread into |values|. Returns false if
+  // reading them failed or they are not supported.
+  static bool Now(ThreadPerfCounterValues* values);
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+  // Replaces the perf_event_open() system call for the counters opened after
+  // this call, and forgets the current thread's counters so that they are
+  // reopened. Null restores the system call.
+  using PerfEventOpenFunction = int (*)(struct perf_event_attr* attr,
+                                        int group_fd);
+  static void SetPerfEventOpenFunctionForTesting(
+      PerfEventOpenFunction perf_event_open);
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS)
+};
+
+}  // namespace trace_event
+}  // namespace base
+
+#endif  // BASE_TRACE_EVENT_THREAD_PERF_COUNTERS_H_
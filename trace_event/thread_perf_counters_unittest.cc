@@ -0,0 +1,187 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/trace_event/thread_perf_counters.h"
+
+#include <stdint.h>
+
+#include <memory>
+
+#include "base/trace_event/traced_value.h"
+#include "base/values.h"
+#include "build/build_config.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "base/base_switches.h"
+#include "base/command_line.h"
+#include "base/test/scoped_command_line.h"
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS)
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+ThreadPerfCounterValues MakeValues(int64_t base) {
+  ThreadPerfCounterValues values;
+  values.cycles = base + 1;
+  values.instructions = base + 2;
+  values.cache_misses = base + 3;
+  values.branch_misses = base + 4;
+  return values;
+}
+
+}  // namespace
+
+TEST(ThreadPerfCountersTest, Delta) {
+  ThreadPerfCounterValues before = MakeValues(10);
+  ThreadPerfCounterValues after = MakeValues(5000000000);
+  ThreadPerfCounterValues delta = after - before;
+  EXPECT_EQ(4999999990, delta.cycles);
+  EXPECT_EQ(4999999990, delta.instructions);
+  EXPECT_EQ(4999999990, delta.cache_misses);
+  EXPECT_EQ(4999999990, delta.branch_misses);
+  EXPECT_FALSE(delta.context_switches);
+
+  before.context_switches = 3;
+  EXPECT_FALSE((after - before).context_switches);
+  after.context_switches = 5;
+  EXPECT_EQ(2, (after - before).context_switches);
+}
+
+TEST(ThreadPerfCountersTest, AsValueInto) {
+  // Cycles don't fit in the 32-bit integers of TracedValue.
+  ThreadPerfCounterValues values = MakeValues(5000000000);
+  {
+    TracedValueJSON value;
+    values.AsValueInto(&value);
+    std::unique_ptr<Value> dict = value.ToBaseValue();
+    EXPECT_EQ(5000000001.0, dict->FindDoubleKey("cycles"));
+    EXPECT_EQ(5000000002.0, dict->FindDoubleKey("instructions"));
+    EXPECT_EQ(5000000003.0, dict->FindDoubleKey("cache_misses"));
+    EXPECT_EQ(5000000004.0, dict->FindDoubleKey("branch_misses"));
+    EXPECT_FALSE(dict->FindKey("context_switches"));
+  }
+
+  values.context_switches = 7;
+  {
+    TracedValueJSON value;
+    values.AsValueInto(&value);
+    EXPECT_EQ(7.0, value.ToBaseValue()->FindDoubleKey("context_switches"));
+  }
+}
+
+#if defined(OS_LINUX) || defined(OS_CHROMEOS)
+
+namespace {
+
+// The attributes of the counters opened by FakePerfEventOpen().
+std::vector<perf_event_attr>* g_opened_counters = nullptr;
+
+// Fails like perf_event_open() does without any access to the counters.
+int FailingPerfEventOpen(perf_event_attr* attr, int group_fd) {
+  g_opened_counters->push_back(*attr);
+  return -1;
+}
+
+// Fails like perf_event_open() does under perf_event_paranoid 2, which only
+// allows counting user space events. The returned file descriptors can't be
+// read as counters.
+int FakePerfEventOpen(perf_event_attr* attr, int group_fd) {
+  g_opened_counters->push_back(*attr);
+  if (!attr->exclude_kernel)
+    return -1;
+  return open("/dev/null", O_RDONLY);
+}
+
+class ThreadPerfCountersOpenTest : public testing::Test {
+ public:
+  ThreadPerfCountersOpenTest() {
+    g_opened_counters = &opened_counters_;
+    command_line_.GetProcessCommandLine()->AppendSwitch(
+        switches::kEnableThreadPerfCounters);
+  }
+
+  ~ThreadPerfCountersOpenTest() override {
+    ThreadPerfCounters::SetPerfEventOpenFunctionForTesting(nullptr);
+    g_opened_counters = nullptr;
+  }
+
+ protected:
+  std::vector<perf_event_attr> opened_counters_;
+
+ private:
+  test::ScopedCommandLine command_line_;
+};
+
+}  // namespace
+
+TEST_F(ThreadPerfCountersOpenTest, OpenFailure) {
+  ThreadPerfCounters::SetPerfEventOpenFunctionForTesting(
+      &FailingPerfEventOpen);
+  EXPECT_FALSE(ThreadPerfCounters::IsSupported());
+  ThreadPerfCounterValues values;
+  EXPECT_FALSE(ThreadPerfCounters::Now(&values));
+  // Opening isn't retried.
+  EXPECT_FALSE(ThreadPerfCounters::IsSupported());
+  EXPECT_EQ(1u, opened_counters_.size());
+}
+
+TEST_F(ThreadPerfCountersOpenTest, KernelEventsForbidden) {
+  ThreadPerfCounters::SetPerfEventOpenFunctionForTesting(&FakePerfEventOpen);
+  // Only the context switch counter counts kernel events, and failing to open
+  // it doesn't disable the others.
+  EXPECT_TRUE(ThreadPerfCounters::IsSupported());
+  ASSERT_EQ(5u, opened_counters_.size());
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(PERF_TYPE_HARDWARE, opened_counters_[i].type);
+    EXPECT_TRUE(opened_counters_[i].exclude_kernel);
+  }
+  EXPECT_EQ(PERF_TYPE_SOFTWARE, opened_counters_[4].type);
+  EXPECT_EQ(PERF_COUNT_SW_CONTEXT_SWITCHES, opened_counters_[4].config);
+  EXPECT_FALSE(opened_counters_[4].exclude_kernel);
+}
+
+TEST_F(ThreadPerfCountersOpenTest, NotEnabled) {
+  CommandLine::ForCurrentProcess()->RemoveSwitch(
+      switches::kEnableThreadPerfCounters);
+  ThreadPerfCounters::SetPerfEventOpenFunctionForTesting(&FakePerfEventOpen);
+  EXPECT_FALSE(ThreadPerfCounters::IsSupported());
+  EXPECT_TRUE(opened_counters_.empty());
+}
+
+TEST_F(ThreadPerfCountersOpenTest, BusyLoop) {
+  ThreadPerfCounters::SetPerfEventOpenFunctionForTesting(nullptr);
+  if (!ThreadPerfCounters::IsSupported())
+    GTEST_SKIP() << "perf_event_open() is unavailable";
+
+  ThreadPerfCounterValues before;
+  ASSERT_TRUE(ThreadPerfCounters::Now(&before));
+  constexpr int kIterations = 1000000;
+  volatile int sum = 0;
+  for (int i = 0; i < kIterations; ++i)
+    sum = sum + i;
+  ThreadPerfCounterValues after;
+  ASSERT_TRUE(ThreadPerfCounters::Now(&after));
+
+  const ThreadPerfCounterValues delta = after - before;
+  EXPECT_GT(delta.cycles, 0);
+  EXPECT_GE(delta.instructions, kIterations);
+  EXPECT_GE(delta.cache_misses, 0);
+  EXPECT_GE(delta.branch_misses, 0);
+  if (delta.context_switches)
+    EXPECT_GE(*delta.context_switches, 0);
+}
+
+#endif  // defined(OS_LINUX) || defined(OS_CHROMEOS)
+
+}  // namespace trace_event
+}  // namespace base
@@ -77,9 +77,20 @@ struct TraceCategory {
     *const_cast<volatile uint32_t*>(&enabled_filters_) = enabled_filters;
   }
 
+  // Zero when every event is recorded. Otherwise events that can be sampled
+  // are recorded with a probability of |sampling_threshold| / 2^32.
+  uint32_t sampling_threshold() const {
+    return *const_cast<volatile const uint32_t*>(&sampling_threshold_);
+  }
+
+  void set_sampling_threshold(uint32_t sampling_threshold) {
+    *const_cast<volatile uint32_t*>(&sampling_threshold_) = sampling_threshold;
+  }
+
   void reset_for_testing() {
     set_state(0);
     set_enabled_filters(0);
+    set_sampling_threshold(0);
   }
 
   // These fields should not be accessed directly, not even by tracing code.
@@ -101,6 +112,10 @@ struct TraceCategory {
 
   // TraceCategory group names are long lived static strings.
   const char* name_;
+
+  // See sampling_threshold() above. Derived from the sampling rate of the
+  // category in the current TraceConfig.
+  uint32_t sampling_threshold_;
 };
 
 }  // namespace trace_event
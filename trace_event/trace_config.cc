@@ -64,6 +64,8 @@ const char kIncludedProcessesParam[] = "included_process_ids";
 
 const char kHistogramNamesParam[] = "histogram_names";
 
+const char kCategorySamplingRatesParam[] = "category_sampling_rates";
+
 class ConvertableTraceConfigToTraceFormat
     : public base::trace_event::ConvertableToTraceFormat {
  public:
@@ -304,6 +306,7 @@ TraceConfig& TraceConfig::operator=(const TraceConfig& rhs) {
   event_filters_ = rhs.event_filters_;
   histogram_names_ = rhs.histogram_names_;
   systrace_events_ = rhs.systrace_events_;
+  category_sampling_rates_ = rhs.category_sampling_rates_;
   return *this;
 }
 
@@ -348,6 +351,13 @@ void TraceConfig::Merge(const TraceConfig& config) {
                         config.event_filters().end());
   histogram_names_.insert(config.histogram_names().begin(),
                           config.histogram_names().end());
+
+  // When both configs sample a category, keep the less aggressive rate.
+  for (const auto& it : config.category_sampling_rates()) {
+    auto inserted = category_sampling_rates_.insert(it);
+    if (!inserted.second)
+      inserted.first->second = std::max(inserted.first->second, it.second);
+  }
 }
 
 void TraceConfig::Clear() {
@@ -362,6 +372,7 @@ void TraceConfig::Clear() {
   event_filters_.clear();
   histogram_names_.clear();
   systrace_events_.clear();
+  category_sampling_rates_.clear();
 }
 
 void TraceConfig::InitializeDefault() {
@@ -403,6 +414,9 @@ void TraceConfig::InitializeFromConfigDict(const Value& dict) {
   const Value* histogram_names = dict.FindListKey(kHistogramNamesParam);
   if (histogram_names)
     SetHistogramNamesFromConfigList(*histogram_names);
+  const Value* sampling_rates = dict.FindDictKey(kCategorySamplingRatesParam);
+  if (sampling_rates)
+    SetCategorySamplingRatesFromConfigDict(*sampling_rates);
 
   if (category_filter_.IsCategoryEnabled(MemoryDumpManager::kTraceCategory)) {
     // If dump triggers not set, the client is using the legacy with just
@@ -571,6 +585,19 @@ void TraceConfig::SetHistogramNamesFromConfigList(
     histogram_names_.insert(value.GetString());
 }
 
+void TraceConfig::SetCategorySamplingRatesFromConfigDict(
+    const Value& sampling_rates) {
+  category_sampling_rates_.clear();
+  for (const auto item : sampling_rates.DictItems()) {
+    absl::optional<double> rate = item.second.GetIfDouble();
+    if (!rate || *rate <= 0 || *rate > 1) {
+      DLOG(ERROR) << "Invalid sampling rate for category " << item.first;
+      continue;
+    }
+    SetCategorySamplingRate(item.first, *rate);
+  }
+}
+
 void TraceConfig::SetEventFiltersFromConfigList(
     const Value& category_event_filters) {
   event_filters_.clear();
@@ -651,6 +678,13 @@ Value TraceConfig::ToValue() const {
     dict.SetKey(kMemoryDumpConfigParam, std::move(memory_dump_config));
   }
 
+  if (!category_sampling_rates_.empty()) {
+    Value sampling_rates(Value::Type::DICTIONARY);
+    for (const auto& it : category_sampling_rates_)
+      sampling_rates.SetDoubleKey(it.first, it.second);
+    dict.SetKey(kCategorySamplingRatesParam, std::move(sampling_rates));
+  }
+
   if (!histogram_names_.empty()) {
     std::vector<Value> histogram_names;
     for (const std::string& histogram_name : histogram_names_)
@@ -678,6 +712,34 @@ void TraceConfig::EnableHistogram(const std::string& histogram_name) {
   histogram_names_.insert(histogram_name);
 }
 
+void TraceConfig::SetCategorySamplingRate(const std::string& category,
+                                          double rate) {
+  DCHECK_GT(rate, 0);
+  DCHECK_LE(rate, 1);
+  if (rate >= 1)
+    category_sampling_rates_.erase(category);
+  else
+    category_sampling_rates_[category] = rate;
+}
+
+double TraceConfig::GetCategorySamplingRate(
+    StringPiece category_group_name) const {
+  if (category_sampling_rates_.empty())
+    return 1;
+  double rate = 0;
+  for (StringPiece category :
+       SplitStringPiece(category_group_name, ",", TRIM_WHITESPACE,
+                        SPLIT_WANT_NONEMPTY)) {
+    auto it = category_sampling_rates_.find(std::string(category));
+    // Events of a group are also events of each of its categories, so a
+    // single unsampled category is enough to keep all of them.
+    if (it == category_sampling_rates_.end())
+      return 1;
+    rate = std::max(rate, it->second);
+  }
+  return rate > 0 ? rate : 1;
+}
+
 std::string TraceConfig::ToTraceOptionsString() const {
   std::string ret;
   switch (record_mode_) {
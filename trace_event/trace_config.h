@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -204,6 +205,7 @@ class BASE_EXPORT TraceConfig {
   //                             "inc_pattern*",
   //                             "disabled-by-default-memory-infra"],
   //     "excluded_categories": ["excluded", "exc_pattern*"],
+  //     "category_sampling_rates": {"toplevel": 0.01},
   //     "memory_dump_config": {
   //       "triggers": [
   //         {
@@ -216,6 +218,9 @@ class BASE_EXPORT TraceConfig {
   //
   // Note: memory_dump_config can be specified only if
   // disabled-by-default-memory-infra category is enabled.
+  //
+  // category_sampling_rates maps category names to the fraction, in (0, 1),
+  // of their complete, instant and counter events that are recorded.
   explicit TraceConfig(StringPiece config_string);
 
   // Functionally identical to the above, but takes a parsed dictionary as input
@@ -246,6 +251,16 @@ class BASE_EXPORT TraceConfig {
   void EnableArgumentFilter() { enable_argument_filter_ = true; }
   void EnableHistogram(const std::string& histogram_name);
 
+  // Records only a |rate| fraction of the complete, instant and counter events
+  // of |category|. |rate| must be in (0, 1]. Ignored when events are recorded
+  // by the Perfetto client library (USE_PERFETTO_CLIENT_LIBRARY).
+  void SetCategorySamplingRate(const std::string& category, double rate);
+
+  // Returns the fraction of events of |category_group_name| that should be
+  // recorded. A group is only sampled if all of its categories are, in which
+  // case the highest of their rates is used. Returns 1 for unsampled groups.
+  double GetCategorySamplingRate(StringPiece category_group_name) const;
+
   // Writes the string representation of the TraceConfig. The string is JSON
   // formatted.
   std::string ToString() const;
@@ -300,6 +315,10 @@ class BASE_EXPORT TraceConfig {
     return histogram_names_;
   }
 
+  const std::map<std::string, double>& category_sampling_rates() const {
+    return category_sampling_rates_;
+  }
+
  private:
   FRIEND_TEST_ALL_PREFIXES(TraceConfigTest, TraceConfigFromValidLegacyFormat);
   FRIEND_TEST_ALL_PREFIXES(TraceConfigTest,
@@ -325,6 +344,7 @@ class BASE_EXPORT TraceConfig {
   void SetDefaultMemoryDumpConfig();
 
   void SetHistogramNamesFromConfigList(const Value& histogram_names);
+  void SetCategorySamplingRatesFromConfigDict(const Value& sampling_rates);
   void SetEventFiltersFromConfigList(const Value& event_filters);
   Value ToValue() const;
 
@@ -342,6 +362,7 @@ class BASE_EXPORT TraceConfig {
   EventFilters event_filters_;
   std::unordered_set<std::string> histogram_names_;
   std::unordered_set<std::string> systrace_events_;
+  std::map<std::string, double> category_sampling_rates_;
 };
 
 }  // namespace trace_event
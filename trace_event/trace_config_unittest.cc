@@ -696,5 +696,37 @@ TEST(TraceConfigTest, SystraceEventsSerialization) {
   EXPECT_TRUE(tc2.systrace_events().count("timer:tick_stop"));
 }
 
+TEST(TraceConfigTest, CategorySamplingRates) {
+  TraceConfig tc(
+      "{\"included_categories\":[\"*\"],"
+      "\"category_sampling_rates\":{\"toplevel\":0.25,\"cc\":0.5,"
+      "\"invalid\":2}}");
+  EXPECT_EQ(2U, tc.category_sampling_rates().size());
+  EXPECT_EQ(0.25, tc.GetCategorySamplingRate("toplevel"));
+  EXPECT_EQ(0.5, tc.GetCategorySamplingRate("cc"));
+  EXPECT_EQ(1, tc.GetCategorySamplingRate("invalid"));
+  EXPECT_EQ(1, tc.GetCategorySamplingRate("other"));
+  // A group is sampled at the highest rate of its categories, and not at all
+  // if one of them isn't sampled.
+  EXPECT_EQ(0.5, tc.GetCategorySamplingRate("toplevel,cc"));
+  EXPECT_EQ(1, tc.GetCategorySamplingRate("toplevel,other"));
+
+  const TraceConfig tc2(tc.ToString());
+  EXPECT_EQ(tc.category_sampling_rates(), tc2.category_sampling_rates());
+
+  TraceConfig tc3("*", "");
+  tc3.SetCategorySamplingRate("toplevel", 0.75);
+  tc3.SetCategorySamplingRate("gpu", 0.1);
+  tc.Merge(tc3);
+  EXPECT_EQ(0.75, tc.GetCategorySamplingRate("toplevel"));
+  EXPECT_EQ(0.5, tc.GetCategorySamplingRate("cc"));
+  EXPECT_EQ(0.1, tc.GetCategorySamplingRate("gpu"));
+
+  tc.SetCategorySamplingRate("gpu", 1);
+  EXPECT_EQ(1, tc.GetCategorySamplingRate("gpu"));
+  tc.Clear();
+  EXPECT_TRUE(tc.category_sampling_rates().empty());
+}
+
 }  // namespace trace_event
 }  // namespace base
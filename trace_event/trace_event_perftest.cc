@@ -0,0 +1,127 @@
+// Copyright 2021 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/simple_thread.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "base/trace_event/trace_event.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_result_reporter.h"
+
+namespace base {
+namespace trace_event {
+
+namespace {
+
+constexpr char kMetricPrefix[] = "TraceEvent.";
+constexpr char kMetricTimePerEvent[] = "time_per_event";
+constexpr int kNumEvents = 1000000;
+constexpr int kNumThreads = 4;
+
+void EmitEvents(int count) {
+  for (int i = 0; i < count; ++i)
+    TRACE_EVENT0("perftest", "TraceEventPerfTest");
+}
+
+void ReportTimePerEvent(const std::string& story, TimeDelta elapsed) {
+  perf_test::PerfResultReporter reporter(kMetricPrefix, story);
+  reporter.RegisterImportantMetric(kMetricTimePerEvent, "ns");
+  reporter.AddResult(kMetricTimePerEvent,
+                     elapsed.InNanosecondsF() / kNumEvents);
+}
+
+// A thread without a message loop, which therefore records into the buffer
+// shared by all such threads.
+class EmittingThread : public SimpleThread {
+ public:
+  explicit EmittingThread(WaitableEvent* start_event)
+      : SimpleThread("EmittingThread"), start_event_(start_event) {}
+  EmittingThread(const EmittingThread&) = delete;
+  EmittingThread& operator=(const EmittingThread&) = delete;
+
+  void Run() override {
+    start_event_->Wait();
+    EmitEvents(kNumEvents);
+  }
+
+ private:
+  WaitableEvent* const start_event_;
+};
+
+class TraceEventPerfTest : public testing::Test {
+ public:
+  void SetUp() override {
+    // Record continuously so that the buffer never fills up and disables
+    // recording half-way through a measurement.
+    TraceLog::GetInstance()->SetEnabled(
+        TraceConfig("perftest", "record-continuously"),
+        TraceLog::RECORDING_MODE);
+  }
+
+  void TearDown() override {
+    TraceLog::GetInstance()->SetDisabled();
+    TraceLog::ResetForTesting();
+  }
+};
+
+}  // namespace
+
+TEST_F(TraceEventPerfTest, Disabled) {
+  TraceLog::GetInstance()->SetDisabled();
+  TimeTicks start = TimeTicks::Now();
+  EmitEvents(kNumEvents);
+  ReportTimePerEvent("disabled", TimeTicks::Now() - start);
+}
+
+TEST_F(TraceEventPerfTest, ThreadWithoutMessageLoop) {
+  TimeTicks start = TimeTicks::Now();
+  EmitEvents(kNumEvents);
+  ReportTimePerEvent("thread_without_message_loop", TimeTicks::Now() - start);
+}
+
+TEST_F(TraceEventPerfTest, ThreadWithMessageLoop) {
+  Thread thread("TraceEventPerfTest");
+  ASSERT_TRUE(thread.Start());
+  TimeDelta elapsed;
+  WaitableEvent done;
+  thread.task_runner()->PostTask(
+      FROM_HERE, BindOnce(
+                     [](TimeDelta* elapsed, WaitableEvent* done) {
+                       TimeTicks start = TimeTicks::Now();
+                       EmitEvents(kNumEvents);
+                       *elapsed = TimeTicks::Now() - start;
+                       done->Signal();
+                     },
+                     &elapsed, &done));
+  done.Wait();
+  thread.Stop();
+  ReportTimePerEvent("thread_with_message_loop", elapsed);
+}
+
+TEST_F(TraceEventPerfTest, ContendedThreadsWithoutMessageLoop) {
+  WaitableEvent start_event;
+  std::vector<std::unique_ptr<EmittingThread>> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.push_back(std::make_unique<EmittingThread>(&start_event));
+    threads.back()->Start();
+  }
+
+  TimeTicks start = TimeTicks::Now();
+  start_event.Signal();
+  for (auto& thread : threads)
+    thread->Join();
+  // Report the wall time per event on one thread while the others compete
+  // for the same buffer.
+  ReportTimePerEvent("4_contended_threads_without_message_loop",
+                     TimeTicks::Now() - start);
+}
+
+}  // namespace trace_event
+}  // namespace base
@@ -897,6 +897,32 @@ TEST_F(TraceEventTestFixture, DataDiscarded) {
   EXPECT_TRUE(trace_parsed_.GetList().empty());
 }
 
+#if !BUILDFLAG(USE_PERFETTO_CLIENT_LIBRARY)
+TEST_F(TraceEventTestFixture, SampledCategory) {
+  TraceConfig trace_config(kRecordAllCategoryFilter, "");
+  // The smallest rate records an event with a probability of 2^-32.
+  trace_config.SetCategorySamplingRate("cat1", 1e-12);
+  TraceLog::GetInstance()->SetEnabled(trace_config, TraceLog::RECORDING_MODE);
+
+  for (int i = 0; i < 100; ++i) {
+    TRACE_EVENT_INSTANT0("cat1", "dropped", TRACE_EVENT_SCOPE_THREAD);
+    TRACE_EVENT0("cat1", "dropped");
+  }
+  // Events that are part of a pair are never sampled.
+  TRACE_EVENT_BEGIN0("cat1", "paired");
+  TRACE_EVENT_END0("cat1", "paired");
+  TRACE_EVENT_INSTANT0("cat2", "unsampled", TRACE_EVENT_SCOPE_THREAD);
+
+  EndTraceAndFlush();
+
+  EXPECT_TRUE(FindTraceEntries(trace_parsed_, "dropped").empty());
+  EXPECT_TRUE(FindNamePhase("paired", "B"));
+  EXPECT_TRUE(FindNamePhase("paired", "E"));
+  EXPECT_TRUE(FindNamePhase("unsampled", "I"));
+  EXPECT_TRUE(FindNamePhase("category_sampling_rates", "M"));
+}
+#endif  // !BUILDFLAG(USE_PERFETTO_CLIENT_LIBRARY)
+
 class MockEnabledStateChangedObserver :
       public TraceLog::EnabledStateObserver {
  public:
@@ -2542,6 +2568,40 @@ TEST_F(TraceEventTestFixture, EchoToConsoleTraceEventRecursion) {
   logging::SetLogMessageHandler(old_log_message_handler);
 }
 
+// Sampling isn't supported with Perfetto.
+#if !BUILDFLAG(USE_PERFETTO_CLIENT_LIBRARY)
+TEST_F(TraceEventTestFixture, EchoToConsoleSampledCompleteEvent) {
+  logging::LogMessageHandlerFunction old_log_message_handler =
+      logging::GetLogMessageHandler();
+  logging::SetLogMessageHandler(MockLogMessageHandler);
+
+  TraceConfig trace_config(kRecordAllCategoryFilter, ECHO_TO_CONSOLE);
+  trace_config.SetCategorySamplingRate("test_sampled", 1e-12);
+  TraceLog::GetInstance()->SetEnabled(trace_config, TraceLog::RECORDING_MODE);
+  {
+    TRACE_EVENT0("test_b", "outer");
+    // The end of a sampled-out event must not pop the start time of "outer".
+    for (int i = 0; i < 10; ++i)
+      TRACE_EVENT0("test_sampled", "sampled");
+  }
+  { TRACE_EVENT0("test_b", "after"); }
+
+  ASSERT_TRUE(g_log_buffer);
+  EXPECT_EQ(std::string::npos, g_log_buffer->find("sampled[test_sampled]"));
+  EXPECT_NE(std::string::npos, g_log_buffer->find("outer[test_b]\x1b"));
+  EXPECT_NE(std::string::npos, g_log_buffer->find("outer[test_b] ("));
+  // "after" isn't nested in anything.
+  EXPECT_NE(std::string::npos, g_log_buffer->find("mafter[test_b]\x1b"));
+
+  EndTraceAndFlush();
+  EXPECT_FALSE(FindMatchingValue("name", "sampled"));
+  EXPECT_TRUE(FindMatchingValue("name", "outer"));
+  delete g_log_buffer;
+  logging::SetLogMessageHandler(old_log_message_handler);
+  g_log_buffer = nullptr;
+}
+#endif  // !BUILDFLAG(USE_PERFETTO_CLIENT_LIBRARY)
+
 // Perfetto doesn't support overriding the time offset.
 #if !BUILDFLAG(USE_PERFETTO_CLIENT_LIBRARY)
 TEST_F(TraceEventTestFixture, TimeOffset) {
@@ -2725,6 +2785,42 @@ TEST_F(TraceEventTestFixture, MAYBE_EventFiltering) {
   EXPECT_EQ(1u, filter_hits_counter.end_event_hit_count);
 }
 
+TEST_F(TraceEventTestFixture, EventFilteringSampledCompleteEvent) {
+  const char config_json[] =
+      "{"
+      "  \"included_categories\": [\"test_filtered_cat\"],"
+      "  \"event_filters\": ["
+      "     {"
+      "       \"filter_predicate\": \"testing_predicate\", "
+      "       \"included_categories\": [\"test_filtered_cat\"]"
+      "     }"
+      "  ]"
+      "}";
+
+  TestEventFilter::HitsCounter filter_hits_counter;
+  TestEventFilter::set_filter_return_value(true);
+  TraceLog::GetInstance()->SetFilterFactoryForTesting(TestEventFilter::Factory);
+
+  TraceConfig trace_config(config_json);
+  trace_config.SetCategorySamplingRate("test_filtered_cat", 1e-12);
+  TraceLog::GetInstance()->SetEnabled(
+      trace_config, TraceLog::RECORDING_MODE | TraceLog::FILTERING_MODE);
+  ASSERT_TRUE(TraceLog::GetInstance()->IsEnabled());
+
+  // Neither the beginning nor the end of sampled-out events reach the filter.
+  for (int i = 0; i < 10; ++i)
+    TRACE_EVENT0("test_filtered_cat", "sampled");
+  // Pairs aren't sampled.
+  TRACE_EVENT_BEGIN0("test_filtered_cat", "paired");
+  TRACE_EVENT_END0("test_filtered_cat", "paired");
+
+  EndTraceAndFlush();
+
+  EXPECT_EQ(2u, filter_hits_counter.filter_trace_event_hit_count);
+  EXPECT_EQ(0u, filter_hits_counter.end_event_hit_count);
+  EXPECT_FALSE(FindMatchingValue("name", "sampled"));
+}
+
 // Flaky on iOS device, see crbug.com/908002
 #if defined(OS_IOS) && !(TARGET_OS_SIMULATOR)
 #define MAYBE_EventAllowlistFiltering DISABLED_EventAllowlistFiltering
@@ -22,6 +22,7 @@
 #include "base/no_destructor.h"
 #include "base/process/process.h"
 #include "base/process/process_metrics.h"
+#include "base/rand_util.h"
 #include "base/ranges/algorithm.h"
 #include "base/strings/string_piece.h"
 #include "base/strings/string_split.h"
@@ -176,6 +177,16 @@ void MakeHandle(uint32_t chunk_seq,
   handle->event_index = static_cast<uint16_t>(event_index);
 }
 
+// Returned for COMPLETE events that are sampled out, so that their end is
+// dropped too. MakeHandle() never produces a zero |chunk_seq|.
+constexpr TraceEventHandle kSampledOutHandle = {
+    0, TraceBufferChunk::kMaxChunkIndex, 0};
+
+bool IsSampledOutHandle(const TraceEventHandle& handle) {
+  return !handle.chunk_seq &&
+         handle.chunk_index == kSampledOutHandle.chunk_index;
+}
+
 template <typename Function>
 void ForEachCategoryFilter(const unsigned char* category_group_enabled,
                            Function filter_fn) {
@@ -567,13 +578,12 @@ TraceEvent* TraceLog::ThreadLocalEventBuffer::AddTraceEvent(
     TraceEventHandle* handle) {
   CheckThisIsCurrentBuffer();
 
-  if (chunk_ && chunk_->IsFull()) {
+  if (!chunk_ || chunk_->IsFull()) {
+    // Hand back the full chunk and take a fresh one under a single
+    // acquisition of |lock_|, which is shared with every other thread.
     AutoLock lock(trace_log_->lock_);
     FlushWhileLocked();
     chunk_.reset();
-  }
-  if (!chunk_) {
-    AutoLock lock(trace_log_->lock_);
     chunk_ = trace_log_->logged_events_->GetChunk(&chunk_index_);
     trace_log_->CheckIfBufferIsFullWhileLocked();
   }
@@ -828,6 +838,16 @@ void TraceLog::UpdateCategoryState(TraceCategory* category) {
     }
   }
   category->set_enabled_filters(enabled_filters_bitmap);
+
+  uint32_t sampling_threshold = 0;
+  if (state_flags & TraceCategory::ENABLED_FOR_RECORDING) {
+    const double rate = trace_config_.GetCategorySamplingRate(category->name());
+    if (rate < 1) {
+      sampling_threshold = static_cast<uint32_t>(
+          std::max(1.0, std::ldexp(rate, 32)));
+    }
+  }
+  category->set_sampling_threshold(sampling_threshold);
   category->set_state(state_flags);
 }
 
@@ -1165,8 +1185,12 @@ void TraceLog::SetDisabledWhileLocked(uint8_t modes_to_disable) {
   if (modes_to_disable & FILTERING_MODE)
     enabled_event_filters_.clear();
 
-  if (modes_to_disable & RECORDING_MODE)
+  if (modes_to_disable & RECORDING_MODE) {
+    // This needs the config, so it can't wait for the other metadata below.
+    if (is_recording_mode_disabled)
+      AddSamplingRatesMetadataWhileLocked();
     trace_config_.Clear();
+  }
 
   UpdateCategoryRegistry();
 
@@ -1575,6 +1599,31 @@ void TraceLog::UseNextTraceBuffer() {
   thread_shared_chunk_index_ = 0;
 }
 
+// static
+bool TraceLog::IsSampledOut(char phase,
+                            const unsigned char* category_group_enabled) {
+  const uint32_t threshold =
+      TraceCategory::FromStatePtr(category_group_enabled)->sampling_threshold();
+  if (!threshold)
+    return false;
+
+  // Sampling one half of a BEGIN/END or async pair independently of the
+  // other would leave it unmatched. The end of a COMPLETE event is dropped
+  // along with it, see kSampledOutHandle.
+  if (phase != TRACE_EVENT_PHASE_COMPLETE &&
+      phase != TRACE_EVENT_PHASE_INSTANT &&
+      phase != TRACE_EVENT_PHASE_COUNTER) {
+    return false;
+  }
+
+  // The generator is constant-initialized, so this doesn't need any dynamic
+  // thread-local initialization.
+  static thread_local InsecureRandomGenerator generator;
+  if (!generator.seeded())
+    generator.Seed();
+  return generator.RandUint32() >= threshold;
+}
+
 bool TraceLog::ShouldAddAfterUpdatingState(
     char phase,
     const unsigned char* category_group_enabled,
@@ -1585,6 +1634,13 @@ bool TraceLog::ShouldAddAfterUpdatingState(
   if (!*category_group_enabled)
     return false;
 
+  // COMPLETE events are sampled by AddTraceEventWithThreadIdAndTimestamps(),
+  // which tags their handle so that their end is dropped as well.
+  if (phase != TRACE_EVENT_PHASE_COMPLETE &&
+      IsSampledOut(phase, category_group_enabled)) {
+    return false;
+  }
+
   // Avoid re-entrance of AddTraceEvent. This may happen in GPU process when
   // ECHO_TO_CONSOLE is enabled: AddTraceEvent -> LOG(ERROR) ->
   // GpuProcessLogMessageHandler -> PostPendingTask -> TRACE_EVENT ...
@@ -1742,6 +1798,10 @@ TraceEventHandle TraceLog::AddTraceEventWithThreadIdAndTimestamps(
     TraceArguments* args,
     unsigned int flags) NO_THREAD_SAFETY_ANALYSIS {
   TraceEventHandle handle = {0, 0, 0};
+  if (phase == TRACE_EVENT_PHASE_COMPLETE && *category_group_enabled &&
+      IsSampledOut(phase, category_group_enabled)) {
+    return kSampledOutHandle;
+  }
   if (!ShouldAddAfterUpdatingState(phase, category_group_enabled, name, id,
                                    thread_id, args)) {
     return handle;
@@ -1966,6 +2026,11 @@ void TraceLog::UpdateTraceEventDurationExplicit(
   if (!category_group_enabled_local)
     return;
 
+  // The beginning of the event was dropped, so neither the recording, the
+  // console nor the filters have anything to end.
+  if (IsSampledOutHandle(handle))
+    return;
+
   // Avoid re-entrance of AddTraceEvent. This may happen in GPU process when
   // ECHO_TO_CONSOLE is enabled: AddTraceEvent -> LOG(ERROR) ->
   // GpuProcessLogMessageHandler -> PostPendingTask -> TRACE_EVENT ...
@@ -2108,6 +2173,19 @@ void TraceLog::AddMetadataEventsWhileLocked() {
   }
 }
 
+void TraceLog::AddSamplingRatesMetadataWhileLocked() {
+  // Record the effective sampling rates so that tools can rescale the counts
+  // of sampled categories.
+  if (trace_config_.category_sampling_rates().empty())
+    return;
+  std::vector<std::string> rates;
+  for (const auto& it : trace_config_.category_sampling_rates())
+    rates.push_back(base::StringPrintf("%s=%g", it.first.c_str(), it.second));
+  AddMetadataEventWhileLocked(
+      static_cast<int>(base::PlatformThread::CurrentId()),
+      "category_sampling_rates", "rates", base::JoinString(rates, ","));
+}
+
 TraceEvent* TraceLog::GetEventByHandle(TraceEventHandle handle) {
   return GetEventByHandleInternal(handle, nullptr);
 }
@@ -455,6 +455,11 @@ class BASE_EXPORT TraceLog :
   void UpdateCategoryRegistry();
   void UpdateCategoryState(TraceCategory* category);
 
+  // Returns true if an event of |phase| should be dropped because its category
+  // is sampled. Only called for enabled categories.
+  static bool IsSampledOut(char phase,
+                           const unsigned char* category_group_enabled);
+
   void CreateFiltersForTraceConfig();
 
   InternalTraceOptions GetInternalOptionsFromTraceConfig(
@@ -467,6 +472,7 @@ class BASE_EXPORT TraceLog :
   explicit TraceLog(int generation);
   ~TraceLog() override;
   void AddMetadataEventsWhileLocked() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  void AddSamplingRatesMetadataWhileLocked() EXCLUSIVE_LOCKS_REQUIRED(lock_);
   template <typename T>
   void AddMetadataEventWhileLocked(int thread_id,
                                    const char* metadata_name,
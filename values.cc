@@ -49,6 +49,35 @@ static_assert(base::size(kTypeNames) ==
                   static_cast<size_t>(Value::Type::LIST) + 1,
               "kTypeNames Has Wrong Size");
 
+// The capacity reserved by the first insertion into a dictionary.
+constexpr size_t kInitialDictCapacity = 4;
+
+// Sets |key| to |value| in |dict|. |Key| is StringPiece or std::string, which
+// is moved into |dict| when inserting a new key.
+template <typename Key>
+Value* SetDictKey(Value::LegacyDictStorage& dict, Key&& key, Value&& value) {
+  // Use lower_bound to avoid doing the search twice for missing keys.
+  auto found = dict.lower_bound(key);
+  if (found != dict.end() && found->first == key) {
+    // Reuse the existing Value rather than replacing its allocation.
+    *found->second = std::move(value);
+    return found->second.get();
+  }
+
+  // Most dictionaries are small, so skip the reallocations of growing the
+  // storage one entry at a time.
+  if (dict.empty()) {
+    dict.reserve(kInitialDictCapacity);
+    found = dict.end();
+  }
+  // NOTE: We can't use |insert_or_assign| here, as only |try_emplace| does
+  // an explicit conversion from StringPiece to std::string if necessary.
+  return dict
+      .try_emplace(found, std::forward<Key>(key),
+                   std::make_unique<Value>(std::move(value)))
+      ->second.get();
+}
+
 std::unique_ptr<Value> CopyWithoutEmptyChildren(const Value& node);
 
 // Make a deep copy of |node|, but don't include empty lists or dictionaries
@@ -484,46 +513,43 @@ Value* Value::FindListKey(StringPiece key) {
 }
 
 Value* Value::SetKey(StringPiece key, Value&& value) {
-  return SetKeyInternal(key, std::make_unique<Value>(std::move(value)));
+  return SetKeyInternal(key, Value(std::move(value)));
 }
 
 Value* Value::SetKey(std::string&& key, Value&& value) {
-  return dict()
-      .insert_or_assign(std::move(key),
-                        std::make_unique<Value>(std::move(value)))
-      .first->second.get();
+  return SetKeyInternal(std::move(key), Value(std::move(value)));
 }
 
 Value* Value::SetKey(const char* key, Value&& value) {
-  return SetKeyInternal(key, std::make_unique<Value>(std::move(value)));
+  return SetKeyInternal(StringPiece(key), Value(std::move(value)));
 }
 
 Value* Value::SetBoolKey(StringPiece key, bool value) {
-  return SetKeyInternal(key, std::make_unique<Value>(value));
+  return SetKeyInternal(key, Value(value));
 }
 
 Value* Value::SetIntKey(StringPiece key, int value) {
-  return SetKeyInternal(key, std::make_unique<Value>(value));
+  return SetKeyInternal(key, Value(value));
 }
 
 Value* Value::SetDoubleKey(StringPiece key, double value) {
-  return SetKeyInternal(key, std::make_unique<Value>(value));
+  return SetKeyInternal(key, Value(value));
 }
 
 Value* Value::SetStringKey(StringPiece key, StringPiece value) {
-  return SetKeyInternal(key, std::make_unique<Value>(value));
+  return SetKeyInternal(key, Value(value));
 }
 
 Value* Value::SetStringKey(StringPiece key, StringPiece16 value) {
-  return SetKeyInternal(key, std::make_unique<Value>(value));
+  return SetKeyInternal(key, Value(value));
 }
 
 Value* Value::SetStringKey(StringPiece key, const char* value) {
-  return SetKeyInternal(key, std::make_unique<Value>(value));
+  return SetKeyInternal(key, Value(value));
 }
 
 Value* Value::SetStringKey(StringPiece key, std::string&& value) {
-  return SetKeyInternal(key, std::make_unique<Value>(std::move(value)));
+  return SetKeyInternal(key, Value(std::move(value)));
 }
 
 bool Value::RemoveKey(StringPiece key) {
@@ -620,35 +646,35 @@ Value* Value::FindListPath(StringPiece path) {
 }
 
 Value* Value::SetPath(StringPiece path, Value&& value) {
-  return SetPathInternal(path, std::make_unique<Value>(std::move(value)));
+  return SetPathInternal(path, Value(std::move(value)));
 }
 
 Value* Value::SetBoolPath(StringPiece path, bool value) {
-  return SetPathInternal(path, std::make_unique<Value>(value));
+  return SetPathInternal(path, Value(value));
 }
 
 Value* Value::SetIntPath(StringPiece path, int value) {
-  return SetPathInternal(path, std::make_unique<Value>(value));
+  return SetPathInternal(path, Value(value));
 }
 
 Value* Value::SetDoublePath(StringPiece path, double value) {
-  return SetPathInternal(path, std::make_unique<Value>(value));
+  return SetPathInternal(path, Value(value));
 }
 
 Value* Value::SetStringPath(StringPiece path, StringPiece value) {
-  return SetPathInternal(path, std::make_unique<Value>(value));
+  return SetPathInternal(path, Value(value));
 }
 
 Value* Value::SetStringPath(StringPiece path, std::string&& value) {
-  return SetPathInternal(path, std::make_unique<Value>(std::move(value)));
+  return SetPathInternal(path, Value(std::move(value)));
 }
 
 Value* Value::SetStringPath(StringPiece path, const char* value) {
-  return SetPathInternal(path, std::make_unique<Value>(value));
+  return SetPathInternal(path, Value(value));
 }
 
 Value* Value::SetStringPath(StringPiece path, StringPiece16 value) {
-  return SetPathInternal(path, std::make_unique<Value>(value));
+  return SetPathInternal(path, Value(value));
 }
 
 bool Value::RemovePath(StringPiece path) {
@@ -1040,21 +1066,17 @@ void Value::WriteIntoTrace(perfetto::TracedValue context) const {
 }
 #endif  // BUILDFLAG(ENABLE_BASE_TRACING)
 
-Value* Value::SetKeyInternal(StringPiece key,
-                             std::unique_ptr<Value>&& val_ptr) {
+Value* Value::SetKeyInternal(StringPiece key, Value&& value) {
   CHECK(is_dict());
-  // NOTE: We can't use |insert_or_assign| here, as only |try_emplace| does
-  // an explicit conversion from StringPiece to std::string if necessary.
-  auto result = dict().try_emplace(key, std::move(val_ptr));
-  if (!result.second) {
-    // val_ptr is guaranteed to be still intact at this point.
-    result.first->second = std::move(val_ptr);
-  }
-  return result.first->second.get();
+  return SetDictKey(dict(), key, std::move(value));
+}
+
+Value* Value::SetKeyInternal(std::string&& key, Value&& value) {
+  CHECK(is_dict());
+  return SetDictKey(dict(), std::move(key), std::move(value));
 }
 
-Value* Value::SetPathInternal(StringPiece path,
-                              std::unique_ptr<Value>&& value_ptr) {
+Value* Value::SetPathInternal(StringPiece path, Value&& value) {
   PathSplitter splitter(path);
   DCHECK(splitter.HasNext()) << "Cannot call SetPath() with empty path";
   // Walk/construct intermediate dictionaries. The last element requires
@@ -1081,7 +1103,7 @@ Value* Value::SetPathInternal(StringPiece path,
   // "cur" will now contain the last dictionary to insert or replace into.
   if (!cur->is_dict())
     return nullptr;
-  return cur->SetKeyInternal(path_component, std::move(value_ptr));
+  return cur->SetKeyInternal(path_component, std::move(value));
 }
 
 ///////////////////// DictionaryValue ////////////////////
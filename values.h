@@ -615,10 +615,11 @@ class BASE_EXPORT Value {
   friend class ValuesTest_SizeOfValue_Test;
   double AsDoubleInternal() const;
 
-  // NOTE: Using a movable reference here is done for performance (it avoids
-  // creating + moving + destroying a temporary unique ptr).
-  Value* SetKeyInternal(StringPiece key, std::unique_ptr<Value>&& val_ptr);
-  Value* SetPathInternal(StringPiece path, std::unique_ptr<Value>&& value_ptr);
+  // |value| must not be part of this Value, which callers ensure by passing
+  // a temporary. Replacing the value of an existing key reuses its storage.
+  Value* SetKeyInternal(StringPiece key, Value&& value);
+  Value* SetKeyInternal(std::string&& key, Value&& value);
+  Value* SetPathInternal(StringPiece path, Value&& value);
 
   absl::variant<absl::monostate,
                 bool,
@@ -1034,6 +1034,29 @@ TEST(ValuesTest, SetKey) {
   EXPECT_EQ(Value(std::move(storage)), dict);
 }
 
+TEST(ValuesTest, SetKeyReplacesValue) {
+  Value dict(Value::Type::DICTIONARY);
+  Value* value = dict.SetIntKey("key", 1);
+  EXPECT_EQ(value, dict.SetStringKey("key", "string"));
+  EXPECT_EQ(1u, dict.DictSize());
+  EXPECT_EQ("string", *dict.FindStringKey("key"));
+
+  // Replace a value with one of its own children.
+  Value* child = dict.SetKey("key", Value(Value::Type::DICTIONARY));
+  child->SetKey("nested", Value(Value::Type::LIST))->Append(2);
+  dict.SetKey("key", std::move(*child->FindKey("nested")));
+  Value expected(Value::Type::LIST);
+  expected.Append(2);
+  EXPECT_EQ(expected, *dict.FindKey("key"));
+
+  dict.SetPath("key", std::move(*dict.FindKey("key")));
+  EXPECT_EQ(expected, *dict.FindKey("key"));
+
+  EXPECT_EQ(value, dict.SetKey(std::string("key"), Value(3)));
+  EXPECT_EQ(1u, dict.DictSize());
+  EXPECT_EQ(3, dict.FindIntKey("key"));
+}
+
 TEST(ValuesTest, SetBoolKey) {
   absl::optional<bool> value;
 